@@ -6,8 +6,15 @@ layout(local_size_x = 8, local_size_y = 8, local_size_z = 8) in;
 
 void main()
 {
-    uint slot = uint(gl_WorkGroupID.x);
-    uint lutIdx = slot_list[slot];
+    // The dispatch is split in rows of work groups to stay under the count limits
+    uint brick = uint(gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x);
+    if (brick >= uBricksCount)
+    {
+        return;
+    }
+
+    uint slot = brick_list[brick].x;
+    uint lutIdx = brick_list[brick].y;
     ivec3 lutCoord = IndexToCoord(lutIdx);
     
     // slot center world pos
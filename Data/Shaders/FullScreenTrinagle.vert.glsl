@@ -30,8 +30,11 @@ layout(location = 0) out vec2 outFragUV;
 layout(location = 1) out vec4 outNear;
 layout(location = 2) out vec4 outFar;
 
-layout(location = 0) uniform mat4 uViewMatrix;
-layout(location = 1) uniform mat4 uProjectionMatrix;
+layout(std140, binding = 4) uniform frame_data
+{
+    mat4 uViewMatrix;
+    mat4 uProjectionMatrix;
+};
 
 void main()
 {
@@ -17,21 +17,16 @@ layout(std430, binding = 0) readonly buffer strokes_buffer
     stroke_t strokes[];
 };
 
-layout(std430, binding = 1) buffer slot_list_buffer
+layout(std430, binding = 1) readonly buffer brick_list_buffer
 {
-    uint slot_list[];
-};
-
-layout(std430, binding = 2) buffer slot_count_buffer
-{
-    uint slot_count;
-    uint padding[2];
+    uvec2 brick_list[];     // atlas slot.x, lut CoordToIndex.y of the bricks to bake
 };
 
 layout(location = 20) uniform uint uStrokesCount;
 layout(location = 21) uniform uint uMaxSlotsCount;
 layout(location = 22) uniform vec4 uVoxelSide;    // LutVoxelSide.x, InvLutVoxelSide.y, AtlasVoxelSide.z InvAtlasVoxelSide.w
 layout(location = 23) uniform vec4 uVolumeExtent;   // LutSize.x, InvLutSize.y, AtlasXYSize.z, AtlasDepth.y
+layout(location = 24) uniform uint uBricksCount;
 
 layout(location = 30) uniform sampler3D uSdfLutTexture;
 layout(location = 31) uniform sampler3D uSdfAtlasTexture;
@@ -36,6 +36,75 @@ workspace "SDFEditor"
 
     filter { }
 
+-- SIMD kernels, selected at runtime with sbx::GetCpuFeatures(), each one
+-- built with its own instruction set
+function SdfKernelBuildOptions()
+    filter { "system:not windows", "files:**/SdfKernelSse41.cpp" }
+        buildoptions { "-msse4.1" }
+
+    filter { "system:windows", "files:**/SdfKernelAvx2.cpp" }
+        buildoptions { "/arch:AVX2" }
+
+    filter { "system:not windows", "files:**/SdfKernelAvx2.cpp" }
+        buildoptions { "-mavx2", "-mfma" }
+
+    filter { "system:windows", "files:**/SdfKernelAvx512.cpp" }
+        buildoptions { "/arch:AVX512" }
+
+    filter { "system:not windows", "files:**/SdfKernelAvx512.cpp" }
+        buildoptions { "-mavx512f" }
+
+    filter { }
+end
+
+-- Command line tool, no window or GL context. Builds ./Source/<aSourceDir>
+-- with the scene code of the editor and aSdfFiles, all of Sdf by default.
+function SdfToolProject(aName, aSourceDir, aSdfFiles)
+    project (aName)
+        location "./Build"
+        kind "ConsoleApp"
+        links { "sbx" }
+        targetname (aName)
+        debugdir "./Data"
+
+        includedirs { 
+            "./Source", 
+            "./Source/ThirdParty"
+        }
+
+        libdirs { 
+            "./Bin/sbx/%{cfg.longname}"
+        }
+
+        files  {
+            "./Source/" .. aSourceDir .. "/**.h",
+            "./Source/" .. aSourceDir .. "/**.cpp",
+            "./Source/SDFEditor/Tool/Scene*.h",
+            "./Source/SDFEditor/Tool/Scene*.cpp",
+            "./Source/SDFEditor/Tool/Camera.*",
+            "./Source/SDFEditor/Tool/StrokeInfo.*",
+            "./Source/SDFEditor/Utils/**.h",
+            "./Source/SDFEditor/Utils/**.cpp",
+        }
+
+        files (aSdfFiles or {
+            "./Source/SDFEditor/Sdf/**.h",
+            "./Source/SDFEditor/Sdf/**.inl",
+            "./Source/SDFEditor/Sdf/**.cpp",
+        })
+
+        vpaths { 
+            ["Source/**"] = "./Source/**.*",
+        }
+
+        filter { "system:not windows" }
+            links { "pthread" }
+
+        filter { }
+
+        SdfKernelBuildOptions()
+end
+
 project "sbx"
     location "./Build"
     kind "StaticLib"
@@ -130,6 +199,25 @@ project "SDFEditor"
         links { "OpenGL32" }
 
     filter { "system:not windows" }
-        links { "GL" }
-
-    
\ No newline at end of file
+        links { "GL", "pthread" }
+
+    SdfKernelBuildOptions()
+
+-- Command line tools
+
+-- Scene and picking code only, the picker evaluates strokes with the kernels
+SdfToolProject("sdfconvert", "SDFConvert", {
+    "./Source/SDFEditor/Sdf/SdfBounds.*",
+    "./Source/SDFEditor/Sdf/SdfStrokeBvh.*",
+    "./Source/SDFEditor/Sdf/SdfPicking.*",
+    "./Source/SDFEditor/Sdf/SdfEvaluator.*",
+    "./Source/SDFEditor/Sdf/SdfSimd.*",
+    "./Source/SDFEditor/Sdf/SdfKernel*",
+})
+
+SdfToolProject("sdfbake", "SDFBake")
+SdfToolProject("sdfrender", "SDFRender")
+SdfToolProject("sdfbench", "SDFBench")
+SdfToolProject("sdfgen", "SDFGen")
+SdfToolProject("sdfmesh", "SDFMesh")
+SdfToolProject("sdftest", "SDFTest")
@@ -0,0 +1,254 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Bakes the LUT and brick atlas of scenes on the CPU, no window or GL context
+
+#include <SDFEditor/Tool/Scene.h>
+#include <SDFEditor/Sdf/SdfAtlasBaker.h>
+#include <SDFEditor/Sdf/SdfEvaluator.h>
+#include <SDFEditor/Sdf/SdfLutBaker.h>
+#include <SDFEditor/Sdf/SdfVolumeCache.h>
+
+#include <sbx/Texture/Texture.h>
+#include <sbx/Texture/TextureUtils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    namespace EOutputFormat
+    {
+        enum Type
+        {
+            PACK,   // <name>.sdfvol texture pack, same layout as the editor volume cache
+            RAW,    // <name>.lut.raw, <name>.bricks.raw and <name>.slots.raw
+        };
+    };
+
+    struct TBakeOptions
+    {
+        TSdfBakeParams mParams;
+        EOutputFormat::Type mFormat{ EOutputFormat::PACK };
+        std::string mOutputDir;
+        std::vector<std::string> mInputs;
+    };
+
+    void PrintUsage()
+    {
+        fprintf(stderr, "usage: sdfbake [options] <input.strks|input.strkb>...\n");
+        fprintf(stderr, "  -r, --resolution <n>    LUT voxels per side, 8 to 256 (default 128), same world extent\n");
+        fprintf(stderr, "  -t, --threads <n>       bake threads (default 0, all hardware threads)\n");
+        fprintf(stderr, "  -f, --format <fmt>      pack: <name>.sdfvol texture pack with the LUT and the bricks (default)\n");
+        fprintf(stderr, "                          raw: <name>.lut.raw (RGBA8), <name>.bricks.raw (R8), <name>.slots.raw (uint32)\n");
+        fprintf(stderr, "  -o, --output <dir>      output directory (default: next to each input)\n");
+        fprintf(stderr, "      --no-cull           evaluate every stroke on every voxel\n");
+    }
+
+    bool ParseInt(const char* aText, int32_t aMin, int32_t aMax, int32_t& aOutValue)
+    {
+        char* lEnd = nullptr;
+        const long lValue = ::strtol(aText, &lEnd, 10);
+        if (lEnd == aText || *lEnd != 0 || lValue < aMin || lValue > aMax)
+        {
+            return false;
+        }
+        aOutValue = int32_t(lValue);
+        return true;
+    }
+
+    bool ParseOptions(int argc, char** argv, TBakeOptions& aOutOptions)
+    {
+        // The default LUT covers 6.4 units, other resolutions keep it
+        const float lExtent = float(aOutOptions.mParams.mLutSize) * aOutOptions.mParams.mLutVoxelSide;
+
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string lArg = argv[i];
+            const bool lHasValue = (i + 1) < argc;
+            int32_t lValue = 0;
+
+            if ((lArg == "-r" || lArg == "--resolution") && lHasValue)
+            {
+                if (!ParseInt(argv[++i], 8, 256, lValue))
+                {
+                    fprintf(stderr, "Invalid resolution [%s], 8 to 256\n", argv[i]);
+                    return false;
+                }
+                aOutOptions.mParams.mLutSize = lValue;
+                aOutOptions.mParams.mLutVoxelSide = lExtent / float(lValue);
+            }
+            else if ((lArg == "-t" || lArg == "--threads") && lHasValue)
+            {
+                if (!ParseInt(argv[++i], 0, 4096, lValue))
+                {
+                    fprintf(stderr, "Invalid thread count [%s]\n", argv[i]);
+                    return false;
+                }
+                aOutOptions.mParams.mThreads = uint32_t(lValue);
+            }
+            else if ((lArg == "-f" || lArg == "--format") && lHasValue)
+            {
+                const std::string lFormat = argv[++i];
+                if (lFormat == "pack")
+                {
+                    aOutOptions.mFormat = EOutputFormat::PACK;
+                }
+                else if (lFormat == "raw")
+                {
+                    aOutOptions.mFormat = EOutputFormat::RAW;
+                }
+                else
+                {
+                    fprintf(stderr, "Unknown format [%s], pack or raw\n", lFormat.c_str());
+                    return false;
+                }
+            }
+            else if ((lArg == "-o" || lArg == "--output") && lHasValue)
+            {
+                aOutOptions.mOutputDir = argv[++i];
+            }
+            else if (lArg == "--no-cull")
+            {
+                aOutOptions.mParams.mCullStrokes = false;
+            }
+            else if (!lArg.empty() && lArg[0] == '-')
+            {
+                fprintf(stderr, "Unknown option [%s]\n", lArg.c_str());
+                return false;
+            }
+            else
+            {
+                aOutOptions.mInputs.push_back(lArg);
+            }
+        }
+
+        return !aOutOptions.mInputs.empty();
+    }
+
+    bool WriteRaw(std::string const& aPath, const void* aData, size_t aSize)
+    {
+        std::ofstream lOutput(aPath, std::ios::binary);
+        lOutput.write((const char*)aData, aSize);
+        lOutput.close();
+        return !lOutput.fail();
+    }
+
+    double SecondsSince(std::chrono::steady_clock::time_point const& aStart)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - aStart).count();
+    }
+
+    bool BakeScene(std::string const& aInputPath, TBakeOptions const& aOptions)
+    {
+        TSdfBakeParams const& lParams = aOptions.mParams;
+
+        auto lStageStart = std::chrono::steady_clock::now();
+        CScene lScene;
+        lScene.mDocument->SetFilePath(aInputPath);
+        if (!lScene.mDocument->Load())
+        {
+            fprintf(stderr, "Unable to load [%s]\n", aInputPath.c_str());
+            return false;
+        }
+        lScene.SyncPackedStrokes();
+        const double lLoadSeconds = SecondsSince(lStageStart);
+
+        std::vector<stroke_t> const& lStrokes = lScene.GetPackedStrokes();
+        CSdfEvaluator lEvaluator(lStrokes);
+
+        sbx::TTexture lLut;
+        std::vector<uint32_t> lSlotList;
+        CSdfLutBaker lLutBaker;
+        const TSdfLutBakeStats lLutStats = lLutBaker.Bake(lEvaluator, lParams, lLut, &lSlotList);
+
+        TSdfBrickAtlas lAtlas;
+        CSdfAtlasBaker lAtlasBaker;
+        const TSdfAtlasBakeStats lAtlasStats = lAtlasBaker.Bake(lEvaluator, lParams, lSlotList, lAtlas, lParams.mCullStrokes ? &lLutBaker.GetCullGrid() : nullptr);
+
+        // Output next to the input unless a directory is given
+        lStageStart = std::chrono::steady_clock::now();
+        std::filesystem::path lOutputBase = std::filesystem::path(aInputPath).replace_extension();
+        if (!aOptions.mOutputDir.empty())
+        {
+            lOutputBase = std::filesystem::path(aOptions.mOutputDir) / lOutputBase.filename();
+        }
+
+        bool lWritten = false;
+        const size_t lLutBytes = lParams.GetLutVoxelsCount() * sizeof(sbx::TColor8U);
+        if (aOptions.mFormat == EOutputFormat::PACK)
+        {
+            std::vector<sbx::TTexture> lPack(ESdfVolumeCachePack::COUNT);
+            lPack[ESdfVolumeCachePack::LUT].Init(lParams.mLutSize, lParams.mLutSize, lParams.mLutSize, sbx::ETextureFormat::RGBA8);
+            ::memcpy(lPack[ESdfVolumeCachePack::LUT].mBuffer.GetByteArray(), lLut.mBuffer.GetByteArray(), lLutBytes);
+
+            const int32_t lBrickSize = lAtlas.mBrickSize;
+            sbx::TTexture& lBricks = lPack[ESdfVolumeCachePack::BRICKS];
+            lBricks.Init(lBrickSize, lBrickSize, int32_t(std::max(lAtlas.GetBricksCount(), 1u)) * lBrickSize, sbx::ETextureFormat::R8);
+            ::memset(lBricks.mBuffer.GetByteArray(), 0, lBricks.GetSliceSize() * lBricks.mSlices);
+            ::memcpy(lBricks.mBuffer.GetByteArray(), lAtlas.mBricks.data(), lAtlas.mBricks.size());
+
+            lWritten = sbx::texutil::StoreTexturePack(lOutputBase.string() + ".sdfvol", lPack);
+        }
+        else
+        {
+            lWritten = WriteRaw(lOutputBase.string() + ".lut.raw", lLut.mBuffer.GetByteArray(), lLutBytes) &&
+                       WriteRaw(lOutputBase.string() + ".bricks.raw", lAtlas.mBricks.data(), lAtlas.mBricks.size()) &&
+                       WriteRaw(lOutputBase.string() + ".slots.raw", lAtlas.mSlotList.data(), lAtlas.mSlotList.size() * sizeof(uint32_t));
+        }
+        const double lWriteSeconds = SecondsSince(lStageStart);
+
+        if (!lWritten)
+        {
+            fprintf(stderr, "Unable to write [%s]\n", lOutputBase.string().c_str());
+            return false;
+        }
+
+        printf("%s: %zu strokes, %d^3 LUT, %u bricks, %u threads\n", aInputPath.c_str(), lStrokes.size(), lParams.mLutSize, lAtlas.GetBricksCount(), lLutStats.mThreads);
+        printf("  load  %8.3f s\n", lLoadSeconds);
+        printf("  cull  %8.3f s  %.1f strokes/voxel\n", lLutStats.mCullSeconds, lLutStats.mStrokesPerVoxel);
+        printf("  lut   %8.3f s  %.2f Mvoxels/s\n", lLutStats.mSeconds, lLutStats.mVoxelsPerSecond / 1e6);
+        printf("  atlas %8.3f s  %.2f Mvoxels/s\n", lAtlasStats.mSeconds, lAtlasStats.mVoxelsPerSecond / 1e6);
+        printf("  write %8.3f s\n", lWriteSeconds);
+        if (lLutStats.mOverflowSlots > 0)
+        {
+            printf("  %u surface voxels over the %u atlas slots, left to the LUT\n", lLutStats.mOverflowSlots, lParams.mMaxSlots);
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    TBakeOptions lOptions;
+    if (!ParseOptions(argc, argv, lOptions))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (!lOptions.mOutputDir.empty())
+    {
+        std::error_code lError;
+        std::filesystem::create_directories(lOptions.mOutputDir, lError);
+    }
+
+    uint32_t lFailed = 0;
+    for (std::string const& lInput : lOptions.mInputs)
+    {
+        lFailed += BakeScene(lInput, lOptions) ? 0 : 1;
+    }
+
+    if (lOptions.mInputs.size() > 1)
+    {
+        printf("%zu scenes baked, %u failed\n", lOptions.mInputs.size() - lFailed, lFailed);
+    }
+
+    return (lFailed == 0) ? 0 : 1;
+}
@@ -0,0 +1,643 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Performance harness: times load/save, evaluation, bakes, undo and CPU render per scene
+
+#include <SDFEditor/Tool/Scene.h>
+#include <SDFEditor/Tool/SceneGenerator.h>
+#include <SDFEditor/Sdf/SdfAtlasBaker.h>
+#include <SDFEditor/Sdf/SdfEvaluator.h>
+#include <SDFEditor/Sdf/SdfLutBaker.h>
+#include <SDFEditor/Sdf/SdfRaymarcher.h>
+
+#include <sbx/Core/Parallel.h>
+#include <sbx/Texture/Texture.h>
+
+#include <ThirdParty/nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Bump when the stages or the generated scenes change, old baselines are refused
+    constexpr int32_t kBenchVersion = 2;
+
+    constexpr size_t kEvalPoints = 16384;
+    constexpr uint32_t kUndoEdits = 64;
+    constexpr uint32_t kDefaultSeed = 1;
+
+    // Slowdowns under this are timer noise, never a regression
+    constexpr double kMinRegressionSeconds = 0.001;
+
+    namespace EBenchStage
+    {
+        enum Type
+        {
+            SAVE_JSON,
+            LOAD_JSON,
+            EVAL,
+            LUT_BAKE,
+            ATLAS_BAKE,
+            UNDO_PUSH,
+            UNDO_POP,
+            RENDER_STROKES,
+            RENDER_ATLAS,
+
+            COUNT
+        };
+    };
+
+    const char* sStageNames[EBenchStage::COUNT] =
+    {
+        "save_json",
+        "load_json",
+        "eval",
+        "lut_bake",
+        "atlas_bake",
+        "undo_push",
+        "undo_pop",
+        "render_strokes",
+        "render_atlas",
+    };
+
+    // Units of the throughput of each stage
+    const char* sStageUnits[EBenchStage::COUNT] =
+    {
+        "strokes/s",
+        "strokes/s",
+        "stroke evals/s",
+        "voxels/s",
+        "voxels/s",
+        "pushes/s",
+        "pops/s",
+        "rays/s",
+        "rays/s",
+    };
+
+    struct TBenchOptions
+    {
+        std::string mExamplesDir{ "./Examples" };
+        std::vector<uint32_t> mSyntheticSizes{ 1000, 10000, 100000 };
+        uint32_t mSeed{ kDefaultSeed };
+        bool mStages[EBenchStage::COUNT];
+        uint32_t mRepeat{ 1 };
+        uint32_t mThreads{ 0 };
+        int32_t mLutSize{ 128 };
+        int32_t mRenderSize{ 256 };
+        uint32_t mRenderMaxStrokes{ 10000 };    // the exact render is skipped over this
+        std::string mJsonPath;
+        std::string mCsvPath;
+        std::string mBaselinePath;
+        double mThreshold{ 0.10 };              // slowdown over the baseline reported as a regression
+
+        TBenchOptions() { std::fill(mStages, mStages + EBenchStage::COUNT, true); }
+    };
+
+    struct TBenchResult
+    {
+        std::string mScene;
+        uint32_t mStrokes{ 0 };
+        EBenchStage::Type mStage{ EBenchStage::COUNT };
+        double mSeconds{ 0.0 };
+        double mThroughput{ 0.0 };
+    };
+
+    void PrintUsage()
+    {
+        fprintf(stderr, "usage: sdfbench [options]\n");
+        fprintf(stderr, "  -e, --examples <dir>      scenes to time, every .strks/.strkb (default ./Examples, '' for none)\n");
+        fprintf(stderr, "  -s, --sizes <n,n,...>     generated scenes, strokes count (default 1000,10000,100000, '' for none)\n");
+        fprintf(stderr, "      --seed <n>            seed of the generated scenes, uniform layout (default %u)\n", kDefaultSeed);
+        fprintf(stderr, "      --stages <a,b,...>    stages to time (default all):");
+        for (const char* lName : sStageNames)
+        {
+            fprintf(stderr, " %s", lName);
+        }
+        fprintf(stderr, "\n");
+        fprintf(stderr, "  -n, --repeat <n>          runs per stage, the fastest one is kept (default 1)\n");
+        fprintf(stderr, "  -t, --threads <n>         bake and render threads (default 0, all hardware threads)\n");
+        fprintf(stderr, "  -r, --resolution <n>      LUT voxels per side, 8 to 256 (default 128)\n");
+        fprintf(stderr, "      --render-size <n>     side of the rendered images (default 256)\n");
+        fprintf(stderr, "      --render-max-strokes <n>  skips render_strokes over n strokes (default 10000)\n");
+        fprintf(stderr, "      --json <path>         writes the results as JSON, the baseline format\n");
+        fprintf(stderr, "      --csv <path>          writes the results as CSV\n");
+        fprintf(stderr, "  -b, --baseline <path>     compares with a previous --json output, exit code 2 on regressions\n");
+        fprintf(stderr, "      --threshold <pct>     slowdown reported as a regression (default 10)\n");
+    }
+
+    std::vector<std::string> SplitList(std::string const& aText)
+    {
+        std::vector<std::string> lItems;
+        std::stringstream lStream(aText);
+        std::string lItem;
+        while (std::getline(lStream, lItem, ','))
+        {
+            if (!lItem.empty())
+            {
+                lItems.push_back(lItem);
+            }
+        }
+        return lItems;
+    }
+
+    bool ParseInt(const char* aText, int64_t aMin, int64_t aMax, int64_t& aOutValue)
+    {
+        char* lEnd = nullptr;
+        const long long lValue = ::strtoll(aText, &lEnd, 10);
+        if (lEnd == aText || *lEnd != 0 || lValue < aMin || lValue > aMax)
+        {
+            return false;
+        }
+        aOutValue = int64_t(lValue);
+        return true;
+    }
+
+    bool ParseOptions(int argc, char** argv, TBenchOptions& aOutOptions)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string lArg = argv[i];
+            const bool lHasValue = (i + 1) < argc;
+            int64_t lValue = 0;
+
+            auto lParseInt = [&](int64_t aMin, int64_t aMax) -> bool
+            {
+                if (!ParseInt(argv[++i], aMin, aMax, lValue))
+                {
+                    fprintf(stderr, "Invalid value [%s] for %s, %lld to %lld\n", argv[i], lArg.c_str(), (long long)aMin, (long long)aMax);
+                    return false;
+                }
+                return true;
+            };
+
+            if ((lArg == "-e" || lArg == "--examples") && lHasValue)
+            {
+                aOutOptions.mExamplesDir = argv[++i];
+            }
+            else if ((lArg == "-s" || lArg == "--sizes") && lHasValue)
+            {
+                aOutOptions.mSyntheticSizes.clear();
+                for (std::string const& lSize : SplitList(argv[++i]))
+                {
+                    if (!ParseInt(lSize.c_str(), 1, 10000000, lValue))
+                    {
+                        fprintf(stderr, "Invalid scene size [%s]\n", lSize.c_str());
+                        return false;
+                    }
+                    aOutOptions.mSyntheticSizes.push_back(uint32_t(lValue));
+                }
+            }
+            else if (lArg == "--seed" && lHasValue)
+            {
+                if (!lParseInt(0, UINT32_MAX)) return false;
+                aOutOptions.mSeed = uint32_t(lValue);
+            }
+            else if (lArg == "--stages" && lHasValue)
+            {
+                std::fill(aOutOptions.mStages, aOutOptions.mStages + EBenchStage::COUNT, false);
+                for (std::string const& lStage : SplitList(argv[++i]))
+                {
+                    const char** lName = std::find_if(sStageNames, sStageNames + EBenchStage::COUNT, [&](const char* aName) { return lStage == aName; });
+                    if (lName == sStageNames + EBenchStage::COUNT)
+                    {
+                        fprintf(stderr, "Unknown stage [%s]\n", lStage.c_str());
+                        return false;
+                    }
+                    aOutOptions.mStages[lName - sStageNames] = true;
+                }
+            }
+            else if ((lArg == "-n" || lArg == "--repeat") && lHasValue)
+            {
+                if (!lParseInt(1, 1000)) return false;
+                aOutOptions.mRepeat = uint32_t(lValue);
+            }
+            else if ((lArg == "-t" || lArg == "--threads") && lHasValue)
+            {
+                if (!lParseInt(0, 4096)) return false;
+                aOutOptions.mThreads = uint32_t(lValue);
+            }
+            else if ((lArg == "-r" || lArg == "--resolution") && lHasValue)
+            {
+                if (!lParseInt(8, 256)) return false;
+                aOutOptions.mLutSize = int32_t(lValue);
+            }
+            else if (lArg == "--render-size" && lHasValue)
+            {
+                if (!lParseInt(1, 16384)) return false;
+                aOutOptions.mRenderSize = int32_t(lValue);
+            }
+            else if (lArg == "--render-max-strokes" && lHasValue)
+            {
+                if (!lParseInt(0, UINT32_MAX)) return false;
+                aOutOptions.mRenderMaxStrokes = uint32_t(lValue);
+            }
+            else if (lArg == "--json" && lHasValue)
+            {
+                aOutOptions.mJsonPath = argv[++i];
+            }
+            else if (lArg == "--csv" && lHasValue)
+            {
+                aOutOptions.mCsvPath = argv[++i];
+            }
+            else if ((lArg == "-b" || lArg == "--baseline") && lHasValue)
+            {
+                aOutOptions.mBaselinePath = argv[++i];
+            }
+            else if (lArg == "--threshold" && lHasValue)
+            {
+                if (!lParseInt(0, 1000)) return false;
+                aOutOptions.mThreshold = double(lValue) / 100.0;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown option [%s]\n", lArg.c_str());
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Fastest of aRepeat runs
+    double TimeStage(uint32_t aRepeat, std::function<void()> const& aStage)
+    {
+        double lBest = 0.0;
+        for (uint32_t r = 0; r < aRepeat; r++)
+        {
+            const auto lStart = std::chrono::steady_clock::now();
+            aStage();
+            const double lSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStart).count();
+            lBest = (r == 0) ? lSeconds : std::min(lBest, lSeconds);
+        }
+        return lBest;
+    }
+
+    class CBench
+    {
+    public:
+        CBench(TBenchOptions const& aOptions) : mOptions(aOptions)
+        {
+            const float lExtent = float(mBakeParams.mLutSize) * mBakeParams.mLutVoxelSide;
+            mBakeParams.mLutSize = aOptions.mLutSize;
+            mBakeParams.mLutVoxelSide = lExtent / float(aOptions.mLutSize);
+            mBakeParams.mThreads = aOptions.mThreads;
+
+            mRenderParams.mWidth = aOptions.mRenderSize;
+            mRenderParams.mHeight = aOptions.mRenderSize;
+            mRenderParams.mThreads = aOptions.mThreads;
+        }
+
+        void Run(std::string const& aName, CScene& aScene);
+
+        std::vector<TBenchResult> const& GetResults() const { return mResults; }
+
+    private:
+        bool IsEnabled(EBenchStage::Type aStage) const { return mOptions.mStages[aStage]; }
+        void AddResult(std::string const& aName, uint32_t aStrokes, EBenchStage::Type aStage, double aSeconds, double aWork);
+
+        TBenchOptions const& mOptions;
+        TSdfBakeParams mBakeParams;
+        TSdfRenderParams mRenderParams;
+        std::vector<TBenchResult> mResults;
+    };
+
+    void CBench::AddResult(std::string const& aName, uint32_t aStrokes, EBenchStage::Type aStage, double aSeconds, double aWork)
+    {
+        TBenchResult lResult;
+        lResult.mScene = aName;
+        lResult.mStrokes = aStrokes;
+        lResult.mStage = aStage;
+        lResult.mSeconds = aSeconds;
+        lResult.mThroughput = (aSeconds > 0.0) ? aWork / aSeconds : 0.0;
+        mResults.push_back(lResult);
+
+        printf("  %-16s %10.4f s  %12.4g %s\n", sStageNames[aStage], aSeconds, lResult.mThroughput, sStageUnits[aStage]);
+        fflush(stdout);
+    }
+
+    void CBench::Run(std::string const& aName, CScene& aScene)
+    {
+        const uint32_t lStrokesCount = uint32_t(aScene.mStrokesArray.size());
+        printf("%s: %u strokes\n", aName.c_str(), lStrokesCount);
+
+        // JSON round trip through a temporary file
+        if (IsEnabled(EBenchStage::SAVE_JSON) || IsEnabled(EBenchStage::LOAD_JSON))
+        {
+            std::error_code lError;
+            const std::string lTempPath = (std::filesystem::temp_directory_path(lError) / ("sdfbench_" + aName + ".strks")).string();
+            const std::string lFilePath = aScene.mDocument->GetFilePath();
+            aScene.mDocument->SetFilePath(lTempPath);
+            const double lSaveSeconds = TimeStage(mOptions.mRepeat, [&]() { aScene.mDocument->Save(); });
+            aScene.mDocument->SetFilePath(lFilePath);
+            if (IsEnabled(EBenchStage::SAVE_JSON))
+            {
+                AddResult(aName, lStrokesCount, EBenchStage::SAVE_JSON, lSaveSeconds, double(lStrokesCount));
+            }
+
+            if (IsEnabled(EBenchStage::LOAD_JSON))
+            {
+                CScene lLoaded;
+                lLoaded.mDocument->SetFilePath(lTempPath);
+                const double lLoadSeconds = TimeStage(mOptions.mRepeat, [&]() { lLoaded.mDocument->Load(); });
+                AddResult(aName, lStrokesCount, EBenchStage::LOAD_JSON, lLoadSeconds, double(lStrokesCount));
+            }
+            std::filesystem::remove(lTempPath, lError);
+        }
+
+        aScene.SyncPackedStrokes();
+        CSdfEvaluator lEvaluator(aScene.GetPackedStrokes());
+
+        // Batched evaluation of every stroke, no culling
+        if (IsEnabled(EBenchStage::EVAL))
+        {
+            std::mt19937 lRandom(mOptions.mSeed);
+            const float lHalfExtent = float(mBakeParams.mLutSize) * mBakeParams.mLutVoxelSide * 0.5f;
+            std::uniform_real_distribution<float> lPosition(-lHalfExtent, lHalfExtent);
+            std::vector<glm::vec3> lPoints(kEvalPoints);
+            for (glm::vec3& lPoint : lPoints)
+            {
+                lPoint = glm::vec3(lPosition(lRandom), lPosition(lRandom), lPosition(lRandom));
+            }
+            std::vector<float> lDistances(kEvalPoints);
+            const double lSeconds = TimeStage(mOptions.mRepeat, [&]() { lEvaluator.Evaluate(lPoints.data(), lPoints.size(), lDistances.data()); });
+            AddResult(aName, lStrokesCount, EBenchStage::EVAL, lSeconds, double(kEvalPoints) * double(lStrokesCount));
+        }
+
+        sbx::TTexture lLut;
+        std::vector<uint32_t> lSlotList;
+        CSdfLutBaker lLutBaker;
+        TSdfBrickAtlas lAtlas;
+        const bool lNeedsAtlas = IsEnabled(EBenchStage::ATLAS_BAKE) || IsEnabled(EBenchStage::RENDER_ATLAS);
+        if (IsEnabled(EBenchStage::LUT_BAKE) || lNeedsAtlas)
+        {
+            const double lSeconds = TimeStage(mOptions.mRepeat, [&]() { lLutBaker.Bake(lEvaluator, mBakeParams, lLut, &lSlotList); });
+            if (IsEnabled(EBenchStage::LUT_BAKE))
+            {
+                AddResult(aName, lStrokesCount, EBenchStage::LUT_BAKE, lSeconds, double(mBakeParams.GetLutVoxelsCount()));
+            }
+        }
+
+        if (lNeedsAtlas)
+        {
+            CSdfAtlasBaker lAtlasBaker;
+            CSdfCullGrid const* lCullGrid = mBakeParams.mCullStrokes ? &lLutBaker.GetCullGrid() : nullptr;
+            const double lSeconds = TimeStage(mOptions.mRepeat, [&]() { lAtlasBaker.Bake(lEvaluator, mBakeParams, lSlotList, lAtlas, lCullGrid); });
+            if (IsEnabled(EBenchStage::ATLAS_BAKE))
+            {
+                AddResult(aName, lStrokesCount, EBenchStage::ATLAS_BAKE, lSeconds, double(lAtlas.mBricks.size()));
+            }
+        }
+
+        // Edits of one stroke each, like moving strokes one by one in the editor
+        if ((IsEnabled(EBenchStage::UNDO_PUSH) || IsEnabled(EBenchStage::UNDO_POP)) && lStrokesCount > 0)
+        {
+            double lPushSeconds = 0.0;
+            double lPopSeconds = 0.0;
+            for (uint32_t r = 0; r < mOptions.mRepeat; r++)
+            {
+                aScene.mStack->Reset();
+                aScene.mStack->PushState(EPushStateFlags::EPE_ALL);
+
+                auto lStart = std::chrono::steady_clock::now();
+                for (uint32_t e = 0; e < kUndoEdits; e++)
+                {
+                    aScene.mStrokesArray[(e * 7919u) % lStrokesCount].posb.x += 0.01f;
+                    aScene.mStack->PushState(EPushStateFlags::EPE_STROKES_ALL);
+                }
+                const double lPush = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStart).count();
+
+                lStart = std::chrono::steady_clock::now();
+                while (aScene.mStack->PopState())
+                {
+                }
+                const double lPop = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStart).count();
+
+                lPushSeconds = (r == 0) ? lPush : std::min(lPushSeconds, lPush);
+                lPopSeconds = (r == 0) ? lPop : std::min(lPopSeconds, lPop);
+            }
+
+            if (IsEnabled(EBenchStage::UNDO_PUSH))
+            {
+                AddResult(aName, lStrokesCount, EBenchStage::UNDO_PUSH, lPushSeconds, double(kUndoEdits));
+            }
+            if (IsEnabled(EBenchStage::UNDO_POP))
+            {
+                AddResult(aName, lStrokesCount, EBenchStage::UNDO_POP, lPopSeconds, double(kUndoEdits));
+            }
+        }
+
+        // Default camera of the scene, square images
+        aScene.mCamera.UpdateAspect(float(mRenderParams.mWidth), float(mRenderParams.mHeight));
+        const glm::mat4 lView = aScene.mCamera.GetViewMatrix();
+        const glm::mat4 lProjection = aScene.mCamera.GetProjectionMatrix();
+        const double lRays = double(mRenderParams.mWidth) * double(mRenderParams.mHeight);
+        CSdfRaymarcher lRaymarcher;
+        sbx::TTexture lImage;
+
+        if (IsEnabled(EBenchStage::RENDER_STROKES))
+        {
+            if (lStrokesCount <= mOptions.mRenderMaxStrokes)
+            {
+                const double lSeconds = TimeStage(mOptions.mRepeat, [&]() { lRaymarcher.RenderStrokes(lEvaluator, aScene.mGlobalMaterial, lView, lProjection, mRenderParams, lImage); });
+                AddResult(aName, lStrokesCount, EBenchStage::RENDER_STROKES, lSeconds, lRays);
+            }
+            else
+            {
+                printf("  %-16s skipped, over %u strokes\n", sStageNames[EBenchStage::RENDER_STROKES], mOptions.mRenderMaxStrokes);
+            }
+        }
+
+        if (IsEnabled(EBenchStage::RENDER_ATLAS))
+        {
+            const double lSeconds = TimeStage(mOptions.mRepeat, [&]() { lRaymarcher.RenderAtlas(lLut, lAtlas, mBakeParams, aScene.mGlobalMaterial, lView, lProjection, mRenderParams, lImage); });
+            AddResult(aName, lStrokesCount, EBenchStage::RENDER_ATLAS, lSeconds, lRays);
+        }
+    }
+
+    bool WriteJson(std::string const& aPath, TBenchOptions const& aOptions, std::vector<TBenchResult> const& aResults)
+    {
+        nlohmann::json lRoot;
+        lRoot["version"] = kBenchVersion;
+        lRoot["threads"] = (aOptions.mThreads > 0) ? aOptions.mThreads : sbx::GetHardwareThreadsCount();
+        lRoot["lut_size"] = aOptions.mLutSize;
+        lRoot["render_size"] = aOptions.mRenderSize;
+        lRoot["seed"] = aOptions.mSeed;
+
+        nlohmann::json& lResults = lRoot["results"];
+        lResults = nlohmann::json::array();
+        for (TBenchResult const& lResult : aResults)
+        {
+            lResults.push_back({
+                { "scene", lResult.mScene },
+                { "strokes", lResult.mStrokes },
+                { "stage", sStageNames[lResult.mStage] },
+                { "seconds", lResult.mSeconds },
+                { "throughput", lResult.mThroughput },
+                { "unit", sStageUnits[lResult.mStage] },
+            });
+        }
+
+        std::ofstream lOutput(aPath);
+        lOutput << lRoot.dump(2) << std::endl;
+        lOutput.close();
+        return !lOutput.fail();
+    }
+
+    bool WriteCsv(std::string const& aPath, std::vector<TBenchResult> const& aResults)
+    {
+        FILE* lFile = fopen(aPath.c_str(), "w");
+        if (lFile == nullptr)
+        {
+            return false;
+        }
+
+        fprintf(lFile, "scene,strokes,stage,seconds,throughput,unit\n");
+        for (TBenchResult const& lResult : aResults)
+        {
+            fprintf(lFile, "%s,%u,%s,%.6f,%.6g,%s\n", lResult.mScene.c_str(), lResult.mStrokes, sStageNames[lResult.mStage],
+                lResult.mSeconds, lResult.mThroughput, sStageUnits[lResult.mStage]);
+        }
+        return fclose(lFile) == 0;
+    }
+
+    // Returns the regressions count, or -1 when the baseline can't be used
+    int32_t CompareWithBaseline(std::string const& aPath, TBenchOptions const& aOptions, std::vector<TBenchResult> const& aResults)
+    {
+        std::ifstream lInput(aPath);
+        nlohmann::json lRoot = nlohmann::json::parse(lInput, nullptr, false);
+        if (lRoot.is_discarded() || !lRoot.is_object() || !lRoot["results"].is_array())
+        {
+            fprintf(stderr, "Unable to read the baseline [%s]\n", aPath.c_str());
+            return -1;
+        }
+
+        if (lRoot.value("version", 0) != kBenchVersion)
+        {
+            fprintf(stderr, "Baseline [%s] is from another sdfbench version\n", aPath.c_str());
+            return -1;
+        }
+
+        if (lRoot.value("lut_size", 0) != aOptions.mLutSize || lRoot.value("render_size", 0) != aOptions.mRenderSize || lRoot.value("seed", 0u) != aOptions.mSeed)
+        {
+            printf("Warning: the baseline used other resolutions or seed, the times may not compare\n");
+        }
+
+        printf("\nCompared with %s (%+.0f%% threshold):\n", aPath.c_str(), aOptions.mThreshold * 100.0);
+        int32_t lRegressions = 0;
+        for (TBenchResult const& lResult : aResults)
+        {
+            const char* lStageName = sStageNames[lResult.mStage];
+            auto lBase = std::find_if(lRoot["results"].begin(), lRoot["results"].end(), [&](nlohmann::json const& aEntry)
+            {
+                return aEntry.value("scene", "") == lResult.mScene && aEntry.value("stage", "") == lStageName;
+            });
+
+            if (lBase == lRoot["results"].end())
+            {
+                printf("  %-24s %-16s %10.4f s  not in the baseline\n", lResult.mScene.c_str(), lStageName, lResult.mSeconds);
+                continue;
+            }
+
+            const double lBaseSeconds = lBase->value("seconds", 0.0);
+            const double lChange = (lBaseSeconds > 0.0) ? (lResult.mSeconds / lBaseSeconds) - 1.0 : 0.0;
+            const bool lRegression = (lChange > aOptions.mThreshold) && ((lResult.mSeconds - lBaseSeconds) > kMinRegressionSeconds);
+            lRegressions += lRegression ? 1 : 0;
+            printf("  %-24s %-16s %10.4f s  %10.4f s  %+7.1f%%%s\n", lResult.mScene.c_str(), lStageName, lResult.mSeconds, lBaseSeconds, lChange * 100.0,
+                lRegression ? "  REGRESSION" : "");
+        }
+
+        printf("%d regressions\n", lRegressions);
+        return lRegressions;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    TBenchOptions lOptions;
+    if (!ParseOptions(argc, argv, lOptions))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    CBench lBench(lOptions);
+
+    // Every scene of the examples directory, sorted to keep the output stable
+    std::vector<std::filesystem::path> lExamples;
+    std::error_code lError;
+    if (!lOptions.mExamplesDir.empty())
+    {
+        for (std::filesystem::directory_entry const& lFile : std::filesystem::directory_iterator(lOptions.mExamplesDir, lError))
+        {
+            const std::filesystem::path lExtension = lFile.path().extension();
+            if (lFile.is_regular_file(lError) && (lExtension == ".strks" || lExtension == ".strkb"))
+            {
+                lExamples.push_back(lFile.path());
+            }
+        }
+        if (lError)
+        {
+            fprintf(stderr, "Unable to list [%s]\n", lOptions.mExamplesDir.c_str());
+        }
+        std::sort(lExamples.begin(), lExamples.end());
+    }
+
+    uint32_t lFailed = 0;
+    for (std::filesystem::path const& lPath : lExamples)
+    {
+        CScene lScene;
+        lScene.mDocument->SetFilePath(lPath.string());
+        if (!lScene.mDocument->Load())
+        {
+            fprintf(stderr, "Unable to load [%s]\n", lPath.string().c_str());
+            lFailed++;
+            continue;
+        }
+        lBench.Run(lPath.filename().string(), lScene);
+    }
+
+    for (uint32_t lSize : lOptions.mSyntheticSizes)
+    {
+        TSceneGeneratorParams lParams;
+        lParams.mSeed = lOptions.mSeed;
+        lParams.mStrokesCount = lSize;
+        CScene lScene;
+        CSceneGenerator::Generate(lParams, lScene);
+        lBench.Run("synthetic_" + std::to_string(lSize), lScene);
+    }
+
+    if (!lOptions.mJsonPath.empty() && !WriteJson(lOptions.mJsonPath, lOptions, lBench.GetResults()))
+    {
+        fprintf(stderr, "Unable to write [%s]\n", lOptions.mJsonPath.c_str());
+        lFailed++;
+    }
+
+    if (!lOptions.mCsvPath.empty() && !WriteCsv(lOptions.mCsvPath, lBench.GetResults()))
+    {
+        fprintf(stderr, "Unable to write [%s]\n", lOptions.mCsvPath.c_str());
+        lFailed++;
+    }
+
+    if (!lOptions.mBaselinePath.empty())
+    {
+        const int32_t lRegressions = CompareWithBaseline(lOptions.mBaselinePath, lOptions, lBench.GetResults());
+        if (lRegressions < 0)
+        {
+            return 1;
+        }
+        if (lRegressions > 0)
+        {
+            return 2;
+        }
+    }
+
+    return (lFailed == 0) ? 0 : 1;
+}
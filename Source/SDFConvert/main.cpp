@@ -0,0 +1,46 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Converts scenes between the JSON (.strks) and binary (.strkb) formats
+
+#include <SDFEditor/Tool/Scene.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: sdfconvert <input.strks|input.strkb> <output.strks|output.strkb>\n");
+        fprintf(stderr, "       the format of each file follows its extension\n");
+        return 1;
+    }
+
+    const std::string lInputPath = argv[1];
+    const std::string lOutputPath = argv[2];
+
+    CScene lScene;
+
+    const auto lLoadStart = std::chrono::steady_clock::now();
+    lScene.mDocument->SetFilePath(lInputPath);
+    if (!lScene.mDocument->Load())
+    {
+        fprintf(stderr, "Unable to load [%s]\n", lInputPath.c_str());
+        return 1;
+    }
+
+    const auto lSaveStart = std::chrono::steady_clock::now();
+    lScene.mDocument->SetFilePath(lOutputPath);
+    if (!lScene.mDocument->Save())
+    {
+        fprintf(stderr, "Unable to save [%s]\n", lOutputPath.c_str());
+        return 1;
+    }
+    const auto lSaveEnd = std::chrono::steady_clock::now();
+
+    printf("%zu strokes, load %.3f s, save %.3f s\n", lScene.mStrokesArray.size(),
+        std::chrono::duration<double>(lSaveStart - lLoadStart).count(),
+        std::chrono::duration<double>(lSaveEnd - lSaveStart).count());
+
+    return 0;
+}
@@ -4,6 +4,11 @@
 
 #include "ThirdParty/glad/glad.h"
 
+#include <sbx/Core/ErrorHandling.h>
+
+#include <algorithm>
+#include <cstring>
+
 GLenum sGPUBufferBindTarget[] =
 {
     GL_UNIFORM_BUFFER,
@@ -23,6 +28,19 @@ CGPUBufferObject::CGPUBufferObject(EGPUBufferBindTarget::Type aTarget)
 
 CGPUBufferObject::~CGPUBufferObject()
 {
+    for (void* lFence : mRingFences)
+    {
+        if (lFence)
+        {
+            glDeleteSync(GLsync(lFence));
+        }
+    }
+
+    if (mRingMapping)
+    {
+        glUnmapNamedBuffer(mBufferHandler);
+    }
+
     glDeleteBuffers(1, &mBufferHandler);
 }
 
@@ -32,6 +50,8 @@ void CGPUBufferObject::SetData(size_t aSize, void* aData, uint32_t aFlags)
     lFlags |= (aFlags & EGPUBufferFlags::DYNAMIC_STORAGE) ? GL_DYNAMIC_STORAGE_BIT : 0;
     lFlags |= (aFlags & EGPUBufferFlags::MAP_READ_BIT) ? GL_MAP_READ_BIT : 0;
     lFlags |= (aFlags & EGPUBufferFlags::MAP_WRITE_BIT) ? GL_MAP_WRITE_BIT : 0;
+    lFlags |= (aFlags & EGPUBufferFlags::MAP_PERSISTENT_BIT) ? GL_MAP_PERSISTENT_BIT : 0;
+    lFlags |= (aFlags & EGPUBufferFlags::MAP_COHERENT_BIT) ? GL_MAP_COHERENT_BIT : 0;
     glNamedBufferStorage(mBufferHandler, aSize, aData, lFlags);
     mStorageSize = aSize;
 }
@@ -41,6 +61,11 @@ void CGPUBufferObject::UpdateSubData(intptr_t aOffset, size_t aSize, void* aData
     glNamedBufferSubData(mBufferHandler, aOffset, aSize, aData);
 }
 
+void CGPUBufferObject::GetSubData(intptr_t aOffset, size_t aSize, void* aOutData)
+{
+    glGetNamedBufferSubData(mBufferHandler, aOffset, aSize, aOutData);
+}
+
 void* CGPUBufferObject::Map()
 {
     return glMapNamedBuffer(mBufferHandler, GL_WRITE_ONLY);
@@ -51,6 +76,85 @@ void CGPUBufferObject::Unmap()
     glUnmapNamedBuffer(mBufferHandler);
 }
 
+bool CGPUBufferObject::SetRingData(size_t aRegionSize, uint32_t aRegionsCount)
+{
+    SBX_ASSERT(!IsRing() && mStorageSize == 0, "Buffer storage is immutable, the ring needs a new buffer");
+    SBX_ASSERT(aRegionsCount > 0, "Ring without regions");
+
+    // Each region can be bound on its own, keep them aligned for both targets
+    GLint lUniformAlignment = 256;
+    GLint lStorageAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &lUniformAlignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &lStorageAlignment);
+    const size_t lAlignment = size_t(std::max(std::max(lUniformAlignment, lStorageAlignment), 16));
+
+    mRingRegionSize = aRegionSize;
+    mRingRegionStride = ((aRegionSize + lAlignment - 1) / lAlignment) * lAlignment;
+    mRingRegion = aRegionsCount - 1;
+    mRingStallsCount = 0;
+    mRingFences.assign(aRegionsCount, nullptr);
+
+    const GLbitfield lFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    mStorageSize = mRingRegionStride * aRegionsCount;
+    glNamedBufferStorage(mBufferHandler, mStorageSize, nullptr, lFlags);
+    mRingMapping = (uint8_t*)glMapNamedBufferRange(mBufferHandler, 0, mStorageSize, lFlags);
+    if (!mRingMapping)
+    {
+        SBX_LOG("Unable to map the ring buffer persistently (%zu bytes)", mStorageSize);
+        mRingFences.clear();
+        return false;
+    }
+
+    ::memset(mRingMapping, 0, mStorageSize);
+    return true;
+}
+
+void* CGPUBufferObject::BeginRingRegion()
+{
+    SBX_ASSERT(IsRing(), "BeginRingRegion on a buffer without ring storage");
+
+    mRingRegion = (mRingRegion + 1) % GetRingRegionsCount();
+    WaitRingFence(mRingRegion);
+    return mRingMapping + GetRingRegionOffset();
+}
+
+void CGPUBufferObject::FenceRingRegion()
+{
+    SBX_ASSERT(IsRing(), "FenceRingRegion on a buffer without ring storage");
+
+    // Only the last use matters, the region is free once the last reader is done
+    void*& lFence = mRingFences[mRingRegion];
+    if (lFence)
+    {
+        glDeleteSync(GLsync(lFence));
+    }
+    lFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void CGPUBufferObject::WaitRingFence(uint32_t aRegion)
+{
+    void*& lFence = mRingFences[aRegion];
+    if (!lFence)
+    {
+        return;
+    }
+
+    // Flush on the first try, otherwise the fence could never reach the GPU
+    GLenum lResult = glClientWaitSync(GLsync(lFence), GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (lResult == GL_TIMEOUT_EXPIRED)
+    {
+        mRingStallsCount++;
+        do
+        {
+            lResult = glClientWaitSync(GLsync(lFence), 0, 1000000000ull);
+        } while (lResult == GL_TIMEOUT_EXPIRED);
+    }
+
+    SBX_ASSERT(lResult != GL_WAIT_FAILED, "Wait on the ring region fence failed");
+    glDeleteSync(GLsync(lFence));
+    lFence = nullptr;
+}
+
 void CGPUBufferObject::BindShaderStorage(uint32_t aBindingIndex)
 {
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, aBindingIndex, mBufferHandler);
@@ -61,6 +165,16 @@ void CGPUBufferObject::BindUniformBuffer(uint32_t aBindingIndex)
     glBindBufferBase(GL_UNIFORM_BUFFER, aBindingIndex, mBufferHandler);
 }
 
+void CGPUBufferObject::BindShaderStorageRange(uint32_t aBindingIndex, intptr_t aOffset, size_t aSize)
+{
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, aBindingIndex, mBufferHandler, aOffset, aSize);
+}
+
+void CGPUBufferObject::BindUniformBufferRange(uint32_t aBindingIndex, intptr_t aOffset, size_t aSize)
+{
+    glBindBufferRange(GL_UNIFORM_BUFFER, aBindingIndex, mBufferHandler, aOffset, aSize);
+}
+
 void CGPUBufferObject::BindTarget(EGPUBufferBindTarget::Type aBindTarget)
 {
     glBindBuffer(sGPUBufferBindTarget[aBindTarget], mBufferHandler);
@@ -4,6 +4,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 using CGPUBufferObjectRef = std::shared_ptr<class CGPUBufferObject>;
 
@@ -13,6 +14,8 @@ namespace EGPUBufferFlags
     {
         MAP_READ_BIT = 0x0001,
         MAP_WRITE_BIT = 0x0002,
+        MAP_PERSISTENT_BIT = 0x0040,
+        MAP_COHERENT_BIT = 0x0080,
         DYNAMIC_STORAGE = 0x0100,
         ALL = MAP_READ_BIT | MAP_WRITE_BIT | DYNAMIC_STORAGE,
     };
@@ -39,22 +42,56 @@ public:
 
     void SetData(size_t aSize, void* aData, uint32_t aFlags = EGPUBufferFlags::ALL);
     void UpdateSubData(intptr_t aOffset, size_t aSize, void* aData);
+    void GetSubData(intptr_t aOffset, size_t aSize, void* aOutData);
 
     void* Map();
     void Unmap();
 
+    // Ring mode: persistent coherent storage split in aRegionsCount regions, mapped
+    // once. The CPU writes one region while the GPU may still read the others,
+    // each region is fenced after its last use and only waited on when reused.
+    // Returns false if the storage can't be mapped.
+    bool SetRingData(size_t aRegionSize, uint32_t aRegionsCount);
+
+    // Moves to the next region and returns its mapped memory, waits on its fence if the GPU still reads it
+    void* BeginRingRegion();
+
+    // Fences the current region after the commands issued so far, call once per frame after the last draw using it
+    void FenceRingRegion();
+
+    bool IsRing() const { return mRingMapping != nullptr; }
+    uint32_t GetRingRegionIndex() const { return mRingRegion; }
+    uint32_t GetRingRegionsCount() const { return uint32_t(mRingFences.size()); }
+    size_t GetRingRegionSize() const { return mRingRegionSize; }
+    intptr_t GetRingRegionOffset() const { return intptr_t(mRingRegion * mRingRegionStride); }
+
+    // Times BeginRingRegion() found the region still in use by the GPU
+    uint32_t GetRingStallsCount() const { return mRingStallsCount; }
+
     uint32_t GetHandler() const { return mBufferHandler; }
     size_t GetStorageSize() const { return mStorageSize; }
 
     void BindShaderStorage(uint32_t aBindingIndex);
     void BindUniformBuffer(uint32_t aBindingIndex);
+    void BindShaderStorageRange(uint32_t aBindingIndex, intptr_t aOffset, size_t aSize);
+    void BindUniformBufferRange(uint32_t aBindingIndex, intptr_t aOffset, size_t aSize);
 
     void BindTarget(EGPUBufferBindTarget::Type aBindTarget);
     void UnbindTarget(EGPUBufferBindTarget::Type aBindTarget);
 
 private:
+    void WaitRingFence(uint32_t aRegion);
+
     uint32_t mBufferHandler;
     size_t mStorageSize;
 
+    // Ring mode
+    uint8_t* mRingMapping{ nullptr };
+    size_t mRingRegionSize{ 0 };
+    size_t mRingRegionStride{ 0 };
+    uint32_t mRingRegion{ 0 };
+    uint32_t mRingStallsCount{ 0 };
+    std::vector<void*> mRingFences;     // GLsync per region, null when not in use
+
     EGPUBufferBindTarget::Type mTarget;
 };
\ No newline at end of file
@@ -137,3 +137,44 @@ void CGPUTexture::UpdateData(const void* aData)
     }
 }
 
+void CGPUTexture::UpdateSubData(int32_t aX, int32_t aY, int32_t aZ, uint32_t aWidth, uint32_t aHeight, uint32_t aDepth,
+                                const void* aData, uint32_t aRowLength, uint32_t aImageHeight)
+{
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, aRowLength);
+    glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, aImageHeight);
+
+    if (mTarget == GL_TEXTURE_3D)
+    {
+        glTextureSubImage3D(mTextureHandler, 0, aX, aY, aZ, aWidth, aHeight, aDepth,
+            sTexFormatSimple[mConfig.mFormat], sTexFormatDataType[mConfig.mFormat],
+            aData);
+    }
+    else if (mTarget == GL_TEXTURE_2D)
+    {
+        glTextureSubImage2D(mTextureHandler, 0, aX, aY, aWidth, aHeight,
+            sTexFormatSimple[mConfig.mFormat], sTexFormatDataType[mConfig.mFormat],
+            aData);
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+}
+
+void CGPUTexture::GetSubData(int32_t aX, int32_t aY, int32_t aZ, uint32_t aWidth, uint32_t aHeight, uint32_t aDepth,
+                             size_t aBufferSize, void* aOutData)
+{
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureSubImage(mTextureHandler, 0, aX, aY, aZ, aWidth, aHeight, aDepth,
+        sTexFormatSimple[mConfig.mFormat], sTexFormatDataType[mConfig.mFormat],
+        GLsizei(aBufferSize), aOutData);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+}
+
+void CGPUTexture::CopySubData(int32_t aSrcX, int32_t aSrcY, int32_t aSrcZ, int32_t aDstX, int32_t aDstY, int32_t aDstZ,
+                              uint32_t aWidth, uint32_t aHeight, uint32_t aDepth)
+{
+    glCopyImageSubData(mTextureHandler, mTarget, 0, aSrcX, aSrcY, aSrcZ,
+                       mTextureHandler, mTarget, 0, aDstX, aDstY, aDstZ,
+                       aWidth, aHeight, aDepth);
+}
+
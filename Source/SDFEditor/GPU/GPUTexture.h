@@ -84,6 +84,19 @@ public:
     void BindImage(uint32_t aBinding, uint32_t aMip, EImgAccess::Type aAccess);
     void SetFilters(ETexFilter::Type aMinFilters, ETexFilter::Type aMagFilter);
     void UpdateData(const void* aData);
+
+    // 3D box of the first mip, aData points to its first texel inside rows of
+    // aRowLength texels and slices of aImageHeight rows (0 = box size)
+    void UpdateSubData(int32_t aX, int32_t aY, int32_t aZ, uint32_t aWidth, uint32_t aHeight, uint32_t aDepth,
+                       const void* aData, uint32_t aRowLength = 0, uint32_t aImageHeight = 0);
+
+    // Reads back a tightly packed 3D box of the first mip, waits for the GPU
+    void GetSubData(int32_t aX, int32_t aY, int32_t aZ, uint32_t aWidth, uint32_t aHeight, uint32_t aDepth,
+                    size_t aBufferSize, void* aOutData);
+
+    // Copies a 3D box of the first mip to another place of the same texture, boxes must not overlap
+    void CopySubData(int32_t aSrcX, int32_t aSrcY, int32_t aSrcZ, int32_t aDstX, int32_t aDstY, int32_t aDstZ,
+                     uint32_t aWidth, uint32_t aHeight, uint32_t aDepth);
 private:
     TGPUTextureConfig mConfig;
 
@@ -14,18 +14,21 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
 namespace EUniformLoc
 {
     enum Type
     {
-        uViewMatrix = 0,
-        uProjectionMatrix = 1,
         uRoughnessMap = 2,
 
         uStrokesNum = 20,
         uMaxSlotsCount = 21,
         uVoxelSide = 22,
         uVolumeExtent = 23,
+        uBricksCount = 24,
 
         uSdfLutTexture = 30,
         uSdfAtlasTexture = 31,
@@ -50,12 +53,19 @@ namespace EBlockBinding
     enum Type
     {
         strokes_buffer = 0,
-        slot_list_buffer = 1,
-        slot_count_buffer = 2,
+        brick_list_buffer = 1,
         global_material = 3,
+        frame_data = 4,
     };
 };
 
+// std140 frame_data block
+struct TFrameBufferData
+{
+    glm::mat4 mViewMatrix;
+    glm::mat4 mProjectionMatrix;
+};
+
 #define LUT_RES (128)
 //#define 
 
@@ -77,10 +87,24 @@ void CRenderer::Init()
     SBX_LOG("GL_MAX_COMPUTE_WORK_GROUP_SIZE: (%d, %d, %d)", workGroupSizes[0], workGroupSizes[1], workGroupSizes[2]);
     SBX_LOG("GL_MAX_COMPUTE_WORK_GROUP_COUNT: (%d, %d, %d)", workGroupCounts[0], workGroupCounts[1], workGroupCounts[2]);
 
-    // Strokes buffer
-    mStrokesBuffer = std::make_shared<CGPUBufferObject>(EGPUBufferBindTarget::SHADER_BUFFER_STORAGE);
-    mStrokesBuffer->SetData(16 * sizeof(stroke_t), nullptr, EGPUBufferFlags::DYNAMIC_STORAGE);
-    mStrokesBuffer->BindShaderStorage(EBlockBinding::strokes_buffer);
+    const char* lBufferMode = ::getenv("SDFEDITOR_BUFFER_MODE");
+    mBufferUploadMode = (lBufferMode && ::strcmp(lBufferMode, "subdata") == 0) ? EBufferUploadMode::SUB_DATA : EBufferUploadMode::PERSISTENT_RING;
+
+    // Stream buffers, written by the CPU every frame or on each edit
+    mStrokesBuffer = CreateStreamBuffer(EGPUBufferBindTarget::SHADER_BUFFER_STORAGE, 16 * sizeof(stroke_t));
+    mMaterialBuffer = CreateStreamBuffer(EGPUBufferBindTarget::UNIFORM_BUFFER, sizeof(TGlobalMaterialBufferData));
+    mFrameBuffer = CreateStreamBuffer(EGPUBufferBindTarget::UNIFORM_BUFFER, sizeof(TFrameBufferData));
+    // Ring regions are bound again each time one is written
+    mStrokesBuffer->BindShaderStorageRange(EBlockBinding::strokes_buffer, mStrokesBuffer->GetRingRegionOffset(), mStrokesBuffer->GetStorageSize() - mStrokesBuffer->GetRingRegionOffset());
+    mMaterialBuffer->BindUniformBufferRange(EBlockBinding::global_material, mMaterialBuffer->GetRingRegionOffset(), sizeof(TGlobalMaterialBufferData));
+    mFrameBuffer->BindUniformBufferRange(EBlockBinding::frame_data, mFrameBuffer->GetRingRegionOffset(), sizeof(TFrameBufferData));
+    for (TStrokesRingRegion& lRegion : mStrokesRingRegions)
+    {
+        lRegion.mPendingRanges.clear();
+        lRegion.mFullCopy = true;
+    }
+
+    SBX_LOG("GL_RENDERER: %s, buffer uploads: %s", (const char*)glGetString(GL_RENDERER), (mBufferUploadMode == EBufferUploadMode::PERSISTENT_RING) ? "persistent ring" : "sub data");
 
     // SDF Lut texture
     TGPUTextureConfig lSdfLutConfig;
@@ -112,24 +136,20 @@ void CRenderer::Init()
     lSdfAtlasConfig.mMips = 1;
     mSdfAtlas = std::make_shared<CGPUTexture>(lSdfAtlasConfig);
 
-    // Slot list buffer
-    mSlotListBuffer = std::make_shared<CGPUBufferObject>(EGPUBufferBindTarget::SHADER_BUFFER_STORAGE);
-    size_t lListSize = size_t(lSdfLutConfig.mExtentX) * 
-                       size_t(lSdfLutConfig.mExtentY) * 
-                       size_t(lSdfLutConfig.mSlices) * 
-                       sizeof(uint32_t);
-    mSlotListBuffer->SetData(lListSize, nullptr, EGPUBufferFlags::DYNAMIC_STORAGE);
-    mSlotListBuffer->BindShaderStorage(EBlockBinding::slot_list_buffer);
+    // Brick list buffer, grows with the bricks of each bake
+    mBrickListBuffer = std::make_shared<CGPUBufferObject>(EGPUBufferBindTarget::SHADER_BUFFER_STORAGE);
+    mBrickListBuffer->SetData(1024 * sizeof(CSdfVolume::TBrick), nullptr, EGPUBufferFlags::DYNAMIC_STORAGE);
+    mBrickListBuffer->BindShaderStorage(EBlockBinding::brick_list_buffer);
 
-    // Atomic Counter buffer
-    mSlotCounterBuffer = std::make_shared<CGPUBufferObject>(EGPUBufferBindTarget::SHADER_BUFFER_STORAGE);
-    mSlotCounterBuffer->SetData(sizeof(uint32_t) * 3, nullptr, EGPUBufferFlags::DYNAMIC_STORAGE);
-    mSlotCounterBuffer->BindShaderStorage(EBlockBinding::slot_count_buffer);
+    // Baked distances are exact up to the cull margin, the dirty bounds cover the voxels that can change,
+    // padded by the blends after the changed strokes
+    mBakedStrokesBounds.SetFieldMargin(mBakeParams.mCullMargin);
+    mEvaluator.SetKernel(ESdfKernel::Auto);
+    mSdfVolume.Init(mBakeParams);
+    mSdfLut->UpdateData(mSdfVolume.GetLut().AsRGBA8Buffer());
 
-    // Material Buffer
-    mMaterialBuffer = std::make_shared<CGPUBufferObject>(EGPUBufferBindTarget::UNIFORM_BUFFER);
-    mMaterialBuffer->SetData(sizeof(TGlobalMaterialBufferData), nullptr, EGPUBufferFlags::DYNAMIC_STORAGE);
-    mMaterialBuffer->BindUniformBuffer(EBlockBinding::global_material);
+    const char* lCacheDir = ::getenv("SDFEDITOR_CACHE_DIR");
+    mVolumeCache.Init((lCacheDir != nullptr) ? lCacheDir : "./Cache/Volumes");
 
 
     // Default 8x8 white roughness texture in case nothing is specified in shading settings.
@@ -179,13 +199,6 @@ void CRenderer::ReloadShaders()
     // Shared SDF code
     CShaderCodeRef lSdfCommonCode = std::make_shared<std::vector<char>>(std::move(ReadFile("./Shaders/SdfCommon.h.glsl")));
     
-    // Compute lut shader program
-    {
-        CShaderCodeRef lComputeLutCode = std::make_shared<std::vector<char>>(std::move(ReadFile("./Shaders/ComputeSdfLut.comp.glsl")));
-        mComputeLutProgram = std::make_shared<CGPUShaderProgram>(CShaderCodeRefList{ lSdfCommonCode, lComputeLutCode }, EShaderSourceType::COMPUTE_SHADER, "ComputeLut");
-        mComputeLutPipeline = std::make_shared<CGPUShaderPipeline>(std::vector<CGPUShaderProgramRef>{ mComputeLutProgram });
-    }
-
     // Compute atlas shader program
     {
         CShaderCodeRef lComputeAtlasCode = std::make_shared<std::vector<char>>(std::move(ReadFile("./Shaders/ComputeSdfAtlas.comp.glsl")));
@@ -209,14 +222,13 @@ void CRenderer::ReloadShaders()
     // Static uniforms
     const std::vector<uint32_t> lProgramHandlers
     {
-        mComputeLutProgram->GetHandler(),
         mComputeAtlasProgram->GetHandler(),
         mColorFragmentProgram->GetHandler()
     };
 
     for (uint32_t lHandler : lProgramHandlers)
     {
-        glProgramUniform1ui(lHandler, EUniformLoc::uMaxSlotsCount, 491520);
+        glProgramUniform1ui(lHandler, EUniformLoc::uMaxSlotsCount, mBakeParams.mMaxSlots);
         float lVoxelExt = 0.05f;
         float lLutSize = float(LUT_RES);
         glProgramUniform4f(lHandler, EUniformLoc::uVoxelSide, lVoxelExt, 1.0f / lVoxelExt, lVoxelExt / 8.0f, 1.0f / (lVoxelExt / 8.0f));
@@ -224,75 +236,120 @@ void CRenderer::ReloadShaders()
         glProgramUniform1i(lHandler, EUniformLoc::uSdfLutTexture, ETexBinding::uSdfLut);
         glProgramUniform1i(lHandler, EUniformLoc::uSdfAtlasTexture, ETexBinding::uSdfAtlas);
     }
+
+    mFullBakePending = true;
 }
 
 void CRenderer::UpdateSceneData(CScene const& aScene)
 {
+    mFrameUploadedBytes = 0;
+    mFrameStrokesUploadedBytes = 0;
+    mFrameStrokesUploadCalls = 0;
+
     if (aScene.IsDirty())
     {
-        size_t lSizeBytes = aScene.mStrokesArray.size() * sizeof(stroke_t);
-
-        if (lSizeBytes > mStrokesBuffer->GetStorageSize())
-        {
-            mStrokesBuffer = std::make_shared<CGPUBufferObject>(EGPUBufferBindTarget::SHADER_BUFFER_STORAGE);
-            mStrokesBuffer->SetData(lSizeBytes + (16 * sizeof(stroke_t)), nullptr, EGPUBufferFlags::DYNAMIC_STORAGE);
-            mStrokesBuffer->BindShaderStorage(EBlockBinding::strokes_buffer);
-        }
-
-        //stroke_t* lStrokesBufferMappedMemory = (stroke_t*)mStrokesBuffer->Map();
-        for (size_t i = 0; i < aScene.mStrokesArray.size(); i++)
-        {
-            //::memcpy(lStrokesBufferMappedMemory + i, (void*)&aScene.mStrokesArray[i], sizeof(stroke_t));
-            mStrokesBuffer->UpdateSubData(sizeof(stroke_t) * i, sizeof(stroke_t), (void*)&aScene.mStrokesArray[i]);
-        }
-        //mStrokesBuffer->Unmap();
+        std::vector<stroke_t> const& lStrokes = aScene.GetPackedStrokes();
+        UploadStrokes(aScene);
+        mFrameUploadedBytes += mFrameStrokesUploadedBytes;
 
         const std::vector<uint32_t> lProgramHandlers
         {
-            mComputeLutProgram->GetHandler(),
             mComputeAtlasProgram->GetHandler(),
             mColorFragmentProgram->GetHandler()
         };
 
         for (uint32_t lHandler : lProgramHandlers)
         {
-            glProgramUniform1ui(lHandler, EUniformLoc::uStrokesNum, aScene.mStrokesArray.size() & 0xFFFFFFFF);
+            glProgramUniform1ui(lHandler, EUniformLoc::uStrokesNum, lStrokes.size() & 0xFFFFFFFF);
         }
 
-        // clear slot count
-        const static uint32_t sZero[] = { 0, 1, 1 };
-        mSlotCounterBuffer->UpdateSubData(0, sizeof(uint32_t) * 3, (void*)sZero);
-
-        // Execute compute lut
-        mComputeLutPipeline->Bind();
-        mSdfLut->BindImage(0, 0, EImgAccess::WRITE_ONLY);
-        const uint32_t dispatchRes = LUT_RES / 8;
-        glDispatchCompute(dispatchRes, dispatchRes, dispatchRes);
-        
-        // Execute compute atlas
-        mComputeAtlasPipeline->Bind();
-        mSlotCounterBuffer->BindTarget(EGPUBufferBindTarget::DISPATCH_INDIRECT_BUFFER);
-        mSdfAtlas->BindImage(0, 0, EImgAccess::WRITE_ONLY);
-        glDispatchComputeIndirect(0);
-        mSlotCounterBuffer->UnbindTarget(EGPUBufferBindTarget::DISPATCH_INDIRECT_BUFFER);
+        // Only the region touched by the changed strokes is rebaked, intersections change everything
+        mBakedStrokesBounds.Update(lStrokes);
+        glm::ivec3 lRegionMin(0);
+        glm::ivec3 lRegionMax(0);
+        if (mFullBakePending || mBakedStrokesBounds.IsDirtyUnbounded())
+        {
+            lRegionMax = glm::ivec3(mBakeParams.mLutSize);
+        }
+        else if (!mBakedStrokesBounds.GetDirtyBounds().IsEmpty())
+        {
+            // Lut voxels whose cell touches the dirty bounds, aligned to the cull cells
+            TAabb const& lDirtyBounds = mBakedStrokesBounds.GetDirtyBounds();
+            const int32_t lCellVoxels = mBakeParams.mCullCellVoxels;
+            const float lInvVoxelSide = 1.0f / mBakeParams.mLutVoxelSide;
+            const glm::vec3 lHalfLut(0.5f * float(mBakeParams.mLutSize));
+            lRegionMin = glm::ivec3(glm::floor(glm::clamp(lDirtyBounds.mMin * lInvVoxelSide + lHalfLut, glm::vec3(0.0f), glm::vec3(mBakeParams.mLutSize))));
+            lRegionMax = glm::ivec3(glm::floor(glm::clamp(lDirtyBounds.mMax * lInvVoxelSide + lHalfLut, glm::vec3(-1.0f), glm::vec3(mBakeParams.mLutSize)))) + 1;
+            lRegionMin = (lRegionMin / lCellVoxels) * lCellVoxels;
+            lRegionMax = glm::min(((lRegionMax + lCellVoxels - 1) / lCellVoxels) * lCellVoxels, glm::ivec3(mBakeParams.mLutSize));
+        }
+
+        // Opening a scene or undoing big changes looks for the whole volume in the cache,
+        // small edits bake faster than a cache entry loads
+        const glm::ivec3 lRegionExtent = glm::max(lRegionMax - lRegionMin, glm::ivec3(0));
+        const size_t lRegionVoxels = size_t(lRegionExtent.x) * size_t(lRegionExtent.y) * size_t(lRegionExtent.z);
+        const bool lCacheLookup = mVolumeCache.IsEnabled() && (lRegionVoxels * kVolumeCacheLookupRatio >= mBakeParams.GetLutVoxelsCount());
+        if (lCacheLookup && RestoreVolumeFromCache(CSdfVolumeCache::ComputeKey(lStrokes, mBakeParams)))
+        {
+            mVolumeCacheStoreCountdown = 0;
+        }
+        else if (lRegionVoxels > 0)
+        {
+            // A cache entry that failed to restore leaves the volume empty
+            if (mFullBakePending)
+            {
+                lRegionMin = glm::ivec3(0);
+                lRegionMax = glm::ivec3(mBakeParams.mLutSize);
+            }
+            BakeVolume(lStrokes, lRegionMin, lRegionMax);
+            mVolumeCacheStoreCountdown = kVolumeCacheStoreDelay;
+        }
+        mFullBakePending = false;
+    }
+
+    if (mVolumeCacheStoreCountdown > 0 && --mVolumeCacheStoreCountdown == 0)
+    {
+        StoreVolumeInCache(CSdfVolumeCache::ComputeKey(aScene.GetPackedStrokes(), mBakeParams));
+    }
+
+    if (mAtlasCompactionPending)
+    {
+        CompactAtlas();
+        mAtlasCompactionPending = false;
     }
 
     if (aScene.IsMaterialDirty())
     {
-        mMaterialBuffer->UpdateSubData(0, sizeof(TGlobalMaterialBufferData), (void*)&aScene.mGlobalMaterial);
+        // Small enough to write whole, no region goes stale
+        if (mMaterialBuffer->IsRing())
+        {
+            ::memcpy(mMaterialBuffer->BeginRingRegion(), &aScene.mGlobalMaterial, sizeof(TGlobalMaterialBufferData));
+            mMaterialBuffer->BindUniformBufferRange(EBlockBinding::global_material, mMaterialBuffer->GetRingRegionOffset(), sizeof(TGlobalMaterialBufferData));
+        }
+        else
+        {
+            mMaterialBuffer->UpdateSubData(0, sizeof(TGlobalMaterialBufferData), (void*)&aScene.mGlobalMaterial);
+        }
+        mFrameUploadedBytes += sizeof(TGlobalMaterialBufferData);
     }
 
     //Update Matrix
-    glm::mat4 lProjection = aScene.mCamera.GetProjectionMatrix(); //glm::perspective(aScene.mCamera.mFOV, aScene.mCamera.mAspect, 0.1f, 100.0f);
-    glm::mat4 lView = aScene.mCamera.GetViewMatrix(); //glm::lookAt(aScene.mCamera.mOrigin, aScene.mCamera.mLookAt, aScene.mCamera.mViewUp);
+    TFrameBufferData lFrameData;
+    lFrameData.mProjectionMatrix = aScene.mCamera.GetProjectionMatrix(); //glm::perspective(aScene.mCamera.mFOV, aScene.mCamera.mAspect, 0.1f, 100.0f);
+    lFrameData.mViewMatrix = aScene.mCamera.GetViewMatrix(); //glm::lookAt(aScene.mCamera.mOrigin, aScene.mCamera.mLookAt, aScene.mCamera.mViewUp);
     //lProjection[1][1] *= -1; // Remember to do this in Vulkan
-    //glm::mat4 lViewProjection = lProjection * lView;
-    //glm::mat4 lInverseViewProjection = glm::inverse(lViewProjection);
 
     // Update program data
-    //glProgramUniformMatrix4fv(mFullscreenVertexProgram->GetHandler(), 0, 1, false, glm::value_ptr(lInverseViewProjection));
-    glProgramUniformMatrix4fv(mFullscreenVertexProgram->GetHandler(), EUniformLoc::uViewMatrix, 1, false, glm::value_ptr(lView));
-    glProgramUniformMatrix4fv(mFullscreenVertexProgram->GetHandler(), EUniformLoc::uProjectionMatrix, 1, false, glm::value_ptr(lProjection));
+    if (mFrameBuffer->IsRing())
+    {
+        ::memcpy(mFrameBuffer->BeginRingRegion(), &lFrameData, sizeof(TFrameBufferData));
+        mFrameBuffer->BindUniformBufferRange(EBlockBinding::frame_data, mFrameBuffer->GetRingRegionOffset(), sizeof(TFrameBufferData));
+    }
+    else
+    {
+        mFrameBuffer->UpdateSubData(0, sizeof(TFrameBufferData), &lFrameData);
+    }
+    mFrameUploadedBytes += sizeof(TFrameBufferData);
     glProgramUniform4i(mColorFragmentProgram->GetHandler(), EUniformLoc::uVoxelPreview, aScene.mUseVoxels ? 1 : 0, aScene.mPreviewSlice, 0, 0);
 
 #if DEBUG
@@ -303,6 +360,318 @@ void CRenderer::UpdateSceneData(CScene const& aScene)
 #endif
 }
 
+uint32_t CRenderer::GetRingStallsCount() const
+{
+    uint32_t lStalls = 0;
+    for (CGPUBufferObjectRef const& lBuffer : { mStrokesBuffer, mMaterialBuffer, mFrameBuffer })
+    {
+        lStalls += lBuffer->IsRing() ? lBuffer->GetRingStallsCount() : 0;
+    }
+    return lStalls;
+}
+
+CGPUBufferObjectRef CRenderer::CreateStreamBuffer(EGPUBufferBindTarget::Type aTarget, size_t aSize)
+{
+    CGPUBufferObjectRef lBuffer = std::make_shared<CGPUBufferObject>(aTarget);
+    if (mBufferUploadMode == EBufferUploadMode::PERSISTENT_RING)
+    {
+        if (lBuffer->SetRingData(aSize, kRingRegionsCount))
+        {
+            return lBuffer;
+        }
+
+        // Storage is immutable, the fallback needs a new buffer
+        SBX_LOG("Persistent mapping not available, falling back to sub data uploads");
+        mBufferUploadMode = EBufferUploadMode::SUB_DATA;
+        lBuffer = std::make_shared<CGPUBufferObject>(aTarget);
+    }
+
+    lBuffer->SetData(aSize, nullptr, EGPUBufferFlags::DYNAMIC_STORAGE);
+    return lBuffer;
+}
+
+void CRenderer::UploadStrokes(CScene const& aScene)
+{
+    std::vector<stroke_t> const& lStrokes = aScene.GetPackedStrokes();
+    const size_t lSizeBytes = lStrokes.size() * sizeof(stroke_t);
+    const size_t lCapacity = mStrokesBuffer->IsRing() ? mStrokesBuffer->GetRingRegionSize() : mStrokesBuffer->GetStorageSize();
+
+    if (lSizeBytes > lCapacity)
+    {
+        // New storage, everything goes up at once
+        mStrokesBuffer = CreateStreamBuffer(EGPUBufferBindTarget::SHADER_BUFFER_STORAGE, lSizeBytes + (16 * sizeof(stroke_t)));
+        for (TStrokesRingRegion& lRegion : mStrokesRingRegions)
+        {
+            lRegion.mPendingRanges.clear();
+            lRegion.mFullCopy = true;
+        }
+
+        if (!mStrokesBuffer->IsRing())
+        {
+            mStrokesBuffer->BindShaderStorage(EBlockBinding::strokes_buffer);
+            mStrokesBuffer->UpdateSubData(0, lSizeBytes, (void*)lStrokes.data());
+            mFrameStrokesUploadedBytes += lSizeBytes;
+            mFrameStrokesUploadCalls++;
+            return;
+        }
+    }
+    else if (!mStrokesBuffer->IsRing())
+    {
+        // Only the strokes changed since the last sync
+        for (TStrokesRange const& lRange : aScene.GetPackedDirtyRanges())
+        {
+            const size_t lRangeBytes = lRange.mCount * sizeof(stroke_t);
+            mStrokesBuffer->UpdateSubData(lRange.mFirst * sizeof(stroke_t), lRangeBytes, (void*)(lStrokes.data() + lRange.mFirst));
+            mFrameStrokesUploadedBytes += lRangeBytes;
+            mFrameStrokesUploadCalls++;
+        }
+        return;
+    }
+
+    // The next region may still be read by the GPU for an older frame, BeginRingRegion only waits then
+    stroke_t* lRegionStrokes = (stroke_t*)mStrokesBuffer->BeginRingRegion();
+    const uint32_t lRegionIndex = mStrokesBuffer->GetRingRegionIndex();
+    std::vector<TStrokesRange> const& lDirtyRanges = aScene.GetPackedDirtyRanges();
+
+    for (uint32_t i = 0; i < kRingRegionsCount; i++)
+    {
+        TStrokesRingRegion& lRegion = mStrokesRingRegions[i];
+        if (i == lRegionIndex || lRegion.mFullCopy)
+        {
+            continue;
+        }
+
+        // Long drags on many strokes are cheaper to copy whole than to track
+        lRegion.mPendingRanges.insert(lRegion.mPendingRanges.end(), lDirtyRanges.begin(), lDirtyRanges.end());
+        if (lRegion.mPendingRanges.size() > 64)
+        {
+            lRegion.mPendingRanges.clear();
+            lRegion.mFullCopy = true;
+        }
+    }
+
+    TStrokesRingRegion& lRegion = mStrokesRingRegions[lRegionIndex];
+    if (lRegion.mFullCopy)
+    {
+        ::memcpy(lRegionStrokes, lStrokes.data(), lSizeBytes);
+        mFrameStrokesUploadedBytes += lSizeBytes;
+        mFrameStrokesUploadCalls++;
+    }
+    else
+    {
+        // Changes this region missed, then the current ones. Removed strokes may leave ranges past the end.
+        lRegion.mPendingRanges.insert(lRegion.mPendingRanges.end(), lDirtyRanges.begin(), lDirtyRanges.end());
+        for (TStrokesRange const& lRange : lRegion.mPendingRanges)
+        {
+            const size_t lFirst = glm::min(size_t(lRange.mFirst), lStrokes.size());
+            const size_t lCount = glm::min(size_t(lRange.mCount), lStrokes.size() - lFirst);
+            if (lCount > 0)
+            {
+                ::memcpy(lRegionStrokes + lFirst, lStrokes.data() + lFirst, lCount * sizeof(stroke_t));
+                mFrameStrokesUploadedBytes += lCount * sizeof(stroke_t);
+                mFrameStrokesUploadCalls++;
+            }
+        }
+    }
+    lRegion.mPendingRanges.clear();
+    lRegion.mFullCopy = false;
+
+    mStrokesBuffer->BindShaderStorageRange(EBlockBinding::strokes_buffer, mStrokesBuffer->GetRingRegionOffset(), mStrokesBuffer->GetRingRegionSize());
+}
+
+void CRenderer::BakeVolume(std::vector<stroke_t> const& aStrokes, glm::ivec3 const& aMin, glm::ivec3 const& aMax)
+{
+    const glm::ivec3 lExtent = aMax - aMin;
+    if (glm::any(glm::lessThanEqual(lExtent, glm::ivec3(0))))
+    {
+        return;
+    }
+
+    // Lut region on the CPU, only the voxels entering or leaving the surface change their slot
+    mEvaluator.SetStrokes(aStrokes);
+    mLastBakeStats = mSdfVolume.BakeRegion(mEvaluator, aMin, aMax);
+
+    const int32_t lLutSize = mBakeParams.mLutSize;
+    const sbx::TColor8U* lTexels = mSdfVolume.GetLut().AsRGBA8Buffer();
+    const size_t lFirstTexel = (size_t(aMin.z) * lLutSize + aMin.y) * lLutSize + aMin.x;
+    mSdfLut->UpdateSubData(aMin.x, aMin.y, aMin.z, lExtent.x, lExtent.y, lExtent.z, lTexels + lFirstTexel, lLutSize, lLutSize);
+    mFrameUploadedBytes += size_t(lExtent.x) * size_t(lExtent.y) * size_t(lExtent.z) * sizeof(sbx::TColor8U);
+
+    // Atlas bricks of the surface voxels of the region
+    std::vector<CSdfVolume::TBrick> const& lBricks = mSdfVolume.GetBricks();
+    const uint32_t lBricksCount = uint32_t(lBricks.size());
+    if (lBricksCount == 0)
+    {
+        return;
+    }
+
+    const size_t lBricksBytes = lBricks.size() * sizeof(CSdfVolume::TBrick);
+    if (lBricksBytes > mBrickListBuffer->GetStorageSize())
+    {
+        mBrickListBuffer = std::make_shared<CGPUBufferObject>(EGPUBufferBindTarget::SHADER_BUFFER_STORAGE);
+        mBrickListBuffer->SetData(lBricksBytes + lBricksBytes / 2, nullptr, EGPUBufferFlags::DYNAMIC_STORAGE);
+        mBrickListBuffer->BindShaderStorage(EBlockBinding::brick_list_buffer);
+    }
+    mBrickListBuffer->UpdateSubData(0, lBricksBytes, (void*)lBricks.data());
+    mFrameUploadedBytes += lBricksBytes;
+
+    // Rows of work groups, one per brick
+    const uint32_t lGroupsX = glm::min(lBricksCount, 65535u);
+    const uint32_t lGroupsY = (lBricksCount + lGroupsX - 1) / lGroupsX;
+    glProgramUniform1ui(mComputeAtlasProgram->GetHandler(), EUniformLoc::uBricksCount, lBricksCount);
+
+    mComputeAtlasPipeline->Bind();
+    mSdfAtlas->BindImage(0, 0, EImgAccess::WRITE_ONLY);
+    glDispatchCompute(lGroupsX, lGroupsY, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+}
+
+void CRenderer::CompactAtlas()
+{
+    const uint32_t lMovesCount = mSdfVolume.Compact();
+    if (lMovesCount == 0)
+    {
+        return;
+    }
+
+    // Bricks keep their content, only the slot changes
+    const glm::ivec3 lAtlasSlots = mBakeParams.GetAtlasSlots();
+    const int32_t lBrickSize = mBakeParams.mBrickSize;
+    for (CSdfVolume::TBrickMove const& lMove : mSdfVolume.GetBrickMoves())
+    {
+        const glm::ivec3 lFrom = Sdf::GetCellCoordFromIndex(lMove.mFromSlot, lAtlasSlots) * lBrickSize;
+        const glm::ivec3 lTo = Sdf::GetCellCoordFromIndex(lMove.mToSlot, lAtlasSlots) * lBrickSize;
+        mSdfAtlas->CopySubData(lFrom.x, lFrom.y, lFrom.z, lTo.x, lTo.y, lTo.z, lBrickSize, lBrickSize, lBrickSize);
+    }
+
+    mSdfLut->UpdateData(mSdfVolume.GetLut().AsRGBA8Buffer());
+    mFrameUploadedBytes += mBakeParams.GetLutVoxelsCount() * sizeof(sbx::TColor8U);
+    SBX_LOG("Atlas compacted, %u bricks moved, %u slots in use", lMovesCount, mSdfVolume.GetSlotAllocator().GetUsedCount());
+}
+
+bool CRenderer::RestoreVolumeFromCache(uint64_t aKey)
+{
+    const auto lStartTime = std::chrono::steady_clock::now();
+
+    std::vector<sbx::TTexture> lPack;
+    if (!mVolumeCache.Load(aKey, lPack))
+    {
+        return false;
+    }
+
+    const int32_t lBrickSize = mBakeParams.mBrickSize;
+    sbx::TTexture const& lBricks = lPack[ESdfVolumeCachePack::BRICKS];
+    if (lBricks.mFormat != sbx::ETextureFormat::R8 || lBricks.mWidth != lBrickSize || lBricks.mHeight != lBrickSize ||
+        !mSdfVolume.Restore(lPack[ESdfVolumeCachePack::LUT]))
+    {
+        mFullBakePending = true;
+        return false;
+    }
+
+    const uint32_t lUsedCount = mSdfVolume.GetSlotAllocator().GetUsedCount();
+    if (size_t(lBricks.mSlices) < size_t(lUsedCount) * size_t(lBrickSize))
+    {
+        mSdfVolume.Init(mBakeParams);
+        mFullBakePending = true;
+        return false;
+    }
+
+    mSdfLut->UpdateData(mSdfVolume.GetLut().AsRGBA8Buffer());
+    mFrameUploadedBytes += mBakeParams.GetLutVoxelsCount() * sizeof(sbx::TColor8U);
+
+    // Slots are [0, used) after the restore, uploaded one layer of bricks at a time
+    const glm::ivec3 lAtlasSlots = mBakeParams.GetAtlasSlots();
+    const uint32_t lLayerSlots = uint32_t(lAtlasSlots.x * lAtlasSlots.y);
+    const size_t lBrickVoxels = size_t(lBrickSize) * size_t(lBrickSize) * size_t(lBrickSize);
+    const int32_t lRowLength = mBakeParams.mAtlasSize.x;
+    std::vector<uint8_t> lLayer;
+    for (uint32_t lFirstSlot = 0; lFirstSlot < lUsedCount; lFirstSlot += lLayerSlots)
+    {
+        const uint32_t lSlotsCount = glm::min(lLayerSlots, lUsedCount - lFirstSlot);
+        const int32_t lLayerHeight = int32_t((lSlotsCount + lAtlasSlots.x - 1) / lAtlasSlots.x) * lBrickSize;
+        lLayer.assign(size_t(lRowLength) * size_t(lLayerHeight) * size_t(lBrickSize), 0);
+
+        for (uint32_t i = 0; i < lSlotsCount; i++)
+        {
+            const glm::ivec3 lCoord = Sdf::GetCellCoordFromIndex(lFirstSlot + i, lAtlasSlots) * lBrickSize;
+            const uint8_t* lBrick = lBricks.AsR8Buffer() + size_t(lFirstSlot + i) * lBrickVoxels;
+            for (int32_t z = 0; z < lBrickSize; z++)
+            {
+                for (int32_t y = 0; y < lBrickSize; y++)
+                {
+                    uint8_t* lDst = lLayer.data() + (size_t(z) * lLayerHeight + lCoord.y + y) * lRowLength + lCoord.x;
+                    ::memcpy(lDst, lBrick + (size_t(z) * lBrickSize + y) * lBrickSize, lBrickSize);
+                }
+            }
+        }
+
+        const int32_t lLayerZ = Sdf::GetCellCoordFromIndex(lFirstSlot, lAtlasSlots).z * lBrickSize;
+        mSdfAtlas->UpdateSubData(0, 0, lLayerZ, lRowLength, lLayerHeight, lBrickSize, lLayer.data(), lRowLength, lLayerHeight);
+        mFrameUploadedBytes += lLayer.size();
+    }
+
+    mLastBakeStats = TSdfVolumeBakeStats();
+    mLastBakeStats.mBricks = lUsedCount;
+    mLastBakeStats.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStartTime).count();
+    SBX_LOG("Volume restored from the cache, %u bricks in %.2f ms", lUsedCount, mLastBakeStats.mSeconds * 1000.0);
+    return true;
+}
+
+void CRenderer::StoreVolumeInCache(uint64_t aKey)
+{
+    if (!mVolumeCache.IsEnabled() || mVolumeCache.Contains(aKey))
+    {
+        return;
+    }
+
+    std::vector<sbx::TTexture> lPack(ESdfVolumeCachePack::COUNT);
+    std::vector<uint32_t> lSlots;
+    mSdfVolume.ExportCompact(lPack[ESdfVolumeCachePack::LUT], lSlots);
+
+    const int32_t lBrickSize = mBakeParams.mBrickSize;
+    const uint32_t lSlotsCount = uint32_t(lSlots.size());
+    sbx::TTexture& lBricks = lPack[ESdfVolumeCachePack::BRICKS];
+    lBricks.Init(lBrickSize, lBrickSize, int32_t(glm::max(lSlotsCount, 1u)) * lBrickSize, sbx::ETextureFormat::R8);
+
+    // The bricks come from the atlas compute pass
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    // Slots are in order, each layer of bricks is read back once up to its last used row
+    const glm::ivec3 lAtlasSlots = mBakeParams.GetAtlasSlots();
+    const size_t lBrickVoxels = size_t(lBrickSize) * size_t(lBrickSize) * size_t(lBrickSize);
+    const int32_t lRowLength = mBakeParams.mAtlasSize.x;
+    std::vector<uint8_t> lLayer;
+    for (uint32_t lFirst = 0, lEnd = 0; lFirst < lSlotsCount; lFirst = lEnd)
+    {
+        const int32_t lLayerIndex = Sdf::GetCellCoordFromIndex(lSlots[lFirst], lAtlasSlots).z;
+        lEnd = lFirst;
+        while (lEnd < lSlotsCount && Sdf::GetCellCoordFromIndex(lSlots[lEnd], lAtlasSlots).z == lLayerIndex)
+        {
+            lEnd++;
+        }
+
+        const int32_t lLayerHeight = (Sdf::GetCellCoordFromIndex(lSlots[lEnd - 1], lAtlasSlots).y + 1) * lBrickSize;
+        lLayer.resize(size_t(lRowLength) * size_t(lLayerHeight) * size_t(lBrickSize));
+        mSdfAtlas->GetSubData(0, 0, lLayerIndex * lBrickSize, lRowLength, lLayerHeight, lBrickSize, lLayer.size(), lLayer.data());
+
+        for (uint32_t i = lFirst; i < lEnd; i++)
+        {
+            const glm::ivec3 lCoord = Sdf::GetCellCoordFromIndex(lSlots[i], lAtlasSlots) * lBrickSize;
+            uint8_t* lBrick = lBricks.AsR8Buffer() + size_t(i) * lBrickVoxels;
+            for (int32_t z = 0; z < lBrickSize; z++)
+            {
+                for (int32_t y = 0; y < lBrickSize; y++)
+                {
+                    const uint8_t* lSrc = lLayer.data() + (size_t(z) * lLayerHeight + lCoord.y + y) * lRowLength + lCoord.x;
+                    ::memcpy(lBrick + (size_t(z) * lBrickSize + y) * lBrickSize, lSrc, lBrickSize);
+                }
+            }
+        }
+    }
+
+    mVolumeCache.Store(aKey, lPack);
+}
+
 void CRenderer::RenderFrame()
 {
     glfwGetFramebufferSize(glfwGetCurrentContext(), &mViewWidth, &mViewHeight);
@@ -321,4 +690,13 @@ void CRenderer::RenderFrame()
     glDrawArrays(GL_TRIANGLES, 0, 3);
     
     glBindVertexArray(0);
+
+    // Last use of the current regions this frame
+    for (CGPUBufferObjectRef const& lBuffer : { mStrokesBuffer, mMaterialBuffer, mFrameBuffer })
+    {
+        if (lBuffer->IsRing())
+        {
+            lBuffer->FenceRingRegion();
+        }
+    }
 }
\ No newline at end of file
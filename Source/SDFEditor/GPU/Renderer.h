@@ -6,12 +6,29 @@
 #include "SDFEditor/GPU/GPUShader.h"
 #include "SDFEditor/GPU/GPUStorageBuffer.h"
 #include "SDFEditor/GPU/GPUTexture.h"
+#include "SDFEditor/Sdf/SdfBakeParams.h"
+#include "SDFEditor/Sdf/SdfBounds.h"
+#include "SDFEditor/Sdf/SdfEvaluator.h"
+#include "SDFEditor/Sdf/SdfVolume.h"
+#include "SDFEditor/Sdf/SdfVolumeCache.h"
+#include "SDFEditor/Tool/Scene.h"
 
 #include <glm/glm.hpp>
 
+namespace EBufferUploadMode
+{
+    enum Type
+    {
+        SUB_DATA,           // glNamedBufferSubData on dynamic storage
+        PERSISTENT_RING,    // persistent coherent mapped rings, fenced per region
+    };
+};
+
 class CRenderer
 {
 public:
+    // Uses the persistent rings unless SDFEDITOR_BUFFER_MODE=subdata is set,
+    // or the driver can't map them.
     void Init();
     void Shutdown();
     void SetRoughnessMap(uint32_t aWidth, uint32_t aHeight, void* aData);
@@ -21,7 +38,41 @@ public:
 
     CGPUBufferObjectRef GetStrokesBufferRef() { return mStrokesBuffer; }
 
+    // Moves the atlas slots in use to the bottom of the atlas on the next update
+    void RequestAtlasCompaction() { mAtlasCompactionPending = true; }
+    CSdfVolume const& GetSdfVolume() const { return mSdfVolume; }
+    TSdfVolumeBakeStats const& GetLastBakeStats() const { return mLastBakeStats; }
+    CSdfVolumeCache const& GetVolumeCache() const { return mVolumeCache; }
+
+    // Bytes sent to the GPU by the last UpdateSceneData
+    size_t GetFrameUploadedBytes() const { return mFrameUploadedBytes; }
+    size_t GetFrameStrokesUploadedBytes() const { return mFrameStrokesUploadedBytes; }
+    uint32_t GetFrameStrokesUploadCalls() const { return mFrameStrokesUploadCalls; }
+
+    EBufferUploadMode::Type GetBufferUploadMode() const { return mBufferUploadMode; }
+    // Times a ring region had to wait for the GPU since Init
+    uint32_t GetRingStallsCount() const;
+
 private:
+    static constexpr uint32_t kRingRegionsCount = 3;
+    // Updates without bakes before the volume goes to the cache, edits in progress are not stored
+    static constexpr uint32_t kVolumeCacheStoreDelay = 30;
+    // Bakes of at least 1 / kVolumeCacheLookupRatio of the LUT look in the cache first
+    static constexpr size_t kVolumeCacheLookupRatio = 4;
+
+    // Ring or dynamic storage buffer depending on the upload mode, sized for aSize bytes per frame
+    CGPUBufferObjectRef CreateStreamBuffer(EGPUBufferBindTarget::Type aTarget, size_t aSize);
+    void UploadStrokes(class CScene const& aScene);
+
+    // Bakes the LUT voxels in [aMin, aMax) and the atlas bricks of its surface voxels
+    void BakeVolume(std::vector<stroke_t> const& aStrokes, glm::ivec3 const& aMin, glm::ivec3 const& aMax);
+    void CompactAtlas();
+
+    // LUT and atlas bricks of a cached volume, false if not cached
+    bool RestoreVolumeFromCache(uint64_t aKey);
+    // Reads the atlas bricks back from the GPU
+    void StoreVolumeInCache(uint64_t aKey);
+
     // View data
     int32_t mViewWidth;
     int32_t mViewHeight;
@@ -32,18 +83,43 @@ private:
     CGPUShaderProgramRef mColorFragmentProgram;
     CGPUShaderPipelineRef mScreenQuadPipeline;
 
-    CGPUShaderProgramRef mComputeLutProgram;
-    CGPUShaderPipelineRef mComputeLutPipeline;
     CGPUShaderProgramRef mComputeAtlasProgram;
     CGPUShaderPipelineRef mComputeAtlasPipeline;
     CGPUTextureRef mSdfLut;
     CGPUTextureRef mSdfAtlas;
 
     CGPUBufferObjectRef mStrokesBuffer;
-    CGPUBufferObjectRef mSlotListBuffer;
-    CGPUBufferObjectRef mSlotCounterBuffer;
+    CGPUBufferObjectRef mBrickListBuffer;
 
     CGPUBufferObjectRef mMaterialBuffer;
+    CGPUBufferObjectRef mFrameBuffer;
+
+    // Each ring region of the strokes buffer catches up with the strokes changed since it was last written
+    struct TStrokesRingRegion
+    {
+        std::vector<TStrokesRange> mPendingRanges;
+        bool mFullCopy{ true };
+    };
+    EBufferUploadMode::Type mBufferUploadMode{ EBufferUploadMode::PERSISTENT_RING };
+    TStrokesRingRegion mStrokesRingRegions[kRingRegionsCount];
+
+    // Incremental bake, the LUT is baked on the CPU and the atlas bricks on the GPU
+    TSdfBakeParams mBakeParams;
+    CStrokeBoundsCache mBakedStrokesBounds;     // strokes in mStrokesBuffer
+    CSdfEvaluator mEvaluator;
+    CSdfVolume mSdfVolume;
+    TSdfVolumeBakeStats mLastBakeStats;
+    bool mFullBakePending{ true };
+    bool mAtlasCompactionPending{ false };
+
+    // Baked volumes of the scenes seen before, SDFEDITOR_CACHE_DIR or ./Cache/Volumes
+    CSdfVolumeCache mVolumeCache;
+    uint32_t mVolumeCacheStoreCountdown{ 0 };
+
+    // Upload stats
+    size_t mFrameUploadedBytes{ 0 };
+    size_t mFrameStrokesUploadedBytes{ 0 };
+    uint32_t mFrameStrokesUploadCalls{ 0 };
 
     CGPUTextureRef mRoughnessMap;
 };
\ No newline at end of file
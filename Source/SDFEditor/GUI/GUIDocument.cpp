@@ -56,6 +56,9 @@ namespace GUI
     {
         // define style for all directories
         ImGuiFileDialog::Instance()->SetFileStyle(IGFD_FileStyleByExtention, ".strks", ImVec4(0.8f, 1.0f, 0.3f, 0.9f), ICON_DOC_TEXT);
+        ImGuiFileDialog::Instance()->SetFileStyle(IGFD_FileStyleByExtention, ".strkb", ImVec4(0.8f, 1.0f, 0.3f, 0.9f), ICON_DOC);
+        ImGuiFileDialog::Instance()->SetFileStyle(IGFD_FileStyleByExtention, ".ply", ImVec4(0.3f, 0.8f, 1.0f, 0.9f), ICON_BOX);
+        ImGuiFileDialog::Instance()->SetFileStyle(IGFD_FileStyleByExtention, ".obj", ImVec4(0.3f, 0.8f, 1.0f, 0.9f), ICON_BOX);
         ImGuiFileDialog::Instance()->SetFileStyle(IGFD_FileStyleByTypeDir, "", ImVec4(0.8f, 0.8f, 0.8f, 0.9f), ICON_FOLDER);
         ImGuiFileDialog::Instance()->SetFileStyle(IGFD_FileStyleByTypeFile, "", ImVec4(1.0f, 1.0f, 1.0f, 0.3f), ICON_DOC);
         ImGuiFileDialog::Instance()->SetFileStyle(IGFD_FileStyleByTypeLink, "", ImVec4(1.0f, 1.0f, 1.0f, 0.3f), ICON_DOC);
@@ -101,13 +104,19 @@ namespace GUI
     void LaunchOpenFileDialog(CToolApp& aToolApp)
     {
         uint32_t lFlags = ImGuiFileDialogFlags_DisableCreateDirectoryButton | ImGuiFileDialogFlags_ReadOnlyFileNameField;
-        ImGuiFileDialog::Instance()->OpenModal("OpenStrokesFile", "Open Strokes File", ".strks", ".", 1, nullptr, lFlags);
+        ImGuiFileDialog::Instance()->OpenModal("OpenStrokesFile", "Open Strokes File", ".strks,.strkb", ".", 1, nullptr, lFlags);
     }
 
     void LaunchSaveFileDialog(CToolApp& aToolApp)
     {
         uint32_t lFlags = ImGuiFileDialogFlags_ConfirmOverwrite;
-        ImGuiFileDialog::Instance()->OpenModal("SaveStrokesFile", "Save Strokes File", ".strks", ".", 1, nullptr, lFlags);
+        ImGuiFileDialog::Instance()->OpenModal("SaveStrokesFile", "Save Strokes File", ".strks,.strkb", ".", 1, nullptr, lFlags);
+    }
+
+    void LaunchExportMeshDialog(CToolApp& aToolApp)
+    {
+        uint32_t lFlags = ImGuiFileDialogFlags_ConfirmOverwrite;
+        ImGuiFileDialog::Instance()->OpenModal("ExportMeshFile", "Export Mesh", ".ply,.obj", ".", 1, nullptr, lFlags);
     }
 
     void WantCloseDocument(CToolApp& aToolApp)
@@ -177,6 +186,15 @@ namespace GUI
             {
                 RequestNewFile(aToolApp);
             }
+            ImGui::SameLine(0.0f, 10.0f);
+            if (TopBarButton(ICON_BOX))
+            {
+                LaunchExportMeshDialog(aToolApp);
+            }
+            if (ImGui::IsItemHovered())
+            {
+                ImGui::SetTooltip("Export mesh (Ctrl + E)");
+            }
             ImGui::PopStyleColor(2);
             ImGui::PopStyleVar(3);
 
@@ -251,6 +269,16 @@ namespace GUI
 
             ImGuiFileDialog::Instance()->Close();
         }
+
+        if (ImGuiFileDialog::Instance()->Display("ExportMeshFile", lDialogsFlags, ImVec2(800, 600)))
+        {
+            if (ImGuiFileDialog::Instance()->IsOk())
+            {
+                aToolApp.ExportMesh(ImGuiFileDialog::Instance()->GetFilePathName());
+            }
+
+            ImGuiFileDialog::Instance()->Close();
+        }
     }
 
     
@@ -3,7 +3,6 @@
 #include "GUIStrokesEdit.h"
 
 #include <SDFEditor/Tool/Scene.h>
-#include <SDFEditor/Math/Box.h>
 
 #include <sbx/Core/Log.h>
 
@@ -35,6 +34,7 @@ namespace GUI
         bool mPanelEditing{ false };
         bool mMaterialEditing{ false };
         bool mGuizmoEditing{ false };
+        uint32_t mGuizmoCoalesceKey{ 0 };
 
         bool ValidStrokeSelected(class CScene& aScene)
         {
@@ -427,16 +427,22 @@ namespace GUI
                                      glm::value_ptr(lTransformationMatrix), 
                                      NULL, NULL, gGUIState.mBoundsActive ? bounds : NULL, NULL))
             {
-                gGUIState.mGuizmoEditing = true;
+                if (!gGUIState.mGuizmoEditing)
+                {
+                    gGUIState.mGuizmoEditing = true;
+                    gGUIState.mGuizmoCoalesceKey = aScene.mStack->NewCoalesceKey();
+                }
                 ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(lTransformationMatrix), &lStrokeInfo.posb.x, &lStrokeInfo.mEulerAngles.x, &lStrokeInfo.param0.x);
                 lStrokeInfo.param0 = glm::max(lStrokeInfo.param0, glm::vec4(0.02f));
                 lStrokeInfo.UpdateRotation();
                 aScene.SetDirty();
+
+                // The whole drag is one undo entry
+                aScene.mStack->PushState(EPushStateFlags::EPE_STROKES_ALL, gGUIState.mGuizmoCoalesceKey);
             }
             else if (gGUIState.mGuizmoEditing && !ImGui::IsMouseDown(ImGuiMouseButton_Left))
             {
                 gGUIState.mGuizmoEditing = false;
-                aScene.mStack->PushState(EPushStateFlags::EPE_STROKES_ALL);
             }
         }
 
@@ -494,34 +500,14 @@ namespace GUI
 
         glm::vec3 lRayOrigin = glm::vec3(1.0);
         glm::vec3 lRayDirection = glm::vec3(1.0);
-        float lPrevDistance = 1000000.0f;
-        int32_t lIntersectedIndex = INT32_MAX;
 
         // calculate ray based on mouse position
         CreateCameraRay(aScene, lRayOrigin, lRayDirection);
 
-        static const glm::vec3 kUnitVec(1.0f, 1.0f, 1.0f);
-
-        for (int32_t i = 0; i < aScene.mStrokesArray.size(); i++)
-        {
-            TStrokeInfo& lStrokeInfo = aScene.mStrokesArray[i];
-           
-            // Calculate box with stroke properties
-            const glm::vec3 lScale = lStrokeInfo.GetScale();
-            glm::mat4 lTransformationMatrix;
-            ImGuizmo::RecomposeMatrixFromComponents(&lStrokeInfo.posb.x, &lStrokeInfo.mEulerAngles.x, &kUnitVec.x, glm::value_ptr(lTransformationMatrix));
-
-
-            float lDistance = 1000000000.0f;
-            bool lIntersects = SBox(lScale, lTransformationMatrix).CheckRayIntersection(lRayOrigin, lRayDirection, &lDistance);
-            if (lDistance < lPrevDistance)
-            {
-                lPrevDistance = lDistance;
-                lIntersectedIndex = i;
-            }
-        }
+        // Stroke under the cursor on the surface, or its box
+        const int32_t lIntersectedIndex = aScene.PickStroke(lRayOrigin, lRayDirection);
 
-        if (lIntersectedIndex != INT32_MAX)
+        if (lIntersectedIndex >= 0)
         {
             //SBX_LOG("Clicked Stroke %s", aScene.mStrokesArray[lIntersectedIndex].mName);
             aScene.mSelectedItems.push_back(lIntersectedIndex);
@@ -0,0 +1,56 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#pragma once
+
+#include <cfloat>
+#include <glm/glm.hpp>
+
+// Axis aligned box, empty when min > max
+struct TAabb
+{
+    glm::vec3 mMin{ FLT_MAX, FLT_MAX, FLT_MAX };
+    glm::vec3 mMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    TAabb() = default;
+    TAabb(glm::vec3 const& aMin, glm::vec3 const& aMax)
+        : mMin(aMin)
+        , mMax(aMax)
+    {}
+
+    bool IsEmpty() const { return (mMin.x > mMax.x) || (mMin.y > mMax.y) || (mMin.z > mMax.z); }
+    glm::vec3 GetCenter() const { return (mMin + mMax) * 0.5f; }
+    glm::vec3 GetExtent() const { return (mMax - mMin) * 0.5f; }
+
+    void Reset() { *this = TAabb(); }
+
+    void Extend(glm::vec3 const& aPoint)
+    {
+        mMin = glm::min(mMin, aPoint);
+        mMax = glm::max(mMax, aPoint);
+    }
+
+    void Extend(TAabb const& aOther)
+    {
+        mMin = glm::min(mMin, aOther.mMin);
+        mMax = glm::max(mMax, aOther.mMax);
+    }
+
+    void Expand(float aMargin)
+    {
+        mMin -= glm::vec3(aMargin);
+        mMax += glm::vec3(aMargin);
+    }
+
+    bool Intersects(TAabb const& aOther) const
+    {
+        return glm::all(glm::lessThanEqual(mMin, aOther.mMax)) && glm::all(glm::lessThanEqual(aOther.mMin, mMax));
+    }
+
+    bool Contains(glm::vec3 const& aPoint) const
+    {
+        return glm::all(glm::lessThanEqual(mMin, aPoint)) && glm::all(glm::lessThanEqual(aPoint, mMax));
+    }
+
+    bool operator==(TAabb const& aOther) const { return (mMin == aOther.mMin) && (mMax == aOther.mMax); }
+    bool operator!=(TAabb const& aOther) const { return !(*this == aOther); }
+};
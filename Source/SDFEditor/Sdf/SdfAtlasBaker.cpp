@@ -0,0 +1,117 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfAtlasBaker.h"
+#include "SdfEvaluator.h"
+#include "SdfCulling.h"
+
+#include <sbx/Core/Parallel.h>
+#include <sbx/Core/ErrorHandling.h>
+#include <sbx/Texture/Texture.h>
+
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    // Bricks per ParallelFor chunk
+    constexpr size_t kBricksPerChunk = 8;
+}
+
+void TSdfBrickAtlas::ExpandToTexture(TSdfBakeParams const& aParams, sbx::TTexture& aOutAtlas) const
+{
+    const glm::ivec3 lAtlasSize = aParams.mAtlasSize;
+    const glm::ivec3 lAtlasSlots = aParams.GetAtlasSlots();
+
+    aOutAtlas.Init(lAtlasSize.x, lAtlasSize.y, lAtlasSize.z, sbx::ETextureFormat::R8);
+    uint8_t* lTexels = aOutAtlas.AsR8Buffer();
+    ::memset(lTexels, 0, size_t(lAtlasSize.x) * size_t(lAtlasSize.y) * size_t(lAtlasSize.z));
+
+    const uint32_t lMaxBricks = uint32_t(lAtlasSlots.x * lAtlasSlots.y * lAtlasSlots.z);
+    const uint32_t lNumBricks = glm::min(GetBricksCount(), lMaxBricks);
+
+    for (uint32_t lSlot = 0; lSlot < lNumBricks; lSlot++)
+    {
+        const glm::ivec3 lOrigin = Sdf::GetCellCoordFromIndex(lSlot, lAtlasSlots) * mBrickSize;
+        const uint8_t* lBrick = GetBrick(lSlot);
+
+        for (int32_t z = 0; z < mBrickSize; z++)
+        {
+            for (int32_t y = 0; y < mBrickSize; y++)
+            {
+                const size_t lDst = (size_t(lOrigin.z + z) * lAtlasSize.y + size_t(lOrigin.y + y)) * lAtlasSize.x + lOrigin.x;
+                ::memcpy(lTexels + lDst, lBrick + (z * mBrickSize + y) * mBrickSize, mBrickSize);
+            }
+        }
+    }
+}
+
+TSdfAtlasBakeStats CSdfAtlasBaker::Bake(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, std::vector<uint32_t> const& aSlotList, TSdfBrickAtlas& aOutAtlas, CSdfCullGrid const* aCullGrid)
+{
+    SBX_ASSERT(aSlotList.size() <= aParams.mMaxSlots, "More slots than the atlas can hold");
+
+    const auto lStartTime = std::chrono::steady_clock::now();
+
+    const int32_t lBrickSize = aParams.mBrickSize;
+    const float lAtlasVoxelSide = aParams.GetAtlasVoxelSide();
+    const float lInvLutVoxelSide = 1.0f / aParams.mLutVoxelSide;
+    const uint32_t lThreads = (aParams.mThreads > 0) ? aParams.mThreads : sbx::GetHardwareThreadsCount();
+
+    aOutAtlas.mBrickSize = lBrickSize;
+    aOutAtlas.mSlotList = aSlotList;
+    aOutAtlas.mBricks.resize(aSlotList.size() * aOutAtlas.GetBrickVoxels());
+
+    // Atlas voxel offsets from the LUT voxel center, same for every brick
+    std::vector<glm::vec3> lBrickOffsets;
+    lBrickOffsets.reserve(aOutAtlas.GetBrickVoxels());
+    for (int32_t z = 0; z < lBrickSize; z++)
+    {
+        for (int32_t y = 0; y < lBrickSize; y++)
+        {
+            for (int32_t x = 0; x < lBrickSize; x++)
+            {
+                lBrickOffsets.emplace_back((glm::vec3(x, y, z) - float(lBrickSize) * 0.5f + 0.5f) * lAtlasVoxelSide);
+            }
+        }
+    }
+
+    sbx::ParallelFor(aSlotList.size(), kBricksPerChunk, [&](size_t aBegin, size_t aEnd, uint32_t)
+    {
+        std::vector<glm::vec3> lPoints(lBrickOffsets.size());
+        std::vector<float> lDistances(lBrickOffsets.size());
+
+        for (size_t lSlot = aBegin; lSlot < aEnd; lSlot++)
+        {
+            const glm::ivec3 lLutCoord = Sdf::IndexToCoord(aSlotList[lSlot]);
+            const glm::vec3 lSlotWorldPos = aParams.LutCoordToWorld(lLutCoord);
+            for (size_t i = 0; i < lPoints.size(); i++)
+            {
+                lPoints[i] = lSlotWorldPos + lBrickOffsets[i];
+            }
+
+            if (aCullGrid)
+            {
+                // Bricks are inside their LUT voxel, well under the cull margin
+                const uint32_t lCell = aCullGrid->GetCellIndex(aCullGrid->GetCellFromLutCoord(lLutCoord));
+                aEvaluator.Evaluate(lPoints.data(), lPoints.size(), lDistances.data(), aCullGrid->GetCellStrokes(lCell), aCullGrid->GetCellStrokesCount(lCell));
+            }
+            else
+            {
+                aEvaluator.Evaluate(lPoints.data(), lPoints.size(), lDistances.data());
+            }
+
+            uint8_t* lBrick = aOutAtlas.mBricks.data() + lSlot * lPoints.size();
+            for (size_t i = 0; i < lPoints.size(); i++)
+            {
+                lBrick[i] = Sdf::FloatToUnorm8(glm::abs((lDistances[i] * lInvLutVoxelSide + 1.0f) * 0.5f));
+            }
+        }
+    }, lThreads);
+
+    TSdfAtlasBakeStats lStats;
+    lStats.mBricks = uint32_t(aSlotList.size());
+    lStats.mVoxels = aOutAtlas.mBricks.size();
+    lStats.mThreads = lThreads;
+    lStats.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStartTime).count();
+    lStats.mVoxelsPerSecond = (lStats.mSeconds > 0.0) ? double(lStats.mVoxels) / lStats.mSeconds : 0.0;
+    return lStats;
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// CPU version of ComputeSDFAtlas.comp.glsl
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDFEditor/Sdf/SdfBakeParams.h>
+
+namespace sbx
+{
+    struct TTexture;
+}
+
+class CSdfEvaluator;
+class CSdfCullGrid;
+
+// Narrow band bricks stored compact, brick i belongs to slot i
+struct TSdfBrickAtlas
+{
+    int32_t mBrickSize{ 8 };
+    std::vector<uint32_t> mSlotList;    // CoordToIndex LUT coord of each slot
+    std::vector<uint8_t> mBricks;       // R8 values, mBrickSize^3 per slot, x major
+
+    uint32_t GetBricksCount() const { return uint32_t(mSlotList.size()); }
+    size_t GetBrickVoxels() const { return size_t(mBrickSize) * size_t(mBrickSize) * size_t(mBrickSize); }
+    uint8_t const* GetBrick(uint32_t aSlot) const { return mBricks.data() + aSlot * GetBrickVoxels(); }
+
+    // Writes the bricks at their GetCellCoordFromIndex position of a full R8 atlas
+    void ExpandToTexture(TSdfBakeParams const& aParams, sbx::TTexture& aOutAtlas) const;
+};
+
+struct TSdfAtlasBakeStats
+{
+    uint32_t mBricks{ 0 };
+    size_t mVoxels{ 0 };
+    uint32_t mThreads{ 0 };
+    double mSeconds{ 0.0 };
+    double mVoxelsPerSecond{ 0.0 };
+};
+
+class CSdfAtlasBaker
+{
+public:
+    // Evaluates one brick per slot of aSlotList (the slot list of CSdfLutBaker).
+    // With aCullGrid each brick only evaluates the strokes of its cell
+    TSdfAtlasBakeStats Bake(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, std::vector<uint32_t> const& aSlotList, TSdfBrickAtlas& aOutAtlas, CSdfCullGrid const* aCullGrid = nullptr);
+};
@@ -0,0 +1,79 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Volume layout shared by the CPU bakers and the shaders, see SDFCommon.h.glsl
+
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+struct TSdfBakeParams
+{
+    int32_t mLutSize{ 128 };                                // voxels per side of the LUT
+    float mLutVoxelSide{ 0.05f };                           // world size of a LUT voxel
+    int32_t mBrickSize{ 8 };                                // atlas voxels per LUT voxel side
+    glm::ivec3 mAtlasSize{ 1024, 1024, 256 };               // ATLAS_SIZE
+    uint32_t mMaxSlots{ 491520 };                           // uMaxSlotsCount
+    uint32_t mThreads{ 0 };                                 // 0 = all hardware threads
+
+    // Stroke culling, see CSdfCullGrid
+    bool mCullStrokes{ true };
+    int32_t mCullCellVoxels{ 8 };                           // LUT voxels per cull cell side
+    float mCullMargin{ 0.4f };                              // distances are exact up to this, clamped beyond
+
+    size_t GetLutVoxelsCount() const { return size_t(mLutSize) * size_t(mLutSize) * size_t(mLutSize); }
+    float GetAtlasVoxelSide() const { return mLutVoxelSide / float(mBrickSize); }
+    glm::ivec3 GetAtlasSlots() const { return mAtlasSize / mBrickSize; }
+
+    int32_t GetCullCellsPerSide() const { return (mLutSize + mCullCellVoxels - 1) / mCullCellVoxels; }
+
+    // Band of LUT voxels that get an atlas slot
+    float GetSurfaceBand() const { return mLutVoxelSide * 1.5f; }
+
+    // LutCoordToWorld
+    glm::vec3 LutCoordToWorld(glm::ivec3 const& aCoord) const
+    {
+        return ((glm::vec3(aCoord) + 0.5f) - (0.5f * float(mLutSize))) * mLutVoxelSide;
+    }
+
+    // WorldToLutCoord
+    glm::ivec3 WorldToLutCoord(glm::vec3 const& aPos) const
+    {
+        return glm::ivec3((aPos / mLutVoxelSide) + (0.5f * float(mLutSize)));
+    }
+
+    // Normalized distance stored in the LUT alpha, ((dist / voxel / lutSize) + 1) * 0.5
+    float LutNormDistance(float aDist) const
+    {
+        return ((aDist / mLutVoxelSide / float(mLutSize)) + 1.0f) * 0.5f;
+    }
+};
+
+namespace Sdf
+{
+    // CoordToIndex, 8 bits per component
+    inline uint32_t CoordToIndex(glm::ivec3 const& aCoord)
+    {
+        return uint32_t(aCoord.x) | (uint32_t(aCoord.y) << 8) | (uint32_t(aCoord.z) << 16);
+    }
+
+    // IndexToCoord
+    inline glm::ivec3 IndexToCoord(uint32_t aIndex)
+    {
+        return glm::ivec3(aIndex & 0xFF, (aIndex >> 8) & 0xFF, (aIndex >> 16) & 0xFF);
+    }
+
+    // GetCellCoordFromIndex
+    inline glm::ivec3 GetCellCoordFromIndex(uint32_t aIndex, glm::ivec3 const& aSize)
+    {
+        const uint32_t a = uint32_t(aSize.x * aSize.y);
+        const uint32_t z = aIndex / a;
+        const uint32_t b = aIndex - a * z;
+        return glm::ivec3(b % uint32_t(aSize.x), b / uint32_t(aSize.x), z);
+    }
+
+    // Unorm conversion used by imageStore on rgba8 / r8 images
+    inline uint8_t FloatToUnorm8(float aValue)
+    {
+        return uint8_t(glm::clamp(aValue, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+}
@@ -0,0 +1,255 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfBounds.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstring>
+
+namespace Sdf
+{
+    TAabb ComputeStrokeLocalBounds(stroke_t const& aStroke)
+    {
+        const glm::vec3 lSize = glm::abs(glm::vec3(aStroke.param0));
+
+        switch (aStroke.id.x)
+        {
+        case EPrimitive::PrEllipsoid:
+        case EPrimitive::PrBox:
+            // The round is taken from inside the box, size is the outer extent
+            return TAabb(-lSize, lSize);
+        case EPrimitive::PrTorus:
+        {
+            // Ring on the xz plane, radius.x major and radius.y minor
+            const float lOuter = lSize.x + lSize.y;
+            return TAabb(glm::vec3(-lOuter, -lSize.y, -lOuter), glm::vec3(lOuter, lSize.y, lOuter));
+        }
+        case EPrimitive::PrCapsule:
+        {
+            // Segment from -h + r to h - r, when h < r the clamp leaves one sphere at h - r
+            const float lRadius = glm::max(aStroke.param0.x, 0.0f);
+            const float lHalfHeight = glm::max(aStroke.param0.y, 0.0f);
+            const float lBottom = glm::min(-lHalfHeight + lRadius, lHalfHeight - lRadius) - lRadius;
+            const float lTop = glm::max(-lHalfHeight + lRadius, lHalfHeight - lRadius) + lRadius;
+            return TAabb(glm::vec3(-lRadius, lBottom, -lRadius), glm::vec3(lRadius, lTop, lRadius));
+        }
+        default:
+            return TAabb();
+        }
+    }
+
+    float ComputeStrokeBlendMargin(stroke_t const& aStroke)
+    {
+        // The smooth ops only differ from min/max where |d1 - d2| < k and move
+        // the field up to k / 4, so the surface can only change where the shape
+        // is closer than k + k / 4 (subtraction offsets the shape by 0.4 k, less)
+        const float lClampedBlend = glm::max(0.0001f, aStroke.posb.w);
+        return lClampedBlend * 1.25f;
+    }
+
+    glm::mat4 ComputeStrokeMatrix(stroke_t const& aStroke)
+    {
+        const glm::quat lRotation(aStroke.quat.w, aStroke.quat.x, aStroke.quat.y, aStroke.quat.z);
+        glm::mat4 lMatrix = glm::mat4(glm::transpose(glm::mat3_cast(lRotation)));
+        lMatrix[3] = glm::vec4(glm::vec3(aStroke.posb), 1.0f);
+        return lMatrix;
+    }
+
+    TAabb TransformStrokeBounds(stroke_t const& aStroke, TAabb const& aLocalBounds)
+    {
+        if (aLocalBounds.IsEmpty())
+        {
+            return TAabb();
+        }
+
+        const glm::mat4 lMatrix = ComputeStrokeMatrix(aStroke);
+        const glm::mat3 lRotation(lMatrix);
+        const glm::mat3 lAbsRotation(glm::abs(lRotation[0]), glm::abs(lRotation[1]), glm::abs(lRotation[2]));
+
+        const glm::vec3 lCenter = glm::vec3(lMatrix[3]) + lRotation * aLocalBounds.GetCenter();
+        const glm::vec3 lExtent = lAbsRotation * aLocalBounds.GetExtent();
+        return TAabb(lCenter - lExtent, lCenter + lExtent);
+    }
+
+    glm::vec3 ComputeStrokeFieldPadding(stroke_t const& aStroke, float aFieldDistance)
+    {
+        if (aStroke.id.x == EPrimitive::PrEllipsoid)
+        {
+            // k0 (k0 - 1) / k1 >= (k0 - 1) * min radius, so the field stays over
+            // aFieldDistance outside the ellipsoid scaled by 1 + aFieldDistance / min radius
+            const glm::vec3 lRadius = glm::max(glm::abs(glm::vec3(aStroke.param0)), glm::vec3(0.0001f));
+            const float lMinRadius = glm::min(lRadius.x, glm::min(lRadius.y, lRadius.z));
+            return lRadius * (aFieldDistance / lMinRadius);
+        }
+
+        return glm::vec3(aFieldDistance);
+    }
+
+    TAabb ComputeStrokeBounds(stroke_t const& aStroke, float aFieldMargin)
+    {
+        TAabb lLocalBounds = ComputeStrokeLocalBounds(aStroke);
+        if (lLocalBounds.IsEmpty())
+        {
+            return lLocalBounds;
+        }
+
+        const glm::vec3 lPadding = ComputeStrokeFieldPadding(aStroke, ComputeStrokeBlendMargin(aStroke) + aFieldMargin);
+        lLocalBounds = TAabb(lLocalBounds.mMin - lPadding, lLocalBounds.mMax + lPadding);
+        TAabb lBounds = TransformStrokeBounds(aStroke, lLocalBounds);
+
+        // Mirrors are applied as abs(p) before the stroke transform, the
+        // stroke shows on both sides of the plane
+        if (aStroke.id.y & EStrokeOp::OpMirrorX)
+        {
+            lBounds.Extend(TAabb(glm::vec3(-lBounds.mMax.x, lBounds.mMin.y, lBounds.mMin.z), glm::vec3(-lBounds.mMin.x, lBounds.mMax.y, lBounds.mMax.z)));
+        }
+
+        if (aStroke.id.y & EStrokeOp::OpMirrorY)
+        {
+            lBounds.Extend(TAabb(glm::vec3(lBounds.mMin.x, -lBounds.mMax.y, lBounds.mMin.z), glm::vec3(lBounds.mMax.x, -lBounds.mMin.y, lBounds.mMax.z)));
+        }
+
+        return lBounds;
+    }
+}
+
+size_t CStrokeBoundsCache::Update(std::vector<TStrokeInfo> const& aStrokes)
+{
+    BeginUpdate(aStrokes.size());
+    for (size_t i = 0; i < aStrokes.size(); i++)
+    {
+        UpdateStroke(i, aStrokes[i]);
+    }
+    EndUpdate();
+
+    return mUpdatedCount;
+}
+
+size_t CStrokeBoundsCache::Update(std::vector<stroke_t> const& aStrokes)
+{
+    BeginUpdate(aStrokes.size());
+    for (size_t i = 0; i < aStrokes.size(); i++)
+    {
+        UpdateStroke(i, aStrokes[i]);
+    }
+    EndUpdate();
+
+    return mUpdatedCount;
+}
+
+void CStrokeBoundsCache::SetFieldMargin(float aFieldMargin)
+{
+    if (mFieldMargin != aFieldMargin)
+    {
+        mFieldMargin = aFieldMargin;
+        Clear();
+    }
+}
+
+void CStrokeBoundsCache::Clear()
+{
+    mStrokes.clear();
+    mLocalBounds.clear();
+    mBounds.clear();
+    mSceneBounds.Reset();
+    mDirtyBounds.Reset();
+    mDirtyStrokes.clear();
+    mUpdatedIndices.clear();
+    mUpdatedCount = 0;
+    mDirtyBlendMargin = 0.0f;
+    mDirtyUnbounded = false;
+}
+
+void CStrokeBoundsCache::BeginUpdate(size_t aCount)
+{
+    mDirtyBounds.Reset();
+    mDirtyStrokes.clear();
+    mUpdatedIndices.clear();
+    mUpdatedCount = 0;
+    mDirtyBlendMargin = 0.0f;
+    mDirtyUnbounded = false;
+
+    // Removed strokes dirty their old region
+    for (size_t i = aCount; i < mBounds.size(); i++)
+    {
+        mDirtyStrokes.push_back({ uint32_t(i), mStrokes[i] });
+        mDirtyUnbounded |= (mStrokes[i].id.y & EStrokeOp::OpsMaskMode) == EStrokeOp::OpIntersect;
+    }
+
+    const size_t lPrevCount = mStrokes.size();
+    mStrokes.resize(aCount);
+    mLocalBounds.resize(aCount);
+    mBounds.resize(aCount);
+
+    // New strokes never match the snapshot
+    for (size_t i = lPrevCount; i < aCount; i++)
+    {
+        mStrokes[i].id.x = -1;
+        mBounds[i].Reset();
+    }
+}
+
+void CStrokeBoundsCache::UpdateStroke(size_t aIndex, stroke_t const& aStroke)
+{
+    if (::memcmp(&mStrokes[aIndex], &aStroke, sizeof(stroke_t)) == 0)
+    {
+        return;
+    }
+
+    const bool lWasIntersect = (mStrokes[aIndex].id.x >= 0) && ((mStrokes[aIndex].id.y & EStrokeOp::OpsMaskMode) == EStrokeOp::OpIntersect);
+    const bool lIsIntersect = (aStroke.id.y & EStrokeOp::OpsMaskMode) == EStrokeOp::OpIntersect;
+    mDirtyUnbounded |= lWasIntersect || lIsIntersect;
+    if (mStrokes[aIndex].id.x >= 0)
+    {
+        mDirtyStrokes.push_back({ uint32_t(aIndex), mStrokes[aIndex] });
+    }
+    mDirtyStrokes.push_back({ uint32_t(aIndex), aStroke });
+
+    mStrokes[aIndex] = aStroke;
+    mLocalBounds[aIndex] = Sdf::ComputeStrokeLocalBounds(aStroke);
+    mBounds[aIndex] = Sdf::ComputeStrokeBounds(aStroke, mFieldMargin);
+
+    mUpdatedIndices.push_back(uint32_t(aIndex));
+    mUpdatedCount++;
+}
+
+void CStrokeBoundsCache::EndUpdate()
+{
+    if (mDirtyStrokes.empty())
+    {
+        return;
+    }
+
+    // Both versions of the strokes after the first change carry it with their blends
+    uint32_t lFirstDirty = UINT32_MAX;
+    for (TDirtyStroke const& lDirty : mDirtyStrokes)
+    {
+        lFirstDirty = glm::min(lFirstDirty, lDirty.mIndex);
+    }
+
+    for (size_t i = size_t(lFirstDirty) + 1; i < mStrokes.size(); i++)
+    {
+        mDirtyBlendMargin = glm::max(mDirtyBlendMargin, Sdf::ComputeStrokeBlendMargin(mStrokes[i]));
+    }
+
+    for (TDirtyStroke const& lDirty : mDirtyStrokes)
+    {
+        if (lDirty.mIndex > lFirstDirty)
+        {
+            mDirtyBlendMargin = glm::max(mDirtyBlendMargin, Sdf::ComputeStrokeBlendMargin(lDirty.mStroke));
+        }
+    }
+
+    // Padded in stroke space like the cull bounds, ellipsoids need more than a plain expand
+    for (TDirtyStroke const& lDirty : mDirtyStrokes)
+    {
+        mDirtyBounds.Extend(Sdf::ComputeStrokeBounds(lDirty.mStroke, mFieldMargin + mDirtyBlendMargin));
+    }
+
+    mSceneBounds.Reset();
+    for (TAabb const& lBounds : mBounds)
+    {
+        mSceneBounds.Extend(lBounds);
+    }
+}
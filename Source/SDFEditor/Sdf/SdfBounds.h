@@ -0,0 +1,92 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Conservative bounds of the region each stroke can modify
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDFEditor/Tool/StrokeInfo.h>
+#include <SDFEditor/Math/Aabb.h>
+
+namespace Sdf
+{
+    // Primitive bounds in stroke space (centered at posb, rotated by quat), no blend
+    TAabb ComputeStrokeLocalBounds(stroke_t const& aStroke);
+
+    // Distance around the primitive where the smooth operation can move the surface
+    float ComputeStrokeBlendMargin(stroke_t const& aStroke);
+
+    // Local to world transform of the stroke (inverse of quatMultVec3(quat, p - pos))
+    glm::mat4 ComputeStrokeMatrix(stroke_t const& aStroke);
+
+    // Local padding where the primitive field is under aFieldDistance. The
+    // ellipsoid approximation underestimates off axis, its padding is
+    // scaled per axis by radius / min radius
+    glm::vec3 ComputeStrokeFieldPadding(stroke_t const& aStroke, float aFieldDistance);
+
+    // World AABB of local bounds + blend margin + aFieldMargin, including the mirrored copies
+    TAabb ComputeStrokeBounds(stroke_t const& aStroke, float aFieldMargin = 0.0f);
+
+    // World AABB of a box in stroke space, without mirrored copies
+    TAabb TransformStrokeBounds(stroke_t const& aStroke, TAabb const& aLocalBounds);
+}
+
+// Per stroke bounds, recomputed only for the strokes that changed since the last update
+class CStrokeBoundsCache
+{
+public:
+    // Returns the number of strokes whose bounds were recomputed
+    size_t Update(std::vector<TStrokeInfo> const& aStrokes);
+    size_t Update(std::vector<stroke_t> const& aStrokes);
+
+    size_t GetCount() const { return mStrokes.size(); }
+    stroke_t const& GetStroke(size_t aIndex) const { return mStrokes[aIndex]; }
+    TAabb const& GetLocalBounds(size_t aIndex) const { return mLocalBounds[aIndex]; }
+    TAabb const& GetBounds(size_t aIndex) const { return mBounds[aIndex]; }
+    std::vector<TAabb> const& GetBoundsArray() const { return mBounds; }
+    TAabb const& GetSceneBounds() const { return mSceneBounds; }
+
+    // Strokes recomputed by the last update, in index order
+    std::vector<uint32_t> const& GetUpdatedIndices() const { return mUpdatedIndices; }
+
+    // Union of old and new bounds of the strokes changed, added or removed by the
+    // last update. Their field margin also covers the widest blend margin of the
+    // strokes after the first of them, the smooth ops that can bring the change
+    // back under the field margin (see CSdfCullGrid)
+    TAabb const& GetDirtyBounds() const { return mDirtyBounds; }
+    float GetDirtyBlendMargin() const { return mDirtyBlendMargin; }
+
+    // An intersection changed in the last update, it modifies the field outside its bounds
+    bool IsDirtyUnbounded() const { return mDirtyUnbounded; }
+
+    // Extra field distance covered by the bounds (see Sdf::ComputeStrokeBounds), forces a full update
+    void SetFieldMargin(float aFieldMargin);
+    float GetFieldMargin() const { return mFieldMargin; }
+
+    void Clear();
+
+private:
+    // Old or new version of a stroke changed by the update
+    struct TDirtyStroke
+    {
+        uint32_t mIndex;
+        stroke_t mStroke;
+    };
+
+    void BeginUpdate(size_t aCount);
+    void UpdateStroke(size_t aIndex, stroke_t const& aStroke);
+    void EndUpdate();
+
+    std::vector<stroke_t> mStrokes;     // snapshot used to detect changes
+    std::vector<TAabb> mLocalBounds;
+    std::vector<TAabb> mBounds;
+    TAabb mSceneBounds;
+    TAabb mDirtyBounds;
+    std::vector<TDirtyStroke> mDirtyStrokes;
+    std::vector<uint32_t> mUpdatedIndices;
+    size_t mUpdatedCount{ 0 };
+    float mDirtyBlendMargin{ 0.0f };
+    bool mDirtyUnbounded{ false };
+    float mFieldMargin{ 0.0f };
+};
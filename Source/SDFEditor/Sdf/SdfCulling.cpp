@@ -0,0 +1,90 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfCulling.h"
+#include "SdfBounds.h"
+
+void CSdfCullGrid::Build(stroke_t const* aStrokes, size_t aCount, TSdfBakeParams const& aParams, glm::ivec3 const& aCellMin, glm::ivec3 const& aCellMax)
+{
+    mCellsPerSide = aParams.GetCullCellsPerSide();
+    mCellVoxels = aParams.mCullCellVoxels;
+    mMargin = aParams.mCullMargin;
+
+    const size_t lNumCells = size_t(mCellsPerSide) * size_t(mCellsPerSide) * size_t(mCellsPerSide);
+    const float lCellSide = float(mCellVoxels) * aParams.mLutVoxelSide;
+    const glm::vec3 lGridOrigin(-0.5f * float(aParams.mLutSize) * aParams.mLutVoxelSide);
+    const glm::ivec3 lRegionMin = glm::max(aCellMin, glm::ivec3(0));
+    const glm::ivec3 lRegionMax = glm::min(aCellMax, glm::ivec3(mCellsPerSide)) - 1;
+
+    std::vector<std::vector<uint32_t>> lCellLists(lNumCells);
+    std::vector<uint8_t> lCellTouched(lNumCells);
+
+    // Widest blend margin of the strokes after each one. A dropped stroke still
+    // changes the running distance past the margin, a later blend reads it that
+    // far back into the band
+    std::vector<float> lLaterBlends(aCount);
+    float lLaterBlend = 0.0f;
+    for (size_t i = aCount; i-- > 0; )
+    {
+        lLaterBlends[i] = lLaterBlend;
+        lLaterBlend = glm::max(lLaterBlend, Sdf::ComputeStrokeBlendMargin(aStrokes[i]));
+    }
+
+    for (size_t i = 0; i < aCount; i++)
+    {
+        stroke_t const& lStroke = aStrokes[i];
+        // The margin is padded in stroke space, ellipsoids need more than a plain expand
+        const TAabb lBounds = Sdf::ComputeStrokeBounds(lStroke, mMargin + lLaterBlends[i]);
+
+        glm::ivec3 lMinCell(0);
+        glm::ivec3 lMaxCell(-1);
+        if (!lBounds.IsEmpty())
+        {
+            lMinCell = glm::max(glm::ivec3(glm::floor((lBounds.mMin - lGridOrigin) / lCellSide)), lRegionMin);
+            lMaxCell = glm::min(glm::ivec3(glm::floor((lBounds.mMax - lGridOrigin) / lCellSide)), lRegionMax);
+        }
+
+        const bool lIntersect = (lStroke.id.y & EStrokeOp::OpsMaskMode) == EStrokeOp::OpIntersect;
+        if (lIntersect)
+        {
+            std::fill(lCellTouched.begin(), lCellTouched.end(), uint8_t(0));
+        }
+
+        for (int32_t z = lMinCell.z; z <= lMaxCell.z; z++)
+        {
+            for (int32_t y = lMinCell.y; y <= lMaxCell.y; y++)
+            {
+                for (int32_t x = lMinCell.x; x <= lMaxCell.x; x++)
+                {
+                    const uint32_t lCell = GetCellIndex(glm::ivec3(x, y, z));
+                    lCellLists[lCell].push_back(uint32_t(i));
+                    lCellTouched[lCell] = 1;
+                }
+            }
+        }
+
+        // Outside its bounds the intersection discards everything before it
+        if (lIntersect)
+        {
+            for (size_t c = 0; c < lNumCells; c++)
+            {
+                if (!lCellTouched[c])
+                {
+                    lCellLists[c].clear();
+                }
+            }
+        }
+    }
+
+    mCellOffsets.resize(lNumCells + 1);
+    mCellOffsets[0] = 0;
+    for (size_t c = 0; c < lNumCells; c++)
+    {
+        mCellOffsets[c + 1] = mCellOffsets[c] + uint32_t(lCellLists[c].size());
+    }
+
+    mCellStrokes.resize(mCellOffsets[lNumCells]);
+    for (size_t c = 0; c < lNumCells; c++)
+    {
+        std::copy(lCellLists[c].begin(), lCellLists[c].end(), mCellStrokes.begin() + mCellOffsets[c]);
+    }
+}
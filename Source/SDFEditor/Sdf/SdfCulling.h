@@ -0,0 +1,51 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Strokes binned in coarse cells of the LUT volume
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDFEditor/Sdf/SdfBakeParams.h>
+#include <SDFEditor/Math/Aabb.h>
+
+struct stroke_t;
+
+// Each cell lists, in CSG order, the strokes that can change its distances
+// within +-mCullMargin. Values past the margin are not exact and must be
+// clamped to it. Strokes left out of a cell:
+// - union / subtract far from the cell: union can't lower the distance under
+//   the margin and subtract only acts on distances already under -margin.
+// - intersect far from the cell: the result is at least its shape distance,
+//   so every previous stroke is dropped from the cell list too.
+// Far means past the margin plus the widest blend margin of the strokes after
+// it, so the next smooth op can't bring what it changed back under the margin.
+// Through a chain of wide blends only a damped part of it can come back.
+class CSdfCullGrid
+{
+public:
+    // Only the cells in [aCellMin, aCellMax) get their lists, the rest stay empty
+    void Build(stroke_t const* aStrokes, size_t aCount, TSdfBakeParams const& aParams,
+               glm::ivec3 const& aCellMin = glm::ivec3(0), glm::ivec3 const& aCellMax = glm::ivec3(INT32_MAX));
+
+    int32_t GetCellsPerSide() const { return mCellsPerSide; }
+    int32_t GetCellVoxels() const { return mCellVoxels; }
+    size_t GetCellsCount() const { return mCellOffsets.empty() ? 0 : mCellOffsets.size() - 1; }
+    float GetMargin() const { return mMargin; }
+
+    uint32_t GetCellIndex(glm::ivec3 const& aCell) const { return uint32_t((aCell.z * mCellsPerSide + aCell.y) * mCellsPerSide + aCell.x); }
+    glm::ivec3 GetCellFromLutCoord(glm::ivec3 const& aLutCoord) const { return aLutCoord / mCellVoxels; }
+
+    uint32_t const* GetCellStrokes(uint32_t aCell) const { return mCellStrokes.data() + mCellOffsets[aCell]; }
+    uint32_t GetCellStrokesCount(uint32_t aCell) const { return mCellOffsets[aCell + 1] - mCellOffsets[aCell]; }
+
+    // Sum of all the cell lists, to compare against cells * strokes
+    size_t GetTotalEntries() const { return mCellStrokes.size(); }
+
+private:
+    int32_t mCellsPerSide{ 0 };
+    int32_t mCellVoxels{ 0 };
+    float mMargin{ 0.0f };
+    std::vector<uint32_t> mCellOffsets;     // mCellOffsets[i] .. mCellOffsets[i + 1] in mCellStrokes
+    std::vector<uint32_t> mCellStrokes;
+};
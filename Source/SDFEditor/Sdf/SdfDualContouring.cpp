@@ -0,0 +1,563 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfDualContouring.h"
+#include "SdfMesh.h"
+#include "SdfMeshGrid.h"
+
+#include <sbx/Core/Parallel.h>
+#include <sbx/Core/ErrorHandling.h>
+
+#include <chrono>
+
+namespace
+{
+    // Bricks per chunk of work
+    constexpr size_t kBricksPerChunk = 16;
+
+    // Offsets of the crossing normals, in cells. Small enough to only blend
+    // the two sides of a crease on crossings right next to it
+    constexpr float kHermiteEpsCells = 0.05f;
+
+    // False position steps on the crossings. The linear guess is off next to
+    // the creases, outside them the distance is to the edge, not to a plane
+    constexpr int32_t kCrossingSteps = 2;
+
+    // Singular values of the QEF below this fraction of the largest are
+    // dropped, the vertex stays at the mass point along those directions
+    constexpr double kQefTolerance = 0.1;
+    constexpr int32_t kJacobiSweeps = 8;
+
+    constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+    // Corner c of a cell is at (c & 1, (c >> 1) & 1, c >> 2), edge e runs along
+    // axis e / 4 between the corners in kEdgeCorners
+    constexpr int32_t kEdgeCorners[12][2] =
+    {
+        {0, 1}, {2, 3}, {4, 5}, {6, 7},
+        {0, 2}, {1, 3}, {4, 6}, {5, 7},
+        {0, 4}, {1, 5}, {2, 6}, {3, 7},
+    };
+
+    // Quadric of the tangent planes n . (x - p) = 0 of a cell
+    struct TQef
+    {
+        double mAtA[3][3]{};
+        glm::dvec3 mNormals[12];
+        glm::dvec3 mPoints[12];
+        glm::dvec3 mMassPoint{ 0.0 };
+        int32_t mCount{ 0 };
+
+        void Add(glm::vec3 const& aPoint, glm::vec3 const& aNormal)
+        {
+            SBX_ASSERT(mCount < 12, "More crossings than cell edges");
+            mNormals[mCount] = glm::dvec3(aNormal);
+            mPoints[mCount] = glm::dvec3(aPoint);
+            mMassPoint += glm::dvec3(aPoint);
+            mCount++;
+        }
+
+        glm::dvec3 Solve()
+        {
+            mMassPoint /= double(mCount);
+
+            // Around the mass point, the dropped directions keep it
+            glm::dvec3 lAtb(0.0);
+            for (int32_t i = 0; i < mCount; i++)
+            {
+                glm::dvec3 const& lN = mNormals[i];
+                const double lB = glm::dot(lN, mPoints[i] - mMassPoint);
+                for (int32_t r = 0; r < 3; r++)
+                {
+                    for (int32_t c = 0; c < 3; c++)
+                    {
+                        mAtA[r][c] += lN[r] * lN[c];
+                    }
+                }
+                lAtb += lN * lB;
+            }
+
+            double lVectors[3][3];
+            double lValues[3];
+            SolveSymmetricEigen(lVectors, lValues);
+
+            const double lMaxValue = glm::max(lValues[0], glm::max(lValues[1], lValues[2]));
+            const double lMinValue = lMaxValue * kQefTolerance * kQefTolerance;
+
+            glm::dvec3 lOffset(0.0);
+            for (int32_t k = 0; k < 3; k++)
+            {
+                if (lValues[k] > lMinValue && lValues[k] > 0.0)
+                {
+                    const glm::dvec3 lVector(lVectors[0][k], lVectors[1][k], lVectors[2][k]);
+                    lOffset += lVector * (glm::dot(lVector, lAtb) / lValues[k]);
+                }
+            }
+
+            return mMassPoint + lOffset;
+        }
+
+        // Cyclic Jacobi rotations of mAtA, the columns of aOutVectors are the eigenvectors
+        void SolveSymmetricEigen(double aOutVectors[3][3], double aOutValues[3])
+        {
+            double lA[3][3];
+            for (int32_t r = 0; r < 3; r++)
+            {
+                for (int32_t c = 0; c < 3; c++)
+                {
+                    lA[r][c] = mAtA[r][c];
+                    aOutVectors[r][c] = (r == c) ? 1.0 : 0.0;
+                }
+            }
+
+            const int32_t lPairs[3][2] = { {0, 1}, {0, 2}, {1, 2} };
+            for (int32_t lSweep = 0; lSweep < kJacobiSweeps; lSweep++)
+            {
+                for (auto const& lPair : lPairs)
+                {
+                    const int32_t p = lPair[0];
+                    const int32_t q = lPair[1];
+                    if (glm::abs(lA[p][q]) < 1e-12)
+                    {
+                        continue;
+                    }
+
+                    const double lTheta = (lA[q][q] - lA[p][p]) / (2.0 * lA[p][q]);
+                    const double lT = ((lTheta >= 0.0) ? 1.0 : -1.0) / (glm::abs(lTheta) + glm::sqrt(lTheta * lTheta + 1.0));
+                    const double lC = 1.0 / glm::sqrt(lT * lT + 1.0);
+                    const double lS = lT * lC;
+
+                    for (int32_t k = 0; k < 3; k++)
+                    {
+                        const double lKP = lA[k][p];
+                        const double lKQ = lA[k][q];
+                        lA[k][p] = lC * lKP - lS * lKQ;
+                        lA[k][q] = lS * lKP + lC * lKQ;
+                    }
+                    for (int32_t k = 0; k < 3; k++)
+                    {
+                        const double lPK = lA[p][k];
+                        const double lQK = lA[q][k];
+                        lA[p][k] = lC * lPK - lS * lQK;
+                        lA[q][k] = lS * lPK + lC * lQK;
+                    }
+                    for (int32_t k = 0; k < 3; k++)
+                    {
+                        const double lKP = aOutVectors[k][p];
+                        const double lKQ = aOutVectors[k][q];
+                        aOutVectors[k][p] = lC * lKP - lS * lKQ;
+                        aOutVectors[k][q] = lS * lKP + lC * lKQ;
+                    }
+                }
+            }
+
+            for (int32_t k = 0; k < 3; k++)
+            {
+                aOutValues[k] = lA[k][k];
+            }
+        }
+    };
+
+    // Edge interval around a crossing, ends with opposite signs
+    struct TCrossingBracket
+    {
+        float mT0;
+        float mT1;
+        float mDist0;
+        float mDist1;
+        float mT;                           // last guess
+        glm::vec3 mFrom;
+        glm::vec3 mTo;
+
+        glm::vec3 Step(float aDist)
+        {
+            if ((aDist < 0.0f) == (mDist0 < 0.0f))
+            {
+                mT0 = mT;
+                mDist0 = aDist;
+            }
+            else
+            {
+                mT1 = mT;
+                mDist1 = aDist;
+            }
+            mT = (mDist0 != mDist1) ? glm::clamp(mT0 + (mT1 - mT0) * mDist0 / (mDist0 - mDist1), mT0, mT1) : 0.5f * (mT0 + mT1);
+            return glm::mix(mFrom, mTo, mT);
+        }
+    };
+
+    // Grid edge crossing the surface, the quad of its cells goes to the brick of its lower point
+    struct TQuadEdge
+    {
+        glm::ivec3 mGridCoord;
+        int32_t mAxis;
+        bool mFlip;                         // lower point outside, the quad faces -axis
+    };
+
+    struct TChunkMesh
+    {
+        std::vector<glm::vec3> mPositions;
+        std::vector<uint64_t> mKeys;
+        std::vector<TQuadEdge> mEdges;
+        std::vector<glm::ivec3> mEdgeBricks; // LUT coord of the brick of each edge group
+        std::vector<size_t> mEdgeBrickEnds;
+        std::vector<uint32_t> mIndices;
+        size_t mFirstVertex{ 0 };
+        size_t mFirstIndex{ 0 };
+    };
+}
+
+TSdfMeshStats CSdfDualContouring::Extract(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, TSdfMesh& aOutMesh)
+{
+    aOutMesh.Clear();
+    return Extract(aEvaluator, aParams, [&aOutMesh](TSdfMesh const& aPiece)
+    {
+        aOutMesh.Append(aPiece);
+        return true;
+    });
+}
+
+TSdfMeshStats CSdfDualContouring::Extract(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, TSdfMeshSinkFn const& aSink)
+{
+    const auto lStartTime = std::chrono::steady_clock::now();
+
+    CSdfMeshGrid lGrid;
+    const TSdfLutBakeStats lLutStats = lGrid.Build(aEvaluator, aParams);
+    std::vector<glm::ivec3> const& lBricks = lGrid.GetBricks();
+
+    const int32_t lBrickSize = lGrid.GetBrickCells();
+    const int32_t lSide = lGrid.GetBrickSide();
+    const int32_t lBrickPoints = lGrid.GetBrickPoints();
+    const float lCellSide = lGrid.GetCellSide();
+    const uint32_t lThreads = (aParams.mThreads > 0) ? aParams.mThreads : sbx::GetHardwareThreadsCount();
+
+    int32_t lCornerOffsets[8];
+    for (int32_t c = 0; c < 8; c++)
+    {
+        lCornerOffsets[c] = ((c >> 2) * lSide + ((c >> 1) & 1)) * lSide + (c & 1);
+    }
+    const int32_t lAxisStrides[3] = { 1, lSide, lSide * lSide };
+
+    TSdfMeshStats lStats;
+    lStats.mBricks = uint32_t(lBricks.size());
+    lStats.mThreads = lThreads;
+    lStats.mStrokesPerVoxel = lLutStats.mStrokesPerVoxel;
+    lStats.mLutSeconds = lLutStats.mSeconds;
+
+    // Vertices of the top cell layer of the last slab, the quads of the next
+    // one reach them
+    std::vector<uint64_t> lSeamKeys;
+    std::vector<uint32_t> lSeamVertices;
+    std::vector<glm::vec3> lSeamPositions;
+
+    std::vector<TChunkMesh> lChunks;
+    std::vector<glm::vec3> lSlabPositions;  // seam ones first
+    std::vector<uint32_t> lSlabGlobal;
+    TSdfMesh lPiece;
+
+    for (size_t lSlabBegin = 0; lSlabBegin < lBricks.size();)
+    {
+        int32_t lSlabTop = 0;
+        const size_t lSlabEnd = lGrid.GetSlabEnd(lSlabBegin, lSlabTop);
+        const size_t lNumChunks = (lSlabEnd - lSlabBegin + kBricksPerChunk - 1) / kBricksPerChunk;
+
+        lChunks.clear();
+        lChunks.resize(lNumChunks);
+
+        // Cell vertices and the crossing edges of each brick
+        sbx::ParallelFor(lNumChunks, 1, [&](size_t aBegin, size_t aEnd, uint32_t)
+        {
+            TSdfMeshBrick lBrick;
+            std::vector<uint32_t> lEdgeCrossings(3 * lBrickPoints);
+            std::vector<glm::vec3> lCrossingPoints;
+            std::vector<glm::vec3> lCrossingNormals;
+            std::vector<TCrossingBracket> lCrossingBrackets;
+            std::vector<float> lCrossingDistances;
+            std::vector<int32_t> lCells;
+            std::vector<uint32_t> lCellCrossings;   // 12 per cell, kInvalidIndex past the last
+
+            for (size_t lChunkIndex = aBegin; lChunkIndex < aEnd; lChunkIndex++)
+            {
+                TChunkMesh& lChunk = lChunks[lChunkIndex];
+                const size_t lLastBrick = glm::min(lSlabBegin + (lChunkIndex + 1) * kBricksPerChunk, lSlabEnd);
+
+                for (size_t lBrickIndex = lSlabBegin + lChunkIndex * kBricksPerChunk; lBrickIndex < lLastBrick; lBrickIndex++)
+                {
+                    const glm::ivec3 lLutCoord = lBricks[lBrickIndex];
+                    const glm::ivec3 lGridOrigin = lLutCoord * lBrickSize;
+                    if (!lGrid.EvaluateBrick(lLutCoord, lBrick))
+                    {
+                        continue;
+                    }
+
+                    std::vector<glm::vec3> const& lPoints = lBrick.mPoints;
+                    std::vector<float> const& lDistances = lBrick.mDistances;
+                    std::fill(lEdgeCrossings.begin(), lEdgeCrossings.end(), kInvalidIndex);
+                    lCrossingPoints.clear();
+                    lCrossingBrackets.clear();
+                    lCells.clear();
+                    lCellCrossings.clear();
+
+                    for (int32_t z = 0; z < lBrickSize; z++)
+                    {
+                        for (int32_t y = 0; y < lBrickSize; y++)
+                        {
+                            for (int32_t x = 0; x < lBrickSize; x++)
+                            {
+                                const int32_t lCellPoint = (z * lSide + y) * lSide + x;
+                                uint32_t lConfig = 0;
+                                for (int32_t c = 0; c < 8; c++)
+                                {
+                                    lConfig |= (lDistances[lCellPoint + lCornerOffsets[c]] < 0.0f) ? (1u << c) : 0u;
+                                }
+                                if (lConfig == 0 || lConfig == 255)
+                                {
+                                    continue;
+                                }
+
+                                lCells.push_back(lCellPoint);
+                                for (int32_t e = 0; e < 12; e++)
+                                {
+                                    if (((lConfig >> kEdgeCorners[e][0]) & 1) == ((lConfig >> kEdgeCorners[e][1]) & 1))
+                                    {
+                                        continue;
+                                    }
+
+                                    const int32_t lAxis = e / 4;
+                                    const int32_t lFrom = lCellPoint + lCornerOffsets[kEdgeCorners[e][0]];
+                                    uint32_t& lCrossing = lEdgeCrossings[lAxis * lBrickPoints + lFrom];
+                                    if (lCrossing == kInvalidIndex)
+                                    {
+                                        const int32_t lTo = lFrom + lAxisStrides[lAxis];
+                                        const float lDistFrom = lDistances[lFrom];
+                                        const float lDistTo = lDistances[lTo];
+                                        const float lT = glm::clamp(lDistFrom / (lDistFrom - lDistTo), 0.0f, 1.0f);
+
+                                        lCrossing = uint32_t(lCrossingPoints.size());
+                                        lCrossingPoints.push_back(glm::mix(lPoints[lFrom], lPoints[lTo], lT));
+                                        lCrossingBrackets.push_back({ 0.0f, 1.0f, lDistFrom, lDistTo, lT, lPoints[lFrom], lPoints[lTo] });
+                                    }
+                                    lCellCrossings.push_back(lCrossing);
+                                }
+                                lCellCrossings.resize(lCells.size() * 12, kInvalidIndex);
+                            }
+                        }
+                    }
+
+                    lCrossingDistances.resize(lCrossingPoints.size());
+                    for (int32_t lStep = 0; lStep < kCrossingSteps; lStep++)
+                    {
+                        lGrid.EvaluateNear(lLutCoord, lCrossingPoints.data(), lCrossingPoints.size(), lCrossingDistances.data());
+                        for (size_t i = 0; i < lCrossingPoints.size(); i++)
+                        {
+                            lCrossingPoints[i] = lCrossingBrackets[i].Step(lCrossingDistances[i]);
+                        }
+                    }
+
+                    lCrossingNormals.resize(lCrossingPoints.size());
+                    lGrid.EvaluateNormals(lLutCoord, lCrossingPoints.data(), lCrossingPoints.size(), lCellSide * kHermiteEpsCells,
+                                          lCrossingNormals.data(), lBrick);
+
+                    // Vertices clamped to their cell, the QEF of a crease can point far away on almost parallel planes
+                    for (size_t c = 0; c < lCells.size(); c++)
+                    {
+                        TQef lQef;
+                        for (size_t i = c * 12; i < (c + 1) * 12 && lCellCrossings[i] != kInvalidIndex; i++)
+                        {
+                            lQef.Add(lCrossingPoints[lCellCrossings[i]], lCrossingNormals[lCellCrossings[i]]);
+                        }
+
+                        const int32_t lCellPoint = lCells[c];
+                        const glm::ivec3 lCellCoord(lCellPoint % lSide, (lCellPoint / lSide) % lSide, lCellPoint / (lSide * lSide));
+                        const glm::vec3 lCellMin = lPoints[lCellPoint];
+                        const glm::vec3 lVertex = glm::clamp(glm::vec3(lQef.Solve()), lCellMin, lCellMin + glm::vec3(lCellSide));
+
+                        lChunk.mPositions.push_back(lVertex);
+                        lChunk.mKeys.push_back(CSdfMeshGrid::GetKey(lGridOrigin + lCellCoord, 0));
+                    }
+
+                    // Crossing edges starting in the brick, the ones on its upper faces start in the next
+                    const size_t lFirstEdge = lChunk.mEdges.size();
+                    for (int32_t z = 0; z < lBrickSize; z++)
+                    {
+                        for (int32_t y = 0; y < lBrickSize; y++)
+                        {
+                            for (int32_t x = 0; x < lBrickSize; x++)
+                            {
+                                const int32_t lFrom = (z * lSide + y) * lSide + x;
+                                const bool lInside = lDistances[lFrom] < 0.0f;
+                                for (int32_t lAxis = 0; lAxis < 3; lAxis++)
+                                {
+                                    if (lInside != (lDistances[lFrom + lAxisStrides[lAxis]] < 0.0f))
+                                    {
+                                        lChunk.mEdges.push_back({ lGridOrigin + glm::ivec3(x, y, z), lAxis, !lInside });
+                                    }
+                                }
+                            }
+                        }
+                    }
+                    if (lChunk.mEdges.size() > lFirstEdge)
+                    {
+                        lChunk.mEdgeBricks.push_back(lLutCoord);
+                        lChunk.mEdgeBrickEnds.push_back(lChunk.mEdges.size());
+                    }
+                }
+            }
+        }, lThreads);
+
+        const auto lWeldStartTime = std::chrono::steady_clock::now();
+
+        // Cells are solved by a single brick, vertices go in chunk order after the seam ones
+        const size_t lNumSeam = lSeamKeys.size();
+        size_t lNumVertices = lNumSeam;
+        for (TChunkMesh& lChunk : lChunks)
+        {
+            lChunk.mFirstVertex = lNumVertices;
+            lNumVertices += lChunk.mPositions.size();
+        }
+        SBX_ASSERT(lStats.mVertices + lNumVertices - lNumSeam < kInvalidIndex, "Too many mesh vertices");
+
+        CSdfMeshKeyTable lCellTable(lNumVertices * 2);
+        lSlabPositions.resize(lNumVertices);
+        lSlabGlobal.resize(lNumVertices);
+        for (size_t v = 0; v < lNumSeam; v++)
+        {
+            lCellTable.Insert(lSeamKeys[v], uint32_t(v));
+            lSlabPositions[v] = lSeamPositions[v];
+            lSlabGlobal[v] = lSeamVertices[v];
+        }
+
+        sbx::ParallelFor(lNumChunks, 1, [&](size_t aBegin, size_t aEnd, uint32_t)
+        {
+            for (size_t c = aBegin; c < aEnd; c++)
+            {
+                TChunkMesh const& lChunk = lChunks[c];
+                for (size_t v = 0; v < lChunk.mPositions.size(); v++)
+                {
+                    const size_t lVertex = lChunk.mFirstVertex + v;
+                    lSlabPositions[lVertex] = lChunk.mPositions[v];
+                    lSlabGlobal[lVertex] = uint32_t(lStats.mVertices + lVertex - lNumSeam);
+                    lCellTable.Insert(lChunk.mKeys[v], uint32_t(lVertex));
+                }
+            }
+        }, lThreads);
+
+        // Quads of the four cells around each crossing edge, counter clockwise
+        // around +axis when the lower point is inside
+        sbx::ParallelFor(lNumChunks, 1, [&](size_t aBegin, size_t aEnd, uint32_t)
+        {
+            std::vector<uint32_t> lQuads;
+            std::vector<glm::vec3> lMidPoints;
+            std::vector<float> lMidDistances;
+
+            for (size_t c = aBegin; c < aEnd; c++)
+            {
+                TChunkMesh& lChunk = lChunks[c];
+                size_t lBrickEdge = 0;
+                for (size_t b = 0; b < lChunk.mEdgeBricks.size(); b++)
+                {
+                    lQuads.clear();
+                    lMidPoints.clear();
+                    for (; lBrickEdge < lChunk.mEdgeBrickEnds[b]; lBrickEdge++)
+                    {
+                        TQuadEdge const& lEdge = lChunk.mEdges[lBrickEdge];
+                        glm::ivec3 lAxisB(0);
+                        glm::ivec3 lAxisC(0);
+                        lAxisB[(lEdge.mAxis + 1) % 3] = 1;
+                        lAxisC[(lEdge.mAxis + 2) % 3] = 1;
+
+                        const glm::ivec3 lCells[4] = { lEdge.mGridCoord, lEdge.mGridCoord - lAxisB, lEdge.mGridCoord - lAxisB - lAxisC, lEdge.mGridCoord - lAxisC };
+                        uint32_t lQuad[4];
+                        bool lComplete = true;
+                        for (int32_t k = 0; k < 4 && lComplete; k++)
+                        {
+                            // Edges on the grid border miss the outer cells
+                            uint32_t& lVertex = lQuad[lEdge.mFlip ? 3 - k : k];
+                            lComplete = glm::all(glm::greaterThanEqual(lCells[k], glm::ivec3(0)));
+                            lVertex = lComplete ? lCellTable.Find(CSdfMeshGrid::GetKey(lCells[k], 0)) : kInvalidIndex;
+                            lComplete &= (lVertex != kInvalidIndex);
+                        }
+                        if (!lComplete)
+                        {
+                            continue;
+                        }
+
+                        lQuads.insert(lQuads.end(), lQuad, lQuad + 4);
+                        lMidPoints.push_back(0.5f * (lSlabPositions[lQuad[0]] + lSlabPositions[lQuad[2]]));
+                        lMidPoints.push_back(0.5f * (lSlabPositions[lQuad[1]] + lSlabPositions[lQuad[3]]));
+                    }
+
+                    lMidDistances.resize(lMidPoints.size());
+                    lGrid.EvaluateNear(lChunk.mEdgeBricks[b], lMidPoints.data(), lMidPoints.size(), lMidDistances.data());
+
+                    // A crease between two quad vertices keeps its diagonal on the surface
+                    for (size_t q = 0; q < lQuads.size() / 4; q++)
+                    {
+                        uint32_t lQuad[4];
+                        for (int32_t k = 0; k < 4; k++)
+                        {
+                            lQuad[k] = lSlabGlobal[lQuads[q * 4 + k]];
+                        }
+
+                        if (glm::abs(lMidDistances[q * 2]) <= glm::abs(lMidDistances[q * 2 + 1]))
+                        {
+                            lChunk.mIndices.insert(lChunk.mIndices.end(), { lQuad[0], lQuad[1], lQuad[2], lQuad[0], lQuad[2], lQuad[3] });
+                        }
+                        else
+                        {
+                            lChunk.mIndices.insert(lChunk.mIndices.end(), { lQuad[0], lQuad[1], lQuad[3], lQuad[1], lQuad[2], lQuad[3] });
+                        }
+                    }
+                }
+            }
+        }, lThreads);
+
+        size_t lNumIndices = 0;
+        for (TChunkMesh& lChunk : lChunks)
+        {
+            lChunk.mFirstIndex = lNumIndices;
+            lNumIndices += lChunk.mIndices.size();
+        }
+
+        lPiece.mPositions.assign(lSlabPositions.begin() + lNumSeam, lSlabPositions.end());
+        lPiece.mIndices.resize(lNumIndices);
+        sbx::ParallelFor(lNumChunks, 1, [&](size_t aBegin, size_t aEnd, uint32_t)
+        {
+            for (size_t c = aBegin; c < aEnd; c++)
+            {
+                TChunkMesh const& lChunk = lChunks[c];
+                std::copy(lChunk.mIndices.begin(), lChunk.mIndices.end(), lPiece.mIndices.begin() + lChunk.mFirstIndex);
+            }
+        }, lThreads);
+
+        lSeamKeys.clear();
+        lSeamVertices.clear();
+        lSeamPositions.clear();
+        for (TChunkMesh const& lChunk : lChunks)
+        {
+            for (size_t v = 0; v < lChunk.mKeys.size(); v++)
+            {
+                if (CSdfMeshGrid::GetKeyCoord(lChunk.mKeys[v]).z == lSlabTop - 1)
+                {
+                    lSeamKeys.push_back(lChunk.mKeys[v]);
+                    lSeamVertices.push_back(lSlabGlobal[lChunk.mFirstVertex + v]);
+                    lSeamPositions.push_back(lChunk.mPositions[v]);
+                }
+            }
+        }
+
+        lStats.mVertices += lPiece.GetVerticesCount();
+        lStats.mTriangles += lPiece.GetTrianglesCount();
+        lStats.mMaxSlabTriangles = glm::max(lStats.mMaxSlabTriangles, lPiece.GetTrianglesCount());
+        lStats.mSlabs++;
+        lStats.mWeldSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - lWeldStartTime).count();
+
+        if (!aSink(lPiece))
+        {
+            break;
+        }
+        lSlabBegin = lSlabEnd;
+    }
+
+    lStats.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStartTime).count();
+    return lStats;
+}
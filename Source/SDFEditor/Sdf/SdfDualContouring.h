@@ -0,0 +1,35 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Narrow band dual contouring over the LUT volume
+
+#pragma once
+
+#include <cstdint>
+
+#include <SDFEditor/Sdf/SdfBakeParams.h>
+#include <SDFEditor/Sdf/SdfMesh.h>
+
+class CSdfEvaluator;
+
+// Dual contouring on the bricks of a CSdfMeshGrid. Each cell the surface
+// crosses gets one vertex, the minimizer of the QEF of the tangent planes at
+// its edge crossings, so box edges and corners stay sharp on a much coarser
+// grid than marching cubes needs. Every crossing edge emits a quad joining the
+// vertices of its four cells, split along the diagonal closer to the surface.
+// Bricks are solved in parallel, cell vertices are found across bricks
+// through a lock free hash of the grid cells, and the output only depends on
+// the brick order.
+// The mesh has no normals: vertices on the creases have no single one, let
+// the tools importing it smooth by angle.
+class CSdfDualContouring
+{
+public:
+    // Mesh cells per LUT voxel side, a quarter of the atlas grid: sharp edges
+    // with about 16 times fewer triangles than marching cubes on the atlas grid
+    static constexpr int32_t kDefaultBrickSize = 2;
+
+    TSdfMeshStats Extract(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, TSdfMesh& aOutMesh);
+
+    // Slabs of LUT voxel layers go to aSink as they are finished, only the
+    // vertices of the top cell layer are kept for the next slab
+    TSdfMeshStats Extract(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, TSdfMeshSinkFn const& aSink);
+};
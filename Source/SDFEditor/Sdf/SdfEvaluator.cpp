@@ -0,0 +1,224 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfEvaluator.h"
+
+namespace Sdf
+{
+    // - MATHS -------------------------------
+    glm::vec3 QuatMultVec3(glm::vec4 const& aQuat, glm::vec3 const& aVec)
+    {
+        const glm::vec3 lQ(aQuat.x, aQuat.y, aQuat.z);
+        const glm::vec3 t = glm::cross(lQ, glm::cross(lQ, aVec) + aQuat.w * aVec);
+        return aVec + t + t;
+    }
+
+    // - SMOOTH OPERATIONS --------------------------
+    // https://www.shadertoy.com/view/lt3BW2
+    float OpSmoothUnion(float aD1, float aD2, float aK)
+    {
+        float h = glm::max(aK - glm::abs(aD1 - aD2), 0.0f);
+        return glm::min(aD1, aD2) - h * h * 0.25f / aK;
+    }
+
+    float OpSmoothSubtraction(float aD1, float aD2, float aK)
+    {
+        float h = glm::max(aK - glm::abs(-aD1 - aD2), 0.0f);
+        return glm::max(-aD1, aD2) + h * h * 0.25f / aK;
+    }
+
+    float OpSmoothIntersection(float aD1, float aD2, float aK)
+    {
+        float h = glm::max(aK - glm::abs(aD1 - aD2), 0.0f);
+        return glm::max(aD1, aD2) + h * h * 0.25f / aK;
+    }
+
+    // - SDF Primitives ---------------------
+    float SdEllipsoid(glm::vec3 const& aPos, glm::vec3 const& aRadius)
+    {
+        float k0 = glm::length(aPos / aRadius);
+        float k1 = glm::length(aPos / (aRadius * aRadius));
+        return k0 * (k0 - 1.0f) / k1;
+    }
+
+    float SdRoundBox(glm::vec3 const& aPos, glm::vec3 const& aHalfSize, float aRound)
+    {
+        glm::vec3 q = glm::abs(aPos) - aHalfSize;
+        return glm::length(glm::max(q, 0.0f)) + glm::min(glm::max(q.x, glm::max(q.y, q.z)), 0.0f) - aRound;
+    }
+
+    float SdTorus(glm::vec3 const& aPos, glm::vec2 const& aRadius)
+    {
+        glm::vec2 q = glm::vec2(glm::length(glm::vec2(aPos.x, aPos.z)) - aRadius.x, aPos.y);
+        return glm::length(q) - aRadius.y;
+    }
+
+    float SdVerticalCapsule(glm::vec3 aPos, float aHeight, float aRadius)
+    {
+        aPos.y -= glm::clamp(aPos.y, 0.0f, aHeight);
+        return glm::length(aPos) - aRadius;
+    }
+
+    // - STROKE EVALUATION --------------
+    float EvalStroke(glm::vec3 aPos, stroke_t const& aStroke)
+    {
+        float lShape = 1000000.0f;
+
+        if ((aStroke.id.y & EStrokeOp::OpMirrorX) == EStrokeOp::OpMirrorX)
+        {
+            aPos.x = glm::abs(aPos.x);
+        }
+
+        if ((aStroke.id.y & EStrokeOp::OpMirrorY) == EStrokeOp::OpMirrorY)
+        {
+            aPos.y = glm::abs(aPos.y);
+        }
+
+        glm::vec3 lPosition = aPos - glm::vec3(aStroke.posb);
+        lPosition = QuatMultVec3(aStroke.quat, lPosition);
+
+        const glm::vec3 lSize = glm::vec3(aStroke.param0);
+
+        if (aStroke.id.x == EPrimitive::PrEllipsoid)
+        {
+            lShape = SdEllipsoid(lPosition, lSize);
+        }
+        else if (aStroke.id.x == EPrimitive::PrBox)
+        {
+            float lRound = glm::clamp(aStroke.param0.w, 0.0f, 1.0f);
+            float lSmaller = glm::min(glm::min(aStroke.param0.x, aStroke.param0.y), aStroke.param0.z);
+            lRound = glm::mix(0.0f, lSmaller, lRound);
+            lShape = SdRoundBox(lPosition, lSize - lRound, lRound);
+        }
+        else if (aStroke.id.x == EPrimitive::PrTorus)
+        {
+            lShape = SdTorus(lPosition, glm::vec2(aStroke.param0));
+        }
+        else if (aStroke.id.x == EPrimitive::PrCapsule)
+        {
+            glm::vec2 lParams = glm::max(glm::vec2(aStroke.param0), glm::vec2(0.0f, 0.0f));
+            lShape = SdVerticalCapsule(lPosition - glm::vec3(0.0f, -lParams.y + lParams.x, 0.0f), lParams.y * 2.0f - lParams.x * 2.0f, lParams.x);
+        }
+
+        return lShape;
+    }
+
+    float ApplyStrokeOp(float aShape, float aDist, stroke_t const& aStroke)
+    {
+        const float lClampedBlend = glm::max(0.0001f, aStroke.posb.w);
+
+        // Same branch order as the shader, OpReplace falls into subtract
+        if ((aStroke.id.y & EStrokeOp::OpsMaskMode) == EStrokeOp::OpAdd)
+        {
+            return OpSmoothUnion(aShape, aDist, lClampedBlend);
+        }
+        else if ((aStroke.id.y & EStrokeOp::OpSubtract) == EStrokeOp::OpSubtract)
+        {
+            return OpSmoothSubtraction(aShape + lClampedBlend * 0.4f, aDist, lClampedBlend);
+        }
+        else if ((aStroke.id.y & EStrokeOp::OpIntersect) == EStrokeOp::OpIntersect)
+        {
+            return OpSmoothIntersection(aShape, aDist, lClampedBlend);
+        }
+
+        return aDist;
+    }
+
+    float DistToScene(glm::vec3 const& aPos, stroke_t const* aStrokes, size_t aCount)
+    {
+        float d = kFarDistance;
+
+        for (size_t i = 0; i < aCount; i++)
+        {
+            d = ApplyStrokeOp(EvalStroke(aPos, aStrokes[i]), d, aStrokes[i]);
+        }
+
+        return d;
+    }
+
+    float DistToScene(glm::vec3 const& aPos, stroke_t const* aStrokes, size_t aCount, int32_t& aOutStroke)
+    {
+        float d = kFarDistance;
+        aOutStroke = -1;
+
+        for (size_t i = 0; i < aCount; i++)
+        {
+            stroke_t const& lStroke = aStrokes[i];
+            const float lShape = EvalStroke(aPos, lStroke);
+
+            // Unblended side of each op, same branches as ApplyStrokeOp
+            bool lDominates = false;
+            if ((lStroke.id.y & EStrokeOp::OpsMaskMode) == EStrokeOp::OpAdd)
+            {
+                lDominates = lShape < d;
+            }
+            else if ((lStroke.id.y & EStrokeOp::OpSubtract) == EStrokeOp::OpSubtract)
+            {
+                lDominates = -(lShape + glm::max(0.0001f, lStroke.posb.w) * 0.4f) > d;
+            }
+            else if ((lStroke.id.y & EStrokeOp::OpIntersect) == EStrokeOp::OpIntersect)
+            {
+                lDominates = lShape > d;
+            }
+
+            if (lDominates)
+            {
+                aOutStroke = int32_t(i);
+            }
+            d = ApplyStrokeOp(lShape, d, lStroke);
+        }
+
+        return d;
+    }
+}
+
+CSdfEvaluator::CSdfEvaluator()
+{
+    SetKernel(ESdfKernel::Auto);
+}
+
+CSdfEvaluator::CSdfEvaluator(std::vector<stroke_t> const& aStrokes)
+    : mStrokes(aStrokes)
+{
+    SetKernel(ESdfKernel::Auto);
+    mStrokesSoA.Build(mStrokes.data(), mStrokes.size());
+}
+
+void CSdfEvaluator::SetStrokes(std::vector<stroke_t> const& aStrokes)
+{
+    mStrokes = aStrokes;
+    mStrokesSoA.Build(mStrokes.data(), mStrokes.size());
+}
+
+void CSdfEvaluator::SetStrokes(std::vector<TStrokeInfo> const& aStrokes)
+{
+    // Drop the editor data, only the gpu layout is needed
+    mStrokes.resize(aStrokes.size());
+    for (size_t i = 0; i < aStrokes.size(); i++)
+    {
+        mStrokes[i] = aStrokes[i];
+    }
+    mStrokesSoA.Build(mStrokes.data(), mStrokes.size());
+}
+
+void CSdfEvaluator::SetKernel(ESdfKernel::Type aKernel)
+{
+    mKernel = Sdf::ResolveKernel(aKernel);
+    mKernelFn = Sdf::GetEvalKernel(mKernel);
+}
+
+float CSdfEvaluator::Evaluate(glm::vec3 const& aPoint) const
+{
+    return Sdf::DistToScene(aPoint, mStrokes.data(), mStrokes.size());
+}
+
+void CSdfEvaluator::Evaluate(glm::vec3 const* aPoints, size_t aCount, float* aOutDistances) const
+{
+    static_assert(sizeof(glm::vec3) == sizeof(float) * 3, "Kernels expect packed xyz points");
+    mKernelFn(mStrokesSoA.GetView(), nullptr, 0, &aPoints[0].x, aCount, aOutDistances);
+}
+
+void CSdfEvaluator::Evaluate(glm::vec3 const* aPoints, size_t aCount, float* aOutDistances, uint32_t const* aSubset, size_t aSubsetCount) const
+{
+    static const uint32_t sEmptySubset = 0;
+    mKernelFn(mStrokesSoA.GetView(), aSubset ? aSubset : &sEmptySubset, aSubsetCount, &aPoints[0].x, aCount, aOutDistances);
+}
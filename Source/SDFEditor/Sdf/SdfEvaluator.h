@@ -0,0 +1,74 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// CPU version of the stroke evaluation in SDFCommon.h.glsl, keep both in sync
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDFEditor/Tool/StrokeInfo.h>
+#include <SDFEditor/Sdf/SdfSimd.h>
+
+namespace Sdf
+{
+    // Empty scene distance, same as the initial value of distToScene
+    constexpr float kFarDistance = 100000.0f;
+
+    // - MATHS -------------------------------
+    glm::vec3 QuatMultVec3(glm::vec4 const& aQuat, glm::vec3 const& aVec);
+
+    // - SMOOTH OPERATIONS --------------------------
+    float OpSmoothUnion(float aD1, float aD2, float aK);
+    float OpSmoothSubtraction(float aD1, float aD2, float aK);
+    float OpSmoothIntersection(float aD1, float aD2, float aK);
+
+    // - SDF Primitives ---------------------
+    float SdEllipsoid(glm::vec3 const& aPos, glm::vec3 const& aRadius);
+    float SdRoundBox(glm::vec3 const& aPos, glm::vec3 const& aHalfSize, float aRound);
+    float SdTorus(glm::vec3 const& aPos, glm::vec2 const& aRadius);
+    float SdVerticalCapsule(glm::vec3 aPos, float aHeight, float aRadius);
+
+    // - STROKE EVALUATION --------------
+    float EvalStroke(glm::vec3 aPos, stroke_t const& aStroke);
+
+    // Applies the stroke operation (id.y) to the accumulated distance
+    float ApplyStrokeOp(float aShape, float aDist, stroke_t const& aStroke);
+
+    // Distance to scene at point, strokes are applied in order
+    float DistToScene(glm::vec3 const& aPos, stroke_t const* aStrokes, size_t aCount);
+
+    // Also returns the stroke that dominates the distance, the last one to win
+    // the min of its union or the max of its subtraction or intersection. -1 if none
+    float DistToScene(glm::vec3 const& aPos, stroke_t const* aStrokes, size_t aCount, int32_t& aOutStroke);
+}
+
+// Batched distance queries over a packed copy of the scene strokes.
+// Single points use the reference path, batches run the SIMD kernel
+class CSdfEvaluator
+{
+public:
+    CSdfEvaluator();
+    explicit CSdfEvaluator(std::vector<stroke_t> const& aStrokes);
+
+    void SetStrokes(std::vector<stroke_t> const& aStrokes);
+    void SetStrokes(std::vector<TStrokeInfo> const& aStrokes);
+
+    std::vector<stroke_t> const& GetStrokes() const { return mStrokes; }
+    size_t GetStrokesCount() const { return mStrokes.size(); }
+
+    // Unsupported kernels fall back to the widest supported one
+    void SetKernel(ESdfKernel::Type aKernel);
+    ESdfKernel::Type GetKernel() const { return mKernel; }
+
+    float Evaluate(glm::vec3 const& aPoint) const;
+    void Evaluate(glm::vec3 const* aPoints, size_t aCount, float* aOutDistances) const;
+
+    // Applies only the strokes listed in aSubset (indices in CSG order)
+    void Evaluate(glm::vec3 const* aPoints, size_t aCount, float* aOutDistances, uint32_t const* aSubset, size_t aSubsetCount) const;
+
+private:
+    std::vector<stroke_t> mStrokes;
+    CSdfStrokesSoA mStrokesSoA;
+    ESdfKernel::Type mKernel{ ESdfKernel::Scalar };
+    TSdfEvalKernelFn mKernelFn{ nullptr };
+};
@@ -0,0 +1,71 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Interface of the SIMD stroke evaluation kernels.
+// Kernels are compiled with different instruction sets, keep this header
+// free of inline code shared with the rest of the program.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace ESdfKernel
+{
+    enum Type
+    {
+        Auto,       // widest kernel supported by the running cpu
+        Scalar,     // one point at a time, portable fallback
+        SSE41,      // 4 points per instruction
+        AVX2,       // 8 points per instruction
+        AVX512,     // 16 points per instruction
+
+        Count,
+    };
+}
+
+namespace ESdfKernelOp
+{
+    enum Type
+    {
+        Union,
+        Subtract,
+        Intersect,
+    };
+}
+
+namespace ESdfKernelMirror
+{
+    enum Type
+    {
+        MirrorX = 1 << 0,
+        MirrorY = 1 << 1,
+    };
+}
+
+// Plain pointers to the SoA arrays, this is all the kernels see
+struct TSdfStrokesView
+{
+    const float*    mPosX;
+    const float*    mPosY;
+    const float*    mPosZ;
+    const float*    mQuatX;
+    const float*    mQuatY;
+    const float*    mQuatZ;
+    const float*    mQuatW;
+    const float*    mParam[4];      // primitive parameters, see CSdfStrokesSoA::Build
+    const float*    mBlend;         // clamped blend
+    const float*    mBlendFactor;   // 0.25 / blend
+    const int32_t*  mPrimitive;
+    const int32_t*  mMirror;        // ESdfKernelMirror bits
+    const int32_t*  mOperation;     // ESdfKernelOp
+    size_t          mCount;
+};
+
+// Evaluates aCount points (xyz packed) against the strokes in the view, in order.
+// aSubset optionally lists the indices of the strokes to apply (aSubsetCount entries)
+using TSdfEvalKernelFn = void(*)(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances);
+
+// Per instruction set kernels, implemented in SdfKernel*.cpp
+void SdfEvalKernelScalar(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances);
+void SdfEvalKernelSSE41(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances);
+void SdfEvalKernelAVX2(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances);
+void SdfEvalKernelAVX512(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances);
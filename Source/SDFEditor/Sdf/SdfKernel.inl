@@ -0,0 +1,164 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Stroke evaluation kernel shared by all the instruction sets.
+// Included by the SdfKernel*.cpp files inside an unnamed namespace, after
+// declaring the vector type V (F, kWidth, Set1, Load, Store, Add, Sub, Mul,
+// Div, MulAdd, Min, Max, Abs, Sqrt). Every lane is a sample point, strokes
+// are broadcasted so primitive and operation branches stay uniform.
+// Mirrors evalStroke / distToScene in SDFCommon.h.glsl.
+
+template <typename V>
+inline typename V::F Length3(typename V::F aX, typename V::F aY, typename V::F aZ)
+{
+    return V::Sqrt(V::MulAdd(aX, aX, V::MulAdd(aY, aY, V::Mul(aZ, aZ))));
+}
+
+template <typename V>
+inline typename V::F Length2(typename V::F aX, typename V::F aY)
+{
+    return V::Sqrt(V::MulAdd(aX, aX, V::Mul(aY, aY)));
+}
+
+template <typename V>
+void EvalStrokesKernel(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances)
+{
+    using F = typename V::F;
+    constexpr size_t W = V::kWidth;
+
+    alignas(64) float lInX[W];
+    alignas(64) float lInY[W];
+    alignas(64) float lInZ[W];
+    alignas(64) float lOut[W];
+
+    const F lZero = V::Set1(0.0f);
+    const F lTwo = V::Set1(2.0f);
+    const size_t lNumStrokes = aSubset ? aSubsetCount : aStrokes.mCount;
+
+    for (size_t lBase = 0; lBase < aCount; lBase += W)
+    {
+        // Transpose the points block to lanes, the tail repeats the last point
+        const size_t lNumPoints = ((aCount - lBase) < W) ? (aCount - lBase) : W;
+        for (size_t i = 0; i < W; i++)
+        {
+            const float* lPoint = aPoints + (lBase + ((i < lNumPoints) ? i : (lNumPoints - 1))) * 3;
+            lInX[i] = lPoint[0];
+            lInY[i] = lPoint[1];
+            lInZ[i] = lPoint[2];
+        }
+
+        const F lPointX = V::Load(lInX);
+        const F lPointY = V::Load(lInY);
+        const F lPointZ = V::Load(lInZ);
+
+        F d = V::Set1(100000.0f);
+
+        for (size_t n = 0; n < lNumStrokes; n++)
+        {
+            const size_t s = aSubset ? aSubset[n] : n;
+            const int32_t lMirror = aStrokes.mMirror[s];
+            const F lPx = (lMirror & ESdfKernelMirror::MirrorX) ? V::Abs(lPointX) : lPointX;
+            const F lPy = (lMirror & ESdfKernelMirror::MirrorY) ? V::Abs(lPointY) : lPointY;
+
+            // position = quatMultVec3(quat, p - pos)
+            F x = V::Sub(lPx, V::Set1(aStrokes.mPosX[s]));
+            F y = V::Sub(lPy, V::Set1(aStrokes.mPosY[s]));
+            F z = V::Sub(lPointZ, V::Set1(aStrokes.mPosZ[s]));
+            {
+                const F qx = V::Set1(aStrokes.mQuatX[s]);
+                const F qy = V::Set1(aStrokes.mQuatY[s]);
+                const F qz = V::Set1(aStrokes.mQuatZ[s]);
+                const F qw = V::Set1(aStrokes.mQuatW[s]);
+
+                // u = cross(q, v) + w * v
+                const F ux = V::MulAdd(qw, x, V::Sub(V::Mul(qy, z), V::Mul(qz, y)));
+                const F uy = V::MulAdd(qw, y, V::Sub(V::Mul(qz, x), V::Mul(qx, z)));
+                const F uz = V::MulAdd(qw, z, V::Sub(V::Mul(qx, y), V::Mul(qy, x)));
+
+                // t = cross(q, u), v + t + t
+                const F tx = V::Sub(V::Mul(qy, uz), V::Mul(qz, uy));
+                const F ty = V::Sub(V::Mul(qz, ux), V::Mul(qx, uz));
+                const F tz = V::Sub(V::Mul(qx, uy), V::Mul(qy, ux));
+
+                x = V::MulAdd(lTwo, tx, x);
+                y = V::MulAdd(lTwo, ty, y);
+                z = V::MulAdd(lTwo, tz, z);
+            }
+
+            F lShape;
+            const float* const* lParam = aStrokes.mParam;
+            switch (aStrokes.mPrimitive[s])
+            {
+            case 0: // Ellipsoid: param = 1/r
+            {
+                const F ix = V::Set1(lParam[0][s]);
+                const F iy = V::Set1(lParam[1][s]);
+                const F iz = V::Set1(lParam[2][s]);
+                const F ax = V::Mul(x, ix), ay = V::Mul(y, iy), az = V::Mul(z, iz);
+                const F k0 = Length3<V>(ax, ay, az);
+                const F k1 = Length3<V>(V::Mul(ax, ix), V::Mul(ay, iy), V::Mul(az, iz));
+                lShape = V::Div(V::Mul(k0, V::Sub(k0, V::Set1(1.0f))), k1);
+                break;
+            }
+            case 1: // Round box: param = size - round, round
+            {
+                const F qx = V::Sub(V::Abs(x), V::Set1(lParam[0][s]));
+                const F qy = V::Sub(V::Abs(y), V::Set1(lParam[1][s]));
+                const F qz = V::Sub(V::Abs(z), V::Set1(lParam[2][s]));
+                const F lOutside = Length3<V>(V::Max(qx, lZero), V::Max(qy, lZero), V::Max(qz, lZero));
+                const F lInside = V::Min(V::Max(qx, V::Max(qy, qz)), lZero);
+                lShape = V::Sub(V::Add(lOutside, lInside), V::Set1(lParam[3][s]));
+                break;
+            }
+            case 2: // Torus: param = major radius, minor radius
+            {
+                const F qx = V::Sub(Length2<V>(x, z), V::Set1(lParam[0][s]));
+                lShape = V::Sub(Length2<V>(qx, y), V::Set1(lParam[1][s]));
+                break;
+            }
+            case 3: // Vertical capsule: param = y offset, height, radius
+            {
+                const F cy = V::Sub(y, V::Set1(lParam[0][s]));
+                const F lClamped = V::Min(V::Max(cy, lZero), V::Set1(lParam[1][s]));
+                lShape = V::Sub(Length3<V>(x, V::Sub(cy, lClamped), z), V::Set1(lParam[2][s]));
+                break;
+            }
+            default:
+                lShape = V::Set1(1000000.0f);
+                break;
+            }
+
+            // Smooth operations
+            const F k = V::Set1(aStrokes.mBlend[s]);
+            const F lFactor = V::Set1(aStrokes.mBlendFactor[s]);
+            switch (aStrokes.mOperation[s])
+            {
+            case ESdfKernelOp::Union:
+            {
+                const F h = V::Max(V::Sub(k, V::Abs(V::Sub(lShape, d))), lZero);
+                d = V::Sub(V::Min(lShape, d), V::Mul(V::Mul(h, h), lFactor));
+                break;
+            }
+            case ESdfKernelOp::Subtract:
+            {
+                const F lNeg = V::Sub(lZero, V::MulAdd(k, V::Set1(0.4f), lShape));
+                const F h = V::Max(V::Sub(k, V::Abs(V::Sub(lNeg, d))), lZero);
+                d = V::MulAdd(V::Mul(h, h), lFactor, V::Max(lNeg, d));
+                break;
+            }
+            case ESdfKernelOp::Intersect:
+            {
+                const F h = V::Max(V::Sub(k, V::Abs(V::Sub(lShape, d))), lZero);
+                d = V::MulAdd(V::Mul(h, h), lFactor, V::Max(lShape, d));
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        V::Store(lOut, d);
+        for (size_t i = 0; i < lNumPoints; i++)
+        {
+            aOutDistances[lBase + i] = lOut[i];
+        }
+    }
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// AVX2 kernel, 8 points per iteration. Built with AVX2 and FMA enabled, only
+// called after checking sbx::GetCpuFeatures()
+
+#include <sbx/Core/Platform.h>
+#include <SDFEditor/Sdf/SdfKernel.h>
+
+#if SBX_SIMD_X86
+
+#include <immintrin.h>
+
+namespace
+{
+    struct TVecAVX2
+    {
+        using F = __m256;
+        static constexpr size_t kWidth = 8;
+
+        static F Set1(float a) { return _mm256_set1_ps(a); }
+        static F Load(const float* a) { return _mm256_load_ps(a); }
+        static void Store(float* a, F v) { _mm256_store_ps(a, v); }
+        static F Add(F a, F b) { return _mm256_add_ps(a, b); }
+        static F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+        static F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+        static F Div(F a, F b) { return _mm256_div_ps(a, b); }
+        static F MulAdd(F a, F b, F c) { return _mm256_fmadd_ps(a, b, c); }
+        static F Min(F a, F b) { return _mm256_min_ps(a, b); }
+        static F Max(F a, F b) { return _mm256_max_ps(a, b); }
+        static F Abs(F a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+        static F Sqrt(F a) { return _mm256_sqrt_ps(a); }
+    };
+
+#include <SDFEditor/Sdf/SdfKernel.inl>
+}
+
+void SdfEvalKernelAVX2(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances)
+{
+    EvalStrokesKernel<TVecAVX2>(aStrokes, aSubset, aSubsetCount, aPoints, aCount, aOutDistances);
+}
+
+#else
+
+void SdfEvalKernelAVX2(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances)
+{
+    SdfEvalKernelScalar(aStrokes, aSubset, aSubsetCount, aPoints, aCount, aOutDistances);
+}
+
+#endif
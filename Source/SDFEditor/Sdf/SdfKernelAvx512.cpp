@@ -0,0 +1,53 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// AVX-512 kernel, 16 points per iteration. Built with AVX-512F enabled, only
+// called after checking sbx::GetCpuFeatures()
+
+#include <sbx/Core/Platform.h>
+#include <SDFEditor/Sdf/SdfKernel.h>
+
+#if SBX_SIMD_X86
+
+// GCC 12 reports the _mm512_undefined_ps() self initialization in its own headers
+#if SBX_COMPILER_GCC && !defined(__clang__)
+#   pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include <immintrin.h>
+
+namespace
+{
+    struct TVecAVX512
+    {
+        using F = __m512;
+        static constexpr size_t kWidth = 16;
+
+        static F Set1(float a) { return _mm512_set1_ps(a); }
+        static F Load(const float* a) { return _mm512_load_ps(a); }
+        static void Store(float* a, F v) { _mm512_store_ps(a, v); }
+        static F Add(F a, F b) { return _mm512_add_ps(a, b); }
+        static F Sub(F a, F b) { return _mm512_sub_ps(a, b); }
+        static F Mul(F a, F b) { return _mm512_mul_ps(a, b); }
+        static F Div(F a, F b) { return _mm512_div_ps(a, b); }
+        static F MulAdd(F a, F b, F c) { return _mm512_fmadd_ps(a, b, c); }
+        static F Min(F a, F b) { return _mm512_min_ps(a, b); }
+        static F Max(F a, F b) { return _mm512_max_ps(a, b); }
+        static F Abs(F a) { return _mm512_abs_ps(a); }
+        static F Sqrt(F a) { return _mm512_sqrt_ps(a); }
+    };
+
+#include <SDFEditor/Sdf/SdfKernel.inl>
+}
+
+void SdfEvalKernelAVX512(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances)
+{
+    EvalStrokesKernel<TVecAVX512>(aStrokes, aSubset, aSubsetCount, aPoints, aCount, aOutDistances);
+}
+
+#else
+
+void SdfEvalKernelAVX512(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances)
+{
+    SdfEvalKernelScalar(aStrokes, aSubset, aSubsetCount, aPoints, aCount, aOutDistances);
+}
+
+#endif
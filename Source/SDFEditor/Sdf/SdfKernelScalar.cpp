@@ -0,0 +1,36 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Portable kernel, one point per iteration
+
+#include <SDFEditor/Sdf/SdfKernel.h>
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    struct TVecScalar
+    {
+        using F = float;
+        static constexpr size_t kWidth = 1;
+
+        static F Set1(float a) { return a; }
+        static F Load(const float* a) { return *a; }
+        static void Store(float* a, F v) { *a = v; }
+        static F Add(F a, F b) { return a + b; }
+        static F Sub(F a, F b) { return a - b; }
+        static F Mul(F a, F b) { return a * b; }
+        static F Div(F a, F b) { return a / b; }
+        static F MulAdd(F a, F b, F c) { return a * b + c; }
+        static F Min(F a, F b) { return std::min(a, b); }
+        static F Max(F a, F b) { return std::max(a, b); }
+        static F Abs(F a) { return std::fabs(a); }
+        static F Sqrt(F a) { return std::sqrt(a); }
+    };
+
+#include <SDFEditor/Sdf/SdfKernel.inl>
+}
+
+void SdfEvalKernelScalar(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances)
+{
+    EvalStrokesKernel<TVecScalar>(aStrokes, aSubset, aSubsetCount, aPoints, aCount, aOutDistances);
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// SSE4.1 kernel, 4 points per iteration. Built with SSE4.1 enabled, only
+// called after checking sbx::GetCpuFeatures()
+
+#include <sbx/Core/Platform.h>
+#include <SDFEditor/Sdf/SdfKernel.h>
+
+#if SBX_SIMD_X86
+
+#include <smmintrin.h>
+
+namespace
+{
+    struct TVecSSE41
+    {
+        using F = __m128;
+        static constexpr size_t kWidth = 4;
+
+        static F Set1(float a) { return _mm_set1_ps(a); }
+        static F Load(const float* a) { return _mm_load_ps(a); }
+        static void Store(float* a, F v) { _mm_store_ps(a, v); }
+        static F Add(F a, F b) { return _mm_add_ps(a, b); }
+        static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+        static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+        static F Div(F a, F b) { return _mm_div_ps(a, b); }
+        static F MulAdd(F a, F b, F c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+        static F Min(F a, F b) { return _mm_min_ps(a, b); }
+        static F Max(F a, F b) { return _mm_max_ps(a, b); }
+        static F Abs(F a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        static F Sqrt(F a) { return _mm_sqrt_ps(a); }
+    };
+
+#include <SDFEditor/Sdf/SdfKernel.inl>
+}
+
+void SdfEvalKernelSSE41(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances)
+{
+    EvalStrokesKernel<TVecSSE41>(aStrokes, aSubset, aSubsetCount, aPoints, aCount, aOutDistances);
+}
+
+#else
+
+void SdfEvalKernelSSE41(TSdfStrokesView const& aStrokes, const uint32_t* aSubset, size_t aSubsetCount, const float* aPoints, size_t aCount, float* aOutDistances)
+{
+    SdfEvalKernelScalar(aStrokes, aSubset, aSubsetCount, aPoints, aCount, aOutDistances);
+}
+
+#endif
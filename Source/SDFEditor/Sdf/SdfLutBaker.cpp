@@ -0,0 +1,211 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfLutBaker.h"
+#include "SdfEvaluator.h"
+
+#include <sbx/Core/Parallel.h>
+#include <sbx/Texture/Texture.h>
+
+#include <atomic>
+#include <chrono>
+
+namespace
+{
+    // Rows of LUT voxels per ParallelFor chunk
+    constexpr size_t kRowsPerChunk = 16;
+}
+
+TSdfLutBakeStats CSdfLutBaker::EvaluateDistances(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, glm::ivec3 const& aMin, glm::ivec3 const& aMax)
+{
+    const auto lStartTime = std::chrono::steady_clock::now();
+
+    const int32_t lSize = aParams.mLutSize;
+    const glm::ivec3 lMin = glm::clamp(aMin, glm::ivec3(0), glm::ivec3(lSize));
+    const glm::ivec3 lMax = glm::clamp(aMax, lMin, glm::ivec3(lSize));
+    const glm::ivec3 lExtent = lMax - lMin;
+    const size_t lNumVoxels = size_t(lExtent.x) * size_t(lExtent.y) * size_t(lExtent.z);
+    const uint32_t lThreads = (aParams.mThreads > 0) ? aParams.mThreads : sbx::GetHardwareThreadsCount();
+
+    TSdfLutBakeStats lStats;
+    lStats.mVoxels = lNumVoxels;
+    lStats.mThreads = lThreads;
+
+    mDistances.resize(aParams.GetLutVoxelsCount(), Sdf::kFarDistance);
+    if (lNumVoxels == 0)
+    {
+        return lStats;
+    }
+
+    // Work is split in the cull cells touching the region, with culling disabled they evaluate all the strokes
+    const int32_t lCellVoxels = aParams.mCullCellVoxels;
+    const glm::ivec3 lCellMin = lMin / lCellVoxels;
+    const glm::ivec3 lCellMax = (lMax + lCellVoxels - 1) / lCellVoxels;
+    const glm::ivec3 lCellExtent = lCellMax - lCellMin;
+    const size_t lNumCells = size_t(lCellExtent.x) * size_t(lCellExtent.y) * size_t(lCellExtent.z);
+
+    if (aParams.mCullStrokes)
+    {
+        mCullGrid.Build(aEvaluator.GetStrokes().data(), aEvaluator.GetStrokesCount(), aParams, lCellMin, lCellMax);
+        lStats.mCullSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStartTime).count();
+    }
+    else
+    {
+        mCullGrid = CSdfCullGrid();
+    }
+
+    // Distances per cell, clamped to the culling margin
+    std::atomic<size_t> lEvaluatedStrokes{ 0 };
+    sbx::ParallelFor(lNumCells, 1, [&](size_t aBegin, size_t aEnd, uint32_t)
+    {
+        std::vector<glm::vec3> lPoints;
+        std::vector<float> lDistances;
+        size_t lCellEvaluatedStrokes = 0;
+
+        for (size_t i = aBegin; i < aEnd; i++)
+        {
+            const glm::ivec3 lCellCoord = lCellMin + glm::ivec3(int32_t(i % lCellExtent.x), int32_t((i / lCellExtent.x) % lCellExtent.y), int32_t(i / (size_t(lCellExtent.x) * lCellExtent.y)));
+            const glm::ivec3 lVoxelMin = glm::max(lCellCoord * lCellVoxels, lMin);
+            const glm::ivec3 lVoxelMax = glm::min(lCellCoord * lCellVoxels + lCellVoxels, lMax);
+
+            lPoints.clear();
+            for (int32_t z = lVoxelMin.z; z < lVoxelMax.z; z++)
+            {
+                for (int32_t y = lVoxelMin.y; y < lVoxelMax.y; y++)
+                {
+                    for (int32_t x = lVoxelMin.x; x < lVoxelMax.x; x++)
+                    {
+                        lPoints.push_back(aParams.LutCoordToWorld(glm::ivec3(x, y, z)));
+                    }
+                }
+            }
+            lDistances.resize(lPoints.size());
+
+            if (aParams.mCullStrokes)
+            {
+                const uint32_t lCell = mCullGrid.GetCellIndex(lCellCoord);
+                const uint32_t lCount = mCullGrid.GetCellStrokesCount(lCell);
+                aEvaluator.Evaluate(lPoints.data(), lPoints.size(), lDistances.data(), mCullGrid.GetCellStrokes(lCell), lCount);
+                for (float& lDist : lDistances)
+                {
+                    lDist = glm::clamp(lDist, -aParams.mCullMargin, aParams.mCullMargin);
+                }
+                lCellEvaluatedStrokes += lCount * lPoints.size();
+            }
+            else
+            {
+                aEvaluator.Evaluate(lPoints.data(), lPoints.size(), lDistances.data());
+                lCellEvaluatedStrokes += aEvaluator.GetStrokesCount() * lPoints.size();
+            }
+
+            size_t lIndex = 0;
+            for (int32_t z = lVoxelMin.z; z < lVoxelMax.z; z++)
+            {
+                for (int32_t y = lVoxelMin.y; y < lVoxelMax.y; y++)
+                {
+                    float* lRowDistances = mDistances.data() + (size_t(z) * lSize + y) * lSize;
+                    for (int32_t x = lVoxelMin.x; x < lVoxelMax.x; x++)
+                    {
+                        lRowDistances[x] = lDistances[lIndex++];
+                    }
+                }
+            }
+        }
+
+        lEvaluatedStrokes += lCellEvaluatedStrokes;
+    }, lThreads);
+
+    lStats.mStrokesPerVoxel = double(lEvaluatedStrokes) / double(lNumVoxels);
+    lStats.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStartTime).count();
+    lStats.mVoxelsPerSecond = (lStats.mSeconds > 0.0) ? double(lNumVoxels) / lStats.mSeconds : 0.0;
+    return lStats;
+}
+
+TSdfLutBakeStats CSdfLutBaker::Bake(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, sbx::TTexture& aOutLut, std::vector<uint32_t>* aOutSlotList)
+{
+    const auto lStartTime = std::chrono::steady_clock::now();
+
+    const int32_t lSize = aParams.mLutSize;
+    const size_t lNumRows = size_t(lSize) * size_t(lSize);
+    const size_t lNumVoxels = aParams.GetLutVoxelsCount();
+    const float lBand = aParams.GetSurfaceBand();
+
+    TSdfLutBakeStats lStats = EvaluateDistances(aEvaluator, aParams, glm::ivec3(0), glm::ivec3(lSize));
+    const uint32_t lThreads = lStats.mThreads;
+
+    aOutLut.Init(lSize, lSize, lSize, sbx::ETextureFormat::RGBA8);
+    sbx::TColor8U* lTexels = aOutLut.AsRGBA8Buffer();
+
+    mRowSlotsOffset.assign(lNumRows + 1, 0);
+
+    // Surface voxels per row
+    sbx::ParallelFor(lNumRows, kRowsPerChunk, [&](size_t aBegin, size_t aEnd, uint32_t)
+    {
+        for (size_t lRow = aBegin; lRow < aEnd; lRow++)
+        {
+            const float* lRowDistances = mDistances.data() + lRow * lSize;
+            uint32_t lRowSlots = 0;
+            for (int32_t x = 0; x < lSize; x++)
+            {
+                lRowSlots += (glm::abs(lRowDistances[x]) < lBand) ? 1 : 0;
+            }
+            mRowSlotsOffset[lRow + 1] = lRowSlots;
+        }
+    }, lThreads);
+
+    for (size_t lRow = 0; lRow < lNumRows; lRow++)
+    {
+        mRowSlotsOffset[lRow + 1] += mRowSlotsOffset[lRow];
+    }
+
+    const uint32_t lTotalSlots = mRowSlotsOffset[lNumRows];
+    const uint32_t lSlotsCount = glm::min(lTotalSlots, aParams.mMaxSlots);
+
+    if (aOutSlotList)
+    {
+        aOutSlotList->resize(lSlotsCount);
+    }
+
+    // Texels, slots are assigned in index order from the row offsets
+    sbx::ParallelFor(lNumRows, kRowsPerChunk, [&](size_t aBegin, size_t aEnd, uint32_t)
+    {
+        for (size_t lRow = aBegin; lRow < aEnd; lRow++)
+        {
+            const glm::ivec3 lCoord(0, int32_t(lRow % lSize), int32_t(lRow / lSize));
+            const float* lRowDistances = mDistances.data() + lRow * lSize;
+            sbx::TColor8U* lRowTexels = lTexels + lRow * lSize;
+            uint32_t lSlot = mRowSlotsOffset[lRow];
+
+            for (int32_t x = 0; x < lSize; x++)
+            {
+                const float lDist = lRowDistances[x];
+                sbx::TColor8U& lTexel = lRowTexels[x];
+                lTexel.r = lTexel.g = lTexel.b = 255;
+                lTexel.a = Sdf::FloatToUnorm8(aParams.LutNormDistance(lDist));
+
+                if (glm::abs(lDist) < lBand)
+                {
+                    if (lSlot < lSlotsCount)
+                    {
+                        // IndexToNormCoord(slot) stored as unorm gives back the slot bytes
+                        const glm::ivec3 lSlotBytes = Sdf::IndexToCoord(lSlot);
+                        lTexel.r = uint8_t(lSlotBytes.x);
+                        lTexel.g = uint8_t(lSlotBytes.y);
+                        lTexel.b = uint8_t(lSlotBytes.z);
+
+                        if (aOutSlotList)
+                        {
+                            (*aOutSlotList)[lSlot] = Sdf::CoordToIndex(glm::ivec3(x, lCoord.y, lCoord.z));
+                        }
+                    }
+                    lSlot++;
+                }
+            }
+        }
+    }, lThreads);
+
+    lStats.mSlotsCount = lSlotsCount;
+    lStats.mOverflowSlots = lTotalSlots - lSlotsCount;
+    lStats.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStartTime).count();
+    lStats.mVoxelsPerSecond = (lStats.mSeconds > 0.0) ? double(lNumVoxels) / lStats.mSeconds : 0.0;
+    return lStats;
+}
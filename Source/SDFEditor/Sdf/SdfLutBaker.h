@@ -0,0 +1,55 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// LUT volume baked on the CPU, distances and atlas slots
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDFEditor/Sdf/SdfBakeParams.h>
+#include <SDFEditor/Sdf/SdfCulling.h>
+
+namespace sbx
+{
+    struct TTexture;
+}
+
+class CSdfEvaluator;
+
+struct TSdfLutBakeStats
+{
+    size_t mVoxels{ 0 };
+    uint32_t mSlotsCount{ 0 };          // surface voxels with an atlas slot
+    uint32_t mOverflowSlots{ 0 };       // surface voxels past mMaxSlots, left to the LUT
+    uint32_t mThreads{ 0 };
+    double mStrokesPerVoxel{ 0.0 };     // average strokes evaluated per voxel after culling
+    double mCullSeconds{ 0.0 };
+    double mSeconds{ 0.0 };
+    double mVoxelsPerSecond{ 0.0 };
+};
+
+// Bakes the RGBA8 LUT: rgb = IndexToNormCoord(slot) or 1 out of the surface band,
+// a = normalized distance. Slots are assigned in LUT index order so the result is
+// deterministic. See CSdfVolume for persistent slots.
+class CSdfLutBaker
+{
+public:
+    // aOutLut is (re)initialized as a mLutSize^3 RGBA8 texture.
+    // aOutSlotList receives the CoordToIndex LUT coord of each slot (slot_list)
+    TSdfLutBakeStats Bake(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, sbx::TTexture& aOutLut, std::vector<uint32_t>* aOutSlotList = nullptr);
+
+    // Only the distances of the LUT voxels in [aMin, aMax), the rest keep the
+    // values of previous calls. Fills the voxel, stroke and time stats.
+    TSdfLutBakeStats EvaluateDistances(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, glm::ivec3 const& aMin, glm::ivec3 const& aMax);
+
+    // Distances of the last bakes, x major like the texture
+    std::vector<float> const& GetDistances() const { return mDistances; }
+
+    // Stroke lists of the last bake, empty when mCullStrokes is disabled
+    CSdfCullGrid const& GetCullGrid() const { return mCullGrid; }
+
+private:
+    CSdfCullGrid mCullGrid;
+    std::vector<float> mDistances;
+    std::vector<uint32_t> mRowSlotsOffset;
+};
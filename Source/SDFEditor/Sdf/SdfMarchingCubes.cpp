@@ -0,0 +1,442 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfMarchingCubes.h"
+#include "SdfMesh.h"
+#include "SdfMeshGrid.h"
+
+#include <sbx/Core/Parallel.h>
+#include <sbx/Core/ErrorHandling.h>
+
+#include <chrono>
+
+namespace
+{
+    // Bricks per chunk of work, chunks are also the unit of the weld
+    constexpr size_t kBricksPerChunk = 16;
+
+    constexpr uint32_t kMaxCellTriangles = 5;
+    constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+    // Corner c of a cell is at (c & 1, (c >> 1) & 1, c >> 2). Edge e runs along
+    // axis e / 4 from its lower corner
+    struct TCubeTables
+    {
+        glm::ivec3 mCorners[8];
+        glm::ivec3 mEdgeOrigins[12];
+        int32_t mEdgeAxis[12];
+        int32_t mEdgeCorners[12][2];
+
+        uint8_t mTrianglesCount[256];
+        int8_t mTriangles[256][kMaxCellTriangles * 3];
+
+        TCubeTables()
+        {
+            for (int32_t c = 0; c < 8; c++)
+            {
+                mCorners[c] = glm::ivec3(c & 1, (c >> 1) & 1, c >> 2);
+            }
+
+            auto lCornerIndex = [](glm::ivec3 const& aCorner) { return aCorner.x | (aCorner.y << 1) | (aCorner.z << 2); };
+
+            for (int32_t e = 0; e < 12; e++)
+            {
+                const int32_t lAxis = e / 4;
+                glm::ivec3 lOrigin(0);
+                lOrigin[(lAxis + 1) % 3] = e & 1;
+                lOrigin[(lAxis + 2) % 3] = (e >> 1) & 1;
+                glm::ivec3 lEnd = lOrigin;
+                lEnd[lAxis] = 1;
+
+                mEdgeOrigins[e] = lOrigin;
+                mEdgeAxis[e] = lAxis;
+                mEdgeCorners[e][0] = lCornerIndex(lOrigin);
+                mEdgeCorners[e][1] = lCornerIndex(lEnd);
+            }
+
+            auto lEdgeIndex = [this](int32_t aCornerA, int32_t aCornerB)
+            {
+                for (int32_t e = 0; e < 12; e++)
+                {
+                    if ((mEdgeCorners[e][0] == aCornerA && mEdgeCorners[e][1] == aCornerB) ||
+                        (mEdgeCorners[e][0] == aCornerB && mEdgeCorners[e][1] == aCornerA))
+                    {
+                        return e;
+                    }
+                }
+                return -1;
+            };
+
+            // Corners of each face counter clockwise seen from outside the cell
+            int32_t lFaces[6][4];
+            for (int32_t f = 0; f < 6; f++)
+            {
+                const int32_t lAxis = f / 2;
+                const int32_t lSide = f & 1;
+                const glm::ivec2 lCycle[4] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+                for (int32_t k = 0; k < 4; k++)
+                {
+                    // (u, v) = (axis + 1, axis + 2) is counter clockwise around +axis, the -axis face goes the other way
+                    const glm::ivec2 lUV = lSide ? lCycle[k] : glm::ivec2(lCycle[k].y, lCycle[k].x);
+                    glm::ivec3 lCorner(0);
+                    lCorner[lAxis] = lSide;
+                    lCorner[(lAxis + 1) % 3] = lUV.x;
+                    lCorner[(lAxis + 2) % 3] = lUV.y;
+                    lFaces[f][k] = lCornerIndex(lCorner);
+                }
+            }
+
+            // Walking a face counter clockwise, each crossing from an inside to
+            // an outside corner links to the next crossing back inside. Every cut
+            // edge leaves one face and enters the other, so the links close in
+            // loops. Faces with two inside corners on a diagonal keep the inside
+            // corners joined, the neighbour cell sees the same face and agrees.
+            for (uint32_t lConfig = 0; lConfig < 256; lConfig++)
+            {
+                auto lInside = [lConfig](int32_t aCorner) { return ((lConfig >> aCorner) & 1) != 0; };
+
+                int32_t lNext[12];
+                for (int32_t& lEdge : lNext)
+                {
+                    lEdge = -1;
+                }
+
+                for (int32_t f = 0; f < 6; f++)
+                {
+                    for (int32_t k = 0; k < 4; k++)
+                    {
+                        const int32_t lFrom = lFaces[f][k];
+                        const int32_t lTo = lFaces[f][(k + 1) % 4];
+                        if (!lInside(lFrom) || lInside(lTo))
+                        {
+                            continue;
+                        }
+
+                        for (int32_t j = 1; j < 4; j++)
+                        {
+                            const int32_t lA = lFaces[f][(k + j) % 4];
+                            const int32_t lB = lFaces[f][(k + j + 1) % 4];
+                            if (!lInside(lA) && lInside(lB))
+                            {
+                                lNext[lEdgeIndex(lFrom, lTo)] = lEdgeIndex(lA, lB);
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                // Fans of each loop, the link order turns clockwise seen from outside
+                uint32_t lCount = 0;
+                bool lVisited[12] = {};
+                for (int32_t lStart = 0; lStart < 12; lStart++)
+                {
+                    if (lNext[lStart] < 0 || lVisited[lStart])
+                    {
+                        continue;
+                    }
+
+                    int32_t lLoop[12];
+                    int32_t lLoopSize = 0;
+                    for (int32_t e = lStart; !lVisited[e]; e = lNext[e])
+                    {
+                        lVisited[e] = true;
+                        lLoop[lLoopSize++] = e;
+                    }
+
+                    for (int32_t i = 1; i + 1 < lLoopSize; i++)
+                    {
+                        SBX_ASSERT(lCount < kMaxCellTriangles, "Marching cubes cell over the triangles limit");
+                        mTriangles[lConfig][lCount * 3 + 0] = int8_t(lLoop[0]);
+                        mTriangles[lConfig][lCount * 3 + 1] = int8_t(lLoop[i + 1]);
+                        mTriangles[lConfig][lCount * 3 + 2] = int8_t(lLoop[i]);
+                        lCount++;
+                    }
+                }
+                mTrianglesCount[lConfig] = uint8_t(lCount);
+            }
+        }
+    };
+
+    TCubeTables const& GetCubeTables()
+    {
+        static const TCubeTables sTables;
+        return sTables;
+    }
+
+    // Triangles of a chunk of bricks, indices into the chunk vertices
+    struct TChunkMesh
+    {
+        std::vector<glm::vec3> mPositions;
+        std::vector<glm::vec3> mNormals;
+        std::vector<uint64_t> mKeys;
+        std::vector<uint32_t> mIndices;
+        size_t mFirstVertex{ 0 };
+        size_t mFirstIndex{ 0 };
+        size_t mWeldedCount{ 0 };           // vertices kept by the weld
+        size_t mFirstWelded{ 0 };
+    };
+}
+
+TSdfMeshStats CSdfMarchingCubes::Extract(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, TSdfMesh& aOutMesh)
+{
+    aOutMesh.Clear();
+    return Extract(aEvaluator, aParams, [&aOutMesh](TSdfMesh const& aPiece)
+    {
+        aOutMesh.Append(aPiece);
+        return true;
+    });
+}
+
+TSdfMeshStats CSdfMarchingCubes::Extract(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, TSdfMeshSinkFn const& aSink)
+{
+    const auto lStartTime = std::chrono::steady_clock::now();
+    TCubeTables const& lTables = GetCubeTables();
+
+    CSdfMeshGrid lGrid;
+    const TSdfLutBakeStats lLutStats = lGrid.Build(aEvaluator, aParams);
+    std::vector<glm::ivec3> const& lBricks = lGrid.GetBricks();
+
+    const int32_t lBrickSize = lGrid.GetBrickCells();
+    const int32_t lSide = lGrid.GetBrickSide();
+    const int32_t lBrickPoints = lGrid.GetBrickPoints();
+    const uint32_t lThreads = (aParams.mThreads > 0) ? aParams.mThreads : sbx::GetHardwareThreadsCount();
+
+    // Offsets of the cell corners and of the edge ends in the brick points
+    int32_t lCornerOffsets[8];
+    for (int32_t c = 0; c < 8; c++)
+    {
+        glm::ivec3 const& lCorner = lTables.mCorners[c];
+        lCornerOffsets[c] = (lCorner.z * lSide + lCorner.y) * lSide + lCorner.x;
+    }
+    const int32_t lAxisStrides[3] = { 1, lSide, lSide * lSide };
+
+    const float lNormalEps = lGrid.GetCellSide() * 0.5f;
+
+    TSdfMeshStats lStats;
+    lStats.mBricks = uint32_t(lBricks.size());
+    lStats.mThreads = lThreads;
+    lStats.mStrokesPerVoxel = lLutStats.mStrokesPerVoxel;
+    lStats.mLutSeconds = lLutStats.mSeconds;
+
+    // Vertices on the top plane of the last slab, the next one shares them
+    std::vector<uint64_t> lSeamKeys;
+    std::vector<uint32_t> lSeamVertices;
+
+    std::vector<TChunkMesh> lChunks;
+    std::vector<uint32_t> lWelded;
+    std::vector<uint32_t> lGlobal;
+    TSdfMesh lPiece;
+
+    for (size_t lSlabBegin = 0; lSlabBegin < lBricks.size();)
+    {
+        int32_t lSlabTop = 0;
+        const size_t lSlabEnd = lGrid.GetSlabEnd(lSlabBegin, lSlabTop);
+        const size_t lNumChunks = (lSlabEnd - lSlabBegin + kBricksPerChunk - 1) / kBricksPerChunk;
+
+        lChunks.clear();
+        lChunks.resize(lNumChunks);
+
+        sbx::ParallelFor(lNumChunks, 1, [&](size_t aBegin, size_t aEnd, uint32_t)
+        {
+            TSdfMeshBrick lBrick;
+            std::vector<uint32_t> lEdgeVertices(3 * lBrickPoints);
+
+            for (size_t lChunkIndex = aBegin; lChunkIndex < aEnd; lChunkIndex++)
+            {
+                TChunkMesh& lChunk = lChunks[lChunkIndex];
+                const size_t lLastBrick = glm::min(lSlabBegin + (lChunkIndex + 1) * kBricksPerChunk, lSlabEnd);
+
+                for (size_t lBrickIndex = lSlabBegin + lChunkIndex * kBricksPerChunk; lBrickIndex < lLastBrick; lBrickIndex++)
+                {
+                    const glm::ivec3 lLutCoord = lBricks[lBrickIndex];
+                    const glm::ivec3 lGridOrigin = lLutCoord * lBrickSize;
+                    if (!lGrid.EvaluateBrick(lLutCoord, lBrick))
+                    {
+                        continue;
+                    }
+
+                    std::vector<glm::vec3> const& lPoints = lBrick.mPoints;
+                    std::vector<float> const& lDistances = lBrick.mDistances;
+                    const size_t lFirstBrickVertex = lChunk.mPositions.size();
+                    std::fill(lEdgeVertices.begin(), lEdgeVertices.end(), kInvalidIndex);
+
+                    for (int32_t z = 0; z < lBrickSize; z++)
+                    {
+                        for (int32_t y = 0; y < lBrickSize; y++)
+                        {
+                            for (int32_t x = 0; x < lBrickSize; x++)
+                            {
+                                const int32_t lCellPoint = (z * lSide + y) * lSide + x;
+                                uint32_t lConfig = 0;
+                                for (int32_t c = 0; c < 8; c++)
+                                {
+                                    lConfig |= (lDistances[lCellPoint + lCornerOffsets[c]] < 0.0f) ? (1u << c) : 0u;
+                                }
+
+                                const int8_t* lTriangles = lTables.mTriangles[lConfig];
+                                const uint32_t lNumEdges = lTables.mTrianglesCount[lConfig] * 3u;
+                                for (uint32_t i = 0; i < lNumEdges; i++)
+                                {
+                                    const int32_t lEdge = lTriangles[i];
+                                    const int32_t lAxis = lTables.mEdgeAxis[lEdge];
+                                    const int32_t lFrom = lCellPoint + lCornerOffsets[lTables.mEdgeCorners[lEdge][0]];
+                                    uint32_t& lVertex = lEdgeVertices[lAxis * lBrickPoints + lFrom];
+
+                                    if (lVertex == kInvalidIndex)
+                                    {
+                                        const int32_t lTo = lFrom + lAxisStrides[lAxis];
+                                        const float lDistFrom = lDistances[lFrom];
+                                        const float lDistTo = lDistances[lTo];
+                                        const float lT = glm::clamp(lDistFrom / (lDistFrom - lDistTo), 0.0f, 1.0f);
+
+                                        lVertex = uint32_t(lChunk.mPositions.size());
+                                        lChunk.mPositions.push_back(glm::mix(lPoints[lFrom], lPoints[lTo], lT));
+                                        lChunk.mKeys.push_back(CSdfMeshGrid::GetKey(lGridOrigin + glm::ivec3(x, y, z) + lTables.mEdgeOrigins[lEdge], uint32_t(lAxis)));
+                                    }
+                                    lChunk.mIndices.push_back(lVertex);
+                                }
+                            }
+                        }
+                    }
+
+                    // Normals from the distance gradient at each new vertex
+                    const size_t lNumBrickVertices = lChunk.mPositions.size() - lFirstBrickVertex;
+                    lChunk.mNormals.resize(lChunk.mPositions.size());
+                    lGrid.EvaluateNormals(lLutCoord, lChunk.mPositions.data() + lFirstBrickVertex, lNumBrickVertices, lNormalEps,
+                                          lChunk.mNormals.data() + lFirstBrickVertex, lBrick);
+                }
+            }
+        }, lThreads);
+
+        const auto lWeldStartTime = std::chrono::steady_clock::now();
+
+        // Seam vertices take the lowest values of the weld, then the slab ones
+        // in chunk order, the first copy of each edge is kept
+        const size_t lNumSeam = lSeamKeys.size();
+        size_t lNumVertices = lNumSeam;
+        for (TChunkMesh& lChunk : lChunks)
+        {
+            lChunk.mFirstVertex = lNumVertices;
+            lNumVertices += lChunk.mPositions.size();
+        }
+        SBX_ASSERT(lNumVertices < kInvalidIndex, "Too many mesh vertices in a slab");
+
+        CSdfMeshKeyTable lWeldTable((lNumVertices - lNumSeam) * 2);
+        for (size_t v = 0; v < lNumSeam; v++)
+        {
+            lWeldTable.Insert(lSeamKeys[v], uint32_t(v));
+        }
+
+        lWelded.resize(lNumVertices);
+        sbx::ParallelFor(lNumChunks, 1, [&](size_t aBegin, size_t aEnd, uint32_t)
+        {
+            for (size_t c = aBegin; c < aEnd; c++)
+            {
+                TChunkMesh const& lChunk = lChunks[c];
+                for (size_t v = 0; v < lChunk.mKeys.size(); v++)
+                {
+                    lWelded[lChunk.mFirstVertex + v] = uint32_t(lWeldTable.Insert(lChunk.mKeys[v], uint32_t(lChunk.mFirstVertex + v)));
+                }
+            }
+        }, lThreads);
+
+        // Slots to the kept vertex, count the kept ones per chunk
+        sbx::ParallelFor(lNumChunks, 1, [&](size_t aBegin, size_t aEnd, uint32_t)
+        {
+            for (size_t c = aBegin; c < aEnd; c++)
+            {
+                TChunkMesh& lChunk = lChunks[c];
+                size_t lKept = 0;
+                for (size_t v = lChunk.mFirstVertex; v < lChunk.mFirstVertex + lChunk.mPositions.size(); v++)
+                {
+                    lWelded[v] = lWeldTable.GetValue(lWelded[v]);
+                    lKept += (lWelded[v] == v) ? 1 : 0;
+                }
+                lChunk.mWeldedCount = lKept;
+            }
+        }, lThreads);
+
+        size_t lNumWelded = 0;
+        size_t lNumIndices = 0;
+        for (TChunkMesh& lChunk : lChunks)
+        {
+            lChunk.mFirstWelded = lNumWelded;
+            lChunk.mFirstIndex = lNumIndices;
+            lNumWelded += lChunk.mWeldedCount;
+            lNumIndices += lChunk.mIndices.size();
+        }
+        SBX_ASSERT(lStats.mVertices + lNumWelded < kInvalidIndex, "Too many mesh vertices");
+
+        // Weld values to the output numbering, the seam ones were written by the last slab
+        lGlobal.resize(lNumVertices);
+        std::copy(lSeamVertices.begin(), lSeamVertices.end(), lGlobal.begin());
+
+        lPiece.mPositions.resize(lNumWelded);
+        lPiece.mNormals.resize(lNumWelded);
+        lPiece.mIndices.resize(lNumIndices);
+
+        sbx::ParallelFor(lNumChunks, 1, [&](size_t aBegin, size_t aEnd, uint32_t)
+        {
+            for (size_t c = aBegin; c < aEnd; c++)
+            {
+                TChunkMesh const& lChunk = lChunks[c];
+                size_t lNext = lChunk.mFirstWelded;
+                for (size_t v = 0; v < lChunk.mPositions.size(); v++)
+                {
+                    const size_t lVertex = lChunk.mFirstVertex + v;
+                    if (lWelded[lVertex] == lVertex)
+                    {
+                        lGlobal[lVertex] = uint32_t(lStats.mVertices + lNext);
+                        lPiece.mPositions[lNext] = lChunk.mPositions[v];
+                        lPiece.mNormals[lNext] = lChunk.mNormals[v];
+                        lNext++;
+                    }
+                }
+            }
+        }, lThreads);
+
+        sbx::ParallelFor(lNumChunks, 1, [&](size_t aBegin, size_t aEnd, uint32_t)
+        {
+            for (size_t c = aBegin; c < aEnd; c++)
+            {
+                TChunkMesh const& lChunk = lChunks[c];
+                uint32_t* lIndices = lPiece.mIndices.data() + lChunk.mFirstIndex;
+                for (size_t i = 0; i < lChunk.mIndices.size(); i++)
+                {
+                    lIndices[i] = lGlobal[lWelded[lChunk.mFirstVertex + lChunk.mIndices[i]]];
+                }
+            }
+        }, lThreads);
+
+        // Edges on the top plane along x or y are shared with the next slab
+        lSeamKeys.clear();
+        lSeamVertices.clear();
+        for (TChunkMesh const& lChunk : lChunks)
+        {
+            for (size_t v = 0; v < lChunk.mKeys.size(); v++)
+            {
+                const uint64_t lKey = lChunk.mKeys[v];
+                if (lWelded[lChunk.mFirstVertex + v] == lChunk.mFirstVertex + v &&
+                    CSdfMeshGrid::GetKeyTag(lKey) != 2 && CSdfMeshGrid::GetKeyCoord(lKey).z == lSlabTop)
+                {
+                    lSeamKeys.push_back(lKey);
+                    lSeamVertices.push_back(lGlobal[lChunk.mFirstVertex + v]);
+                }
+            }
+        }
+
+        lStats.mVertices += lPiece.GetVerticesCount();
+        lStats.mTriangles += lPiece.GetTrianglesCount();
+        lStats.mMaxSlabTriangles = glm::max(lStats.mMaxSlabTriangles, lPiece.GetTrianglesCount());
+        lStats.mSlabs++;
+        lStats.mWeldSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - lWeldStartTime).count();
+
+        if (!aSink(lPiece))
+        {
+            break;
+        }
+        lSlabBegin = lSlabEnd;
+    }
+
+    lStats.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStartTime).count();
+    return lStats;
+}
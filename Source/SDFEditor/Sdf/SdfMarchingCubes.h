@@ -0,0 +1,25 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Narrow band marching cubes over the LUT volume
+
+#pragma once
+
+#include <cstdint>
+
+#include <SDFEditor/Sdf/SdfBakeParams.h>
+#include <SDFEditor/Sdf/SdfMesh.h>
+
+class CSdfEvaluator;
+
+// Marching cubes on the bricks of a CSdfMeshGrid, each one meshed on its own
+// in parallel. Vertices on the brick borders are welded through a lock free
+// hash of the grid edges, keeping the copy of the first brick so the output
+// doesn't depend on the threads count.
+class CSdfMarchingCubes
+{
+public:
+    TSdfMeshStats Extract(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, TSdfMesh& aOutMesh);
+
+    // Slabs of LUT voxel layers go to aSink as they are finished, only the
+    // vertices on the seam with the next slab are kept between them
+    TSdfMeshStats Extract(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams, TSdfMeshSinkFn const& aSink);
+};
@@ -0,0 +1,366 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfMesh.h"
+
+#include <sbx/Core/ErrorHandling.h>
+
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    // Output is staged in memory and written in blocks of this size
+    constexpr size_t kWriteBlockSize = 1 << 20;
+
+    class CBlockWriter
+    {
+    public:
+        CBlockWriter(std::string const& aPath)
+            : mOutput(aPath, std::ios::binary)
+        {
+            mBuffer.reserve(kWriteBlockSize + 256);
+        }
+
+        // Overwrites already written bytes, the next writes go to the end
+        void WriteAt(size_t aOffset, const void* aData, size_t aSize)
+        {
+            Flush();
+            mOutput.seekp(std::streamoff(aOffset));
+            mOutput.write((const char*)aData, std::streamsize(aSize));
+            mOutput.seekp(0, std::ios::end);
+        }
+
+        void Write(const void* aData, size_t aSize)
+        {
+            const char* lData = (const char*)aData;
+            mBuffer.insert(mBuffer.end(), lData, lData + aSize);
+            FlushIfFull();
+        }
+
+        void WriteText(const char* aText)
+        {
+            Write(aText, ::strlen(aText));
+        }
+
+        // Shortest text that reads back the same float
+        void WriteFloat(float aValue)
+        {
+            char lText[32];
+            const std::to_chars_result lResult = std::to_chars(lText, lText + sizeof(lText), aValue);
+            Write(lText, size_t(lResult.ptr - lText));
+        }
+
+        void WriteUint(uint32_t aValue)
+        {
+            char lText[16];
+            const std::to_chars_result lResult = std::to_chars(lText, lText + sizeof(lText), aValue);
+            Write(lText, size_t(lResult.ptr - lText));
+        }
+
+        bool Close()
+        {
+            Flush();
+            mOutput.close();
+            return !mOutput.fail();
+        }
+
+        bool IsOpen() const { return mOutput.is_open(); }
+
+    private:
+        void FlushIfFull()
+        {
+            if (mBuffer.size() >= kWriteBlockSize)
+            {
+                Flush();
+            }
+        }
+
+        void Flush()
+        {
+            mOutput.write(mBuffer.data(), mBuffer.size());
+            mBuffer.clear();
+        }
+
+        std::ofstream mOutput;
+        std::vector<char> mBuffer;
+    };
+
+    // Host order, every target of the editor is little endian
+    void WritePlyVertices(CBlockWriter& aWriter, TSdfMesh const& aMesh, bool aNormals)
+    {
+        for (size_t i = 0; i < aMesh.mPositions.size(); i++)
+        {
+            aWriter.Write(&aMesh.mPositions[i], sizeof(glm::vec3));
+            if (aNormals)
+            {
+                aWriter.Write(&aMesh.mNormals[i], sizeof(glm::vec3));
+            }
+        }
+    }
+
+    void WritePlyFaces(CBlockWriter& aWriter, TSdfMesh const& aMesh)
+    {
+        char lFace[1 + 3 * sizeof(uint32_t)];
+        lFace[0] = 3;
+        for (size_t i = 0; i + 2 < aMesh.mIndices.size(); i += 3)
+        {
+            ::memcpy(lFace + 1, &aMesh.mIndices[i], 3 * sizeof(uint32_t));
+            aWriter.Write(lFace, sizeof(lFace));
+        }
+    }
+
+    void WriteObjVector(CBlockWriter& aWriter, const char* aPrefix, glm::vec3 const& aVector)
+    {
+        aWriter.WriteText(aPrefix);
+        aWriter.WriteFloat(aVector.x);
+        aWriter.WriteText(" ");
+        aWriter.WriteFloat(aVector.y);
+        aWriter.WriteText(" ");
+        aWriter.WriteFloat(aVector.z);
+        aWriter.WriteText("\n");
+    }
+
+    void WriteObjVertices(CBlockWriter& aWriter, TSdfMesh const& aMesh, bool aNormals)
+    {
+        for (glm::vec3 const& lPos : aMesh.mPositions)
+        {
+            WriteObjVector(aWriter, "v ", lPos);
+        }
+
+        if (aNormals)
+        {
+            for (glm::vec3 const& lNormal : aMesh.mNormals)
+            {
+                WriteObjVector(aWriter, "vn ", lNormal);
+            }
+        }
+    }
+
+    // OBJ indices start at 1, with normals each corner is v//vn
+    void WriteObjFaces(CBlockWriter& aWriter, TSdfMesh const& aMesh, bool aNormals)
+    {
+        for (size_t i = 0; i + 2 < aMesh.mIndices.size(); i += 3)
+        {
+            aWriter.WriteText("f");
+            for (size_t c = 0; c < 3; c++)
+            {
+                const uint32_t lIndex = aMesh.mIndices[i + c] + 1;
+                aWriter.WriteText(" ");
+                aWriter.WriteUint(lIndex);
+                if (aNormals)
+                {
+                    aWriter.WriteText("//");
+                    aWriter.WriteUint(lIndex);
+                }
+            }
+            aWriter.WriteText("\n");
+        }
+    }
+
+    bool IsObjPath(std::string const& aPath)
+    {
+        const size_t lLength = aPath.size();
+        return lLength >= 4 && (aPath.compare(lLength - 4, 4, ".obj") == 0 || aPath.compare(lLength - 4, 4, ".OBJ") == 0);
+    }
+
+    // Counts in the streamed PLY header are padded to this width and patched at the end
+    constexpr size_t kPlyCountWidth = 20;
+}
+
+void TSdfMesh::Clear()
+{
+    mPositions.clear();
+    mNormals.clear();
+    mIndices.clear();
+}
+
+void TSdfMesh::Append(TSdfMesh const& aPiece)
+{
+    mPositions.insert(mPositions.end(), aPiece.mPositions.begin(), aPiece.mPositions.end());
+    mNormals.insert(mNormals.end(), aPiece.mNormals.begin(), aPiece.mNormals.end());
+    mIndices.insert(mIndices.end(), aPiece.mIndices.begin(), aPiece.mIndices.end());
+}
+
+namespace Sdf
+{
+    bool WriteMeshPly(std::string const& aPath, TSdfMesh const& aMesh)
+    {
+        CBlockWriter lWriter(aPath);
+        if (!lWriter.IsOpen())
+        {
+            return false;
+        }
+
+        const bool lHasNormals = aMesh.mNormals.size() == aMesh.mPositions.size();
+
+        std::string lHeader = "ply\nformat binary_little_endian 1.0\ncomment SDFEditor\n";
+        lHeader += "element vertex " + std::to_string(aMesh.GetVerticesCount()) + "\n";
+        lHeader += "property float x\nproperty float y\nproperty float z\n";
+        if (lHasNormals)
+        {
+            lHeader += "property float nx\nproperty float ny\nproperty float nz\n";
+        }
+        lHeader += "element face " + std::to_string(aMesh.GetTrianglesCount()) + "\n";
+        lHeader += "property list uchar uint vertex_indices\nend_header\n";
+        lWriter.Write(lHeader.data(), lHeader.size());
+
+        WritePlyVertices(lWriter, aMesh, lHasNormals);
+        WritePlyFaces(lWriter, aMesh);
+
+        return lWriter.Close();
+    }
+
+    bool WriteMeshObj(std::string const& aPath, TSdfMesh const& aMesh)
+    {
+        CBlockWriter lWriter(aPath);
+        if (!lWriter.IsOpen())
+        {
+            return false;
+        }
+
+        const bool lHasNormals = aMesh.mNormals.size() == aMesh.mPositions.size();
+
+        lWriter.WriteText("# SDFEditor\n");
+        WriteObjVertices(lWriter, aMesh, lHasNormals);
+        WriteObjFaces(lWriter, aMesh, lHasNormals);
+
+        return lWriter.Close();
+    }
+
+    bool WriteMesh(std::string const& aPath, TSdfMesh const& aMesh)
+    {
+        return IsObjPath(aPath) ? WriteMeshObj(aPath, aMesh) : WriteMeshPly(aPath, aMesh);
+    }
+}
+
+struct CSdfMeshStreamWriter::TFiles
+{
+    TFiles(std::string const& aPath, std::string const& aFacesPath)
+        : mOutput(aPath)
+    {
+        if (!aFacesPath.empty())
+        {
+            mFaces.reset(new CBlockWriter(aFacesPath));
+        }
+    }
+
+    CBlockWriter mOutput;
+    std::unique_ptr<CBlockWriter> mFaces;
+};
+
+CSdfMeshStreamWriter::CSdfMeshStreamWriter()
+{
+}
+
+CSdfMeshStreamWriter::~CSdfMeshStreamWriter()
+{
+    if (mFiles)
+    {
+        mFailed = true;
+        Close();
+    }
+}
+
+bool CSdfMeshStreamWriter::Open(std::string const& aPath, bool aNormals)
+{
+    mPath = aPath;
+    mObj = IsObjPath(aPath);
+    mNormals = aNormals;
+    mFailed = false;
+    mVerticesCount = 0;
+    mTrianglesCount = 0;
+    mFiles.reset(new TFiles(aPath, mObj ? std::string() : aPath + ".faces.tmp"));
+
+    if (!mFiles->mOutput.IsOpen() || (mFiles->mFaces && !mFiles->mFaces->IsOpen()))
+    {
+        mFailed = true;
+        Close();
+        return false;
+    }
+
+    if (mObj)
+    {
+        mFiles->mOutput.WriteText("# SDFEditor\n");
+        return true;
+    }
+
+    const std::string lPadding(kPlyCountWidth, ' ');
+    std::string lHeader = "ply\nformat binary_little_endian 1.0\ncomment SDFEditor\nelement vertex ";
+    mVertexCountOffset = lHeader.size();
+    lHeader += lPadding + "\nproperty float x\nproperty float y\nproperty float z\n";
+    if (mNormals)
+    {
+        lHeader += "property float nx\nproperty float ny\nproperty float nz\n";
+    }
+    lHeader += "element face ";
+    mFaceCountOffset = lHeader.size();
+    lHeader += lPadding + "\nproperty list uchar uint vertex_indices\nend_header\n";
+    mFiles->mOutput.Write(lHeader.data(), lHeader.size());
+
+    return true;
+}
+
+bool CSdfMeshStreamWriter::Write(TSdfMesh const& aPiece)
+{
+    if (!mFiles || mFailed)
+    {
+        return false;
+    }
+    SBX_ASSERT(!mNormals || aPiece.mNormals.size() == aPiece.mPositions.size(), "Mesh piece without normals");
+
+    if (mObj)
+    {
+        WriteObjVertices(mFiles->mOutput, aPiece, mNormals);
+        WriteObjFaces(mFiles->mOutput, aPiece, mNormals);
+    }
+    else
+    {
+        WritePlyVertices(mFiles->mOutput, aPiece, mNormals);
+        WritePlyFaces(*mFiles->mFaces, aPiece);
+    }
+
+    mVerticesCount += aPiece.GetVerticesCount();
+    mTrianglesCount += aPiece.GetTrianglesCount();
+    return true;
+}
+
+bool CSdfMeshStreamWriter::Close()
+{
+    if (!mFiles)
+    {
+        return false;
+    }
+
+    if (mFiles->mFaces)
+    {
+        const std::string lFacesPath = mPath + ".faces.tmp";
+        mFailed |= !mFiles->mFaces->Close();
+
+        // Faces after the vertices, a block at a time
+        if (!mFailed)
+        {
+            std::ifstream lFaces(lFacesPath, std::ios::binary);
+            std::vector<char> lBlock(kWriteBlockSize);
+            while (lFaces)
+            {
+                lFaces.read(lBlock.data(), std::streamsize(lBlock.size()));
+                mFiles->mOutput.Write(lBlock.data(), size_t(lFaces.gcount()));
+            }
+            mFailed |= lFaces.bad();
+        }
+
+        std::error_code lError;
+        std::filesystem::remove(lFacesPath, lError);
+
+        const std::string lVertexCount = std::to_string(mVerticesCount);
+        const std::string lFaceCount = std::to_string(mTrianglesCount);
+        mFiles->mOutput.WriteAt(mVertexCountOffset, lVertexCount.data(), lVertexCount.size());
+        mFiles->mOutput.WriteAt(mFaceCountOffset, lFaceCount.data(), lFaceCount.size());
+    }
+
+    mFailed |= !mFiles->mOutput.Close();
+    mFiles.reset();
+    return !mFailed;
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Indexed triangle meshes extracted from the scene and their file formats
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct TSdfMesh
+{
+    std::vector<glm::vec3> mPositions;
+    std::vector<glm::vec3> mNormals;        // one per position, empty or unit length
+    std::vector<uint32_t> mIndices;         // 3 per triangle, counter clockwise seen from outside
+
+    size_t GetVerticesCount() const { return mPositions.size(); }
+    size_t GetTrianglesCount() const { return mIndices.size() / 3; }
+
+    void Clear();
+
+    // Vertices go after the current ones, aPiece indices already count them
+    void Append(TSdfMesh const& aPiece);
+};
+
+// Receives the mesh of an extraction slab by slab, each piece holds the new
+// vertices and the triangles finished in the slab. Returning false stops the
+// extraction
+using TSdfMeshSinkFn = std::function<bool(TSdfMesh const& aPiece)>;
+
+struct TSdfMeshStats
+{
+    uint32_t mBricks{ 0 };              // LUT voxels close enough to the surface to be meshed
+    size_t mVertices{ 0 };
+    size_t mTriangles{ 0 };
+    uint32_t mThreads{ 0 };
+    double mStrokesPerVoxel{ 0.0 };     // average strokes evaluated per LUT voxel after culling
+    double mLutSeconds{ 0.0 };
+    uint32_t mSlabs{ 0 };
+    size_t mMaxSlabTriangles{ 0 };      // largest piece, what the extraction keeps in memory
+    double mWeldSeconds{ 0.0 };         // joining the vertices the bricks share
+    double mSeconds{ 0.0 };
+};
+
+namespace Sdf
+{
+    // Binary little endian PLY, positions and normals as float
+    bool WriteMeshPly(std::string const& aPath, TSdfMesh const& aMesh);
+
+    // Wavefront OBJ, v / vn / f lines
+    bool WriteMeshObj(std::string const& aPath, TSdfMesh const& aMesh);
+
+    // .obj writes OBJ, anything else PLY
+    bool WriteMesh(std::string const& aPath, TSdfMesh const& aMesh);
+}
+
+// Writes the pieces of an extraction as they arrive, only the write buffers
+// stay in memory. OBJ is written in arrival order. PLY needs the counts in the
+// header and the faces after all the vertices: the faces are staged in a
+// temporary file next to the output and the header is patched on Close.
+class CSdfMeshStreamWriter
+{
+public:
+    CSdfMeshStreamWriter();
+    ~CSdfMeshStreamWriter();
+
+    // .obj writes OBJ, anything else binary PLY. The pieces must all have
+    // normals or none, as aNormals says
+    bool Open(std::string const& aPath, bool aNormals);
+    bool Write(TSdfMesh const& aPiece);
+    bool Close();
+
+    size_t GetVerticesCount() const { return mVerticesCount; }
+    size_t GetTrianglesCount() const { return mTrianglesCount; }
+
+private:
+    struct TFiles;
+
+    std::unique_ptr<TFiles> mFiles;
+    std::string mPath;
+    bool mObj{ false };
+    bool mNormals{ false };
+    bool mFailed{ false };
+    size_t mVerticesCount{ 0 };
+    size_t mTrianglesCount{ 0 };
+    size_t mVertexCountOffset{ 0 };     // PLY header fields patched on Close
+    size_t mFaceCountOffset{ 0 };
+};
@@ -0,0 +1,287 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfMeshGrid.h"
+#include "SdfEvaluator.h"
+#include "SdfBounds.h"
+
+#include <sbx/Core/ErrorHandling.h>
+
+namespace
+{
+    // Surface can only cross a LUT voxel closer than half its diagonal, plus
+    // some slack for the blends that aren't exact distances
+    constexpr float kBrickBand = 1.0f;
+
+    // Cull grid of the mesh, in LUT voxels. The margin covers the band and
+    // the cell corners of the bricks around it
+    constexpr int32_t kCullCellVoxels = 2;
+    constexpr float kCullMarginVoxels = 2.0f;
+
+    glm::ivec3 GetFaceOffset(int32_t aFaces)
+    {
+        return glm::ivec3(aFaces & 1, (aFaces >> 1) & 1, aFaces >> 2);
+    }
+}
+
+TSdfLutBakeStats CSdfMeshGrid::Build(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams)
+{
+    SBX_ASSERT(aParams.mLutSize * aParams.mBrickSize < (1 << kKeyCoordBits), "Mesh grid too large for the grid keys");
+
+    mEvaluator = &aEvaluator;
+    mParams = aParams;
+    mCellSide = aParams.GetAtlasVoxelSide();
+    mHalfExtent = 0.5f * float(aParams.mLutSize) * aParams.mLutVoxelSide;
+
+    // Blends read the distance of the strokes before them, up to the blend
+    // radius away, the margin covers the widest one
+    float lMaxBlend = 0.0f;
+    for (stroke_t const& lStroke : aEvaluator.GetStrokes())
+    {
+        lMaxBlend = glm::max(lMaxBlend, Sdf::ComputeStrokeBlendMargin(lStroke));
+    }
+
+    TSdfBakeParams lLutParams = aParams;
+    lLutParams.mCullCellVoxels = kCullCellVoxels;
+    lLutParams.mCullMargin = aParams.mLutVoxelSide * kCullMarginVoxels + lMaxBlend;
+
+    const TSdfLutBakeStats lLutStats = mLutBaker.EvaluateDistances(aEvaluator, lLutParams, glm::ivec3(0), glm::ivec3(aParams.mLutSize));
+    std::vector<float> const& lLutDistances = mLutBaker.GetDistances();
+
+    const int32_t lLutSize = aParams.mLutSize;
+    const float lBand = aParams.mLutVoxelSide * kBrickBand;
+
+    mBricks.clear();
+    for (int32_t z = 0; z < lLutSize; z++)
+    {
+        for (int32_t y = 0; y < lLutSize; y++)
+        {
+            const float* lRow = lLutDistances.data() + (size_t(z) * lLutSize + y) * lLutSize;
+            for (int32_t x = 0; x < lLutSize; x++)
+            {
+                if (glm::abs(lRow[x]) < lBand)
+                {
+                    mBricks.emplace_back(x, y, z);
+                }
+            }
+        }
+    }
+
+    const int32_t lSide = GetBrickSide();
+    const int32_t lBrickPoints = GetBrickPoints();
+    const int32_t lBrickCells = GetBrickCells();
+    mPointFaces.resize(lBrickPoints);
+    for (int32_t i = 0; i < lBrickPoints; i++)
+    {
+        mPointFaces[i] = uint8_t(((i % lSide) == lBrickCells ? 1 : 0) |
+                                 (((i / lSide) % lSide) == lBrickCells ? 2 : 0) |
+                                 ((i / (lSide * lSide)) == lBrickCells ? 4 : 0));
+    }
+
+    return lLutStats;
+}
+
+size_t CSdfMeshGrid::GetSlabEnd(size_t aFirst, int32_t& aOutTop) const
+{
+    const int32_t lLayers = glm::max(kSlabCells / GetBrickCells(), 1);
+    const int32_t lLimit = (mBricks[aFirst].z / lLayers + 1) * lLayers;
+    aOutTop = lLimit * GetBrickCells();
+    size_t lEnd = aFirst;
+    while (lEnd < mBricks.size() && mBricks[lEnd].z < lLimit)
+    {
+        lEnd++;
+    }
+    return lEnd;
+}
+
+uint32_t CSdfMeshGrid::GetCullCell(glm::ivec3 const& aLutCoord) const
+{
+    if (!mParams.mCullStrokes)
+    {
+        return 0;
+    }
+
+    CSdfCullGrid const& lCullGrid = mLutBaker.GetCullGrid();
+    return lCullGrid.GetCellIndex(lCullGrid.GetCellFromLutCoord(glm::min(aLutCoord, glm::ivec3(mParams.mLutSize - 1))));
+}
+
+void CSdfMeshGrid::EvaluateCell(uint32_t aCell, glm::vec3 const* aPoints, size_t aCount, float* aOutDistances) const
+{
+    if (mParams.mCullStrokes)
+    {
+        CSdfCullGrid const& lCullGrid = mLutBaker.GetCullGrid();
+        mEvaluator->Evaluate(aPoints, aCount, aOutDistances, lCullGrid.GetCellStrokes(aCell), lCullGrid.GetCellStrokesCount(aCell));
+    }
+    else
+    {
+        mEvaluator->Evaluate(aPoints, aCount, aOutDistances);
+    }
+}
+
+bool CSdfMeshGrid::EvaluateBrick(glm::ivec3 const& aLutCoord, TSdfMeshBrick& aBrick) const
+{
+    const int32_t lSide = GetBrickSide();
+    const int32_t lBrickPoints = GetBrickPoints();
+    const glm::ivec3 lGridOrigin = aLutCoord * GetBrickCells();
+
+    aBrick.mPoints.resize(lBrickPoints);
+    aBrick.mDistances.resize(lBrickPoints);
+
+    size_t lPoint = 0;
+    for (int32_t z = 0; z < lSide; z++)
+    {
+        for (int32_t y = 0; y < lSide; y++)
+        {
+            for (int32_t x = 0; x < lSide; x++)
+            {
+                aBrick.mPoints[lPoint++] = GetPointPosition(lGridOrigin + glm::ivec3(x, y, z));
+            }
+        }
+    }
+
+    // Points on the upper faces belong to the next LUT voxel, that may be in
+    // another cull cell: the culled distances aren't exact far from the
+    // surface and every brick must get the same value
+    uint32_t lFaceCells[8];
+    bool lSingleCell = true;
+    for (int32_t f = 0; f < 8; f++)
+    {
+        lFaceCells[f] = GetCullCell(aLutCoord + GetFaceOffset(f));
+        lSingleCell &= (lFaceCells[f] == lFaceCells[0]);
+    }
+
+    if (lSingleCell)
+    {
+        EvaluateCell(lFaceCells[0], aBrick.mPoints.data(), aBrick.mPoints.size(), aBrick.mDistances.data());
+    }
+    else
+    {
+        for (int32_t f = 0; f < 8; f++)
+        {
+            // Each cell once, with the points of all the faces it owns
+            bool lDone = false;
+            for (int32_t g = 0; g < f; g++)
+            {
+                lDone |= (lFaceCells[g] == lFaceCells[f]);
+            }
+            if (lDone)
+            {
+                continue;
+            }
+
+            aBrick.mScratchPoints.clear();
+            for (int32_t i = 0; i < lBrickPoints; i++)
+            {
+                if (lFaceCells[mPointFaces[i]] == lFaceCells[f])
+                {
+                    aBrick.mScratchPoints.push_back(aBrick.mPoints[i]);
+                }
+            }
+            aBrick.mScratchDistances.resize(aBrick.mScratchPoints.size());
+            EvaluateCell(lFaceCells[f], aBrick.mScratchPoints.data(), aBrick.mScratchPoints.size(), aBrick.mScratchDistances.data());
+
+            size_t lGroupIndex = 0;
+            for (int32_t i = 0; i < lBrickPoints; i++)
+            {
+                if (lFaceCells[mPointFaces[i]] == lFaceCells[f])
+                {
+                    aBrick.mDistances[i] = aBrick.mScratchDistances[lGroupIndex++];
+                }
+            }
+        }
+    }
+
+    uint32_t lInsideCount = 0;
+    for (float lDist : aBrick.mDistances)
+    {
+        lInsideCount += (lDist < 0.0f) ? 1 : 0;
+    }
+    return lInsideCount != 0 && lInsideCount != uint32_t(lBrickPoints);
+}
+
+void CSdfMeshGrid::EvaluateNear(glm::ivec3 const& aLutCoord, glm::vec3 const* aPoints, size_t aCount, float* aOutDistances) const
+{
+    EvaluateCell(GetCullCell(aLutCoord), aPoints, aCount, aOutDistances);
+}
+
+void CSdfMeshGrid::EvaluateNormals(glm::ivec3 const& aLutCoord, glm::vec3 const* aPoints, size_t aCount, float aEps, glm::vec3* aOutNormals, TSdfMeshBrick& aScratch) const
+{
+    const glm::vec3 lOffsets[4] = { {1.0f, -1.0f, -1.0f}, {-1.0f, -1.0f, 1.0f}, {-1.0f, 1.0f, -1.0f}, {1.0f, 1.0f, 1.0f} };
+
+    aScratch.mScratchPoints.resize(aCount * 4);
+    for (size_t i = 0; i < aCount; i++)
+    {
+        for (size_t k = 0; k < 4; k++)
+        {
+            aScratch.mScratchPoints[i * 4 + k] = aPoints[i] + lOffsets[k] * aEps;
+        }
+    }
+    aScratch.mScratchDistances.resize(aScratch.mScratchPoints.size());
+    EvaluateNear(aLutCoord, aScratch.mScratchPoints.data(), aScratch.mScratchPoints.size(), aScratch.mScratchDistances.data());
+
+    for (size_t i = 0; i < aCount; i++)
+    {
+        glm::vec3 lGradient(0.0f);
+        for (size_t k = 0; k < 4; k++)
+        {
+            lGradient += lOffsets[k] * aScratch.mScratchDistances[i * 4 + k];
+        }
+        const float lLength = glm::length(lGradient);
+        aOutNormals[i] = (lLength > 0.0f) ? lGradient / lLength : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+}
+
+CSdfMeshKeyTable::CSdfMeshKeyTable(size_t aMinCapacity)
+{
+    size_t lCapacity = 1024;
+    while (lCapacity < aMinCapacity)
+    {
+        lCapacity <<= 1;
+    }
+    mMask = lCapacity - 1;
+    mKeys.reset(new std::atomic<uint64_t>[lCapacity]);
+    mValues.reset(new std::atomic<uint32_t>[lCapacity]);
+    for (size_t i = 0; i < lCapacity; i++)
+    {
+        mKeys[i].store(0, std::memory_order_relaxed);
+        mValues[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t CSdfMeshKeyTable::Insert(uint64_t aKey, uint32_t aValue)
+{
+    const uint32_t lValue = aValue + 1;
+    for (size_t lSlot = Hash(aKey) & mMask;; lSlot = (lSlot + 1) & mMask)
+    {
+        uint64_t lKey = mKeys[lSlot].load(std::memory_order_relaxed);
+        if (lKey == 0 && mKeys[lSlot].compare_exchange_strong(lKey, aKey, std::memory_order_relaxed))
+        {
+            lKey = aKey;
+        }
+
+        if (lKey == aKey)
+        {
+            uint32_t lCurrent = mValues[lSlot].load(std::memory_order_relaxed);
+            while ((lCurrent == 0 || lCurrent > lValue) &&
+                   !mValues[lSlot].compare_exchange_weak(lCurrent, lValue, std::memory_order_relaxed))
+            {
+            }
+            return lSlot;
+        }
+    }
+}
+
+uint32_t CSdfMeshKeyTable::Find(uint64_t aKey) const
+{
+    for (size_t lSlot = Hash(aKey) & mMask;; lSlot = (lSlot + 1) & mMask)
+    {
+        const uint64_t lKey = mKeys[lSlot].load(std::memory_order_relaxed);
+        if (lKey == aKey)
+        {
+            return GetValue(lSlot);
+        }
+        if (lKey == 0)
+        {
+            return kInvalidValue;
+        }
+    }
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Narrow band of the LUT volume shared by the mesh extractors
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <SDFEditor/Sdf/SdfBakeParams.h>
+#include <SDFEditor/Sdf/SdfLutBaker.h>
+
+class CSdfEvaluator;
+
+// Per thread points and distances of a brick, and scratch for the evaluations
+struct TSdfMeshBrick
+{
+    std::vector<glm::vec3> mPoints;         // (mBrickSize + 1)^3 grid points, x major
+    std::vector<float> mDistances;
+
+    std::vector<glm::vec3> mScratchPoints;
+    std::vector<float> mScratchDistances;
+};
+
+// Mesh grid mBrickSize times finer than the LUT, the same grid as the atlas
+// for the default params. Only the LUT voxels next to the surface are kept,
+// each one is a brick of mBrickSize^3 cells the extractors visit in parallel.
+// The LUT distances that pick the bricks are evaluated here, with a cull grid
+// much finer than the bake one: the mesh only needs exact distances next to
+// the surface, not the raymarching margin.
+class CSdfMeshGrid
+{
+public:
+    static constexpr int32_t kKeyCoordBits = 20;
+    static constexpr int32_t kSlabCells = 32;
+
+    TSdfLutBakeStats Build(CSdfEvaluator const& aEvaluator, TSdfBakeParams const& aParams);
+
+    // Bricks in LUT index order
+    std::vector<glm::ivec3> const& GetBricks() const { return mBricks; }
+
+    int32_t GetBrickCells() const { return mParams.mBrickSize; }
+    int32_t GetBrickSide() const { return mParams.mBrickSize + 1; }
+    int32_t GetBrickPoints() const { return GetBrickSide() * GetBrickSide() * GetBrickSide(); }
+    int32_t GetGridSide() const { return mParams.mLutSize * mParams.mBrickSize; }
+    float GetCellSide() const { return mCellSide; }
+
+    // From the integer coords, shared points get the same value in every brick
+    glm::vec3 GetPointPosition(glm::ivec3 const& aGridCoord) const { return glm::vec3(aGridCoord) * mCellSide - mHalfExtent; }
+
+    // Fills the points and distances of the brick, false when they all have
+    // the same sign. Each grid point takes the strokes of the cull cell of the
+    // LUT voxel it falls in, so the bricks sharing a point agree on its sign.
+    bool EvaluateBrick(glm::ivec3 const& aLutCoord, TSdfMeshBrick& aBrick) const;
+
+    // Points inside or next to the LUT voxel, with the strokes of its cull cell
+    void EvaluateNear(glm::ivec3 const& aLutCoord, glm::vec3 const* aPoints, size_t aCount, float* aOutDistances) const;
+
+    // Unit gradients of the distance from a tetrahedron of offsets aEps long,
+    // same as the raymarcher normals
+    void EvaluateNormals(glm::ivec3 const& aLutCoord, glm::vec3 const* aPoints, size_t aCount, float aEps, glm::vec3* aOutNormals, TSdfMeshBrick& aScratch) const;
+
+    // Key of a grid point, cell or edge, aTag (0 to 3) tells them apart. Never 0
+    static uint64_t GetKey(glm::ivec3 const& aGridCoord, uint32_t aTag)
+    {
+        return (1ull << 63) | uint64_t(aTag) |
+               (uint64_t(aGridCoord.x) << 2) |
+               (uint64_t(aGridCoord.y) << (2 + kKeyCoordBits)) |
+               (uint64_t(aGridCoord.z) << (2 + kKeyCoordBits * 2));
+    }
+
+    static glm::ivec3 GetKeyCoord(uint64_t aKey)
+    {
+        const uint64_t lMask = (1ull << kKeyCoordBits) - 1;
+        return glm::ivec3(int32_t((aKey >> 2) & lMask), int32_t((aKey >> (2 + kKeyCoordBits)) & lMask), int32_t((aKey >> (2 + kKeyCoordBits * 2)) & lMask));
+    }
+
+    static uint32_t GetKeyTag(uint64_t aKey) { return uint32_t(aKey & 3); }
+
+    // Extractors go through the bricks in slabs of whole LUT voxel layers,
+    // about kSlabCells grid cells thick. Returns the end of the slab starting
+    // at aFirst and the grid z of its top plane
+    size_t GetSlabEnd(size_t aFirst, int32_t& aOutTop) const;
+
+private:
+    uint32_t GetCullCell(glm::ivec3 const& aLutCoord) const;
+    void EvaluateCell(uint32_t aCell, glm::vec3 const* aPoints, size_t aCount, float* aOutDistances) const;
+
+    CSdfEvaluator const* mEvaluator{ nullptr };
+    TSdfBakeParams mParams;
+    CSdfLutBaker mLutBaker;
+    std::vector<glm::ivec3> mBricks;
+    std::vector<uint8_t> mPointFaces;       // upper faces of the brick of each point, bits like the cell corners
+    float mCellSide{ 0.0f };
+    float mHalfExtent{ 0.0f };
+};
+
+// Open addressing from grid key to the lowest value inserted with it. Slots
+// are claimed with a CAS on the key, 0 is empty in both arrays
+class CSdfMeshKeyTable
+{
+public:
+    static constexpr uint32_t kInvalidValue = UINT32_MAX;
+
+    CSdfMeshKeyTable(size_t aMinCapacity);
+
+    // Returns the slot of aKey
+    size_t Insert(uint64_t aKey, uint32_t aValue);
+
+    // Valid once all the inserts are done
+    uint32_t GetValue(size_t aSlot) const { return mValues[aSlot].load(std::memory_order_relaxed) - 1; }
+    uint32_t Find(uint64_t aKey) const;
+
+private:
+    static size_t Hash(uint64_t aKey)
+    {
+        aKey ^= aKey >> 33;
+        aKey *= 0xff51afd7ed558ccdull;
+        aKey ^= aKey >> 33;
+        return size_t(aKey);
+    }
+
+    size_t mMask{ 0 };
+    std::unique_ptr<std::atomic<uint64_t>[]> mKeys;
+    std::unique_ptr<std::atomic<uint32_t>[]> mValues;
+};
@@ -0,0 +1,648 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfMeshSimplifier.h"
+
+#include <sbx/Core/Parallel.h>
+#include <sbx/Core/ErrorHandling.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+    constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+    // Vertex locks, open borders for the whole simplification and shared
+    // vertices only for the partitions pass
+    constexpr uint8_t kLockOpenBorder = 1;
+    constexpr uint8_t kLockShared = 2;
+
+    // Partitions per side of the grid are capped, past this the shared
+    // vertices stop being a small fraction of each partition
+    constexpr int32_t kMaxPartitionGrid = 32;
+
+    // Collapses are sorted by the upper bits of their float cost, sign,
+    // exponent and 3 mantissa bits: an eighth of an octave is enough order
+    constexpr uint32_t kCostBucketShift = 20;
+    constexpr uint32_t kCostBuckets = 1 << (32 - kCostBucketShift);
+
+    // Collapses can't turn the normal of a remaining triangle more than ~75 degrees
+    constexpr float kMinNormalCos = 0.25f;
+
+    // Symmetric 4x4 quadric of area weighted planes, in double: the float
+    // version of a plane at a few units from the origin cancels out the
+    // errors of small flat details
+    struct TQuadric
+    {
+        double mA00{ 0.0 }, mA01{ 0.0 }, mA02{ 0.0 }, mA11{ 0.0 }, mA12{ 0.0 }, mA22{ 0.0 };
+        double mB0{ 0.0 }, mB1{ 0.0 }, mB2{ 0.0 };
+        double mC{ 0.0 };
+        double mWeight{ 0.0 };
+
+        void AddPlane(glm::dvec3 const& aNormal, double aDistance, double aWeight)
+        {
+            mA00 += aWeight * aNormal.x * aNormal.x;
+            mA01 += aWeight * aNormal.x * aNormal.y;
+            mA02 += aWeight * aNormal.x * aNormal.z;
+            mA11 += aWeight * aNormal.y * aNormal.y;
+            mA12 += aWeight * aNormal.y * aNormal.z;
+            mA22 += aWeight * aNormal.z * aNormal.z;
+            mB0 += aWeight * aNormal.x * aDistance;
+            mB1 += aWeight * aNormal.y * aDistance;
+            mB2 += aWeight * aNormal.z * aDistance;
+            mC += aWeight * aDistance * aDistance;
+            mWeight += aWeight;
+        }
+
+        TQuadric& operator+=(TQuadric const& aOther)
+        {
+            mA00 += aOther.mA00; mA01 += aOther.mA01; mA02 += aOther.mA02;
+            mA11 += aOther.mA11; mA12 += aOther.mA12; mA22 += aOther.mA22;
+            mB0 += aOther.mB0; mB1 += aOther.mB1; mB2 += aOther.mB2;
+            mC += aOther.mC;
+            mWeight += aOther.mWeight;
+            return *this;
+        }
+
+        TQuadric& operator-=(TQuadric const& aOther)
+        {
+            mA00 -= aOther.mA00; mA01 -= aOther.mA01; mA02 -= aOther.mA02;
+            mA11 -= aOther.mA11; mA12 -= aOther.mA12; mA22 -= aOther.mA22;
+            mB0 -= aOther.mB0; mB1 -= aOther.mB1; mB2 -= aOther.mB2;
+            mC -= aOther.mC;
+            mWeight -= aOther.mWeight;
+            return *this;
+        }
+
+        // Mean squared distance to the planes
+        double Evaluate(glm::vec3 const& aPoint) const
+        {
+            const double x = aPoint.x;
+            const double y = aPoint.y;
+            const double z = aPoint.z;
+            const double lError = x * (mA00 * x + 2.0 * (mA01 * y + mA02 * z + mB0)) +
+                                  y * (mA11 * y + 2.0 * (mA12 * z + mB1)) +
+                                  z * (mA22 * z + 2.0 * mB2) + mC;
+            return (mWeight > 0.0) ? glm::max(lError, 0.0) / mWeight : 0.0;
+        }
+    };
+
+    // Vertices, quadrics and locks of the part of the mesh being simplified
+    struct TRegion
+    {
+        glm::vec3 const* mPositions{ nullptr };
+        TQuadric* mQuadrics{ nullptr };
+        uint8_t const* mLocks{ nullptr };
+        size_t mVerticesCount{ 0 };
+    };
+
+    // Triangles around each vertex, in triangle order
+    struct TAdjacency
+    {
+        std::vector<uint32_t> mOffsets;
+        std::vector<uint32_t> mTriangles;
+
+        void Build(std::vector<uint32_t> const& aIndices, size_t aVerticesCount)
+        {
+            mOffsets.assign(aVerticesCount + 1, 0);
+            for (uint32_t lIndex : aIndices)
+            {
+                mOffsets[lIndex + 1]++;
+            }
+            for (size_t v = 0; v < aVerticesCount; v++)
+            {
+                mOffsets[v + 1] += mOffsets[v];
+            }
+
+            // Offsets move to the end of each list while filling, then back
+            mTriangles.resize(aIndices.size());
+            for (size_t i = 0; i < aIndices.size(); i++)
+            {
+                mTriangles[mOffsets[aIndices[i]]++] = uint32_t(i / 3);
+            }
+            for (size_t v = aVerticesCount; v > 0; v--)
+            {
+                mOffsets[v] = mOffsets[v - 1];
+            }
+            mOffsets[0] = 0;
+        }
+
+        uint32_t const* Begin(uint32_t aVertex) const { return mTriangles.data() + mOffsets[aVertex]; }
+        uint32_t const* End(uint32_t aVertex) const { return mTriangles.data() + mOffsets[aVertex + 1]; }
+    };
+
+    uint64_t HashIndex(uint32_t aIndex)
+    {
+        uint64_t lHash = aIndex + 0x9e3779b97f4a7c15ull;
+        lHash = (lHash ^ (lHash >> 30)) * 0xbf58476d1ce4e5b9ull;
+        lHash = (lHash ^ (lHash >> 27)) * 0x94d049bb133111ebull;
+        return lHash ^ (lHash >> 31);
+    }
+
+    struct TCollapse
+    {
+        uint32_t mFrom;
+        uint32_t mTo;
+        float mCost;        // mean squared distance of the merged quadric at mTo
+    };
+
+    uint32_t GetCostBucket(float aCost)
+    {
+        uint32_t lBits;
+        memcpy(&lBits, &aCost, sizeof(lBits));
+        return lBits >> kCostBucketShift;
+    }
+
+    // Counting sort by cost bucket, the collapses of a bucket keep the order
+    // they were found in
+    void SortCollapses(std::vector<TCollapse> const& aCollapses, std::vector<uint32_t>& aBuckets, std::vector<TCollapse>& aOutSorted)
+    {
+        aBuckets.assign(kCostBuckets + 1, 0);
+        for (TCollapse const& lCollapse : aCollapses)
+        {
+            aBuckets[GetCostBucket(lCollapse.mCost) + 1]++;
+        }
+        for (uint32_t b = 0; b < kCostBuckets; b++)
+        {
+            aBuckets[b + 1] += aBuckets[b];
+        }
+
+        aOutSorted.resize(aCollapses.size());
+        for (TCollapse const& lCollapse : aCollapses)
+        {
+            aOutSorted[aBuckets[GetCostBucket(lCollapse.mCost)]++] = lCollapse;
+        }
+    }
+
+    // Cheapest direction to collapse the edge, false if both ends are locked
+    bool GetCollapse(TRegion const& aRegion, uint32_t aA, uint32_t aB, TCollapse& aOutCollapse)
+    {
+        const bool lMoveA = (aRegion.mLocks[aA] == 0);
+        const bool lMoveB = (aRegion.mLocks[aB] == 0);
+        if (!lMoveA && !lMoveB)
+        {
+            return false;
+        }
+
+        TQuadric lQuadric = aRegion.mQuadrics[aA];
+        lQuadric += aRegion.mQuadrics[aB];
+        const double lCostAB = lMoveA ? lQuadric.Evaluate(aRegion.mPositions[aB]) : DBL_MAX;
+        const double lCostBA = lMoveB ? lQuadric.Evaluate(aRegion.mPositions[aA]) : DBL_MAX;
+
+        aOutCollapse.mFrom = (lCostAB <= lCostBA) ? aA : aB;
+        aOutCollapse.mTo = (lCostAB <= lCostBA) ? aB : aA;
+        aOutCollapse.mCost = float(glm::min(lCostAB, lCostBA));
+        return true;
+    }
+
+    // The collapse keeps the mesh manifold and doesn't fold any triangle.
+    // Fills aOutRing with the neighbours of mFrom, the vertices it changes
+    bool CanCollapse(TRegion const& aRegion, std::vector<uint32_t> const& aIndices, TAdjacency const& aAdjacency, TCollapse const& aCollapse,
+                     std::vector<uint32_t>& aOutRing, std::vector<uint32_t>& aScratch)
+    {
+        const glm::vec3 lFrom = aRegion.mPositions[aCollapse.mFrom];
+        const glm::vec3 lTo = aRegion.mPositions[aCollapse.mTo];
+
+        aOutRing.clear();
+        uint32_t lShared = 0;
+        for (uint32_t const* lIt = aAdjacency.Begin(aCollapse.mFrom); lIt != aAdjacency.End(aCollapse.mFrom); ++lIt)
+        {
+            uint32_t const* lTriangle = &aIndices[size_t(*lIt) * 3];
+            const uint32_t lCorner = (lTriangle[0] == aCollapse.mFrom) ? 0 : (lTriangle[1] == aCollapse.mFrom) ? 1 : 2;
+            const uint32_t lNext = lTriangle[(lCorner + 1) % 3];
+            const uint32_t lPrev = lTriangle[(lCorner + 2) % 3];
+            aOutRing.push_back(lNext);
+            aOutRing.push_back(lPrev);
+
+            // Triangles on the edge go away
+            if (lNext == aCollapse.mTo || lPrev == aCollapse.mTo)
+            {
+                lShared++;
+                continue;
+            }
+
+            const glm::vec3 lNextPos = aRegion.mPositions[lNext];
+            const glm::vec3 lPrevPos = aRegion.mPositions[lPrev];
+            const glm::vec3 lBefore = glm::cross(lNextPos - lFrom, lPrevPos - lFrom);
+            const glm::vec3 lAfter = glm::cross(lNextPos - lTo, lPrevPos - lTo);
+            const float lBeforeLength = glm::length(lBefore);
+            const float lAfterLength = glm::length(lAfter);
+            if (lAfterLength <= 0.0f || (lBeforeLength > 0.0f && glm::dot(lBefore, lAfter) <= kMinNormalCos * lBeforeLength * lAfterLength))
+            {
+                return false;
+            }
+        }
+
+        // Interior edge, and the only common neighbours of its ends are the
+        // opposite corners of its two triangles, otherwise the surface pinches
+        if (lShared != 2)
+        {
+            return false;
+        }
+
+        aScratch.clear();
+        for (uint32_t const* lIt = aAdjacency.Begin(aCollapse.mTo); lIt != aAdjacency.End(aCollapse.mTo); ++lIt)
+        {
+            uint32_t const* lTriangle = &aIndices[size_t(*lIt) * 3];
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                if (lTriangle[k] != aCollapse.mTo)
+                {
+                    aScratch.push_back(lTriangle[k]);
+                }
+            }
+        }
+
+        std::sort(aOutRing.begin(), aOutRing.end());
+        aOutRing.erase(std::unique(aOutRing.begin(), aOutRing.end()), aOutRing.end());
+        std::sort(aScratch.begin(), aScratch.end());
+        aScratch.erase(std::unique(aScratch.begin(), aScratch.end()), aScratch.end());
+
+        uint32_t lCommon = 0;
+        for (size_t i = 0, j = 0; i < aOutRing.size() && j < aScratch.size();)
+        {
+            if (aOutRing[i] < aScratch[j])
+            {
+                i++;
+            }
+            else if (aScratch[j] < aOutRing[i])
+            {
+                j++;
+            }
+            else
+            {
+                lCommon++;
+                i++;
+                j++;
+            }
+        }
+        return lCommon == 2;
+    }
+
+    // Passes of independent collapses, cheapest first, until the target or
+    // the error limit. Collapses in a pass don't touch the triangles of each
+    // other: the neighbours of a moved vertex wait for the next pass.
+    // Returns the largest collapse cost
+    double SimplifyRegion(TRegion const& aRegion, std::vector<uint32_t>& aIndices, size_t aTargetTriangles, double aMaxCost)
+    {
+        TAdjacency lAdjacency;
+        std::vector<TCollapse> lCollapses;
+        std::vector<TCollapse> lSorted;
+        std::vector<uint32_t> lBuckets;
+        std::vector<uint32_t> lRemap(aRegion.mVerticesCount);
+        std::iota(lRemap.begin(), lRemap.end(), 0u);
+        std::vector<uint8_t> lTouched(aRegion.mVerticesCount);
+        std::vector<uint32_t> lRing;
+        std::vector<uint32_t> lScratch;
+        double lMaxCost = 0.0;
+
+        while (aIndices.size() / 3 > aTargetTriangles)
+        {
+            const size_t lTriangles = aIndices.size() / 3;
+            lAdjacency.Build(aIndices, aRegion.mVerticesCount);
+
+            // Each interior edge once, from the triangle that walks it upwards.
+            // Edges with only one triangle here have both ends locked
+            lCollapses.clear();
+            for (size_t i = 0; i < aIndices.size(); i++)
+            {
+                const uint32_t lA = aIndices[i];
+                const uint32_t lB = aIndices[(i % 3 == 2) ? i - 2 : i + 1];
+                TCollapse lCollapse;
+                if (lA < lB && GetCollapse(aRegion, lA, lB, lCollapse) && lCollapse.mCost <= aMaxCost)
+                {
+                    lCollapses.push_back(lCollapse);
+                }
+            }
+
+            SortCollapses(lCollapses, lBuckets, lSorted);
+
+            const size_t lExcess = lTriangles - aTargetTriangles;
+            std::fill(lTouched.begin(), lTouched.end(), uint8_t(0));
+            size_t lRemoved = 0;
+            for (size_t c = 0; c < lSorted.size() && lRemoved < lExcess; c++)
+            {
+                TCollapse const& lCollapse = lSorted[c];
+                if (lTouched[lCollapse.mFrom] || lTouched[lCollapse.mTo] ||
+                    !CanCollapse(aRegion, aIndices, lAdjacency, lCollapse, lRing, lScratch))
+                {
+                    continue;
+                }
+
+                lRemap[lCollapse.mFrom] = lCollapse.mTo;
+                aRegion.mQuadrics[lCollapse.mTo] += aRegion.mQuadrics[lCollapse.mFrom];
+                lMaxCost = glm::max(lMaxCost, double(lCollapse.mCost));
+
+                lTouched[lCollapse.mFrom] = 1;
+                for (uint32_t lVertex : lRing)
+                {
+                    lTouched[lVertex] = 1;
+                }
+                lRemoved += 2;
+            }
+
+            if (lRemoved == 0)
+            {
+                break;
+            }
+
+            size_t lKept = 0;
+            for (size_t t = 0; t < lTriangles; t++)
+            {
+                const uint32_t lA = lRemap[aIndices[t * 3 + 0]];
+                const uint32_t lB = lRemap[aIndices[t * 3 + 1]];
+                const uint32_t lC = lRemap[aIndices[t * 3 + 2]];
+                if (lA != lB && lB != lC && lA != lC)
+                {
+                    aIndices[lKept * 3 + 0] = lA;
+                    aIndices[lKept * 3 + 1] = lB;
+                    aIndices[lKept * 3 + 2] = lC;
+                    lKept++;
+                }
+            }
+            aIndices.resize(lKept * 3);
+        }
+
+        return lMaxCost;
+    }
+
+    // Partition result, the quadric changes of the shared vertices are added
+    // once all the partitions are done
+    struct TPartition
+    {
+        std::vector<uint32_t> mIndices;
+        std::vector<uint32_t> mSharedVertices;
+        std::vector<TQuadric> mSharedQuadrics;
+        double mMaxCost{ 0.0 };
+    };
+
+    // Only the vertices the triangles use, in their original order
+    void CompactMesh(TSdfMesh const& aMesh, std::vector<uint32_t> const& aIndices, TSdfMesh& aOutMesh)
+    {
+        const bool lNormals = !aMesh.mNormals.empty();
+        std::vector<uint32_t> lRemap(aMesh.GetVerticesCount(), kInvalidIndex);
+        for (uint32_t lIndex : aIndices)
+        {
+            lRemap[lIndex] = 0;
+        }
+
+        aOutMesh.Clear();
+        for (size_t v = 0; v < lRemap.size(); v++)
+        {
+            if (lRemap[v] != kInvalidIndex)
+            {
+                lRemap[v] = uint32_t(aOutMesh.mPositions.size());
+                aOutMesh.mPositions.push_back(aMesh.mPositions[v]);
+                if (lNormals)
+                {
+                    aOutMesh.mNormals.push_back(aMesh.mNormals[v]);
+                }
+            }
+        }
+
+        aOutMesh.mIndices.resize(aIndices.size());
+        for (size_t i = 0; i < aIndices.size(); i++)
+        {
+            aOutMesh.mIndices[i] = lRemap[aIndices[i]];
+        }
+    }
+}
+
+TSdfSimplifyStats CSdfMeshSimplifier::Simplify(TSdfMesh const& aMesh, TSdfSimplifyParams const& aParams, TSdfMesh& aOutMesh)
+{
+    const auto lStartTime = std::chrono::steady_clock::now();
+
+    const uint32_t lThreads = (aParams.mThreads > 0) ? aParams.mThreads : sbx::GetHardwareThreadsCount();
+    const size_t lVerticesCount = aMesh.GetVerticesCount();
+    const size_t lTriangles = aMesh.GetTrianglesCount();
+    const double lMaxCost = double(aParams.mMaxError) * double(aParams.mMaxError);
+
+    TSdfSimplifyStats lStats;
+    lStats.mThreads = lThreads;
+
+    std::vector<uint32_t> lIndices = aMesh.mIndices;
+
+    // Quadrics of the input planes. On closed surfaces every edge leaving a
+    // vertex comes back through the next triangle: the hashes of the next and
+    // previous corners around it cancel out, except on open borders
+    std::vector<TQuadric> lQuadrics(lVerticesCount);
+    std::vector<uint8_t> lLocks(lVerticesCount);
+    {
+        std::vector<uint64_t> lBalances(lVerticesCount, 0);
+        for (size_t t = 0; t < lTriangles; t++)
+        {
+            uint32_t const* lTriangle = &lIndices[t * 3];
+            const glm::dvec3 lP0 = aMesh.mPositions[lTriangle[0]];
+            const glm::dvec3 lNormal = glm::cross(glm::dvec3(aMesh.mPositions[lTriangle[1]]) - lP0, glm::dvec3(aMesh.mPositions[lTriangle[2]]) - lP0);
+            const double lLength = glm::length(lNormal);
+
+            TQuadric lQuadric;
+            if (lLength > 0.0)
+            {
+                lQuadric.AddPlane(lNormal / lLength, -glm::dot(lNormal / lLength, lP0), 0.5 * lLength);
+            }
+
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                lQuadrics[lTriangle[k]] += lQuadric;
+                lBalances[lTriangle[k]] += HashIndex(lTriangle[(k + 1) % 3]) - HashIndex(lTriangle[(k + 2) % 3]);
+            }
+        }
+
+        for (size_t v = 0; v < lVerticesCount; v++)
+        {
+            lLocks[v] = (lBalances[v] != 0) ? kLockOpenBorder : 0;
+        }
+    }
+
+    // Grid of partitions over the bounds, the surface crosses about the
+    // square of its side, each with kPartitionTriangles
+    int32_t lGrid = 1;
+    while (lGrid < kMaxPartitionGrid && size_t(lGrid) * size_t(lGrid) * kPartitionTriangles < lTriangles)
+    {
+        lGrid++;
+    }
+
+    const auto lPartitionStartTime = std::chrono::steady_clock::now();
+    if (lGrid > 1)
+    {
+        glm::vec3 lMin(FLT_MAX);
+        glm::vec3 lMax(-FLT_MAX);
+        for (glm::vec3 const& lPosition : aMesh.mPositions)
+        {
+            lMin = glm::min(lMin, lPosition);
+            lMax = glm::max(lMax, lPosition);
+        }
+        const glm::vec3 lScale = float(lGrid) / glm::max(lMax - lMin, glm::vec3(FLT_MIN));
+
+        // Triangles go to the partition of their centroid, counting sort by partition
+        const size_t lCellsCount = size_t(lGrid) * lGrid * lGrid;
+        std::vector<uint32_t> lTriangleCells(lTriangles);
+        std::vector<uint32_t> lCellOffsets(lCellsCount + 1, 0);
+        for (size_t t = 0; t < lTriangles; t++)
+        {
+            const glm::vec3 lCentroid = (aMesh.mPositions[lIndices[t * 3]] + aMesh.mPositions[lIndices[t * 3 + 1]] + aMesh.mPositions[lIndices[t * 3 + 2]]) / 3.0f;
+            const glm::ivec3 lCell = glm::clamp(glm::ivec3((lCentroid - lMin) * lScale), glm::ivec3(0), glm::ivec3(lGrid - 1));
+            lTriangleCells[t] = uint32_t((lCell.z * lGrid + lCell.y) * lGrid + lCell.x);
+            lCellOffsets[lTriangleCells[t] + 1]++;
+        }
+        for (size_t c = 0; c < lCellsCount; c++)
+        {
+            lCellOffsets[c + 1] += lCellOffsets[c];
+        }
+
+        std::vector<uint32_t> lCellTriangles(lTriangles);
+        {
+            std::vector<uint32_t> lCursor(lCellOffsets.begin(), lCellOffsets.end() - 1);
+            for (size_t t = 0; t < lTriangles; t++)
+            {
+                lCellTriangles[lCursor[lTriangleCells[t]]++] = uint32_t(t);
+            }
+        }
+
+        // Vertices with triangles in more than one partition stay put
+        {
+            std::vector<uint32_t> lOwners(lVerticesCount, kInvalidIndex);
+            for (size_t i = 0; i < lIndices.size(); i++)
+            {
+                uint32_t& lOwner = lOwners[lIndices[i]];
+                const uint32_t lCell = lTriangleCells[i / 3];
+                lLocks[lIndices[i]] |= (lOwner != kInvalidIndex && lOwner != lCell) ? kLockShared : 0;
+                lOwner = lCell;
+            }
+        }
+
+        std::vector<uint32_t> lCells;
+        for (size_t c = 0; c < lCellsCount; c++)
+        {
+            if (lCellOffsets[c + 1] > lCellOffsets[c])
+            {
+                lCells.push_back(uint32_t(c));
+            }
+        }
+
+        const double lRatio = double(aParams.mTargetTriangles) / double(lTriangles);
+        std::vector<TPartition> lPartitions(lCells.size());
+        sbx::ParallelFor(lCells.size(), 1, [&](size_t aBegin, size_t aEnd, uint32_t)
+        {
+            std::vector<uint32_t> lVertices;
+            std::vector<glm::vec3> lPositions;
+            std::vector<TQuadric> lPartitionQuadrics;
+            std::vector<uint8_t> lPartitionLocks;
+
+            for (size_t p = aBegin; p < aEnd; p++)
+            {
+                const uint32_t lCell = lCells[p];
+                TPartition& lPartition = lPartitions[p];
+
+                std::vector<uint32_t>& lPartitionIndices = lPartition.mIndices;
+                for (uint32_t i = lCellOffsets[lCell]; i < lCellOffsets[lCell + 1]; i++)
+                {
+                    uint32_t const* lTriangle = &lIndices[size_t(lCellTriangles[i]) * 3];
+                    lPartitionIndices.insert(lPartitionIndices.end(), lTriangle, lTriangle + 3);
+                }
+
+                lVertices = lPartitionIndices;
+                std::sort(lVertices.begin(), lVertices.end());
+                lVertices.erase(std::unique(lVertices.begin(), lVertices.end()), lVertices.end());
+                for (uint32_t& lIndex : lPartitionIndices)
+                {
+                    lIndex = uint32_t(std::lower_bound(lVertices.begin(), lVertices.end(), lIndex) - lVertices.begin());
+                }
+
+                lPositions.resize(lVertices.size());
+                lPartitionQuadrics.resize(lVertices.size());
+                lPartitionLocks.resize(lVertices.size());
+                for (size_t v = 0; v < lVertices.size(); v++)
+                {
+                    lPositions[v] = aMesh.mPositions[lVertices[v]];
+                    lPartitionQuadrics[v] = lQuadrics[lVertices[v]];
+                    lPartitionLocks[v] = lLocks[lVertices[v]];
+                }
+
+                const TRegion lRegion{ lPositions.data(), lPartitionQuadrics.data(), lPartitionLocks.data(), lVertices.size() };
+                const size_t lTarget = size_t(double(lPartitionIndices.size() / 3) * lRatio + 0.5);
+                lPartition.mMaxCost = SimplifyRegion(lRegion, lPartitionIndices, lTarget, lMaxCost);
+
+                for (uint32_t& lIndex : lPartitionIndices)
+                {
+                    lIndex = lVertices[lIndex];
+                }
+
+                // The vertices only this partition has are written right away
+                for (size_t v = 0; v < lVertices.size(); v++)
+                {
+                    if ((lPartitionLocks[v] & kLockShared) == 0)
+                    {
+                        lQuadrics[lVertices[v]] = lPartitionQuadrics[v];
+                    }
+                    else if (lPartitionQuadrics[v].mWeight != lQuadrics[lVertices[v]].mWeight)
+                    {
+                        lPartition.mSharedVertices.push_back(lVertices[v]);
+                        lPartition.mSharedQuadrics.push_back(lPartitionQuadrics[v]);
+                        lPartition.mSharedQuadrics.back() -= lQuadrics[lVertices[v]];
+                    }
+                }
+            }
+        }, lThreads);
+
+        lIndices.clear();
+        for (TPartition const& lPartition : lPartitions)
+        {
+            lIndices.insert(lIndices.end(), lPartition.mIndices.begin(), lPartition.mIndices.end());
+            for (size_t i = 0; i < lPartition.mSharedVertices.size(); i++)
+            {
+                lQuadrics[lPartition.mSharedVertices[i]] += lPartition.mSharedQuadrics[i];
+            }
+            lStats.mError = glm::max(lStats.mError, float(glm::sqrt(lPartition.mMaxCost)));
+        }
+
+        for (uint8_t& lLock : lLocks)
+        {
+            lLock &= ~kLockShared;
+        }
+
+        lStats.mPartitions = uint32_t(lCells.size());
+    }
+    else
+    {
+        lStats.mPartitions = 1;
+    }
+    lStats.mPartitionTriangles = lIndices.size() / 3;
+
+    // The whole mesh, mostly the collapses around the partition borders
+    const auto lBorderStartTime = std::chrono::steady_clock::now();
+    const TRegion lRegion{ aMesh.mPositions.data(), lQuadrics.data(), lLocks.data(), lVerticesCount };
+    const double lBorderCost = SimplifyRegion(lRegion, lIndices, aParams.mTargetTriangles, lMaxCost);
+    lStats.mError = glm::max(lStats.mError, float(glm::sqrt(lBorderCost)));
+
+    TSdfMesh lSimplified;
+    CompactMesh(aMesh, lIndices, lSimplified);
+    std::swap(aOutMesh, lSimplified);
+
+    const auto lEndTime = std::chrono::steady_clock::now();
+    lStats.mVertices = aOutMesh.GetVerticesCount();
+    lStats.mTriangles = aOutMesh.GetTrianglesCount();
+    lStats.mPartitionSeconds = std::chrono::duration<double>(lBorderStartTime - lPartitionStartTime).count();
+    lStats.mBorderSeconds = std::chrono::duration<double>(lEndTime - lBorderStartTime).count();
+    lStats.mSeconds = std::chrono::duration<double>(lEndTime - lStartTime).count();
+    return lStats;
+}
+
+std::vector<TSdfSimplifyStats> CSdfMeshSimplifier::BuildLodChain(TSdfMesh const& aMesh, std::vector<size_t> const& aTargetTriangles,
+                                                                 TSdfSimplifyParams const& aParams, std::vector<TSdfMesh>& aOutLods)
+{
+    std::vector<TSdfSimplifyStats> lStats;
+    aOutLods.resize(aTargetTriangles.size());
+    for (size_t i = 0; i < aTargetTriangles.size(); i++)
+    {
+        SBX_ASSERT(i == 0 || aTargetTriangles[i] <= aTargetTriangles[i - 1], "LOD targets must go down");
+
+        TSdfSimplifyParams lParams = aParams;
+        lParams.mTargetTriangles = aTargetTriangles[i];
+        lStats.push_back(Simplify((i == 0) ? aMesh : aOutLods[i - 1], lParams, aOutLods[i]));
+    }
+    return lStats;
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Quadric error simplification of the extracted meshes and LOD chains
+
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+#include <SDFEditor/Sdf/SdfMesh.h>
+
+struct TSdfSimplifyParams
+{
+    size_t mTargetTriangles{ 0 };
+    float mMaxError{ FLT_MAX };         // largest distance a collapse may move the surface, world units
+    uint32_t mThreads{ 0 };             // 0 uses all the hardware threads
+};
+
+struct TSdfSimplifyStats
+{
+    size_t mVertices{ 0 };
+    size_t mTriangles{ 0 };
+    uint32_t mPartitions{ 0 };
+    uint32_t mThreads{ 0 };
+    size_t mPartitionTriangles{ 0 };    // left by the parallel pass, before the border one
+    float mError{ 0.0f };               // of the worst collapse, world units
+    double mPartitionSeconds{ 0.0 };
+    double mBorderSeconds{ 0.0 };
+    double mSeconds{ 0.0 };
+};
+
+// Edge collapses ordered by the quadric error of the planes of the original
+// triangles. Vertices collapse into one of their neighbours, so the output
+// keeps a subset of the input vertices and their normals.
+// The mesh is split in a grid of spatial partitions of about
+// kPartitionTriangles, simplified in parallel with the vertices they share
+// locked. A last pass over the whole mesh unlocks them and reaches the
+// target. The partitions only depend on the mesh, not on the threads count,
+// and neither does the output.
+// Vertices on open borders, where the mesh meets the LUT bounds, never move.
+class CSdfMeshSimplifier
+{
+public:
+    static constexpr size_t kPartitionTriangles = 65536;
+
+    // Each LOD of a chain keeps this ratio of the triangles of the previous one
+    static constexpr float kDefaultLodRatio = 0.25f;
+
+    TSdfSimplifyStats Simplify(TSdfMesh const& aMesh, TSdfSimplifyParams const& aParams, TSdfMesh& aOutMesh);
+
+    // aOutLods[i] has about aTargetTriangles[i] triangles, each one simplified
+    // from the previous, the first from aMesh. The targets must go down
+    std::vector<TSdfSimplifyStats> BuildLodChain(TSdfMesh const& aMesh, std::vector<size_t> const& aTargetTriangles,
+                                                 TSdfSimplifyParams const& aParams, std::vector<TSdfMesh>& aOutLods);
+};
@@ -0,0 +1,107 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfPicking.h"
+#include "SdfBounds.h"
+#include "SdfEvaluator.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+    // Finer than the hit limit of the renderers, the hit point decides the stroke
+    constexpr float kHitLimit = 0.001f;
+    constexpr uint32_t kMaxSteps = 512;
+
+    bool IsUnbounded(stroke_t const& aStroke)
+    {
+        return (aStroke.id.y & EStrokeOp::OpsMaskMode) == EStrokeOp::OpIntersect;
+    }
+}
+
+TSdfPickResult CSdfPicker::Pick(CStrokeBoundsCache const& aBounds, CStrokeBvh const& aBvh, glm::vec3 const& aOrigin, glm::vec3 const& aDirection)
+{
+    TSdfPickResult lResult;
+
+    aBvh.RaycastField(aOrigin, aDirection, mHits);
+    if (mHits.empty())
+    {
+        return lResult;
+    }
+
+    // The surface is only inside the field boxes of the unions and
+    // subtractions, a point outside a box is not affected by its stroke when
+    // marching outside the shapes. Intersections carve everywhere
+    mHits.erase(std::remove_if(mHits.begin(), mHits.end(), [&aBounds](CStrokeBvh::TRayHit const& aHit) { return IsUnbounded(aBounds.GetStroke(aHit.mStroke)); }), mHits.end());
+    std::sort(mHits.begin(), mHits.end(), [](CStrokeBvh::TRayHit const& aA, CStrokeBvh::TRayHit const& aB) { return aA.mEnter < aB.mEnter; });
+    std::vector<uint32_t> const& lUnbounded = aBvh.GetUnboundedStrokes();
+
+    mActive.clear();
+    size_t lNextHit = 0;
+    float t = 0.0f;
+    float lActiveEnd = -1.0f;       // the active strokes stay the same before it
+    float lNextEnter = 0.0f;
+    while (lResult.mSteps < kMaxSteps)
+    {
+        if (t >= lActiveEnd)
+        {
+            // Boxes that cover t, the hits are sorted by entry and t only grows
+            mActive.erase(std::remove_if(mActive.begin(), mActive.end(), [t](CStrokeBvh::TRayHit const& aHit) { return aHit.mExit < t; }), mActive.end());
+            for (; lNextHit < mHits.size() && mHits[lNextHit].mEnter <= t; lNextHit++)
+            {
+                if (mHits[lNextHit].mExit >= t)
+                {
+                    mActive.push_back(mHits[lNextHit]);
+                }
+            }
+            lNextEnter = (lNextHit < mHits.size()) ? mHits[lNextHit].mEnter : FLT_MAX;
+
+            if (mActive.empty())
+            {
+                // Gap between the boxes, no surface in it
+                if (lNextHit == mHits.size())
+                {
+                    break;
+                }
+                t = lNextEnter;
+                continue;
+            }
+
+            // Their strokes in CSG order
+            lActiveEnd = lNextEnter;
+            mSubset.assign(lUnbounded.begin(), lUnbounded.end());
+            for (CStrokeBvh::TRayHit const& lHit : mActive)
+            {
+                lActiveEnd = glm::min(lActiveEnd, lHit.mExit);
+                mSubset.push_back(uint32_t(lHit.mStroke));
+            }
+            std::sort(mSubset.begin(), mSubset.end());
+            mSubset.erase(std::unique(mSubset.begin(), mSubset.end()), mSubset.end());
+            mStrokes.resize(mSubset.size());
+            for (size_t i = 0; i < mSubset.size(); i++)
+            {
+                mStrokes[i] = aBounds.GetStroke(mSubset[i]);
+            }
+        }
+
+        const glm::vec3 lPosition = aOrigin + aDirection * t;
+        int32_t lStroke = -1;
+        const float lDistance = Sdf::DistToScene(lPosition, mStrokes.data(), mStrokes.size(), lStroke);
+        lResult.mSteps++;
+        lResult.mStrokes += uint32_t(mStrokes.size());
+
+        // Negative when the ray starts inside
+        if (lDistance < kHitLimit)
+        {
+            lResult.mStroke = (lStroke >= 0) ? int32_t(mSubset[lStroke]) : -1;
+            lResult.mDistance = t;
+            lResult.mPosition = lPosition;
+            return lResult;
+        }
+
+        // The strokes entering later are not in the distance, stop at them
+        t = glm::min(t + lDistance, lNextEnter);
+    }
+
+    return lResult;
+}
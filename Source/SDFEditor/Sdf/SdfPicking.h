@@ -0,0 +1,40 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Stroke picking on the CSG surface
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDFEditor/Tool/StrokeInfo.h>
+#include <SDFEditor/Sdf/SdfStrokeBvh.h>
+
+class CStrokeBoundsCache;
+
+struct TSdfPickResult
+{
+    int32_t mStroke{ -1 };          // -1 when the ray misses the surface
+    float mDistance{ 0.0f };        // along the ray
+    glm::vec3 mPosition{ 0.0f };
+    uint32_t mSteps{ 0 };           // distance queries
+    uint32_t mStrokes{ 0 };         // evaluated by all the queries
+};
+
+// Sphere traces the surface of the strokes along a ray with the CPU evaluator
+// and picks the stroke that dominates the distance at the hit, so strokes
+// carved away or buried inside others are not picked through the surface.
+// Each step only evaluates the strokes whose field boxes along the ray cover
+// it, plus the intersections, and never steps past the entry of another box.
+// The march jumps over the gaps between the boxes.
+class CSdfPicker
+{
+public:
+    // aBvh must be updated with aBounds
+    TSdfPickResult Pick(CStrokeBoundsCache const& aBounds, CStrokeBvh const& aBvh, glm::vec3 const& aOrigin, glm::vec3 const& aDirection);
+
+private:
+    std::vector<CStrokeBvh::TRayHit> mHits;
+    std::vector<CStrokeBvh::TRayHit> mActive;
+    std::vector<uint32_t> mSubset;
+    std::vector<stroke_t> mStrokes;
+};
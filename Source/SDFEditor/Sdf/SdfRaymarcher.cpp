@@ -0,0 +1,607 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfRaymarcher.h"
+#include "SdfEvaluator.h"
+#include "SdfAtlasBaker.h"
+
+#include <sbx/Core/Parallel.h>
+#include <sbx/Texture/Texture.h>
+
+#include <chrono>
+
+namespace
+{
+    // RaymarchStrokes
+    constexpr int32_t kMaxIterations = 70;
+    constexpr float kHitLimit = 0.02f;
+
+    // Rays that run away overflow in a few steps, the shader ends them on NaN but the
+    // SIMD min/max of the evaluator don't keep NaNs, so they end here as misses
+    constexpr float kMaxRayDistance = 10000.0f;
+
+    // estimateNormal
+    constexpr float kNormalEps = 0.001f;
+
+    // CalcAO
+    constexpr int32_t kAOSamples = 5;
+
+    // RaymarchAtlas, limitSubVoxel
+    constexpr int32_t kAtlasMaxIterations = 300;
+    constexpr float kAtlasHitLimit = 0.02f;
+
+    const glm::vec3 kLightDir = glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f));
+    const glm::vec3 kLightDir2 = glm::normalize(glm::vec3(-1.0f, -1.0f, 0.0f));
+
+    // Per worker buffers, reused between tiles
+    struct TTileScratch
+    {
+        std::vector<glm::vec3> mPos;
+        std::vector<glm::vec3> mDir;
+        std::vector<float> mDist;
+        std::vector<uint32_t> mActive;
+        std::vector<glm::vec3> mQueries;
+        std::vector<float> mQueryDists;
+        std::vector<glm::vec3> mNormals;
+        std::vector<glm::vec3> mColors;
+    };
+
+    glm::vec3 LinearToSRGB(glm::vec3 aRGB)
+    {
+        aRGB = glm::clamp(aRGB, 0.0f, 1.0f);
+        return glm::mix(glm::pow(aRGB, glm::vec3(1.0f / 2.4f)) * 1.055f - 0.055f, aRGB * 12.92f, glm::vec3(glm::lessThan(aRGB, glm::vec3(0.0031308f))));
+    }
+
+    uint8_t ToUnorm8(float aValue)
+    {
+        // NaN goes to 0
+        aValue = (aValue > 0.0f) ? glm::min(aValue, 1.0f) : 0.0f;
+        return uint8_t(aValue * 255.0f + 0.5f);
+    }
+
+    // ApplyLight
+    glm::vec3 ApplyLight(glm::vec3 const& aRayDir, glm::vec3 const& aNormal, glm::vec3 const& aAlbedo, glm::vec3 const& aLight, glm::vec3 const& aLightColor, float aRough)
+    {
+        float nl = glm::dot(aNormal, aLight);
+        nl = (nl + 0.7f) / 1.7f; // cover more area
+        nl = glm::clamp(nl, 0.01f, 1.0f);
+        const glm::vec3 f0(0.1f);
+
+        const glm::vec3 haf = glm::normalize(aLight - aRayDir);
+        const float nh = glm::clamp(glm::dot(aNormal, haf), 0.0f, 1.0f);
+        const float nv = glm::clamp(glm::dot(aNormal, -aRayDir), 0.0f, 1.0f);
+        const float lh = glm::clamp(glm::dot(aLight, haf), 0.0f, 1.0f);
+        const float a = aRough * aRough;
+        const float a2 = a * a;
+        const float dnm = nh * nh * (a2 - 1.0f) + 1.0f;
+        const float D = a2 / (3.14159f * dnm * dnm);
+        const float k = (aRough + 1.0f) * (aRough + 1.0f) / 8.0f; //hotness reducing
+        const float G = (1.0f / (nl * (1.0f - k) + k)) * (1.0f / (nv * (1.0f - k) + k));
+        const glm::vec3 F = f0 + (1.0f - f0) * glm::exp2((-5.55473f * lh - 6.98316f) * lh);
+        const glm::vec3 spec = nl * D * F * G;
+        glm::vec3 col = aLightColor * nl * (spec + aAlbedo * (1.0f - f0));
+
+        const float bnc = glm::clamp(glm::dot(aNormal, glm::normalize(glm::vec3(-aLight.x, 5.0f, -aLight.z))) * 0.5f + 0.28f, 0.0f, 1.0f);
+        col += aLightColor * aAlbedo * bnc * 0.1f;
+        return col;
+    }
+
+    // End of CalcAO from the kAOSamples distances
+    float AOFromDistances(const float* aDists)
+    {
+        float lOcc = 0.0f;
+        float lSca = 1.0f;
+        for (int32_t s = 0; s < kAOSamples; s++)
+        {
+            const float lHr = 0.01f + 0.23f * float(s) / 4.0f;
+            lOcc += -(aDists[s] - lHr) * lSca;
+            lSca *= 0.95f;
+        }
+        return glm::clamp(1.0f - 1.6f * lOcc, 0.0f, 1.0f);
+    }
+
+    // Splits the image in tiles and generates the rays of FullScreenTrinagle.vert.glsl for
+    // each one, aShadeTile(scratch, rays count, tile stats) writes the linear colors of
+    // the rays over the background, then the tile goes to the image as the end of main()
+    template <typename TShadeTile>
+    TSdfRenderStats RenderTiles(TSdfRenderParams const& aParams, glm::vec3 const& aBackground, glm::mat4 const& aViewMatrix, glm::mat4 const& aProjectionMatrix,
+                                TShadeTile const& aShadeTile, sbx::TTexture& aOutImage)
+    {
+        const auto lStartTime = std::chrono::steady_clock::now();
+
+        const int32_t lWidth = glm::max(aParams.mWidth, 1);
+        const int32_t lHeight = glm::max(aParams.mHeight, 1);
+        const int32_t lTileSize = glm::max(aParams.mTileSize, 1);
+        const glm::ivec2 lTiles((lWidth + lTileSize - 1) / lTileSize, (lHeight + lTileSize - 1) / lTileSize);
+        aOutImage.Init(lWidth, lHeight, 1, sbx::ETextureFormat::RGBA8);
+        sbx::TColor8U* lPixels = aOutImage.AsRGBA8Buffer();
+
+        TSdfRenderStats lStats;
+        lStats.mThreads = (aParams.mThreads > 0) ? aParams.mThreads : sbx::GetHardwareThreadsCount();
+        lStats.mTiles.resize(size_t(lTiles.x) * size_t(lTiles.y));
+        std::vector<TTileScratch> lScratches(lStats.mThreads);
+
+        const glm::mat4 lInvViewProj = glm::inverse(aProjectionMatrix * aViewMatrix);
+
+        auto lRenderTile = [&](size_t aTile, uint32_t aWorker)
+        {
+            const auto lTileStart = std::chrono::steady_clock::now();
+            TSdfRenderTileStats& lTileStats = lStats.mTiles[aTile];
+            TTileScratch& lScratch = lScratches[aWorker];
+
+            lTileStats.mMin = glm::ivec2(int32_t(aTile % size_t(lTiles.x)), int32_t(aTile / size_t(lTiles.x))) * lTileSize;
+            lTileStats.mMax = glm::min(lTileStats.mMin + lTileSize, glm::ivec2(lWidth, lHeight));
+            lTileStats.mWorker = aWorker;
+            const glm::ivec2 lTileExtent = lTileStats.mMax - lTileStats.mMin;
+            const uint32_t lRaysCount = uint32_t(lTileExtent.x * lTileExtent.y);
+
+            // uv (0, 0) at the bottom left
+            lScratch.mPos.resize(lRaysCount);
+            lScratch.mDir.resize(lRaysCount);
+            lScratch.mDist.resize(lRaysCount);
+            for (uint32_t i = 0; i < lRaysCount; i++)
+            {
+                const glm::ivec2 lPixel = lTileStats.mMin + glm::ivec2(int32_t(i) % lTileExtent.x, int32_t(i) / lTileExtent.x);
+                const glm::vec2 lClipPos(((float(lPixel.x) + 0.5f) / float(lWidth)) * 2.0f - 1.0f, 1.0f - ((float(lPixel.y) + 0.5f) / float(lHeight)) * 2.0f);
+                const glm::vec4 lNear = lInvViewProj * glm::vec4(lClipPos, 0.0f, 1.0f);
+                const glm::vec4 lFar = lInvViewProj * glm::vec4(lClipPos, 1.0f, 1.0f);
+                lScratch.mPos[i] = glm::vec3(lNear) / lNear.w;
+                lScratch.mDir[i] = glm::normalize(glm::vec3(lFar) / lFar.w - lScratch.mPos[i]);
+            }
+
+            lScratch.mColors.assign(lRaysCount, aBackground);
+            aShadeTile(lScratch, lRaysCount, lTileStats);
+
+            for (uint32_t i = 0; i < lRaysCount; i++)
+            {
+                const glm::ivec2 lPixel = lTileStats.mMin + glm::ivec2(int32_t(i) % lTileExtent.x, int32_t(i) / lTileExtent.x);
+                glm::vec3 lColor = LinearToSRGB(lScratch.mColors[i]);
+
+                if (aParams.mVignette)
+                {
+                    const glm::vec2 lUV((float(lPixel.x) + 0.5f) / float(lWidth), 1.0f - (float(lPixel.y) + 0.5f) / float(lHeight));
+                    const glm::vec2 lUV2 = lUV * (glm::vec2(1.0f) - glm::vec2(lUV.y, lUV.x));
+                    float lVig = lUV2.x * lUV2.y * 13.0f;
+                    lVig = glm::pow(lVig, 0.35f);
+                    lVig = glm::mix(0.35f, 1.0f, lVig);
+                    lVig = glm::smoothstep(0.0f, 0.75f, lVig);
+                    lColor *= lVig;
+                }
+
+                sbx::TColor8U& lOut = lPixels[size_t(lPixel.y) * size_t(lWidth) + size_t(lPixel.x)];
+                lOut.r = ToUnorm8(lColor.r);
+                lOut.g = ToUnorm8(lColor.g);
+                lOut.b = ToUnorm8(lColor.b);
+                lOut.a = 255;
+            }
+
+            lTileStats.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lTileStart).count();
+        };
+
+        lStats.mStolenTiles = sbx::ParallelForEachStealing(lStats.mTiles.size(), lRenderTile, lStats.mThreads);
+
+        for (TSdfRenderTileStats const& lTile : lStats.mTiles)
+        {
+            lStats.mEvaluations += lTile.mEvaluations;
+        }
+        lStats.mRays = uint64_t(lWidth) * uint64_t(lHeight);
+        lStats.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStartTime).count();
+        lStats.mRaysPerSecond = (lStats.mSeconds > 0.0) ? double(lStats.mRays) / lStats.mSeconds : 0.0;
+        return lStats;
+    }
+
+    // rayboxintersect, distances = (tmin, tmax)
+    bool RayBoxIntersect(glm::vec3 const& aRayPos, glm::vec3 const& aRayDir, glm::vec3 const& aBoxMin, glm::vec3 const& aBoxMax, glm::vec2& aOutDistances)
+    {
+        const glm::vec3 t1 = (aBoxMin - aRayPos) / aRayDir;
+        const glm::vec3 t2 = (aBoxMax - aRayPos) / aRayDir;
+        const glm::vec3 lMin = glm::min(t1, t2);
+        const glm::vec3 lMax = glm::max(t1, t2);
+        const float tmin = glm::max(glm::max(lMin.x, lMin.y), lMin.z);
+        const float tmax = glm::min(glm::min(lMax.x, lMax.y), lMax.z);
+        aOutDistances = glm::vec2(tmin, tmax);
+        return (tmax >= 0.0f) && (tmin <= tmax);
+    }
+
+    // Lookups of SDFCommon.h.glsl over a baked LUT and the compact bricks, linear
+    // filtering and clamp to edge like the renderer textures
+    class CAtlasVolume
+    {
+    public:
+        CAtlasVolume(sbx::TTexture const& aLut, TSdfBrickAtlas const& aAtlas, TSdfBakeParams const& aParams)
+            : mLut(aLut.AsRGBA8Buffer())
+            , mAtlas(aAtlas)
+            , mLutSize(aParams.mLutSize)
+            , mVoxelSide(aParams.mLutVoxelSide)
+            , mInvVoxelSide(1.0f / aParams.mLutVoxelSide)
+        {
+        }
+
+        float GetVoxelSide() const { return mVoxelSide; }
+        float GetInvVoxelSide() const { return mInvVoxelSide; }
+        float GetExtent() const { return mVoxelSide * float(mLutSize); }
+
+        // distToSceneLut
+        float DistToSceneLut(glm::vec3 const& aPos) const
+        {
+            const glm::vec3 lCoord = (aPos * mInvVoxelSide) + (0.5f * float(mLutSize)) - 0.5f;
+            const glm::vec3 lBase = glm::floor(lCoord);
+            const glm::vec3 lFrac = lCoord - lBase;
+            const glm::ivec3 lBase0 = glm::clamp(glm::ivec3(lBase), 0, mLutSize - 1);
+            const glm::ivec3 lBase1 = glm::clamp(glm::ivec3(lBase) + 1, 0, mLutSize - 1);
+
+            auto lFetch = [&](int32_t x, int32_t y, int32_t z)
+            {
+                return float(mLut[(size_t(z) * size_t(mLutSize) + size_t(y)) * size_t(mLutSize) + size_t(x)].a);
+            };
+
+            const float lDist = Trilinear(lFrac,
+                lFetch(lBase0.x, lBase0.y, lBase0.z), lFetch(lBase1.x, lBase0.y, lBase0.z), lFetch(lBase0.x, lBase1.y, lBase0.z), lFetch(lBase1.x, lBase1.y, lBase0.z),
+                lFetch(lBase0.x, lBase0.y, lBase1.z), lFetch(lBase1.x, lBase0.y, lBase1.z), lFetch(lBase0.x, lBase1.y, lBase1.z), lFetch(lBase1.x, lBase1.y, lBase1.z)) / 255.0f;
+            return (lDist * 2.0f - 1.0f) * float(mLutSize) * mVoxelSide;
+        }
+
+        // Atlas slot of a LUT voxel, false out of the surface band. texelFetch out of the LUT
+        // is undefined, here it is out of the band
+        bool FetchSlot(glm::ivec3 const& aLutCoord, uint32_t& aOutSlot) const
+        {
+            if (glm::any(glm::lessThan(aLutCoord, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(aLutCoord, glm::ivec3(mLutSize))))
+            {
+                return false;
+            }
+
+            sbx::TColor8U const& lTexel = mLut[(size_t(aLutCoord.z) * size_t(mLutSize) + size_t(aLutCoord.y)) * size_t(mLutSize) + size_t(aLutCoord.x)];
+
+            // ivec3(rgb + 0.5) == ivec3(1)
+            if (lTexel.r >= 128 && lTexel.g >= 128 && lTexel.b >= 128)
+            {
+                return false;
+            }
+
+            aOutSlot = Sdf::CoordToIndex(glm::ivec3(lTexel.r, lTexel.g, lTexel.b));
+            return aOutSlot < mAtlas.GetBricksCount();
+        }
+
+        // sampleAtlasDist, aOffset in atlas voxels inside the brick, [0.5, 7.5]
+        float SampleAtlasDist(uint32_t aSlot, glm::vec3 const& aOffset) const
+        {
+            const int32_t lBrickSize = mAtlas.mBrickSize;
+            const glm::vec3 lCoord = aOffset - 0.5f;
+            const glm::vec3 lBase = glm::floor(lCoord);
+            const glm::vec3 lFrac = lCoord - lBase;
+            const glm::ivec3 lBase0 = glm::clamp(glm::ivec3(lBase), 0, lBrickSize - 1);
+            const glm::ivec3 lBase1 = glm::min(lBase0 + 1, lBrickSize - 1);
+            uint8_t const* lBrick = mAtlas.GetBrick(aSlot);
+
+            auto lFetch = [&](int32_t x, int32_t y, int32_t z)
+            {
+                return float(lBrick[(size_t(z) * size_t(lBrickSize) + size_t(y)) * size_t(lBrickSize) + size_t(x)]);
+            };
+
+            const float lDist = Trilinear(lFrac,
+                lFetch(lBase0.x, lBase0.y, lBase0.z), lFetch(lBase1.x, lBase0.y, lBase0.z), lFetch(lBase0.x, lBase1.y, lBase0.z), lFetch(lBase1.x, lBase1.y, lBase0.z),
+                lFetch(lBase0.x, lBase0.y, lBase1.z), lFetch(lBase1.x, lBase0.y, lBase1.z), lFetch(lBase0.x, lBase1.y, lBase1.z), lFetch(lBase1.x, lBase1.y, lBase1.z)) / 255.0f;
+            return (lDist * 2.0f - 1.0f) * mVoxelSide;
+        }
+
+        // Brick offset of a world position, fract(pos * uVoxelSide.y) * 8 clamped to the voxel centers
+        glm::vec3 GetBrickOffset(glm::vec3 const& aPos) const
+        {
+            const float lBrickSize = float(mAtlas.mBrickSize);
+            return glm::clamp(glm::fract(aPos * mInvVoxelSide) * lBrickSize, 0.5f, lBrickSize - 0.5f);
+        }
+
+        // WorldToLutCoord
+        glm::ivec3 WorldToLutCoord(glm::vec3 const& aPos) const
+        {
+            return glm::ivec3((aPos * mInvVoxelSide) + (0.5f * float(mLutSize)));
+        }
+
+        // distToSceneAtlas
+        float DistToSceneAtlas(glm::vec3 const& aPos) const
+        {
+            uint32_t lSlot = 0;
+            if (FetchSlot(WorldToLutCoord(aPos), lSlot))
+            {
+                return SampleAtlasDist(lSlot, GetBrickOffset(aPos));
+            }
+
+            return DistToSceneLut(aPos);
+        }
+
+    private:
+        static float Trilinear(glm::vec3 const& aFrac, float a000, float a100, float a010, float a110, float a001, float a101, float a011, float a111)
+        {
+            const float lY0 = glm::mix(glm::mix(a000, a100, aFrac.x), glm::mix(a010, a110, aFrac.x), aFrac.y);
+            const float lY1 = glm::mix(glm::mix(a001, a101, aFrac.x), glm::mix(a011, a111, aFrac.x), aFrac.y);
+            return glm::mix(lY0, lY1, aFrac.z);
+        }
+
+        sbx::TColor8U const* mLut;
+        TSdfBrickAtlas const& mAtlas;
+        int32_t mLutSize;
+        float mVoxelSide;
+        float mInvVoxelSide;
+    };
+}
+
+TSdfRenderStats CSdfRaymarcher::RenderStrokes(CSdfEvaluator const& aEvaluator, TGlobalMaterialBufferData const& aMaterial,
+                                              glm::mat4 const& aViewMatrix, glm::mat4 const& aProjectionMatrix,
+                                              TSdfRenderParams const& aParams, sbx::TTexture& aOutImage) const
+{
+    auto lShadeTile = [&](TTileScratch& aScratch, uint32_t aRaysCount, TSdfRenderTileStats& aTileStats)
+    {
+        aEvaluator.Evaluate(aScratch.mPos.data(), aRaysCount, aScratch.mDist.data());
+        aTileStats.mEvaluations += aRaysCount;
+
+        aScratch.mActive.clear();
+        for (uint32_t i = 0; i < aRaysCount; i++)
+        {
+            if (aScratch.mDist[i] > kHitLimit)
+            {
+                aScratch.mActive.push_back(i);
+            }
+        }
+
+        // Marching, one batch per step with the rays still out of the surface
+        for (int32_t lIter = 0; lIter < kMaxIterations && !aScratch.mActive.empty(); lIter++)
+        {
+            const size_t lActiveCount = aScratch.mActive.size();
+            aScratch.mQueries.resize(lActiveCount);
+            aScratch.mQueryDists.resize(lActiveCount);
+            for (size_t j = 0; j < lActiveCount; j++)
+            {
+                const uint32_t i = aScratch.mActive[j];
+                aScratch.mPos[i] += aScratch.mDist[i] * aScratch.mDir[i];
+                aScratch.mQueries[j] = aScratch.mPos[i];
+            }
+
+            aEvaluator.Evaluate(aScratch.mQueries.data(), lActiveCount, aScratch.mQueryDists.data());
+            aTileStats.mEvaluations += lActiveCount;
+
+            size_t lStillActive = 0;
+            for (size_t j = 0; j < lActiveCount; j++)
+            {
+                const uint32_t i = aScratch.mActive[j];
+                aScratch.mDist[i] = aScratch.mQueryDists[j];
+                if (aScratch.mDist[i] > kHitLimit && glm::dot(aScratch.mPos[i], aScratch.mPos[i]) < kMaxRayDistance * kMaxRayDistance)
+                {
+                    aScratch.mActive[lStillActive++] = i;
+                }
+            }
+            aScratch.mActive.resize(lStillActive);
+        }
+
+        // Hits, estimateNormal then CalcAO as two more batches
+        aScratch.mActive.clear();
+        for (uint32_t i = 0; i < aRaysCount; i++)
+        {
+            if (aScratch.mDist[i] <= kHitLimit)
+            {
+                aScratch.mActive.push_back(i);
+            }
+        }
+
+        const size_t lHitsCount = aScratch.mActive.size();
+        aTileStats.mHits = uint32_t(lHitsCount);
+
+        const glm::vec3 lEpsX(kNormalEps, 0.0f, 0.0f);
+        const glm::vec3 lEpsY(0.0f, kNormalEps, 0.0f);
+        const glm::vec3 lEpsZ(0.0f, 0.0f, kNormalEps);
+        aScratch.mQueries.resize(lHitsCount * 6);
+        aScratch.mQueryDists.resize(lHitsCount * 6);
+        for (size_t j = 0; j < lHitsCount; j++)
+        {
+            glm::vec3 const& lPos = aScratch.mPos[aScratch.mActive[j]];
+            glm::vec3* lQueries = aScratch.mQueries.data() + j * 6;
+            lQueries[0] = lPos + lEpsX;
+            lQueries[1] = lPos - lEpsX;
+            lQueries[2] = lPos + lEpsY;
+            lQueries[3] = lPos - lEpsY;
+            lQueries[4] = lPos + lEpsZ;
+            lQueries[5] = lPos - lEpsZ;
+        }
+        aEvaluator.Evaluate(aScratch.mQueries.data(), lHitsCount * 6, aScratch.mQueryDists.data());
+
+        aScratch.mNormals.resize(lHitsCount);
+        for (size_t j = 0; j < lHitsCount; j++)
+        {
+            const float* lDists = aScratch.mQueryDists.data() + j * 6;
+            aScratch.mNormals[j] = glm::normalize(glm::vec3(lDists[0] - lDists[1], lDists[2] - lDists[3], lDists[4] - lDists[5]));
+        }
+
+        aScratch.mQueries.resize(lHitsCount * kAOSamples);
+        aScratch.mQueryDists.resize(lHitsCount * kAOSamples);
+        for (size_t j = 0; j < lHitsCount; j++)
+        {
+            glm::vec3 const& lPos = aScratch.mPos[aScratch.mActive[j]];
+            for (int32_t s = 0; s < kAOSamples; s++)
+            {
+                const float lHr = 0.01f + 0.23f * float(s) / 4.0f;
+                aScratch.mQueries[j * kAOSamples + s] = aScratch.mNormals[j] * lHr + lPos;
+            }
+        }
+        aEvaluator.Evaluate(aScratch.mQueries.data(), lHitsCount * kAOSamples, aScratch.mQueryDists.data());
+        aTileStats.mEvaluations += lHitsCount * (6 + kAOSamples);
+
+        for (size_t j = 0; j < lHitsCount; j++)
+        {
+            const uint32_t i = aScratch.mActive[j];
+            const float lAO = AOFromDistances(aScratch.mQueryDists.data() + j * kAOSamples);
+            aScratch.mColors[i] = ApplyMaterial(aMaterial, aScratch.mPos[i], aScratch.mDir[i], aScratch.mNormals[j], lAO);
+        }
+    };
+
+    return RenderTiles(aParams, glm::vec3(aMaterial.backgroundColor), aViewMatrix, aProjectionMatrix, lShadeTile, aOutImage);
+}
+
+TSdfRenderStats CSdfRaymarcher::RenderAtlas(sbx::TTexture const& aLut, TSdfBrickAtlas const& aAtlas, TSdfBakeParams const& aBakeParams, TGlobalMaterialBufferData const& aMaterial,
+                                            glm::mat4 const& aViewMatrix, glm::mat4 const& aProjectionMatrix,
+                                            TSdfRenderParams const& aParams, sbx::TTexture& aOutImage) const
+{
+    const CAtlasVolume lVolume(aLut, aAtlas, aBakeParams);
+    const float lVoxelSide = lVolume.GetVoxelSide();
+    const float lInvVoxelSide = lVolume.GetInvVoxelSide();
+    const glm::vec3 lVolumeMax(lVolume.GetExtent() * 0.5f);
+
+    // Each ray takes its own path through the bricks, no lockstep batches, the lookups are cheap
+    auto lShadeTile = [&](TTileScratch& aScratch, uint32_t aRaysCount, TSdfRenderTileStats& aTileStats)
+    {
+        for (uint32_t i = 0; i < aRaysCount; i++)
+        {
+            glm::vec3 lPos = aScratch.mPos[i];
+            glm::vec3 const& lDir = aScratch.mDir[i];
+
+            glm::vec2 lBoxDistance;
+            if (!RayBoxIntersect(lPos, lDir, -lVolumeMax, lVolumeMax, lBoxDistance))
+            {
+                continue;
+            }
+
+            const glm::vec3 lEnterPoint = lPos + lDir * glm::max(lBoxDistance.x, 0.0f);
+            const float lExitDist = lBoxDistance.y - glm::max(lBoxDistance.x, 0.0f);
+            lPos = lEnterPoint;
+
+            float lTotalDist = 0.0f;
+            float lFinalDist = lVolume.DistToSceneLut(lPos);
+            bool lReenter = false;
+            aTileStats.mEvaluations++;
+
+            for (int32_t lIter = 0; lIter < kAtlasMaxIterations && ((lFinalDist > lVoxelSide || lReenter) && lTotalDist < lExitDist); lIter++)
+            {
+                lReenter = false;
+                lPos += lFinalDist * lDir;
+                lTotalDist = glm::distance(lPos, lEnterPoint);
+                lFinalDist = lVolume.DistToSceneLut(lPos);
+                aTileStats.mEvaluations++;
+
+                if (lFinalDist > lVoxelSide || lTotalDist >= lExitDist)
+                {
+                    continue;
+                }
+
+                // Close to the surface, four samples along the ray inside the brick of this LUT voxel
+                const glm::vec3 lBrickMin = glm::floor(lPos * lInvVoxelSide) * lVoxelSide;
+                glm::vec2 lBrickDistance;
+                if (!RayBoxIntersect(lPos, lDir, lBrickMin, lBrickMin + lVoxelSide, lBrickDistance))
+                {
+                    continue;
+                }
+
+                uint32_t lSlot = 0;
+                float lMaxDist = lBrickDistance.y;
+                if (lVolume.FetchSlot(glm::clamp(lVolume.WorldToLutCoord(lPos), glm::ivec3(0), glm::ivec3(aBakeParams.mLutSize - 1)), lSlot))
+                {
+                    const float lSampleT[4] = { lBrickDistance.x + 0.0001f, 0.0f, lBrickDistance.y * 0.15f, lBrickDistance.y * 0.25f };
+                    lMaxDist = lSampleT[3];
+
+                    glm::vec2 lMinDist(1.0f, 0.0f);
+                    for (float lT : lSampleT)
+                    {
+                        const float lDist = lVolume.SampleAtlasDist(lSlot, lVolume.GetBrickOffset(lPos + lT * lDir));
+                        lMinDist = (lDist < lMinDist.x) ? glm::vec2(lDist, lT) : lMinDist;
+                    }
+                    aTileStats.mEvaluations += 4;
+
+                    if (lMinDist.x < kAtlasHitLimit)
+                    {
+                        if (lMinDist.x > -kAtlasHitLimit)
+                        {
+                            lPos += lMinDist.y * lDir;
+                            lFinalDist = lMinDist.x;
+                            lTotalDist = glm::distance(lPos, lEnterPoint);
+                        }
+                        else
+                        {
+                            // Too deep, the hit stays at the current position
+                            lFinalDist = 0.0f;
+                        }
+                        continue;
+                    }
+                }
+
+                // Too far away, advance through the brick and keep marching
+                lReenter = true;
+                lFinalDist = lMaxDist + 0.0001f;
+            }
+
+            if (lFinalDist >= kAtlasHitLimit)
+            {
+                continue;
+            }
+
+            // estimateNormalAtlas and CalcAOAtlas
+            const float lOffset = lVoxelSide * 0.5f;
+            const glm::vec3 lNormal = glm::normalize(glm::vec3(
+                lVolume.DistToSceneAtlas(lPos + glm::vec3(lOffset, 0.0f, 0.0f)) - lVolume.DistToSceneAtlas(lPos - glm::vec3(lOffset, 0.0f, 0.0f)),
+                lVolume.DistToSceneAtlas(lPos + glm::vec3(0.0f, lOffset, 0.0f)) - lVolume.DistToSceneAtlas(lPos - glm::vec3(0.0f, lOffset, 0.0f)),
+                lVolume.DistToSceneAtlas(lPos + glm::vec3(0.0f, 0.0f, lOffset)) - lVolume.DistToSceneAtlas(lPos - glm::vec3(0.0f, 0.0f, lOffset))));
+
+            float lAODists[kAOSamples];
+            const glm::vec3 lAOPos = lPos + lNormal * 0.01f;
+            for (int32_t s = 0; s < kAOSamples; s++)
+            {
+                lAODists[s] = lVolume.DistToSceneAtlas(lNormal * (0.01f + 0.23f * float(s) / 4.0f) + lAOPos);
+            }
+            aTileStats.mEvaluations += 6 + kAOSamples;
+            aTileStats.mHits++;
+
+            aScratch.mColors[i] = ApplyMaterial(aMaterial, lPos, lDir, lNormal, AOFromDistances(lAODists));
+        }
+    };
+
+    return RenderTiles(aParams, glm::vec3(aMaterial.backgroundColor), aViewMatrix, aProjectionMatrix, lShadeTile, aOutImage);
+}
+
+glm::vec3 CSdfRaymarcher::ApplyMaterial(TGlobalMaterialBufferData const& aMaterial, glm::vec3 const& aPos, glm::vec3 const& aRayDir, glm::vec3 const& aNormal, float aAO) const
+{
+    const float lDotCam = glm::pow(1.0f - glm::abs(glm::dot(aRayDir, aNormal)), aMaterial.pbr.z);
+
+    // BoxMap(uRoughnessMap, pos, normal, 8.0)
+    const glm::vec3 lM = glm::pow(glm::abs(aNormal), glm::vec3(8.0f));
+    const float lRoughMap = (SampleRoughness(glm::vec2(aPos.y, aPos.z)) * lM.x +
+                             SampleRoughness(glm::vec2(aPos.z, aPos.x)) * lM.y +
+                             SampleRoughness(glm::vec2(aPos.x, aPos.y)) * lM.z) / (lM.x + lM.y + lM.z);
+    const float lRoughness = glm::mix(0.0f, lRoughMap, glm::clamp(aMaterial.pbr.x, 0.0f, 1.0f));
+
+    const glm::vec3 lSurface(aMaterial.surfaceColor);
+    glm::vec3 lColor = ApplyLight(aRayDir, aNormal, lSurface, kLightDir, glm::vec3(aMaterial.lightAColor), lRoughness);
+    lColor += ApplyLight(aRayDir, aNormal, lSurface, kLightDir2, glm::vec3(aMaterial.lightBColor), lRoughness);
+    lColor = glm::mix(lColor, glm::vec3(aMaterial.fresnelColor), lDotCam);
+    lColor = glm::mix(glm::vec3(aMaterial.aoColor), lColor, aAO);
+    return lColor;
+}
+
+float CSdfRaymarcher::SampleRoughness(glm::vec2 const& aUV) const
+{
+    if (mRoughnessMap == nullptr)
+    {
+        return 1.0f;
+    }
+
+    // Bilinear with repeat, red channel
+    sbx::TTexture const& lMap = *mRoughnessMap;
+    const glm::vec2 lCoord = aUV * glm::vec2(lMap.mWidth, lMap.mHeight) - 0.5f;
+    const glm::vec2 lBase = glm::floor(lCoord);
+    const glm::vec2 lFrac = lCoord - lBase;
+
+    auto lFetch = [&lMap](int32_t aX, int32_t aY)
+    {
+        aX = ((aX % lMap.mWidth) + lMap.mWidth) % lMap.mWidth;
+        aY = ((aY % lMap.mHeight) + lMap.mHeight) % lMap.mHeight;
+        const size_t lIndex = size_t(aY) * size_t(lMap.mWidth) + size_t(aX);
+        switch (lMap.mFormat)
+        {
+        case sbx::ETextureFormat::R8:       return float(lMap.AsR8Buffer()[lIndex]) / 255.0f;
+        case sbx::ETextureFormat::RGBA8:    return float(lMap.AsRGBA8Buffer()[lIndex].r) / 255.0f;
+        case sbx::ETextureFormat::R32F:     return lMap.AsR32FBuffer()[lIndex];
+        case sbx::ETextureFormat::RGBA32F:  return lMap.AsRGBA32FBuffer()[lIndex].r;
+        default:                            return 1.0f;
+        }
+    };
+
+    const int32_t x = int32_t(lBase.x);
+    const int32_t y = int32_t(lBase.y);
+    const float lTop = glm::mix(lFetch(x, y), lFetch(x + 1, y), lFrac.x);
+    const float lBottom = glm::mix(lFetch(x, y + 1), lFetch(x + 1, y + 1), lFrac.x);
+    return glm::mix(lTop, lBottom, lFrac.y);
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// CPU version of the raymarching in Color.frag.glsl
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <SDFEditor/Tool/StrokeInfo.h>
+#include <SDFEditor/Sdf/SdfBakeParams.h>
+
+namespace sbx
+{
+    struct TTexture;
+}
+
+class CSdfEvaluator;
+struct TSdfBrickAtlas;
+
+struct TSdfRenderParams
+{
+    int32_t mWidth{ 512 };
+    int32_t mHeight{ 512 };
+    int32_t mTileSize{ 32 };        // pixels per tile side
+    uint32_t mThreads{ 0 };         // 0 = all hardware threads
+    bool mVignette{ true };
+};
+
+struct TSdfRenderTileStats
+{
+    glm::ivec2 mMin{ 0 };           // pixels [mMin, mMax), row 0 at the top
+    glm::ivec2 mMax{ 0 };
+    uint32_t mWorker{ 0 };
+    uint32_t mHits{ 0 };
+    uint64_t mEvaluations{ 0 };     // distance queries or volume lookups, marching, normals and AO
+    double mSeconds{ 0.0 };
+};
+
+struct TSdfRenderStats
+{
+    uint64_t mRays{ 0 };            // primary rays, one per pixel
+    uint64_t mEvaluations{ 0 };
+    uint32_t mThreads{ 0 };
+    uint32_t mStolenTiles{ 0 };
+    double mSeconds{ 0.0 };
+    double mRaysPerSecond{ 0.0 };
+    std::vector<TSdfRenderTileStats> mTiles;
+};
+
+// Renders the view of a frame_data block (see FullScreenTrinagle.vert.glsl),
+// tiles are spread over the workers with sbx::ParallelForEachStealing.
+// RenderStrokes marches the rays of a tile in lockstep so each step is one
+// batched distance query. RenderAtlas marches a baked volume instead, its cost
+// doesn't depend on the strokes count.
+class CSdfRaymarcher
+{
+public:
+    // Same as uRoughnessMap, sampled with repeat. Null uses the white default map of the renderer
+    void SetRoughnessMap(sbx::TTexture const* aRoughnessMap) { mRoughnessMap = aRoughnessMap; }
+
+    // RaymarchStrokes on each pixel, aOutImage is (re)initialized as a RGBA8 image
+    TSdfRenderStats RenderStrokes(CSdfEvaluator const& aEvaluator, TGlobalMaterialBufferData const& aMaterial,
+                                  glm::mat4 const& aViewMatrix, glm::mat4 const& aProjectionMatrix,
+                                  TSdfRenderParams const& aParams, sbx::TTexture& aOutImage) const;
+
+    // RaymarchAtlas on each pixel over the LUT of CSdfLutBaker and its compact bricks
+    TSdfRenderStats RenderAtlas(sbx::TTexture const& aLut, TSdfBrickAtlas const& aAtlas, TSdfBakeParams const& aBakeParams, TGlobalMaterialBufferData const& aMaterial,
+                                glm::mat4 const& aViewMatrix, glm::mat4 const& aProjectionMatrix,
+                                TSdfRenderParams const& aParams, sbx::TTexture& aOutImage) const;
+
+private:
+    // ApplyMaterial, linear color
+    glm::vec3 ApplyMaterial(TGlobalMaterialBufferData const& aMaterial, glm::vec3 const& aPos, glm::vec3 const& aRayDir, glm::vec3 const& aNormal, float aAO) const;
+    float SampleRoughness(glm::vec2 const& aUV) const;
+
+    sbx::TTexture const* mRoughnessMap{ nullptr };
+};
@@ -0,0 +1,228 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfSimd.h"
+
+#include <sbx/Core/Platform.h>
+#include <SDFEditor/Tool/StrokeInfo.h>
+
+#include <algorithm>
+
+namespace
+{
+    // Float arrays in mFloats, in TSdfStrokesView order
+    enum EFloatArray
+    {
+        PosX, PosY, PosZ,
+        QuatX, QuatY, QuatZ, QuatW,
+        Param0, Param1, Param2, Param3,
+        Blend, BlendFactor,
+        FloatArrayCount
+    };
+
+    enum EIntArray
+    {
+        Primitive, Mirror, Operation,
+        IntArrayCount
+    };
+}
+
+CSdfStrokesSoA::CSdfStrokesSoA(CSdfStrokesSoA const& aOther)
+    : mFloats(aOther.mFloats)
+    , mInts(aOther.mInts)
+    , mCount(aOther.mCount)
+{
+    UpdateView();
+}
+
+CSdfStrokesSoA& CSdfStrokesSoA::operator=(CSdfStrokesSoA const& aOther)
+{
+    mFloats = aOther.mFloats;
+    mInts = aOther.mInts;
+    mCount = aOther.mCount;
+    UpdateView();
+    return *this;
+}
+
+void CSdfStrokesSoA::Build(stroke_t const* aStrokes, size_t aCount)
+{
+    mCount = aCount;
+    mFloats.assign(aCount * FloatArrayCount, 0.0f);
+    mInts.assign(aCount * IntArrayCount, 0);
+
+    float* f[FloatArrayCount];
+    for (int i = 0; i < FloatArrayCount; i++)
+    {
+        f[i] = mFloats.data() + i * aCount;
+    }
+
+    int32_t* n[IntArrayCount];
+    for (int i = 0; i < IntArrayCount; i++)
+    {
+        n[i] = mInts.data() + i * aCount;
+    }
+
+    for (size_t s = 0; s < aCount; s++)
+    {
+        stroke_t const& lStroke = aStrokes[s];
+
+        f[PosX][s] = lStroke.posb.x;
+        f[PosY][s] = lStroke.posb.y;
+        f[PosZ][s] = lStroke.posb.z;
+        f[QuatX][s] = lStroke.quat.x;
+        f[QuatY][s] = lStroke.quat.y;
+        f[QuatZ][s] = lStroke.quat.z;
+        f[QuatW][s] = lStroke.quat.w;
+
+        // Per primitive constants, same math as evalStroke
+        n[Primitive][s] = lStroke.id.x;
+        switch (lStroke.id.x)
+        {
+        case EPrimitive::PrEllipsoid:
+            f[Param0][s] = 1.0f / lStroke.param0.x;
+            f[Param1][s] = 1.0f / lStroke.param0.y;
+            f[Param2][s] = 1.0f / lStroke.param0.z;
+            break;
+        case EPrimitive::PrBox:
+        {
+            const float lSmaller = std::min(std::min(lStroke.param0.x, lStroke.param0.y), lStroke.param0.z);
+            const float lRound = lSmaller * std::min(std::max(lStroke.param0.w, 0.0f), 1.0f);
+            f[Param0][s] = lStroke.param0.x - lRound;
+            f[Param1][s] = lStroke.param0.y - lRound;
+            f[Param2][s] = lStroke.param0.z - lRound;
+            f[Param3][s] = lRound;
+            break;
+        }
+        case EPrimitive::PrTorus:
+            f[Param0][s] = lStroke.param0.x;
+            f[Param1][s] = lStroke.param0.y;
+            break;
+        case EPrimitive::PrCapsule:
+        {
+            const float lRadius = std::max(lStroke.param0.x, 0.0f);
+            const float lHeight = std::max(lStroke.param0.y, 0.0f);
+            f[Param0][s] = lRadius - lHeight;
+            f[Param1][s] = lHeight * 2.0f - lRadius * 2.0f;
+            f[Param2][s] = lRadius;
+            break;
+        }
+        default:
+            n[Primitive][s] = -1;
+            break;
+        }
+
+        const float lClampedBlend = std::max(0.0001f, lStroke.posb.w);
+        f[Blend][s] = lClampedBlend;
+        f[BlendFactor][s] = 0.25f / lClampedBlend;
+
+        n[Mirror][s] = ((lStroke.id.y & EStrokeOp::OpMirrorX) ? ESdfKernelMirror::MirrorX : 0) |
+                       ((lStroke.id.y & EStrokeOp::OpMirrorY) ? ESdfKernelMirror::MirrorY : 0);
+
+        // Same branch order as the shader, OpReplace falls into subtract
+        if ((lStroke.id.y & EStrokeOp::OpsMaskMode) == EStrokeOp::OpAdd)
+        {
+            n[Operation][s] = ESdfKernelOp::Union;
+        }
+        else if ((lStroke.id.y & EStrokeOp::OpSubtract) == EStrokeOp::OpSubtract)
+        {
+            n[Operation][s] = ESdfKernelOp::Subtract;
+        }
+        else
+        {
+            n[Operation][s] = ESdfKernelOp::Intersect;
+        }
+    }
+
+    UpdateView();
+}
+
+void CSdfStrokesSoA::UpdateView()
+{
+    // The view points into the arrays, rebuild it when they move
+    const float* f[FloatArrayCount];
+    for (int i = 0; i < FloatArrayCount; i++)
+    {
+        f[i] = mFloats.data() + i * mCount;
+    }
+
+    const int32_t* n[IntArrayCount];
+    for (int i = 0; i < IntArrayCount; i++)
+    {
+        n[i] = mInts.data() + i * mCount;
+    }
+
+    mView.mPosX = f[PosX];
+    mView.mPosY = f[PosY];
+    mView.mPosZ = f[PosZ];
+    mView.mQuatX = f[QuatX];
+    mView.mQuatY = f[QuatY];
+    mView.mQuatZ = f[QuatZ];
+    mView.mQuatW = f[QuatW];
+    mView.mParam[0] = f[Param0];
+    mView.mParam[1] = f[Param1];
+    mView.mParam[2] = f[Param2];
+    mView.mParam[3] = f[Param3];
+    mView.mBlend = f[Blend];
+    mView.mBlendFactor = f[BlendFactor];
+    mView.mPrimitive = n[Primitive];
+    mView.mMirror = n[Mirror];
+    mView.mOperation = n[Operation];
+    mView.mCount = mCount;
+}
+
+namespace Sdf
+{
+    bool IsKernelSupported(ESdfKernel::Type aKernel)
+    {
+        const uint32_t lFeatures = sbx::GetCpuFeatures();
+
+        switch (aKernel)
+        {
+        case ESdfKernel::Auto:
+        case ESdfKernel::Scalar:
+            return true;
+        case ESdfKernel::SSE41:
+            return (lFeatures & sbx::ECpuFeature::SSE41) != 0;
+        case ESdfKernel::AVX2:
+            return (lFeatures & (sbx::ECpuFeature::AVX2 | sbx::ECpuFeature::FMA)) == (sbx::ECpuFeature::AVX2 | sbx::ECpuFeature::FMA);
+        case ESdfKernel::AVX512:
+            return (lFeatures & sbx::ECpuFeature::AVX512F) != 0;
+        default:
+            return false;
+        }
+    }
+
+    ESdfKernel::Type ResolveKernel(ESdfKernel::Type aKernel)
+    {
+        if (aKernel == ESdfKernel::Auto)
+        {
+            for (int32_t i = ESdfKernel::Count - 1; i > ESdfKernel::Scalar; i--)
+            {
+                if (IsKernelSupported(ESdfKernel::Type(i)))
+                {
+                    return ESdfKernel::Type(i);
+                }
+            }
+
+            return ESdfKernel::Scalar;
+        }
+
+        return IsKernelSupported(aKernel) ? aKernel : ESdfKernel::Scalar;
+    }
+
+    TSdfEvalKernelFn GetEvalKernel(ESdfKernel::Type aKernel)
+    {
+        switch (ResolveKernel(aKernel))
+        {
+        case ESdfKernel::SSE41:     return &SdfEvalKernelSSE41;
+        case ESdfKernel::AVX2:      return &SdfEvalKernelAVX2;
+        case ESdfKernel::AVX512:    return &SdfEvalKernelAVX512;
+        default:                    return &SdfEvalKernelScalar;
+        }
+    }
+
+    const char* GetKernelName(ESdfKernel::Type aKernel)
+    {
+        static const char* sKernelNames[ESdfKernel::Count] = { "Auto", "Scalar", "SSE4.1", "AVX2", "AVX-512" };
+        return (aKernel >= 0 && aKernel < ESdfKernel::Count) ? sKernelNames[aKernel] : "Unknown";
+    }
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Structure of arrays stroke layout and runtime selection of the SIMD kernels
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDFEditor/Sdf/SdfKernel.h>
+
+struct stroke_t;
+
+// Strokes transposed to SoA, with the per primitive constants of evalStroke precomputed
+class CSdfStrokesSoA
+{
+public:
+    CSdfStrokesSoA() = default;
+    CSdfStrokesSoA(CSdfStrokesSoA const& aOther);
+    CSdfStrokesSoA& operator=(CSdfStrokesSoA const& aOther);
+
+    void Build(stroke_t const* aStrokes, size_t aCount);
+    size_t GetCount() const { return mCount; }
+    TSdfStrokesView const& GetView() const { return mView; }
+
+private:
+    void UpdateView();
+
+    std::vector<float> mFloats;
+    std::vector<int32_t> mInts;
+    TSdfStrokesView mView{};
+    size_t mCount{ 0 };
+};
+
+namespace Sdf
+{
+    bool IsKernelSupported(ESdfKernel::Type aKernel);
+    ESdfKernel::Type ResolveKernel(ESdfKernel::Type aKernel);
+    TSdfEvalKernelFn GetEvalKernel(ESdfKernel::Type aKernel);
+    const char* GetKernelName(ESdfKernel::Type aKernel);
+}
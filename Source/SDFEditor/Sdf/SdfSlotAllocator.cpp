@@ -0,0 +1,120 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfSlotAllocator.h"
+
+#include <sbx/Core/ErrorHandling.h>
+
+#include <algorithm>
+
+void CSdfSlotAllocator::Init(uint32_t aCapacity)
+{
+    SBX_ASSERT(aCapacity <= kIndexMask, "Slot capacity %u over the handle index bits", aCapacity);
+
+    // Generations survive a reinit of the same size so handles from before don't validate
+    mGenerations.resize(aCapacity, 0);
+    for (uint32_t i = 0; i < mHighWatermark && i < aCapacity; i++)
+    {
+        if (mUsed[i])
+        {
+            mGenerations[i] = uint16_t((mGenerations[i] + 1) & kGenerationMask);
+        }
+    }
+
+    mUsed.assign(aCapacity, 0);
+    mFreeList.clear();
+    mUsedCount = 0;
+    mHighWatermark = 0;
+}
+
+void CSdfSlotAllocator::InitCompact(uint32_t aCapacity, uint32_t aUsedCount)
+{
+    SBX_ASSERT(aUsedCount <= aCapacity, "%u used slots over the capacity %u", aUsedCount, aCapacity);
+
+    Init(aCapacity);
+    std::fill(mUsed.begin(), mUsed.begin() + aUsedCount, uint8_t(1));
+    mUsedCount = aUsedCount;
+    mHighWatermark = aUsedCount;
+}
+
+uint32_t CSdfSlotAllocator::Allocate()
+{
+    uint32_t lIndex;
+    if (!mFreeList.empty())
+    {
+        lIndex = mFreeList.back();
+        mFreeList.pop_back();
+    }
+    else if (mHighWatermark < GetCapacity())
+    {
+        lIndex = mHighWatermark++;
+    }
+    else
+    {
+        return kInvalidHandle;
+    }
+
+    mUsed[lIndex] = 1;
+    mUsedCount++;
+    return MakeHandle(lIndex);
+}
+
+bool CSdfSlotAllocator::Release(uint32_t aHandle)
+{
+    if (!IsValid(aHandle))
+    {
+        return false;
+    }
+
+    const uint32_t lIndex = GetIndex(aHandle);
+    mUsed[lIndex] = 0;
+    mGenerations[lIndex] = uint16_t((mGenerations[lIndex] + 1) & kGenerationMask);
+    mFreeList.push_back(lIndex);
+    mUsedCount--;
+    return true;
+}
+
+bool CSdfSlotAllocator::IsValid(uint32_t aHandle) const
+{
+    const uint32_t lIndex = GetIndex(aHandle);
+    return (aHandle != kInvalidHandle) && (lIndex < mHighWatermark) && mUsed[lIndex] && (MakeHandle(lIndex) == aHandle);
+}
+
+void CSdfSlotAllocator::Compact(std::vector<TSlotMove>& aOutMoves)
+{
+    aOutMoves.clear();
+
+    // Fill the holes from the bottom with the slots from the top
+    uint32_t lHole = 0;
+    uint32_t lTop = mHighWatermark;
+    while (true)
+    {
+        while (lHole < mUsedCount && mUsed[lHole])
+        {
+            lHole++;
+        }
+
+        while (lTop > mUsedCount && !mUsed[lTop - 1])
+        {
+            lTop--;
+        }
+
+        if (lHole >= mUsedCount || lTop <= mUsedCount)
+        {
+            break;
+        }
+
+        const uint32_t lFrom = lTop - 1;
+        TSlotMove lMove;
+        lMove.mFrom = MakeHandle(lFrom);
+
+        mUsed[lFrom] = 0;
+        mGenerations[lFrom] = uint16_t((mGenerations[lFrom] + 1) & kGenerationMask);
+        mUsed[lHole] = 1;
+        lMove.mTo = MakeHandle(lHole);
+
+        aOutMoves.push_back(lMove);
+    }
+
+    mFreeList.clear();
+    mHighWatermark = mUsedCount;
+}
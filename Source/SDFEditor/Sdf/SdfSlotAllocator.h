@@ -0,0 +1,69 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Persistent atlas slots with free list reuse
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Slot handles pack the slot index with a generation counter, the generation
+// changes each time the slot is released so old handles can be told apart
+// from the current owner of the slot.
+class CSdfSlotAllocator
+{
+public:
+    static constexpr uint32_t kIndexBits = 20;
+    static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1u;
+    static constexpr uint32_t kGenerationMask = (1u << (32 - kIndexBits)) - 1u;
+    static constexpr uint32_t kInvalidHandle = UINT32_MAX;
+
+    struct TSlotMove
+    {
+        uint32_t mFrom;     // handle released by the move
+        uint32_t mTo;       // handle that replaces it
+    };
+
+    // Releases every slot, capacity up to kIndexMask slots
+    void Init(uint32_t aCapacity);
+
+    // Init with the slots [0, aUsedCount) in use, the state left by a Compact
+    void InitCompact(uint32_t aCapacity, uint32_t aUsedCount);
+
+    // Reuses the last released slot or takes a new one, kInvalidHandle when full
+    uint32_t Allocate();
+
+    // Returns false for stale or invalid handles
+    bool Release(uint32_t aHandle);
+
+    bool IsValid(uint32_t aHandle) const;
+
+    // Handle of the current owner of a used slot
+    uint32_t GetHandle(uint32_t aIndex) const { return MakeHandle(aIndex); }
+
+    static uint32_t GetIndex(uint32_t aHandle) { return aHandle & kIndexMask; }
+    static uint32_t GetGeneration(uint32_t aHandle) { return aHandle >> kIndexBits; }
+
+    uint32_t GetCapacity() const { return uint32_t(mGenerations.size()); }
+    uint32_t GetUsedCount() const { return mUsedCount; }
+    uint32_t GetFreeListCount() const { return uint32_t(mFreeList.size()); }
+
+    // Slots handed out at least once since the last Init or Compact, the atlas
+    // is only touched below it
+    uint32_t GetHighWatermark() const { return mHighWatermark; }
+
+    // Used slots over the high watermark, 1 when there are no holes
+    float GetOccupancy() const { return (mHighWatermark > 0) ? float(mUsedCount) / float(mHighWatermark) : 1.0f; }
+
+    // Moves the used slots past GetUsedCount() to the holes below it, afterwards
+    // the used slots are [0, GetUsedCount()). aOutMoves receives each move.
+    void Compact(std::vector<TSlotMove>& aOutMoves);
+
+private:
+    uint32_t MakeHandle(uint32_t aIndex) const { return (uint32_t(mGenerations[aIndex]) << kIndexBits) | aIndex; }
+
+    std::vector<uint16_t> mGenerations;
+    std::vector<uint8_t> mUsed;
+    std::vector<uint32_t> mFreeList;
+    uint32_t mUsedCount{ 0 };
+    uint32_t mHighWatermark{ 0 };
+};
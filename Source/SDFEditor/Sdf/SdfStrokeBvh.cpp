@@ -0,0 +1,613 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfStrokeBvh.h"
+#include "SdfBounds.h"
+
+#include <sbx/Core/Platform.h>
+#include <sbx/Core/ErrorHandling.h>
+
+#include <algorithm>
+#include <numeric>
+
+#if SBX_SIMD_X86
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    constexpr int32_t kEmptyChild = INT32_MIN;
+    constexpr uint32_t kEmptyBox = UINT32_MAX;
+
+    // Same ray range as SBox::CheckRayIntersection
+    constexpr float kMaxDistance = 100000.0f;
+
+    // Keeps the slab distances finite for the axes parallel to the ray
+    constexpr float kMinDirection = 1e-12f;
+
+    // The node bounds cover the float rounding of the oriented boxes
+    constexpr float kBoundsPadding = 1e-4f;
+
+    // Strokes refit since the last build, relative to the count, before rebuilding
+    constexpr float kRebuildRefitRatio = 0.5f;
+
+    constexpr uint32_t kMaxStack = 256;
+
+#if SBX_SIMD_X86
+    // SSE2 is always there on x86, no runtime check needed
+    struct TVec4
+    {
+        using F = __m128;
+
+        static F Set1(float a) { return _mm_set1_ps(a); }
+        static F Load(const float* a) { return _mm_load_ps(a); }
+        static void Store(float* a, F v) { _mm_store_ps(a, v); }
+        static F Add(F a, F b) { return _mm_add_ps(a, b); }
+        static F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+        static F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+        static F Div(F a, F b) { return _mm_div_ps(a, b); }
+        static F Min(F a, F b) { return _mm_min_ps(a, b); }
+        static F Max(F a, F b) { return _mm_max_ps(a, b); }
+        static F Abs(F a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        static F LessEqual(F a, F b) { return _mm_cmple_ps(a, b); }
+        static F Select(F aMask, F aTrue, F aFalse) { return _mm_or_ps(_mm_and_ps(aMask, aTrue), _mm_andnot_ps(aMask, aFalse)); }
+    };
+#else
+    // Portable lanes, masks are 1 or 0
+    struct TVec4
+    {
+        struct F { float v[4]; };
+
+        template <typename Fn>
+        static F Map(Fn aFn) { F r; for (int i = 0; i < 4; i++) { r.v[i] = aFn(i); } return r; }
+
+        static F Set1(float a) { return Map([&](int) { return a; }); }
+        static F Load(const float* a) { return Map([&](int i) { return a[i]; }); }
+        static void Store(float* a, F v) { for (int i = 0; i < 4; i++) { a[i] = v.v[i]; } }
+        static F Add(F a, F b) { return Map([&](int i) { return a.v[i] + b.v[i]; }); }
+        static F Sub(F a, F b) { return Map([&](int i) { return a.v[i] - b.v[i]; }); }
+        static F Mul(F a, F b) { return Map([&](int i) { return a.v[i] * b.v[i]; }); }
+        static F Div(F a, F b) { return Map([&](int i) { return a.v[i] / b.v[i]; }); }
+        static F Min(F a, F b) { return Map([&](int i) { return (a.v[i] < b.v[i]) ? a.v[i] : b.v[i]; }); }
+        static F Max(F a, F b) { return Map([&](int i) { return (a.v[i] > b.v[i]) ? a.v[i] : b.v[i]; }); }
+        static F Abs(F a) { return Map([&](int i) { return glm::abs(a.v[i]); }); }
+        static F LessEqual(F a, F b) { return Map([&](int i) { return (a.v[i] <= b.v[i]) ? 1.0f : 0.0f; }); }
+        static F Select(F aMask, F aTrue, F aFalse) { return Map([&](int i) { return (aMask.v[i] != 0.0f) ? aTrue.v[i] : aFalse.v[i]; }); }
+    };
+#endif
+
+    using F = TVec4::F;
+
+    uint32_t GetStrokeBoxesCount(stroke_t const& aStroke, TAabb const& aLocalBounds)
+    {
+        if (aLocalBounds.IsEmpty())
+        {
+            return 0;
+        }
+        return ((aStroke.id.y & EStrokeOp::OpMirrorX) ? 2 : 1) * ((aStroke.id.y & EStrokeOp::OpMirrorY) ? 2 : 1);
+    }
+
+    bool HasMirror(stroke_t const& aStroke, uint32_t aMirror)
+    {
+        return !(((aMirror & 1) && !(aStroke.id.y & EStrokeOp::OpMirrorX)) ||
+                 ((aMirror & 2) && !(aStroke.id.y & EStrokeOp::OpMirrorY)));
+    }
+}
+
+struct CStrokeBvh::TRay
+{
+    F mOrigin[3];
+    F mDirection[3];
+    F mInverse[3];
+
+    TRay(glm::vec3 const& aOrigin, glm::vec3 const& aDirection)
+    {
+        for (int32_t k = 0; k < 3; k++)
+        {
+            const float lSafeDirection = (glm::abs(aDirection[k]) < kMinDirection) ? ((aDirection[k] < 0.0f) ? -kMinDirection : kMinDirection) : aDirection[k];
+            mOrigin[k] = TVec4::Set1(aOrigin[k]);
+            mDirection[k] = TVec4::Set1(aDirection[k]);
+            mInverse[k] = TVec4::Set1(1.0f / lSafeDirection);
+        }
+    }
+};
+
+void CStrokeBvh::Update(CStrokeBoundsCache const& aBounds)
+{
+    bool lRebuild = (mStrokeBoxes.size() != aBounds.GetCount() + 1);
+
+    std::vector<uint32_t> const& lUpdated = aBounds.GetUpdatedIndices();
+    for (size_t i = 0; i < lUpdated.size() && !lRebuild; i++)
+    {
+        const uint32_t lStroke = lUpdated[i];
+        lRebuild = (mStrokeBoxes[lStroke + 1] - mStrokeBoxes[lStroke]) != GetStrokeBoxesCount(aBounds.GetStroke(lStroke), aBounds.GetLocalBounds(lStroke));
+    }
+
+    mRefitsSinceBuild += lUpdated.size();
+    lRebuild |= (float(mRefitsSinceBuild) > kRebuildRefitRatio * float(aBounds.GetCount()));
+
+    if (lRebuild)
+    {
+        Build(aBounds);
+        return;
+    }
+
+    for (uint32_t lStroke : lUpdated)
+    {
+        UpdateUnbounded(lStroke, aBounds.GetStroke(lStroke));
+        if (aBounds.GetLocalBounds(lStroke).IsEmpty())
+        {
+            continue;
+        }
+
+        uint32_t lBox = mStrokeBoxes[lStroke];
+        for (uint32_t lMirror = 0; lMirror < 4; lMirror++)
+        {
+            if (HasMirror(aBounds.GetStroke(lStroke), lMirror))
+            {
+                ComputeBox(aBounds, lStroke, lMirror, mBoxes[lBox]);
+                WriteLane(lBox);
+                Refit(~int32_t(mBoxes[lBox].mLeafLane / kWidth));
+                lBox++;
+            }
+        }
+    }
+}
+
+int32_t CStrokeBvh::Raycast(glm::vec3 const& aOrigin, glm::vec3 const& aDirection, float* aOutDistance) const
+{
+    if (mBoxes.empty())
+    {
+        return -1;
+    }
+
+    const TRay lRay(aOrigin, aDirection);
+    float lBestDistance = kMaxDistance;
+    int32_t lBestStroke = -1;
+
+    struct TStackEntry
+    {
+        int32_t mChild;
+        float mDistance;
+    };
+    TStackEntry lStack[kMaxStack];
+    uint32_t lStackSize = 0;
+    lStack[lStackSize++] = { mRoot, 0.0f };
+
+    alignas(16) float lEnter[kWidth];
+    alignas(16) float lExit[kWidth];
+
+    while (lStackSize > 0)
+    {
+        const TStackEntry lEntry = lStack[--lStackSize];
+        if (lEntry.mDistance > lBestDistance)
+        {
+            continue;
+        }
+
+        if (lEntry.mChild >= 0)
+        {
+            TNode const& lNode = mNodes[lEntry.mChild];
+            IntersectNode(lNode, lRay, false, lEnter, lExit);
+
+            // Nearest children go on top
+            TStackEntry lHits[kWidth];
+            uint32_t lHitsCount = 0;
+            for (uint32_t c = 0; c < kWidth; c++)
+            {
+                if (lNode.mChildren[c] != kEmptyChild && lEnter[c] <= lExit[c] && lEnter[c] <= lBestDistance)
+                {
+                    uint32_t lSlot = lHitsCount++;
+                    for (; lSlot > 0 && lHits[lSlot - 1].mDistance < lEnter[c]; lSlot--)
+                    {
+                        lHits[lSlot] = lHits[lSlot - 1];
+                    }
+                    lHits[lSlot] = { lNode.mChildren[c], lEnter[c] };
+                }
+            }
+
+            SBX_ASSERT(lStackSize + lHitsCount <= kMaxStack, "Stroke BVH too deep");
+            for (uint32_t h = 0; h < lHitsCount; h++)
+            {
+                lStack[lStackSize++] = lHits[h];
+            }
+        }
+        else
+        {
+            TLeaf const& lLeaf = mLeaves[~lEntry.mChild];
+            IntersectLeaf(lLeaf, lRay, false, lEnter, lExit);
+            for (uint32_t l = 0; l < kWidth; l++)
+            {
+                const int32_t lStroke = lLeaf.mStrokes[l];
+                if (lStroke >= 0 && lEnter[l] <= lExit[l] &&
+                    (lEnter[l] < lBestDistance || (lEnter[l] == lBestDistance && lStroke < lBestStroke)))
+                {
+                    lBestDistance = lEnter[l];
+                    lBestStroke = lStroke;
+                }
+            }
+        }
+    }
+
+    if (aOutDistance && lBestStroke >= 0)
+    {
+        *aOutDistance = lBestDistance;
+    }
+    return lBestStroke;
+}
+
+void CStrokeBvh::RaycastField(glm::vec3 const& aOrigin, glm::vec3 const& aDirection, std::vector<TRayHit>& aOutHits) const
+{
+    aOutHits.clear();
+    if (mBoxes.empty())
+    {
+        return;
+    }
+
+    const TRay lRay(aOrigin, aDirection);
+    int32_t lStack[kMaxStack];
+    uint32_t lStackSize = 0;
+    lStack[lStackSize++] = mRoot;
+
+    alignas(16) float lEnter[kWidth];
+    alignas(16) float lExit[kWidth];
+
+    while (lStackSize > 0)
+    {
+        const int32_t lChild = lStack[--lStackSize];
+        if (lChild >= 0)
+        {
+            TNode const& lNode = mNodes[lChild];
+            IntersectNode(lNode, lRay, true, lEnter, lExit);
+            for (uint32_t c = 0; c < kWidth; c++)
+            {
+                if (lNode.mChildren[c] != kEmptyChild && lEnter[c] <= lExit[c])
+                {
+                    SBX_ASSERT(lStackSize < kMaxStack, "Stroke BVH too deep");
+                    lStack[lStackSize++] = lNode.mChildren[c];
+                }
+            }
+        }
+        else
+        {
+            TLeaf const& lLeaf = mLeaves[~lChild];
+            IntersectLeaf(lLeaf, lRay, true, lEnter, lExit);
+            for (uint32_t l = 0; l < kWidth; l++)
+            {
+                if (lLeaf.mStrokes[l] >= 0 && lEnter[l] <= lExit[l])
+                {
+                    aOutHits.push_back({ lLeaf.mStrokes[l], lEnter[l], lExit[l] });
+                }
+            }
+        }
+    }
+}
+
+void CStrokeBvh::IntersectNode(TNode const& aNode, TRay const& aRay, bool aFieldBoxes, float* aOutEnter, float* aOutExit) const
+{
+    // Slabs of the 4 child boxes
+    const float (&lMinArray)[3][kWidth] = aFieldBoxes ? aNode.mFieldMin : aNode.mMin;
+    const float (&lMaxArray)[3][kWidth] = aFieldBoxes ? aNode.mFieldMax : aNode.mMax;
+    F lEnter = TVec4::Set1(0.0f);
+    F lExit = TVec4::Set1(kMaxDistance);
+    for (int32_t k = 0; k < 3; k++)
+    {
+        const F lT0 = TVec4::Mul(TVec4::Sub(TVec4::Load(lMinArray[k]), aRay.mOrigin[k]), aRay.mInverse[k]);
+        const F lT1 = TVec4::Mul(TVec4::Sub(TVec4::Load(lMaxArray[k]), aRay.mOrigin[k]), aRay.mInverse[k]);
+        lEnter = TVec4::Max(lEnter, TVec4::Min(lT0, lT1));
+        lExit = TVec4::Min(lExit, TVec4::Max(lT0, lT1));
+    }
+    TVec4::Store(aOutEnter, lEnter);
+    TVec4::Store(aOutExit, lExit);
+}
+
+void CStrokeBvh::IntersectLeaf(TLeaf const& aLeaf, TRay const& aRay, bool aFieldBoxes, float* aOutEnter, float* aOutExit) const
+{
+    // Oriented box slabs of the 4 lanes, in the box frame as SBox::CheckRayIntersection
+    const float (&lMinArray)[3][kWidth] = aFieldBoxes ? aLeaf.mFieldMin : aLeaf.mMin;
+    const float (&lMaxArray)[3][kWidth] = aFieldBoxes ? aLeaf.mFieldMax : aLeaf.mMax;
+    const F lZero = TVec4::Set1(0.0f);
+    const F lMinDirection = TVec4::Set1(kMinDirection);
+    const F lMinDirectionNeg = TVec4::Set1(-kMinDirection);
+
+    F lDelta[3];
+    for (int32_t k = 0; k < 3; k++)
+    {
+        lDelta[k] = TVec4::Sub(TVec4::Load(aLeaf.mPosition[k]), aRay.mOrigin[k]);
+    }
+
+    F lEnter = lZero;
+    F lExit = TVec4::Set1(kMaxDistance);
+    for (int32_t a = 0; a < 3; a++)
+    {
+        const F lAxisX = TVec4::Load(aLeaf.mAxes[a * 3 + 0]);
+        const F lAxisY = TVec4::Load(aLeaf.mAxes[a * 3 + 1]);
+        const F lAxisZ = TVec4::Load(aLeaf.mAxes[a * 3 + 2]);
+        const F lE = TVec4::Add(TVec4::Add(TVec4::Mul(lAxisX, lDelta[0]), TVec4::Mul(lAxisY, lDelta[1])), TVec4::Mul(lAxisZ, lDelta[2]));
+        const F lF = TVec4::Add(TVec4::Add(TVec4::Mul(lAxisX, aRay.mDirection[0]), TVec4::Mul(lAxisY, aRay.mDirection[1])), TVec4::Mul(lAxisZ, aRay.mDirection[2]));
+
+        // Nearly parallel axes keep a tiny direction of their sign, the
+        // slabs then reach +-inf unless the origin is between the planes
+        const F lTiny = TVec4::Select(TVec4::LessEqual(lZero, lF), lMinDirection, lMinDirectionNeg);
+        const F lSafeF = TVec4::Select(TVec4::LessEqual(TVec4::Abs(lF), lMinDirection), lTiny, lF);
+        const F lT1 = TVec4::Div(TVec4::Add(lE, TVec4::Load(lMinArray[a])), lSafeF);
+        const F lT2 = TVec4::Div(TVec4::Add(lE, TVec4::Load(lMaxArray[a])), lSafeF);
+        lEnter = TVec4::Max(lEnter, TVec4::Min(lT1, lT2));
+        lExit = TVec4::Min(lExit, TVec4::Max(lT1, lT2));
+    }
+    TVec4::Store(aOutEnter, lEnter);
+    TVec4::Store(aOutExit, lExit);
+}
+
+void CStrokeBvh::Clear()
+{
+    mBoxes.clear();
+    mStrokeBoxes.clear();
+    mNodes.clear();
+    mLeaves.clear();
+    mUnboundedStrokes.clear();
+    mRoot = 0;
+    mRefitsSinceBuild = 0;
+}
+
+void CStrokeBvh::Build(CStrokeBoundsCache const& aBounds)
+{
+    Clear();
+    mBuildsCount++;
+
+    mStrokeBoxes.push_back(0);
+    for (uint32_t s = 0; s < aBounds.GetCount(); s++)
+    {
+        UpdateUnbounded(s, aBounds.GetStroke(s));
+        if (!aBounds.GetLocalBounds(s).IsEmpty())
+        {
+            for (uint32_t lMirror = 0; lMirror < 4; lMirror++)
+            {
+                if (HasMirror(aBounds.GetStroke(s), lMirror))
+                {
+                    mBoxes.emplace_back();
+                    ComputeBox(aBounds, s, lMirror, mBoxes.back());
+                }
+            }
+        }
+        mStrokeBoxes.push_back(uint32_t(mBoxes.size()));
+    }
+
+    if (mBoxes.empty())
+    {
+        return;
+    }
+
+    std::vector<uint32_t> lOrder(mBoxes.size());
+    std::iota(lOrder.begin(), lOrder.end(), 0u);
+    mRoot = BuildRange(lOrder, 0, uint32_t(lOrder.size()), -1, 0);
+}
+
+int32_t CStrokeBvh::BuildRange(std::vector<uint32_t>& aOrder, uint32_t aBegin, uint32_t aEnd, int32_t aParent, uint32_t aParentSlot)
+{
+    if (aEnd - aBegin <= kWidth)
+    {
+        const uint32_t lLeaf = uint32_t(mLeaves.size());
+        mLeaves.emplace_back();
+        TLeaf& lLeafData = mLeaves.back();
+        lLeafData.mParent = aParent;
+        lLeafData.mParentSlot = aParentSlot;
+        for (uint32_t l = 0; l < kWidth; l++)
+        {
+            lLeafData.mStrokes[l] = -1;
+            lLeafData.mBoxes[l] = kEmptyBox;
+        }
+
+        for (uint32_t i = aBegin; i < aEnd; i++)
+        {
+            mBoxes[aOrder[i]].mLeafLane = lLeaf * kWidth + (i - aBegin);
+            WriteLane(aOrder[i]);
+        }
+        TAabb lLeafBounds;
+        TAabb lLeafFieldBounds;
+        GetLeafBounds(lLeaf, lLeafBounds, lLeafFieldBounds);
+        SetChildBounds(aParent, aParentSlot, lLeafBounds, lLeafFieldBounds);
+        return ~int32_t(lLeaf);
+    }
+
+    // Median of the box centers along their longest axis
+    auto lSplit = [this, &aOrder](uint32_t aRangeBegin, uint32_t aRangeEnd)
+    {
+        TAabb lCenters;
+        for (uint32_t i = aRangeBegin; i < aRangeEnd; i++)
+        {
+            lCenters.Extend(mBoxes[aOrder[i]].mBounds.GetCenter());
+        }
+        const glm::vec3 lSize = lCenters.mMax - lCenters.mMin;
+        const int32_t lAxis = (lSize.x >= lSize.y && lSize.x >= lSize.z) ? 0 : (lSize.y >= lSize.z) ? 1 : 2;
+
+        const uint32_t lMiddle = aRangeBegin + (aRangeEnd - aRangeBegin) / 2;
+        std::nth_element(aOrder.begin() + aRangeBegin, aOrder.begin() + lMiddle, aOrder.begin() + aRangeEnd, [this, lAxis](uint32_t aA, uint32_t aB)
+        {
+            const float lA = mBoxes[aA].mBounds.GetCenter()[lAxis];
+            const float lB = mBoxes[aB].mBounds.GetCenter()[lAxis];
+            return (lA != lB) ? lA < lB : aA < aB;
+        });
+        return lMiddle;
+    };
+
+    // Two levels of splits make up to 4 children
+    uint32_t lBounds[kWidth + 1];
+    uint32_t lChildrenCount = 0;
+    const uint32_t lMiddle = lSplit(aBegin, aEnd);
+    const uint32_t lHalves[3] = { aBegin, lMiddle, aEnd };
+    lBounds[0] = aBegin;
+    for (uint32_t h = 0; h < 2; h++)
+    {
+        if (lHalves[h + 1] - lHalves[h] > kWidth)
+        {
+            lBounds[++lChildrenCount] = lSplit(lHalves[h], lHalves[h + 1]);
+        }
+        lBounds[++lChildrenCount] = lHalves[h + 1];
+    }
+
+    const int32_t lNode = int32_t(mNodes.size());
+    mNodes.emplace_back();
+    {
+        TNode& lNodeData = mNodes.back();
+        lNodeData.mParent = aParent;
+        lNodeData.mParentSlot = aParentSlot;
+        for (uint32_t c = 0; c < kWidth; c++)
+        {
+            lNodeData.mChildren[c] = kEmptyChild;
+            SetChildBounds(lNode, c, TAabb(), TAabb());
+        }
+    }
+
+    TAabb lNodeBounds;
+    TAabb lNodeFieldBounds;
+    for (uint32_t c = 0; c < lChildrenCount; c++)
+    {
+        // Nodes may move while the children are built
+        const int32_t lChild = BuildRange(aOrder, lBounds[c], lBounds[c + 1], lNode, c);
+        mNodes[lNode].mChildren[c] = lChild;
+        for (uint32_t i = lBounds[c]; i < lBounds[c + 1]; i++)
+        {
+            lNodeBounds.Extend(mBoxes[aOrder[i]].mBounds);
+            lNodeFieldBounds.Extend(mBoxes[aOrder[i]].mFieldBounds);
+        }
+    }
+
+    SetChildBounds(aParent, aParentSlot, lNodeBounds, lNodeFieldBounds);
+    return lNode;
+}
+
+void CStrokeBvh::ComputeBox(CStrokeBoundsCache const& aBounds, uint32_t aStroke, uint32_t aMirror, TBox& aOutBox) const
+{
+    // Mirrored copies reflect the world transform, as the picking always did
+    const glm::vec3 lMirrorScale((aMirror & 1) ? -1.0f : 1.0f, (aMirror & 2) ? -1.0f : 1.0f, 1.0f);
+    stroke_t const& lStroke = aBounds.GetStroke(aStroke);
+    const glm::mat4 lMatrix = Sdf::ComputeStrokeMatrix(lStroke);
+    TAabb const& lLocalBounds = aBounds.GetLocalBounds(aStroke);
+
+    aOutBox.mPosition = lMirrorScale * glm::vec3(lMatrix[3]);
+    for (int32_t a = 0; a < 3; a++)
+    {
+        aOutBox.mAxes[a] = lMirrorScale * glm::vec3(lMatrix[a]);
+    }
+    aOutBox.mMin = lLocalBounds.mMin;
+    aOutBox.mMax = lLocalBounds.mMax;
+    aOutBox.mStroke = int32_t(aStroke);
+
+    // Same padding as Sdf::ComputeStrokeBounds without the field margin
+    const glm::vec3 lPadding = Sdf::ComputeStrokeFieldPadding(lStroke, Sdf::ComputeStrokeBlendMargin(lStroke));
+    aOutBox.mFieldMin = lLocalBounds.mMin - lPadding;
+    aOutBox.mFieldMax = lLocalBounds.mMax + lPadding;
+
+    // World AABBs of both
+    const glm::vec3 lLocalCenter = lLocalBounds.GetCenter();
+    const glm::vec3 lLocalExtent = lLocalBounds.GetExtent();
+    glm::vec3 lCenter = aOutBox.mPosition;
+    glm::vec3 lExtent(kBoundsPadding);
+    glm::vec3 lFieldExtent(kBoundsPadding);
+    for (int32_t a = 0; a < 3; a++)
+    {
+        lCenter += aOutBox.mAxes[a] * lLocalCenter[a];
+        lExtent += glm::abs(aOutBox.mAxes[a]) * lLocalExtent[a];
+        lFieldExtent += glm::abs(aOutBox.mAxes[a]) * (lLocalExtent[a] + lPadding[a]);
+    }
+    aOutBox.mBounds = TAabb(lCenter - lExtent, lCenter + lExtent);
+    aOutBox.mFieldBounds = TAabb(lCenter - lFieldExtent, lCenter + lFieldExtent);
+}
+
+void CStrokeBvh::WriteLane(uint32_t aBox)
+{
+    TBox const& lBox = mBoxes[aBox];
+    TLeaf& lLeaf = mLeaves[lBox.mLeafLane / kWidth];
+    const uint32_t lLane = lBox.mLeafLane % kWidth;
+
+    for (int32_t k = 0; k < 3; k++)
+    {
+        lLeaf.mPosition[k][lLane] = lBox.mPosition[k];
+        lLeaf.mMin[k][lLane] = lBox.mMin[k];
+        lLeaf.mMax[k][lLane] = lBox.mMax[k];
+        lLeaf.mFieldMin[k][lLane] = lBox.mFieldMin[k];
+        lLeaf.mFieldMax[k][lLane] = lBox.mFieldMax[k];
+        for (int32_t c = 0; c < 3; c++)
+        {
+            lLeaf.mAxes[k * 3 + c][lLane] = lBox.mAxes[k][c];
+        }
+    }
+    lLeaf.mStrokes[lLane] = lBox.mStroke;
+    lLeaf.mBoxes[lLane] = aBox;
+}
+
+void CStrokeBvh::SetChildBounds(int32_t aParent, uint32_t aSlot, TAabb const& aBounds, TAabb const& aFieldBounds)
+{
+    if (aParent < 0)
+    {
+        return;
+    }
+
+    TNode& lNode = mNodes[aParent];
+    for (int32_t k = 0; k < 3; k++)
+    {
+        lNode.mMin[k][aSlot] = aBounds.mMin[k];
+        lNode.mMax[k][aSlot] = aBounds.mMax[k];
+        lNode.mFieldMin[k][aSlot] = aFieldBounds.mMin[k];
+        lNode.mFieldMax[k][aSlot] = aFieldBounds.mMax[k];
+    }
+}
+
+void CStrokeBvh::GetLeafBounds(uint32_t aLeaf, TAabb& aOutBounds, TAabb& aOutFieldBounds) const
+{
+    aOutBounds.Reset();
+    aOutFieldBounds.Reset();
+    for (uint32_t lBox : mLeaves[aLeaf].mBoxes)
+    {
+        if (lBox != kEmptyBox)
+        {
+            aOutBounds.Extend(mBoxes[lBox].mBounds);
+            aOutFieldBounds.Extend(mBoxes[lBox].mFieldBounds);
+        }
+    }
+}
+
+void CStrokeBvh::Refit(int32_t aChild)
+{
+    SBX_ASSERT(aChild < 0, "Refits start from a leaf");
+
+    TLeaf const& lLeaf = mLeaves[~aChild];
+    TAabb lBounds;
+    TAabb lFieldBounds;
+    GetLeafBounds(~aChild, lBounds, lFieldBounds);
+    int32_t lParent = lLeaf.mParent;
+    uint32_t lSlot = lLeaf.mParentSlot;
+    while (lParent >= 0)
+    {
+        SetChildBounds(lParent, lSlot, lBounds, lFieldBounds);
+
+        TNode const& lNode = mNodes[lParent];
+        lBounds.Reset();
+        lFieldBounds.Reset();
+        for (uint32_t c = 0; c < kWidth; c++)
+        {
+            if (lNode.mChildren[c] != kEmptyChild)
+            {
+                lBounds.Extend(TAabb(glm::vec3(lNode.mMin[0][c], lNode.mMin[1][c], lNode.mMin[2][c]), glm::vec3(lNode.mMax[0][c], lNode.mMax[1][c], lNode.mMax[2][c])));
+                lFieldBounds.Extend(TAabb(glm::vec3(lNode.mFieldMin[0][c], lNode.mFieldMin[1][c], lNode.mFieldMin[2][c]), glm::vec3(lNode.mFieldMax[0][c], lNode.mFieldMax[1][c], lNode.mFieldMax[2][c])));
+            }
+        }
+        lSlot = lNode.mParentSlot;
+        lParent = lNode.mParent;
+    }
+}
+
+void CStrokeBvh::UpdateUnbounded(uint32_t aStroke, stroke_t const& aData)
+{
+    const bool lUnbounded = (aData.id.y & EStrokeOp::OpsMaskMode) == EStrokeOp::OpIntersect;
+    auto lIt = std::lower_bound(mUnboundedStrokes.begin(), mUnboundedStrokes.end(), aStroke);
+    const bool lListed = (lIt != mUnboundedStrokes.end()) && (*lIt == aStroke);
+    if (lUnbounded && !lListed)
+    {
+        mUnboundedStrokes.insert(lIt, aStroke);
+    }
+    else if (!lUnbounded && lListed)
+    {
+        mUnboundedStrokes.erase(lIt);
+    }
+}
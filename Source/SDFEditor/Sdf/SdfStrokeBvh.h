@@ -0,0 +1,120 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Ray picking of the strokes through a BVH of their oriented bounds
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SDFEditor/Tool/StrokeInfo.h>
+#include <SDFEditor/Math/Aabb.h>
+
+class CStrokeBoundsCache;
+
+// 4 wide BVH over the oriented boxes of the stroke primitives, one per
+// mirrored copy, the same boxes the picking always tested. Nodes keep the
+// bounds of their 4 children and leaves their 4 oriented boxes in SoA, a ray
+// tests each group at once with SIMD.
+// Each box also has a field version padded with the blend margin of the
+// stroke, the region where it can change the surface, nodes bound both.
+// Update only refits the leaves of the strokes the bounds cache recomputed
+// and their ancestors. Adding or removing strokes, or changing their mirrors,
+// rebuilds it, and so does refitting many strokes since the last build: the
+// nodes grow loose as the strokes move away from where they were built.
+class CStrokeBvh
+{
+public:
+    static constexpr uint32_t kWidth = 4;
+
+    // Call after aBounds.Update, with the strokes it just recomputed
+    void Update(CStrokeBoundsCache const& aBounds);
+
+    // Nearest stroke whose box the unit length ray crosses, -1 if none. The
+    // distance is 0 when the ray starts inside. Ties go to the lower index
+    int32_t Raycast(glm::vec3 const& aOrigin, glm::vec3 const& aDirection, float* aOutDistance = nullptr) const;
+
+    struct TRayHit
+    {
+        int32_t mStroke;
+        float mEnter;
+        float mExit;
+    };
+
+    // Every field box the unit length ray crosses, one hit per mirrored copy, unordered
+    void RaycastField(glm::vec3 const& aOrigin, glm::vec3 const& aDirection, std::vector<TRayHit>& aOutHits) const;
+
+    // Intersection strokes carve the scene outside their bounds too, in index order
+    std::vector<uint32_t> const& GetUnboundedStrokes() const { return mUnboundedStrokes; }
+
+    size_t GetBoxesCount() const { return mBoxes.size(); }
+    size_t GetNodesCount() const { return mNodes.size(); }
+    uint32_t GetBuildsCount() const { return mBuildsCount; }
+
+    void Clear();
+
+private:
+    // Oriented box: local [mMin, mMax] around mPosition along mAxes
+    struct TBox
+    {
+        glm::vec3 mPosition;
+        glm::vec3 mAxes[3];
+        glm::vec3 mMin;
+        glm::vec3 mMax;
+        glm::vec3 mFieldMin;
+        glm::vec3 mFieldMax;
+        TAabb mBounds;
+        TAabb mFieldBounds;
+        int32_t mStroke;
+        uint32_t mLeafLane;     // leaf * kWidth + lane
+    };
+
+    // Child references are node indices, or ~leaf index when negative
+    struct TNode
+    {
+        alignas(16) float mMin[3][kWidth];
+        alignas(16) float mMax[3][kWidth];
+        alignas(16) float mFieldMin[3][kWidth];
+        alignas(16) float mFieldMax[3][kWidth];
+        int32_t mChildren[kWidth];
+        int32_t mParent;
+        uint32_t mParentSlot;
+    };
+
+    struct TLeaf
+    {
+        alignas(16) float mPosition[3][kWidth];
+        alignas(16) float mAxes[9][kWidth];     // axis * 3 + component
+        alignas(16) float mMin[3][kWidth];
+        alignas(16) float mMax[3][kWidth];
+        alignas(16) float mFieldMin[3][kWidth];
+        alignas(16) float mFieldMax[3][kWidth];
+        int32_t mStrokes[kWidth];               // -1 on the empty lanes
+        uint32_t mBoxes[kWidth];
+        int32_t mParent;
+        uint32_t mParentSlot;
+    };
+
+    // SIMD copy of the ray, defined with the vector type in the source
+    struct TRay;
+
+    void IntersectNode(TNode const& aNode, TRay const& aRay, bool aFieldBoxes, float* aOutEnter, float* aOutExit) const;
+    void IntersectLeaf(TLeaf const& aLeaf, TRay const& aRay, bool aFieldBoxes, float* aOutEnter, float* aOutExit) const;
+
+    void Build(CStrokeBoundsCache const& aBounds);
+    int32_t BuildRange(std::vector<uint32_t>& aOrder, uint32_t aBegin, uint32_t aEnd, int32_t aParent, uint32_t aParentSlot);
+    void ComputeBox(CStrokeBoundsCache const& aBounds, uint32_t aStroke, uint32_t aMirror, TBox& aOutBox) const;
+    void WriteLane(uint32_t aBox);
+    void SetChildBounds(int32_t aParent, uint32_t aSlot, TAabb const& aBounds, TAabb const& aFieldBounds);
+    void GetLeafBounds(uint32_t aLeaf, TAabb& aOutBounds, TAabb& aOutFieldBounds) const;
+    void Refit(int32_t aChild);
+    void UpdateUnbounded(uint32_t aStroke, stroke_t const& aData);
+
+    std::vector<TBox> mBoxes;           // by stroke, then mirror
+    std::vector<uint32_t> mStrokeBoxes; // first box of each stroke, plus the end
+    std::vector<TNode> mNodes;
+    std::vector<TLeaf> mLeaves;
+    std::vector<uint32_t> mUnboundedStrokes;
+    int32_t mRoot{ 0 };
+    size_t mRefitsSinceBuild{ 0 };
+    uint32_t mBuildsCount{ 0 };
+};
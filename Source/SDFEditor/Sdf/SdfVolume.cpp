@@ -0,0 +1,223 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfVolume.h"
+#include "SdfEvaluator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+void CSdfVolume::Init(TSdfBakeParams const& aParams)
+{
+    mParams = aParams;
+    mParams.mCullStrokes = true;
+
+    const int32_t lSize = mParams.mLutSize;
+    const size_t lNumVoxels = mParams.GetLutVoxelsCount();
+
+    // Empty space, as far as the clamped distances go
+    mLut.Init(lSize, lSize, lSize, sbx::ETextureFormat::RGBA8);
+    sbx::TColor8U* lTexels = mLut.AsRGBA8Buffer();
+    const uint8_t lFarDistance = Sdf::FloatToUnorm8(mParams.LutNormDistance(mParams.mCullMargin));
+    for (size_t i = 0; i < lNumVoxels; i++)
+    {
+        lTexels[i].r = lTexels[i].g = lTexels[i].b = 255;
+        lTexels[i].a = lFarDistance;
+    }
+
+    mSlots.Init(mParams.mMaxSlots);
+    mVoxelSlots.assign(lNumVoxels, CSdfSlotAllocator::kInvalidHandle);
+    mSlotVoxels.assign(mParams.mMaxSlots, 0);
+    mBricks.clear();
+    mBrickMoves.clear();
+}
+
+TSdfVolumeBakeStats CSdfVolume::BakeRegion(CSdfEvaluator const& aEvaluator, glm::ivec3 const& aMin, glm::ivec3 const& aMax)
+{
+    const auto lStartTime = std::chrono::steady_clock::now();
+
+    TSdfVolumeBakeStats lStats;
+    lStats.mLut = mLutBaker.EvaluateDistances(aEvaluator, mParams, aMin, aMax);
+
+    const int32_t lSize = mParams.mLutSize;
+    const glm::ivec3 lMin = glm::clamp(aMin, glm::ivec3(0), glm::ivec3(lSize));
+    const glm::ivec3 lMax = glm::clamp(aMax, lMin, glm::ivec3(lSize));
+    const float lBand = mParams.GetSurfaceBand();
+    std::vector<float> const& lDistances = mLutBaker.GetDistances();
+    sbx::TColor8U* lTexels = mLut.AsRGBA8Buffer();
+
+    // Serial so the free list order, and the resulting slots, are deterministic
+    mBricks.clear();
+    for (int32_t z = lMin.z; z < lMax.z; z++)
+    {
+        for (int32_t y = lMin.y; y < lMax.y; y++)
+        {
+            for (int32_t x = lMin.x; x < lMax.x; x++)
+            {
+                const size_t lVoxel = (size_t(z) * lSize + y) * lSize + x;
+                const float lDist = lDistances[lVoxel];
+                uint32_t& lHandle = mVoxelSlots[lVoxel];
+
+                lTexels[lVoxel].a = Sdf::FloatToUnorm8(mParams.LutNormDistance(lDist));
+
+                if (glm::abs(lDist) >= lBand)
+                {
+                    if (lHandle != CSdfSlotAllocator::kInvalidHandle)
+                    {
+                        mSlots.Release(lHandle);
+                        lHandle = CSdfSlotAllocator::kInvalidHandle;
+                        lStats.mReleasedSlots++;
+                    }
+                    WriteTexelSlot(lVoxel, lHandle);
+                    continue;
+                }
+
+                if (lHandle == CSdfSlotAllocator::kInvalidHandle)
+                {
+                    lHandle = mSlots.Allocate();
+                    if (lHandle == CSdfSlotAllocator::kInvalidHandle)
+                    {
+                        lStats.mOverflowSlots++;
+                        WriteTexelSlot(lVoxel, lHandle);
+                        continue;
+                    }
+
+                    mSlotVoxels[CSdfSlotAllocator::GetIndex(lHandle)] = uint32_t(lVoxel);
+                    lStats.mAllocatedSlots++;
+                }
+
+                // The voxel keeps its slot, the brick is baked again with the new distances
+                WriteTexelSlot(lVoxel, lHandle);
+                mBricks.push_back({ CSdfSlotAllocator::GetIndex(lHandle), Sdf::CoordToIndex(glm::ivec3(x, y, z)) });
+            }
+        }
+    }
+
+    lStats.mBricks = uint32_t(mBricks.size());
+    lStats.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStartTime).count();
+    return lStats;
+}
+
+uint32_t CSdfVolume::Compact()
+{
+    mSlots.Compact(mSlotMoves);
+
+    mBrickMoves.clear();
+    for (CSdfSlotAllocator::TSlotMove const& lMove : mSlotMoves)
+    {
+        const uint32_t lFrom = CSdfSlotAllocator::GetIndex(lMove.mFrom);
+        const uint32_t lTo = CSdfSlotAllocator::GetIndex(lMove.mTo);
+        const uint32_t lVoxel = mSlotVoxels[lFrom];
+
+        mSlotVoxels[lTo] = lVoxel;
+        mVoxelSlots[lVoxel] = lMove.mTo;
+        WriteTexelSlot(lVoxel, lMove.mTo);
+        mBrickMoves.push_back({ lFrom, lTo });
+    }
+
+    return uint32_t(mBrickMoves.size());
+}
+
+void CSdfVolume::ExportCompact(sbx::TTexture& aOutLut, std::vector<uint32_t>& aOutSlots) const
+{
+    const int32_t lSize = mParams.mLutSize;
+    const size_t lNumVoxels = mParams.GetLutVoxelsCount();
+    const uint32_t lHighWatermark = mSlots.GetHighWatermark();
+
+    // New slot of each used slot, same order
+    std::vector<uint32_t> lNewSlots(lHighWatermark, CSdfSlotAllocator::kInvalidHandle);
+    aOutSlots.clear();
+    for (uint32_t i = 0; i < lHighWatermark; i++)
+    {
+        if (mSlots.IsValid(mSlots.GetHandle(i)))
+        {
+            lNewSlots[i] = uint32_t(aOutSlots.size());
+            aOutSlots.push_back(i);
+        }
+    }
+
+    aOutLut.Init(lSize, lSize, lSize, sbx::ETextureFormat::RGBA8);
+    ::memcpy(aOutLut.mBuffer.GetByteArray(), mLut.mBuffer.GetByteArray(), lNumVoxels * sizeof(sbx::TColor8U));
+    sbx::TColor8U* lOutTexels = aOutLut.AsRGBA8Buffer();
+    for (size_t lVoxel = 0; lVoxel < lNumVoxels; lVoxel++)
+    {
+        const uint32_t lHandle = mVoxelSlots[lVoxel];
+        if (lHandle != CSdfSlotAllocator::kInvalidHandle)
+        {
+            const glm::ivec3 lSlotBytes = Sdf::IndexToCoord(lNewSlots[CSdfSlotAllocator::GetIndex(lHandle)]);
+            lOutTexels[lVoxel].r = uint8_t(lSlotBytes.x);
+            lOutTexels[lVoxel].g = uint8_t(lSlotBytes.y);
+            lOutTexels[lVoxel].b = uint8_t(lSlotBytes.z);
+        }
+    }
+}
+
+bool CSdfVolume::Restore(sbx::TTexture const& aLut)
+{
+    const int32_t lSize = mParams.mLutSize;
+    const size_t lNumVoxels = mParams.GetLutVoxelsCount();
+    if (aLut.mWidth != lSize || aLut.mHeight != lSize || aLut.mSlices != lSize || aLut.mFormat != sbx::ETextureFormat::RGBA8)
+    {
+        Init(mParams);
+        return false;
+    }
+
+    // Slot indices must be [0, used) and each one owned by a single voxel
+    const uint32_t lNoSlot = Sdf::CoordToIndex(glm::ivec3(255));
+    sbx::TColor8U const* lTexels = aLut.AsRGBA8Buffer();
+    std::fill(mSlotVoxels.begin(), mSlotVoxels.end(), UINT32_MAX);
+    uint32_t lUsedCount = 0;
+    uint32_t lMaxSlot = 0;
+    for (size_t lVoxel = 0; lVoxel < lNumVoxels; lVoxel++)
+    {
+        const uint32_t lSlot = Sdf::CoordToIndex(glm::ivec3(lTexels[lVoxel].r, lTexels[lVoxel].g, lTexels[lVoxel].b));
+        if (lSlot == lNoSlot)
+        {
+            continue;
+        }
+
+        if (lSlot >= mParams.mMaxSlots || mSlotVoxels[lSlot] != UINT32_MAX)
+        {
+            Init(mParams);
+            return false;
+        }
+
+        mSlotVoxels[lSlot] = uint32_t(lVoxel);
+        lMaxSlot = glm::max(lMaxSlot, lSlot);
+        lUsedCount++;
+    }
+
+    if (lUsedCount > 0 && lMaxSlot >= lUsedCount)
+    {
+        Init(mParams);
+        return false;
+    }
+
+    mSlots.InitCompact(mParams.mMaxSlots, lUsedCount);
+    std::fill(mVoxelSlots.begin(), mVoxelSlots.end(), CSdfSlotAllocator::kInvalidHandle);
+    for (uint32_t i = 0; i < lUsedCount; i++)
+    {
+        mVoxelSlots[mSlotVoxels[i]] = mSlots.GetHandle(i);
+    }
+
+    ::memcpy(mLut.mBuffer.GetByteArray(), aLut.mBuffer.GetByteArray(), lNumVoxels * sizeof(sbx::TColor8U));
+    mBricks.clear();
+    mBrickMoves.clear();
+    return true;
+}
+
+void CSdfVolume::WriteTexelSlot(size_t aVoxel, uint32_t aHandle)
+{
+    // IndexToNormCoord(slot) stored as unorm gives back the slot bytes, 255 for no slot
+    sbx::TColor8U& lTexel = mLut.AsRGBA8Buffer()[aVoxel];
+    if (aHandle == CSdfSlotAllocator::kInvalidHandle)
+    {
+        lTexel.r = lTexel.g = lTexel.b = 255;
+        return;
+    }
+
+    const glm::ivec3 lSlotBytes = Sdf::IndexToCoord(CSdfSlotAllocator::GetIndex(aHandle));
+    lTexel.r = uint8_t(lSlotBytes.x);
+    lTexel.g = uint8_t(lSlotBytes.y);
+    lTexel.b = uint8_t(lSlotBytes.z);
+}
@@ -0,0 +1,88 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// LUT volume kept between bakes, with persistent atlas slots
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <sbx/Texture/Texture.h>
+
+#include <SDFEditor/Sdf/SdfBakeParams.h>
+#include <SDFEditor/Sdf/SdfLutBaker.h>
+#include <SDFEditor/Sdf/SdfSlotAllocator.h>
+
+class CSdfEvaluator;
+
+struct TSdfVolumeBakeStats
+{
+    TSdfLutBakeStats mLut;              // distances of the region
+    uint32_t mBricks{ 0 };              // bricks to bake, surface voxels of the region
+    uint32_t mAllocatedSlots{ 0 };      // voxels that entered the surface band
+    uint32_t mReleasedSlots{ 0 };       // voxels that left it
+    uint32_t mOverflowSlots{ 0 };       // surface voxels left without slot, the atlas is full
+    double mSeconds{ 0.0 };
+};
+
+// The LUT texture and the slot of each surface voxel persist between bakes,
+// rebaking a region only releases the slots of the voxels leaving the surface
+// band and allocates slots for the ones entering it. Needs the stroke culling,
+// distances are exact up to mCullMargin so the region must cover the bounds
+// of the changed strokes padded by it, plus the widest blend margin of the
+// strokes after the first changed one (see CSdfCullGrid).
+class CSdfVolume
+{
+public:
+    struct TBrick
+    {
+        uint32_t mSlot;         // atlas slot index
+        uint32_t mLutIndex;     // CoordToIndex of the LUT voxel
+    };
+
+    struct TBrickMove
+    {
+        uint32_t mFromSlot;
+        uint32_t mToSlot;
+    };
+
+    // Empty LUT, every slot free
+    void Init(TSdfBakeParams const& aParams);
+
+    // Rebakes the LUT voxels in [aMin, aMax), GetBricks() lists the surface voxels of the region
+    TSdfVolumeBakeStats BakeRegion(CSdfEvaluator const& aEvaluator, glm::ivec3 const& aMin, glm::ivec3 const& aMax);
+
+    // Moves the slots to the bottom of the atlas, GetBrickMoves() lists the atlas
+    // bricks to copy and the whole LUT changes. Returns the number of moves.
+    uint32_t Compact();
+
+    // LUT with the slots renumbered in their order, aOutSlots gets the current
+    // slot index of each new one. Leaves the volume untouched, see Restore.
+    void ExportCompact(sbx::TTexture& aOutLut, std::vector<uint32_t>& aOutSlots) const;
+
+    // Replaces the volume with a LUT from ExportCompact, the slots are [0, used)
+    // as after a Compact. Returns false, with an empty volume, when the LUT
+    // doesn't match the params of the last Init.
+    bool Restore(sbx::TTexture const& aLut);
+
+    TSdfBakeParams const& GetParams() const { return mParams; }
+    sbx::TTexture const& GetLut() const { return mLut; }
+    CSdfSlotAllocator const& GetSlotAllocator() const { return mSlots; }
+    std::vector<TBrick> const& GetBricks() const { return mBricks; }
+    std::vector<TBrickMove> const& GetBrickMoves() const { return mBrickMoves; }
+
+    // Slot handle of a LUT voxel, CSdfSlotAllocator::kInvalidHandle out of the surface band
+    uint32_t GetVoxelSlot(size_t aLutIndex) const { return mVoxelSlots[aLutIndex]; }
+
+private:
+    void WriteTexelSlot(size_t aVoxel, uint32_t aHandle);
+
+    TSdfBakeParams mParams;
+    CSdfLutBaker mLutBaker;
+    CSdfSlotAllocator mSlots;
+    sbx::TTexture mLut;
+    std::vector<uint32_t> mVoxelSlots;      // slot handle per LUT voxel
+    std::vector<uint32_t> mSlotVoxels;      // LUT voxel per slot index
+    std::vector<TBrick> mBricks;
+    std::vector<TBrickMove> mBrickMoves;
+    std::vector<CSdfSlotAllocator::TSlotMove> mSlotMoves;
+};
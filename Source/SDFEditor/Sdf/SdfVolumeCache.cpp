@@ -0,0 +1,183 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SdfVolumeCache.h"
+
+#include <sbx/Core/Log.h>
+#include <sbx/Texture/Texture.h>
+#include <sbx/Texture/TextureUtils.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+
+namespace
+{
+    // Bump when the baked data changes for the same strokes, like a change of the bake shaders
+    constexpr uint64_t kCacheVersion = 2;
+
+    constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+    constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+    constexpr const char* kEntryExtension = ".sdfvol";
+
+    // FNV-1a
+    uint64_t HashBytes(uint64_t aHash, const void* aData, size_t aSize)
+    {
+        const uint8_t* lBytes = (const uint8_t*)aData;
+        for (size_t i = 0; i < aSize; i++)
+        {
+            aHash = (aHash ^ lBytes[i]) * kFnvPrime;
+        }
+        return aHash;
+    }
+
+    template <typename T>
+    uint64_t HashValue(uint64_t aHash, T const& aValue)
+    {
+        return HashBytes(aHash, &aValue, sizeof(T));
+    }
+}
+
+bool CSdfVolumeCache::Init(std::string const& aDirectory, size_t aBudget)
+{
+    mDirectory = aDirectory;
+    mBudget = aBudget;
+
+    std::error_code lError;
+    std::filesystem::create_directories(mDirectory, lError);
+    mEnabled = !lError && std::filesystem::is_directory(mDirectory, lError);
+    if (!mEnabled)
+    {
+        SBX_LOG("Volume cache disabled, can't create [%s]", mDirectory.c_str());
+    }
+
+    return mEnabled;
+}
+
+uint64_t CSdfVolumeCache::ComputeKey(std::vector<stroke_t> const& aStrokes, TSdfBakeParams const& aParams)
+{
+    // Field by field, the params struct has padding
+    uint64_t lHash = HashValue(kFnvOffsetBasis, kCacheVersion);
+    lHash = HashValue(lHash, aParams.mLutSize);
+    lHash = HashValue(lHash, aParams.mLutVoxelSide);
+    lHash = HashValue(lHash, aParams.mBrickSize);
+    lHash = HashValue(lHash, aParams.mAtlasSize);
+    lHash = HashValue(lHash, aParams.mMaxSlots);
+    lHash = HashValue(lHash, uint8_t(aParams.mCullStrokes));
+    lHash = HashValue(lHash, aParams.mCullCellVoxels);
+    lHash = HashValue(lHash, aParams.mCullMargin);
+
+    const uint64_t lStrokesCount = aStrokes.size();
+    lHash = HashValue(lHash, lStrokesCount);
+    return HashBytes(lHash, aStrokes.data(), aStrokes.size() * sizeof(stroke_t));
+}
+
+bool CSdfVolumeCache::Contains(uint64_t aKey) const
+{
+    std::error_code lError;
+    return mEnabled && std::filesystem::is_regular_file(GetEntryPath(aKey), lError);
+}
+
+bool CSdfVolumeCache::Load(uint64_t aKey, std::vector<sbx::TTexture>& aOutPack)
+{
+    aOutPack.clear();
+    if (!Contains(aKey))
+    {
+        mStats.mMisses++;
+        return false;
+    }
+
+    const std::string lPath = GetEntryPath(aKey);
+    if (!sbx::texutil::LoadTexturePack(lPath, aOutPack) || aOutPack.size() != ESdfVolumeCachePack::COUNT)
+    {
+        SBX_LOG("Removing invalid volume cache entry [%s]", lPath.c_str());
+        std::error_code lError;
+        std::filesystem::remove(lPath, lError);
+        aOutPack.clear();
+        mStats.mMisses++;
+        return false;
+    }
+
+    // Most recently used
+    std::error_code lError;
+    std::filesystem::last_write_time(lPath, std::filesystem::file_time_type::clock::now(), lError);
+    mStats.mHits++;
+    return true;
+}
+
+bool CSdfVolumeCache::Store(uint64_t aKey, std::vector<sbx::TTexture> const& aPack)
+{
+    if (!mEnabled)
+    {
+        return false;
+    }
+
+    // Written aside and renamed, a reader never sees half an entry
+    const std::string lPath = GetEntryPath(aKey);
+    const std::string lTempPath = lPath + ".tmp";
+    std::error_code lError;
+    if (!sbx::texutil::StoreTexturePack(lTempPath, aPack))
+    {
+        SBX_LOG("Error writing volume cache entry [%s]", lTempPath.c_str());
+        std::filesystem::remove(lTempPath, lError);
+        return false;
+    }
+
+    std::filesystem::rename(lTempPath, lPath, lError);
+    if (lError)
+    {
+        std::filesystem::remove(lTempPath, lError);
+        return false;
+    }
+
+    mStats.mStores++;
+    EvictOverBudget();
+    return true;
+}
+
+std::string CSdfVolumeCache::GetEntryPath(uint64_t aKey) const
+{
+    char lName[32];
+    snprintf(lName, sizeof(lName), "%016" PRIx64, aKey);
+    return (std::filesystem::path(mDirectory) / (std::string(lName) + kEntryExtension)).string();
+}
+
+void CSdfVolumeCache::EvictOverBudget()
+{
+    struct TEntry
+    {
+        std::filesystem::path mPath;
+        std::filesystem::file_time_type mTime;
+        uintmax_t mSize;
+    };
+
+    std::vector<TEntry> lEntries;
+    uintmax_t lTotalSize = 0;
+    std::error_code lError;
+    for (std::filesystem::directory_entry const& lFile : std::filesystem::directory_iterator(mDirectory, lError))
+    {
+        if (lFile.path().extension() != kEntryExtension)
+        {
+            continue;
+        }
+
+        TEntry lEntry{ lFile.path(), lFile.last_write_time(lError), lFile.file_size(lError) };
+        if (!lError)
+        {
+            lTotalSize += lEntry.mSize;
+            lEntries.push_back(lEntry);
+        }
+    }
+
+    // Oldest first, the newest entry stays even over the budget
+    std::sort(lEntries.begin(), lEntries.end(), [](TEntry const& a, TEntry const& b) { return a.mTime < b.mTime; });
+    for (size_t i = 0; (i + 1) < lEntries.size() && lTotalSize > mBudget; i++)
+    {
+        if (std::filesystem::remove(lEntries[i].mPath, lError))
+        {
+            lTotalSize -= lEntries[i].mSize;
+        }
+    }
+}
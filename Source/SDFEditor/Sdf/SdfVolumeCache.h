@@ -0,0 +1,67 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Baked volumes on disk, keyed by the strokes and the bake params
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <SDFEditor/Sdf/SdfBakeParams.h>
+#include <SDFEditor/Tool/StrokeInfo.h>
+
+namespace sbx
+{
+    struct TTexture;
+}
+
+namespace ESdfVolumeCachePack
+{
+    enum Type
+    {
+        LUT,        // RGBA8 LUT from CSdfVolume::ExportCompact
+        BRICKS,     // R8 bricks of the LUT slots in order, mBrickSize slices each
+
+        COUNT
+    };
+};
+
+struct TSdfVolumeCacheStats
+{
+    uint32_t mHits{ 0 };
+    uint32_t mMisses{ 0 };
+    uint32_t mStores{ 0 };
+};
+
+// One texture pack (sbx::texutil::StoreTexturePack) per key in the cache
+// directory. The oldest entries are removed when the directory goes over the
+// budget, loading an entry makes it the newest.
+class CSdfVolumeCache
+{
+public:
+    static constexpr size_t kDefaultBudget = size_t(1024) * 1024 * 1024;
+
+    // Creates the directory, the cache stays disabled if it can't
+    bool Init(std::string const& aDirectory, size_t aBudget = kDefaultBudget);
+    bool IsEnabled() const { return mEnabled; }
+
+    // Hash of the packed strokes and of every param that changes the baked data
+    static uint64_t ComputeKey(std::vector<stroke_t> const& aStrokes, TSdfBakeParams const& aParams);
+
+    bool Contains(uint64_t aKey) const;
+
+    // aOutPack receives ESdfVolumeCachePack::COUNT textures
+    bool Load(uint64_t aKey, std::vector<sbx::TTexture>& aOutPack);
+    bool Store(uint64_t aKey, std::vector<sbx::TTexture> const& aPack);
+
+    TSdfVolumeCacheStats const& GetStats() const { return mStats; }
+
+private:
+    std::string GetEntryPath(uint64_t aKey) const;
+    void EvictOverBudget();
+
+    std::string mDirectory;
+    size_t mBudget{ kDefaultBudget };
+    bool mEnabled{ false };
+    TSdfVolumeCacheStats mStats;
+};
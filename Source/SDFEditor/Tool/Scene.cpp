@@ -1,7 +1,5 @@
 // Copyright (c) 2022 David Gallardo and SDFEditor Project
 
-#pragma once
-
 #include "Scene.h"
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -10,6 +8,14 @@
 #include <glm/gtx/euler_angles.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstring>
+
+namespace
+{
+    // Unchanged strokes between two dirty ones that are uploaded anyway to save a call
+    constexpr uint32_t kMaxPackedRangeGap = 8;
+}
+
 CScene::CScene()
     : mStack(std::make_unique<CSceneStack>(*this))
     , mClipboard(std::make_unique<CSceneClipboard>(*this))
@@ -92,3 +98,55 @@ uint32_t CScene::AddNewStroke(uint32_t aBaseStrokeIndex)
     return mNextStrokeId++;
 }
 
+CStrokeBoundsCache const& CScene::UpdateStrokesBounds()
+{
+    mStrokesBounds.Update(mStrokesArray);
+    mStrokesBvh.Update(mStrokesBounds);
+    return mStrokesBounds;
+}
+
+int32_t CScene::PickStroke(glm::vec3 const& aRayOrigin, glm::vec3 const& aRayDirection)
+{
+    UpdateStrokesBounds();
+
+    const TSdfPickResult lPick = mPicker.Pick(mStrokesBounds, mStrokesBvh, aRayOrigin, aRayDirection);
+    if (lPick.mStroke >= 0)
+    {
+        return lPick.mStroke;
+    }
+
+    return mStrokesBvh.Raycast(aRayOrigin, aRayDirection);
+}
+
+size_t CScene::SyncPackedStrokes()
+{
+    mPackedDirtyRanges.clear();
+
+    const size_t lPrevCount = mPackedStrokes.size();
+    mPackedStrokes.resize(mStrokesArray.size());
+
+    size_t lChangedCount = 0;
+    for (size_t i = 0; i < mStrokesArray.size(); i++)
+    {
+        stroke_t const& lStroke = mStrokesArray[i];
+        if (i < lPrevCount && ::memcmp(&mPackedStrokes[i], &lStroke, sizeof(stroke_t)) == 0)
+        {
+            continue;
+        }
+
+        mPackedStrokes[i] = lStroke;
+        lChangedCount++;
+
+        const uint32_t lIndex = uint32_t(i);
+        if (!mPackedDirtyRanges.empty() && (lIndex - (mPackedDirtyRanges.back().mFirst + mPackedDirtyRanges.back().mCount)) <= kMaxPackedRangeGap)
+        {
+            mPackedDirtyRanges.back().mCount = lIndex + 1 - mPackedDirtyRanges.back().mFirst;
+        }
+        else
+        {
+            mPackedDirtyRanges.push_back({ lIndex, 1 });
+        }
+    }
+
+    return lChangedCount;
+}
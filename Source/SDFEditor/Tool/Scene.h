@@ -13,9 +13,19 @@
 #include <SDFEditor/Tool/SceneDocument.h>
 
 #include <SDFEditor/Tool/Camera.h>
+#include <SDFEditor/Sdf/SdfBounds.h>
+#include <SDFEditor/Sdf/SdfStrokeBvh.h>
+#include <SDFEditor/Sdf/SdfPicking.h>
 
 
 
+// Strokes [mFirst, mFirst + mCount)
+struct TStrokesRange
+{
+    uint32_t mFirst;
+    uint32_t mCount;
+};
+
 class CScene
 {
 public:
@@ -37,6 +47,25 @@ public:
 
     uint32_t AddNewStroke(uint32_t aBaseStrokeIndex = UINT32_MAX);
 
+    // Bounds of mStrokesArray, only the strokes changed since the last call are
+    // recomputed. The picking BVH is refit with them
+    CStrokeBoundsCache const& UpdateStrokesBounds();
+    CStrokeBvh const& GetStrokesBvh() const { return mStrokesBvh; }
+
+    // Stroke that dominates the surface hit by the ray. Without a surface hit
+    // the nearest stroke box it crosses, strokes without visible surface stay
+    // pickable. -1 if none
+    int32_t PickStroke(glm::vec3 const& aRayOrigin, glm::vec3 const& aRayDirection);
+
+    // Copies the stroke_t part of the changed strokes to the packed array, returns the changed count
+    size_t SyncPackedStrokes();
+
+    // Contiguous stroke_t array as it goes to the GPU, without the editor data
+    std::vector<stroke_t> const& GetPackedStrokes() const { return mPackedStrokes; }
+
+    // Ranges changed by the last sync, close ranges are merged to save upload calls
+    std::vector<TStrokesRange> const& GetPackedDirtyRanges() const { return mPackedDirtyRanges; }
+
     // Scene data
     std::vector< TStrokeInfo > mStrokesArray;
     std::vector<uint32_t> mSelectedItems;
@@ -57,5 +86,10 @@ private:
     bool mDirty;
     bool mMaterialDirty;
     uint32_t mNextStrokeId;
+    CStrokeBoundsCache mStrokesBounds;
+    CStrokeBvh mStrokesBvh;
+    CSdfPicker mPicker;
+    std::vector<stroke_t> mPackedStrokes;
+    std::vector<TStrokesRange> mPackedDirtyRanges;
 };
 
@@ -0,0 +1,42 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Binary scene format (.strkb), meant to be mapped and copied straight into the scene
+
+#pragma once
+
+#include <cstdint>
+
+#include <SDFEditor/Tool/StrokeInfo.h>
+
+// Layout, little endian, sections aligned to kSectionAlignment:
+//   TStrkbHeader
+//   stroke_t                   strokes[mStrokesCount]          GPU layout, quaternion included
+//   glm::vec3                  eulerAngles[mStrokesCount]      editor rotation the quaternion comes from
+//   uint32_t                   nameOffsets[mStrokesCount + 1]  name i is strings[nameOffsets[i], nameOffsets[i + 1])
+//   char                       strings[mStringsSize]           names without terminator
+//   TGlobalMaterialBufferData  material
+// Readers accept newer minor versions, they only append fields to the header.
+struct TStrkbHeader
+{
+    static constexpr uint32_t kMagic = 0x424B5453; // "STKB"
+    static constexpr uint16_t kVersionMajor = 1;
+    static constexpr uint16_t kVersionMinor = 0;
+    static constexpr uint64_t kSectionAlignment = 16;
+
+    uint32_t mMagic;
+    uint16_t mVersionMajor;
+    uint16_t mVersionMinor;
+    uint32_t mHeaderSize;
+    uint32_t mStrokeSize;           // sizeof(stroke_t)
+    uint32_t mMaterialSize;         // sizeof(TGlobalMaterialBufferData)
+    uint32_t mStrokesCount;
+
+    uint64_t mStrokesOffset;
+    uint64_t mEulerAnglesOffset;
+    uint64_t mNameOffsetsOffset;
+    uint64_t mStringsOffset;
+    uint64_t mStringsSize;
+    uint64_t mMaterialOffset;
+    uint64_t mFileSize;
+};
+
+static_assert(sizeof(TStrkbHeader) == 80, "TStrkbHeader layout changed, bump kVersionMajor");
@@ -1,10 +1,14 @@
 // Copyright (c) 2022 David Gallardo and SDFEditor Project
 
 #include "SceneDocument.h"
+#include "SceneBinaryFormat.h"
 #include "Scene.h"
 
 #include <SDFEditor/Utils/FileIO.h>
+#include <SDFEditor/Utils/MappedFile.h>
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -53,7 +57,7 @@ namespace
         return sOpNames[aOperation & EStrokeOp::OpsMaskMode];
     }
 
-    int32_t GetOperationCodeByName(std::string& aOperationName)
+    int32_t GetOperationCodeByName(std::string const& aOperationName)
     {
         const auto& lOpPair = sOpMap.find(aOperationName);
         if (lOpPair != sOpMap.end())
@@ -69,7 +73,7 @@ namespace
         return sPrimitiveNames[aPrimitive];
     }
 
-    int32_t GetPrimitiveCodeByName(std::string& aPrimitiveName)
+    int32_t GetPrimitiveCodeByName(std::string const& aPrimitiveName)
     {
         const auto& lPrimitivePair = sPrimitiveMap.find(aPrimitiveName);
         if (lPrimitivePair != sPrimitiveMap.end())
@@ -79,6 +83,345 @@ namespace
 
         return EPrimitive::PrBox;
     }
+
+    namespace ESaxContext
+    {
+        enum Type
+        {
+            Document,
+            Root,
+            Strokes,
+            Stroke,
+            Material,
+            Vector,     // position, rotation, scale or a material color
+            Skip,       // unknown or malformed values
+        };
+    };
+
+    namespace ESaxValue
+    {
+        enum Type
+        {
+            Number,
+            Bool,
+            String,
+            Other,
+        };
+    };
+
+    namespace ESaxKey
+    {
+        enum Type
+        {
+            None,
+            Strokes,
+            Material,
+            Name,
+            Position,
+            Rotation,
+            Scale,
+            Blend,
+            Round,
+            PrimitiveId,
+            Operation,
+            MirrorX,
+            MirrorY,
+            MatSurface,
+            MatFresnel,
+            MatAo,
+            MatBackground,
+            MatPbr,
+            MatLightA,
+            MatLightB,
+
+            Count
+        };
+    };
+
+    static const char* sSaxKeyNames[] =
+    {
+        "",
+        "strokes",
+        "material",
+        "name",
+        "position",
+        "rotation",
+        "scale",
+        "blend",
+        "round",
+        "primitive_id",
+        "operation",
+        "mirror_x",
+        "mirror_y",
+        "mat_surface",
+        "mat_fresnel",
+        "mat_ao",
+        "mat_background",
+        "mat_pbr",
+        "mat_light_a",
+        "mat_light_b",
+    };
+
+    static_assert(sizeof(sSaxKeyNames) / sizeof(sSaxKeyNames[0]) == ESaxKey::Count, "Missing SAX key names");
+
+    // SAX handler for the JSON scenes, fills each stroke straight from the parser
+    // events without building the document. Missing fields keep their defaults,
+    // fields of the wrong type are reported and skipped.
+    class CSceneSaxReader
+    {
+    public:
+        using TJson = nlohmann::json;
+
+        CSceneSaxReader(std::vector< TStrokeInfo >& aOutStrokes, TGlobalMaterialBufferData& aOutMaterial)
+            : mStrokes(aOutStrokes)
+            , mMaterial(aOutMaterial)
+        {
+            mContexts.reserve(8);
+        }
+
+        bool HasStrokes() const { return mHasStrokes; }
+        bool HasMaterial() const { return mHasMaterial; }
+
+        bool null()                                                 { return Scalar(ESaxValue::Other, 0.0, false, nullptr); }
+        bool boolean(bool aValue)                                   { return Scalar(ESaxValue::Bool, 0.0, aValue, nullptr); }
+        bool number_integer(TJson::number_integer_t aValue)         { return Scalar(ESaxValue::Number, double(aValue), false, nullptr); }
+        bool number_unsigned(TJson::number_unsigned_t aValue)       { return Scalar(ESaxValue::Number, double(aValue), false, nullptr); }
+        bool number_float(TJson::number_float_t aValue, const TJson::string_t&) { return Scalar(ESaxValue::Number, double(aValue), false, nullptr); }
+        bool string(TJson::string_t& aValue)                        { return Scalar(ESaxValue::String, 0.0, false, &aValue); }
+        bool binary(TJson::binary_t&)                               { return Scalar(ESaxValue::Other, 0.0, false, nullptr); }
+
+        bool start_object(std::size_t)
+        {
+            const ESaxContext::Type lParent = mContexts.empty() ? ESaxContext::Document : mContexts.back();
+            ESaxContext::Type lContext = ESaxContext::Skip;
+            if (lParent == ESaxContext::Document)
+            {
+                lContext = ESaxContext::Root;
+            }
+            else if (lParent == ESaxContext::Root && mKey == ESaxKey::Material)
+            {
+                lContext = ESaxContext::Material;
+                mHasMaterial = true;
+            }
+            else if (lParent == ESaxContext::Strokes)
+            {
+                lContext = ESaxContext::Stroke;
+                mStroke = TStrokeInfo();
+                mStroke.id.y = 0;
+            }
+            else if ((lParent == ESaxContext::Stroke || lParent == ESaxContext::Material) && mKey != ESaxKey::None)
+            {
+                ReportFieldError("unexpected object");
+            }
+
+            mContexts.push_back(lContext);
+            return true;
+        }
+
+        bool end_object()
+        {
+            if (mContexts.back() == ESaxContext::Stroke)
+            {
+                // The file only has the euler angles
+                mStroke.UpdateRotation();
+                mStrokes.emplace_back(mStroke);
+                mStrokeIndex++;
+            }
+
+            mContexts.pop_back();
+            return true;
+        }
+
+        bool start_array(std::size_t)
+        {
+            const ESaxContext::Type lParent = mContexts.empty() ? ESaxContext::Document : mContexts.back();
+            ESaxContext::Type lContext = ESaxContext::Skip;
+            if (lParent == ESaxContext::Root && mKey == ESaxKey::Strokes)
+            {
+                lContext = ESaxContext::Strokes;
+                mHasStrokes = true;
+                mStrokes.clear();
+                mStrokeIndex = 0;
+            }
+            else if ((lParent == ESaxContext::Stroke && GetStrokeVector(mKey) != nullptr) || (lParent == ESaxContext::Material && GetMaterialVector(mKey) != nullptr))
+            {
+                lContext = ESaxContext::Vector;
+                mVectorSize = 0;
+                mVectorValid = true;
+            }
+            else if ((lParent == ESaxContext::Stroke || lParent == ESaxContext::Material) && mKey != ESaxKey::None)
+            {
+                ReportFieldError("unexpected array");
+            }
+
+            mContexts.push_back(lContext);
+            return true;
+        }
+
+        bool end_array()
+        {
+            const ESaxContext::Type lContext = mContexts.back();
+            mContexts.pop_back();
+
+            if (lContext == ESaxContext::Vector)
+            {
+                // Vector fields are applied whole, or not at all like the DOM loader did
+                const bool lInStroke = (mContexts.back() == ESaxContext::Stroke);
+                const int32_t lExpectedSize = lInStroke ? 3 : 4;
+                if (!mVectorValid || mVectorSize != lExpectedSize)
+                {
+                    ReportFieldError("expected an array of numbers of the field size");
+                }
+                else
+                {
+                    float* lTarget = lInStroke ? GetStrokeVector(mKey) : GetMaterialVector(mKey);
+                    ::memcpy(lTarget, mVector, sizeof(float) * lExpectedSize);
+                }
+            }
+
+            return true;
+        }
+
+        bool key(TJson::string_t& aKey)
+        {
+            mKey = ESaxKey::None;
+            const ESaxContext::Type lContext = mContexts.back();
+            if (lContext != ESaxContext::Root && lContext != ESaxContext::Stroke && lContext != ESaxContext::Material)
+            {
+                return true;
+            }
+
+            for (uint32_t i = ESaxKey::None + 1; i < ESaxKey::Count; i++)
+            {
+                if (::strcmp(aKey.c_str(), sSaxKeyNames[i]) == 0)
+                {
+                    mKey = ESaxKey::Type(i);
+                    break;
+                }
+            }
+            return true;
+        }
+
+        bool parse_error(std::size_t aPosition, const std::string&, const nlohmann::detail::exception& aException)
+        {
+            SBX_ERROR("Error reading file at byte %zu: %s", aPosition, aException.what());
+            return false;
+        }
+
+    private:
+        bool Scalar(ESaxValue::Type aType, double aNumber, bool aBool, TJson::string_t* aString)
+        {
+            const ESaxContext::Type lContext = mContexts.empty() ? ESaxContext::Document : mContexts.back();
+            if (lContext == ESaxContext::Vector)
+            {
+                if (aType == ESaxValue::Number && mVectorSize < 4)
+                {
+                    mVector[mVectorSize] = float(aNumber);
+                }
+                mVectorValid = mVectorValid && (aType == ESaxValue::Number);
+                mVectorSize++;
+            }
+            else if (lContext == ESaxContext::Stroke)
+            {
+                ReadStrokeField(aType, aNumber, aBool, aString);
+            }
+            else if (lContext == ESaxContext::Strokes)
+            {
+                SBX_ERROR("Error reading entry [%u]: not a stroke object", mStrokeIndex);
+                mStrokeIndex++;
+            }
+            else if (lContext == ESaxContext::Material && GetMaterialVector(mKey) != nullptr)
+            {
+                ReportFieldError("expected an array of numbers of the field size");
+            }
+
+            return true;
+        }
+
+        void ReadStrokeField(ESaxValue::Type aType, double aNumber, bool aBool, TJson::string_t* aString)
+        {
+            const bool lExpectedType =
+                ((mKey == ESaxKey::Name || mKey == ESaxKey::PrimitiveId || mKey == ESaxKey::Operation) && aType == ESaxValue::String) ||
+                ((mKey == ESaxKey::Blend || mKey == ESaxKey::Round) && aType == ESaxValue::Number) ||
+                ((mKey == ESaxKey::MirrorX || mKey == ESaxKey::MirrorY) && aType == ESaxValue::Bool);
+
+            if (!lExpectedType)
+            {
+                if (mKey != ESaxKey::None)
+                {
+                    ReportFieldError("unexpected value type");
+                }
+                return;
+            }
+
+            switch (mKey)
+            {
+            case ESaxKey::Name:
+                ::strncpy(mStroke.mName, (aString->length() > 0) ? aString->c_str() : "EmptyName", TStrokeInfo::MAX_NAME_SIZE);
+                mStroke.mName[TStrokeInfo::MAX_NAME_SIZE - 1] = 0;
+                break;
+            case ESaxKey::Blend:        mStroke.posb.w = float(aNumber); break;
+            case ESaxKey::Round:        mStroke.param0.w = float(aNumber); break;
+            case ESaxKey::PrimitiveId:  mStroke.id.x = GetPrimitiveCodeByName(*aString); break;
+            case ESaxKey::Operation:    mStroke.id.y |= GetOperationCodeByName(*aString); break;
+            case ESaxKey::MirrorX:      mStroke.id.y |= aBool ? EStrokeOp::OpMirrorX : 0; break;
+            case ESaxKey::MirrorY:      mStroke.id.y |= aBool ? EStrokeOp::OpMirrorY : 0; break;
+            default: break;
+            }
+        }
+
+        float* GetStrokeVector(ESaxKey::Type aKey)
+        {
+            switch (aKey)
+            {
+            case ESaxKey::Position: return &mStroke.posb.x;
+            case ESaxKey::Rotation: return &mStroke.mEulerAngles.x;
+            case ESaxKey::Scale:    return &mStroke.param0.x;
+            default:                return nullptr;
+            }
+        }
+
+        float* GetMaterialVector(ESaxKey::Type aKey)
+        {
+            switch (aKey)
+            {
+            case ESaxKey::MatSurface:       return &mMaterial.surfaceColor.x;
+            case ESaxKey::MatFresnel:       return &mMaterial.fresnelColor.x;
+            case ESaxKey::MatAo:            return &mMaterial.aoColor.x;
+            case ESaxKey::MatBackground:    return &mMaterial.backgroundColor.x;
+            case ESaxKey::MatPbr:           return &mMaterial.pbr.x;
+            case ESaxKey::MatLightA:        return &mMaterial.lightAColor.x;
+            case ESaxKey::MatLightB:        return &mMaterial.lightBColor.x;
+            default:                        return nullptr;
+            }
+        }
+
+        void ReportFieldError(const char* aReason)
+        {
+            const bool lInStroke = (mContexts.size() > 2) && (mContexts[2] == ESaxContext::Stroke);
+            if (lInStroke)
+            {
+                SBX_ERROR("Error reading entry [%u], field [%s]: %s", mStrokeIndex, sSaxKeyNames[mKey], aReason);
+            }
+            else
+            {
+                SBX_ERROR("Error reading entry material field [%s]: %s", sSaxKeyNames[mKey], aReason);
+            }
+        }
+
+        std::vector< TStrokeInfo >& mStrokes;
+        TGlobalMaterialBufferData& mMaterial;
+
+        std::vector< ESaxContext::Type > mContexts;
+        ESaxKey::Type mKey{ ESaxKey::None };
+        TStrokeInfo mStroke;
+        uint32_t mStrokeIndex{ 0 };
+        float mVector[4];
+        int32_t mVectorSize{ 0 };
+        bool mVectorValid{ false };
+        bool mHasStrokes{ false };
+        bool mHasMaterial{ false };
+    };
 }
 
 CSceneDocument::CSceneDocument(CScene& aScene)
@@ -98,159 +441,301 @@ void CSceneDocument::SetPendingChanges(bool aPendingChanges, bool aForceCallback
     }
 }
 
-void CSceneDocument::Save()
+bool CSceneDocument::IsBinaryFilePath(const std::string& aFilePath)
 {
-    if (HasFilePath())
-    {
-        using namespace nlohmann;
-
-        ordered_json lDoc;
-        lDoc["version"] = 0.1;
-        ordered_json& lDocStrokes = lDoc["strokes"];
+    static const std::string sBinaryExtension = ".strkb";
+    return (aFilePath.length() >= sBinaryExtension.length()) && (aFilePath.compare(aFilePath.length() - sBinaryExtension.length(), sBinaryExtension.length(), sBinaryExtension) == 0);
+}
 
-        for (auto& lStroke : mScene.mStrokesArray)
-        {
-            lDocStrokes.emplace_back();
-            ordered_json& lDocStroke = lDocStrokes.back();
-
-            lDocStroke["type"] = "stroke";
-            lDocStroke["name"] = lStroke.mName;
-            lDocStroke["position"] = ordered_json::array({lStroke.posb.x, lStroke.posb.y, lStroke.posb.z});
-            lDocStroke["rotation"] = ordered_json::array({ lStroke.mEulerAngles.x, lStroke.mEulerAngles.y, lStroke.mEulerAngles.z });
-            lDocStroke["scale"] = ordered_json::array({ lStroke.param0.x, lStroke.param0.y, lStroke.param0.z });
-            lDocStroke["blend"] = lStroke.posb.w;
-            lDocStroke["round"] = lStroke.param0.w;
-            lDocStroke["primitive_id"] = GetPrimitiveNameByCode(lStroke.id.x);
-            lDocStroke["operation"] = GetOperationNameByCode(lStroke.id.y & EStrokeOp::OpsMaskMode);
-            lDocStroke["mirror_x"] = bool(lStroke.id.y & EStrokeOp::OpMirrorX);
-            lDocStroke["mirror_y"] = bool(lStroke.id.y & EStrokeOp::OpMirrorY);
-        }
+bool CSceneDocument::Save()
+{
+    if (!HasFilePath())
+    {
+        return false;
+    }
 
-        //mScene.mGlobalMaterial.surfaceColor
-        ordered_json& lDocMaterial = lDoc["material"];
-
-        lDocMaterial["mat_surface"] = ordered_json::array({ mScene.mGlobalMaterial.surfaceColor.x,
-                                                            mScene.mGlobalMaterial.surfaceColor.y, 
-                                                            mScene.mGlobalMaterial.surfaceColor.z,
-                                                            mScene.mGlobalMaterial.surfaceColor.w });
-
-        lDocMaterial["mat_fresnel"] = ordered_json::array({ mScene.mGlobalMaterial.fresnelColor.x,
-                                                            mScene.mGlobalMaterial.fresnelColor.y,
-                                                            mScene.mGlobalMaterial.fresnelColor.z,
-                                                            mScene.mGlobalMaterial.fresnelColor.w });
-
-        lDocMaterial["mat_ao"] = ordered_json::array({  mScene.mGlobalMaterial.aoColor.x,
-                                                        mScene.mGlobalMaterial.aoColor.y,
-                                                        mScene.mGlobalMaterial.aoColor.z,
-                                                        mScene.mGlobalMaterial.aoColor.w });
-
-        lDocMaterial["mat_background"] = ordered_json::array({  mScene.mGlobalMaterial.backgroundColor.x,
-                                                                mScene.mGlobalMaterial.backgroundColor.y,
-                                                                mScene.mGlobalMaterial.backgroundColor.z,
-                                                                mScene.mGlobalMaterial.backgroundColor.w });
-
-        lDocMaterial["mat_pbr"] = ordered_json::array({ mScene.mGlobalMaterial.pbr.x,
-                                                        mScene.mGlobalMaterial.pbr.y,
-                                                        mScene.mGlobalMaterial.pbr.z,
-                                                        mScene.mGlobalMaterial.pbr.w });
-
-        lDocMaterial["mat_light_a"] = ordered_json::array({ mScene.mGlobalMaterial.lightAColor.x,
-                                                            mScene.mGlobalMaterial.lightAColor.y,
-                                                            mScene.mGlobalMaterial.lightAColor.z,
-                                                            mScene.mGlobalMaterial.lightAColor.w });
-
-        lDocMaterial["mat_light_b"] = ordered_json::array({ mScene.mGlobalMaterial.lightBColor.x,
-                                                            mScene.mGlobalMaterial.lightBColor.y,
-                                                            mScene.mGlobalMaterial.lightBColor.z,
-                                                            mScene.mGlobalMaterial.lightBColor.w });
-
-        //save json
-        std::ofstream lOutputFile(mFilePath);
-        lOutputFile << std::setw(4) << lDoc << std::endl;
+    const bool lSaved = IsBinaryFilePath(mFilePath) ? SaveBinary() : SaveJson();
+    if (lSaved)
+    {
         SetPendingChanges(false, true);
     }
+    return lSaved;
 }
 
-void CSceneDocument::Load()
+bool CSceneDocument::Load()
 {
-    using namespace nlohmann;
-
     if (!HasFilePath())
     {
         SBX_ERROR("Trying to load a document with no file path!");
-        return;
+        return false;
     }
 
-    // read a JSON file
-    std::ifstream lInputFile(mFilePath);
-    json lJsonData;
+    if (!(IsBinaryFilePath(mFilePath) ? LoadBinary() : LoadJson()))
+    {
+        return false;
+    }
+
+    mScene.SetDirty();
+    mScene.SetMaterialDirty();
+    mScene.mStack->Reset();
+    mScene.mStack->PushState(EPushStateFlags::EPE_ALL);
+    SetPendingChanges(false, true);
+    return true;
+}
 
-    try
+bool CSceneDocument::SaveJson()
+{
+    using namespace nlohmann;
+
+    ordered_json lDoc;
+    lDoc["version"] = 0.1;
+    ordered_json& lDocStrokes = lDoc["strokes"];
+
+    for (auto& lStroke : mScene.mStrokesArray)
     {
-        lInputFile >> lJsonData;
+        lDocStrokes.emplace_back();
+        ordered_json& lDocStroke = lDocStrokes.back();
+
+        lDocStroke["type"] = "stroke";
+        lDocStroke["name"] = lStroke.mName;
+        lDocStroke["position"] = ordered_json::array({lStroke.posb.x, lStroke.posb.y, lStroke.posb.z});
+        lDocStroke["rotation"] = ordered_json::array({ lStroke.mEulerAngles.x, lStroke.mEulerAngles.y, lStroke.mEulerAngles.z });
+        lDocStroke["scale"] = ordered_json::array({ lStroke.param0.x, lStroke.param0.y, lStroke.param0.z });
+        lDocStroke["blend"] = lStroke.posb.w;
+        lDocStroke["round"] = lStroke.param0.w;
+        lDocStroke["primitive_id"] = GetPrimitiveNameByCode(lStroke.id.x);
+        lDocStroke["operation"] = GetOperationNameByCode(lStroke.id.y & EStrokeOp::OpsMaskMode);
+        lDocStroke["mirror_x"] = bool(lStroke.id.y & EStrokeOp::OpMirrorX);
+        lDocStroke["mirror_y"] = bool(lStroke.id.y & EStrokeOp::OpMirrorY);
     }
-    catch (detail::exception e)
+
+    //mScene.mGlobalMaterial.surfaceColor
+    ordered_json& lDocMaterial = lDoc["material"];
+
+    lDocMaterial["mat_surface"] = ordered_json::array({ mScene.mGlobalMaterial.surfaceColor.x,
+                                                        mScene.mGlobalMaterial.surfaceColor.y, 
+                                                        mScene.mGlobalMaterial.surfaceColor.z,
+                                                        mScene.mGlobalMaterial.surfaceColor.w });
+
+    lDocMaterial["mat_fresnel"] = ordered_json::array({ mScene.mGlobalMaterial.fresnelColor.x,
+                                                        mScene.mGlobalMaterial.fresnelColor.y,
+                                                        mScene.mGlobalMaterial.fresnelColor.z,
+                                                        mScene.mGlobalMaterial.fresnelColor.w });
+
+    lDocMaterial["mat_ao"] = ordered_json::array({  mScene.mGlobalMaterial.aoColor.x,
+                                                    mScene.mGlobalMaterial.aoColor.y,
+                                                    mScene.mGlobalMaterial.aoColor.z,
+                                                    mScene.mGlobalMaterial.aoColor.w });
+
+    lDocMaterial["mat_background"] = ordered_json::array({  mScene.mGlobalMaterial.backgroundColor.x,
+                                                            mScene.mGlobalMaterial.backgroundColor.y,
+                                                            mScene.mGlobalMaterial.backgroundColor.z,
+                                                            mScene.mGlobalMaterial.backgroundColor.w });
+
+    lDocMaterial["mat_pbr"] = ordered_json::array({ mScene.mGlobalMaterial.pbr.x,
+                                                    mScene.mGlobalMaterial.pbr.y,
+                                                    mScene.mGlobalMaterial.pbr.z,
+                                                    mScene.mGlobalMaterial.pbr.w });
+
+    lDocMaterial["mat_light_a"] = ordered_json::array({ mScene.mGlobalMaterial.lightAColor.x,
+                                                        mScene.mGlobalMaterial.lightAColor.y,
+                                                        mScene.mGlobalMaterial.lightAColor.z,
+                                                        mScene.mGlobalMaterial.lightAColor.w });
+
+    lDocMaterial["mat_light_b"] = ordered_json::array({ mScene.mGlobalMaterial.lightBColor.x,
+                                                        mScene.mGlobalMaterial.lightBColor.y,
+                                                        mScene.mGlobalMaterial.lightBColor.z,
+                                                        mScene.mGlobalMaterial.lightBColor.w });
+
+    //save json
+    std::ofstream lOutputFile(mFilePath);
+    lOutputFile << std::setw(4) << lDoc << std::endl;
+    return lOutputFile.good();
+}
+
+bool CSceneDocument::LoadJson()
+{
+    // Parsed from the mapped file, the reader fills the strokes as they come
+    CMappedFile lFile;
+    if (!lFile.Open(mFilePath))
     {
-        SBX_ERROR("Error reading file [%s]: %s", mFilePath.c_str(), e.what());
+        SBX_ERROR("Error reading file [%s]", mFilePath.c_str());
+        return false;
     }
 
-#   define JSON_STROKE_CHECK(_obj, _field, _exp) try{ if(_obj.find(_field) != _obj.end()){ _exp; } } catch(detail::exception e){ SBX_ERROR("Error reading entry [%u], field [%s]: %s", i, _field, e.what()); }
+    std::vector< TStrokeInfo > lStrokes;
+    TGlobalMaterialBufferData lMaterial = mScene.mGlobalMaterial;
+    CSceneSaxReader lReader(lStrokes, lMaterial);
 
-    auto lStrokesIt = lJsonData.find("strokes");
-    if (lStrokesIt != lJsonData.end() && lStrokesIt->is_array())
+    const char* lText = (const char*)lFile.GetData();
+    if (!nlohmann::json::sax_parse(lText, lText + lFile.GetSize(), &lReader))
     {
-        // json deserialization
-        const json& lJsonStrokes = *lStrokesIt;
+        return false;
+    }
 
-        mScene.mStrokesArray.clear();
+    if (lReader.HasStrokes())
+    {
+        mScene.mStrokesArray.swap(lStrokes);
         mScene.mSelectedItems.clear();
-        mScene.mStrokesArray.reserve(lJsonStrokes.size());
+    }
 
-        for (size_t i = 0, l = lJsonStrokes.size(); i < l; i++ )
-        {
-            const json& lJsonStroke = lJsonStrokes[i];
-
-            TStrokeInfo lStroke;
-
-            JSON_STROKE_CHECK(lJsonStroke, "name", ::strncpy(lStroke.mName, (lJsonStroke["name"].get<std::string>().length() > 0) ? lJsonStroke["name"].get<std::string>().c_str() : "EmptyName", TStrokeInfo::MAX_NAME_SIZE));
-            JSON_STROKE_CHECK(lJsonStroke, "position", ::memcpy(&lStroke.posb, lJsonStroke["position"].get<std::array<float, 3>>().data(), sizeof(float) * 3));
-            JSON_STROKE_CHECK(lJsonStroke, "rotation", ::memcpy(&lStroke.mEulerAngles, lJsonStroke["rotation"].get<std::array<float, 3>>().data(), sizeof(float) * 3));
-            JSON_STROKE_CHECK(lJsonStroke, "scale", ::memcpy(&lStroke.param0, lJsonStroke["scale"].get<std::array<float, 3>>().data(), sizeof(float) * 3));
-            JSON_STROKE_CHECK(lJsonStroke, "blend", lStroke.posb.w = lJsonStroke["blend"].get<float>());
-            JSON_STROKE_CHECK(lJsonStroke, "round", lStroke.param0.w = lJsonStroke["round"].get<float>());
-            JSON_STROKE_CHECK(lJsonStroke, "primitive_id", lStroke.id.x = GetPrimitiveCodeByName(lJsonStroke["primitive_id"].get<std::string>()));
-            lStroke.id.y = 0;
-            JSON_STROKE_CHECK(lJsonStroke, "operation", lStroke.id.y |= GetOperationCodeByName(lJsonStroke["operation"].get<std::string>()));
-            JSON_STROKE_CHECK(lJsonStroke, "mirror_x", lStroke.id.y |= (lJsonStroke["mirror_x"].get<bool>()) ? EStrokeOp::OpMirrorX : 0);
-            JSON_STROKE_CHECK(lJsonStroke, "mirror_y", lStroke.id.y |= (lJsonStroke["mirror_y"].get<bool>()) ? EStrokeOp::OpMirrorY : 0);
-
-            mScene.mStrokesArray.emplace_back(lStroke);
-        }
+    mScene.mGlobalMaterial = lReader.HasMaterial() ? lMaterial : TGlobalMaterialBufferData();
+
+    return true;
+}
+
+bool CSceneDocument::SaveBinary()
+{
+    std::vector< TStrokeInfo > const& lStrokes = mScene.mStrokesArray;
+    const uint32_t lStrokesCount = uint32_t(lStrokes.size());
+
+    // Name table first, its size places the sections after it
+    std::vector<uint32_t> lNameOffsets;
+    std::vector<char> lStrings;
+    lNameOffsets.reserve(lStrokesCount + 1);
+    for (TStrokeInfo const& lStroke : lStrokes)
+    {
+        lNameOffsets.push_back(uint32_t(lStrings.size()));
+        lStrings.insert(lStrings.end(), lStroke.mName, lStroke.mName + ::strnlen(lStroke.mName, TStrokeInfo::MAX_NAME_SIZE));
     }
+    lNameOffsets.push_back(uint32_t(lStrings.size()));
+
+    auto AlignSection = [](uint64_t aOffset) { return (aOffset + TStrkbHeader::kSectionAlignment - 1) & ~(TStrkbHeader::kSectionAlignment - 1); };
+
+    TStrkbHeader lHeader = {};
+    lHeader.mMagic = TStrkbHeader::kMagic;
+    lHeader.mVersionMajor = TStrkbHeader::kVersionMajor;
+    lHeader.mVersionMinor = TStrkbHeader::kVersionMinor;
+    lHeader.mHeaderSize = sizeof(TStrkbHeader);
+    lHeader.mStrokeSize = sizeof(stroke_t);
+    lHeader.mMaterialSize = sizeof(TGlobalMaterialBufferData);
+    lHeader.mStrokesCount = lStrokesCount;
+    lHeader.mStrokesOffset = AlignSection(sizeof(TStrkbHeader));
+    lHeader.mEulerAnglesOffset = AlignSection(lHeader.mStrokesOffset + uint64_t(lStrokesCount) * sizeof(stroke_t));
+    lHeader.mNameOffsetsOffset = AlignSection(lHeader.mEulerAnglesOffset + uint64_t(lStrokesCount) * sizeof(glm::vec3));
+    lHeader.mStringsOffset = AlignSection(lHeader.mNameOffsetsOffset + lNameOffsets.size() * sizeof(uint32_t));
+    lHeader.mStringsSize = lStrings.size();
+    lHeader.mMaterialOffset = AlignSection(lHeader.mStringsOffset + lHeader.mStringsSize);
+    lHeader.mFileSize = lHeader.mMaterialOffset + sizeof(TGlobalMaterialBufferData);
+
+    std::ofstream lOutputFile(mFilePath, std::ios::binary | std::ios::trunc);
+    if (!lOutputFile.is_open())
+    {
+        SBX_ERROR("Unable to write file [%s]", mFilePath.c_str());
+        return false;
+    }
+
+    auto WriteSection = [&lOutputFile](uint64_t aOffset, const void* aData, size_t aSize)
+    {
+        static const char sPadding[TStrkbHeader::kSectionAlignment] = {};
+        lOutputFile.write(sPadding, std::streamsize(aOffset - uint64_t(lOutputFile.tellp())));
+        lOutputFile.write((const char*)aData, std::streamsize(aSize));
+    };
 
-#   define JSON_MAT_CHECK(_obj, _field, _exp) try{ if(_obj.find(_field) != _obj.end()){ _exp; } } catch(detail::exception e){ SBX_ERROR("Error reading entry material field [%s]: %s", _field, e.what()); }
+    lOutputFile.write((const char*)&lHeader, sizeof(TStrkbHeader));
 
-    auto lMatIt = lJsonData.find("material");
-    if (lMatIt != lJsonData.end() && lMatIt->is_object())
+    // Strokes and rotations are written as they lay in the editor, one stroke at a time
+    WriteSection(lHeader.mStrokesOffset, nullptr, 0);
+    for (TStrokeInfo const& lStroke : lStrokes)
     {
-        json& lMatJson = *lMatIt;
-        auto& lMat = mScene.mGlobalMaterial;
-        JSON_MAT_CHECK(lMatJson, "mat_surface", ::memcpy(&lMat.surfaceColor, lMatJson["mat_surface"].get<std::array<float, 4>>().data(), sizeof(float) * 4));
-        JSON_MAT_CHECK(lMatJson, "mat_fresnel", ::memcpy(&lMat.fresnelColor, lMatJson["mat_fresnel"].get<std::array<float, 4>>().data(), sizeof(float) * 4));
-        JSON_MAT_CHECK(lMatJson, "mat_ao",      ::memcpy(&lMat.aoColor, lMatJson["mat_ao"].get<std::array<float, 4>>().data(), sizeof(float) * 4));
-        JSON_MAT_CHECK(lMatJson, "mat_background", ::memcpy(&lMat.backgroundColor, lMatJson["mat_background"].get<std::array<float, 4>>().data(), sizeof(float) * 4));
-        JSON_MAT_CHECK(lMatJson, "mat_pbr", ::memcpy(&lMat.pbr, lMatJson["mat_pbr"].get<std::array<float, 4>>().data(), sizeof(float) * 4));
-        JSON_MAT_CHECK(lMatJson, "mat_light_a", ::memcpy(&lMat.lightAColor, lMatJson["mat_light_a"].get<std::array<float, 4>>().data(), sizeof(float) * 4));
-        JSON_MAT_CHECK(lMatJson, "mat_light_b", ::memcpy(&lMat.lightBColor, lMatJson["mat_light_b"].get<std::array<float, 4>>().data(), sizeof(float) * 4));
+        lOutputFile.write((const char*)static_cast<stroke_t const*>(&lStroke), sizeof(stroke_t));
     }
-    else
+    WriteSection(lHeader.mEulerAnglesOffset, nullptr, 0);
+    for (TStrokeInfo const& lStroke : lStrokes)
     {
-        mScene.mGlobalMaterial = TGlobalMaterialBufferData();
+        lOutputFile.write((const char*)&lStroke.mEulerAngles, sizeof(glm::vec3));
     }
 
-    mScene.SetDirty();
-    mScene.SetMaterialDirty();
-    mScene.mStack->Reset();
-    mScene.mStack->PushState(EPushStateFlags::EPE_ALL);
-    SetPendingChanges(false, true);
+    WriteSection(lHeader.mNameOffsetsOffset, lNameOffsets.data(), lNameOffsets.size() * sizeof(uint32_t));
+    WriteSection(lHeader.mStringsOffset, lStrings.data(), lStrings.size());
+    WriteSection(lHeader.mMaterialOffset, &mScene.mGlobalMaterial, sizeof(TGlobalMaterialBufferData));
+
+    return lOutputFile.good();
+}
+
+bool CSceneDocument::LoadBinary()
+{
+    CMappedFile lFile;
+    if (!lFile.Open(mFilePath))
+    {
+        SBX_ERROR("Error reading file [%s]", mFilePath.c_str());
+        return false;
+    }
+
+    const uint8_t* lData = lFile.GetData();
+    const uint64_t lFileSize = lFile.GetSize();
+
+    TStrkbHeader lHeader = {};
+    if (lFileSize >= sizeof(TStrkbHeader))
+    {
+        ::memcpy(&lHeader, lData, sizeof(TStrkbHeader));
+    }
+
+    if (lHeader.mMagic != TStrkbHeader::kMagic || lHeader.mVersionMajor != TStrkbHeader::kVersionMajor || lHeader.mHeaderSize < sizeof(TStrkbHeader))
+    {
+        SBX_ERROR("File [%s] is not a supported strokes binary (version %u.%u)", mFilePath.c_str(), lHeader.mVersionMajor, lHeader.mVersionMinor);
+        return false;
+    }
+
+    // Every section inside the file before touching the scene
+    const uint64_t lStrokesCount = lHeader.mStrokesCount;
+    auto SectionFits = [lFileSize](uint64_t aOffset, uint64_t aSize) { return (aOffset <= lFileSize) && (aSize <= lFileSize - aOffset); };
+    bool lValid = (lHeader.mStrokeSize == sizeof(stroke_t)) && (lHeader.mMaterialSize == sizeof(TGlobalMaterialBufferData)) && (lHeader.mFileSize == lFileSize);
+
+    // Bounded by the file before the section sizes are computed, they can't overflow then
+    lValid = lValid && (lStrokesCount <= lFileSize / sizeof(stroke_t));
+    lValid = lValid && SectionFits(lHeader.mStrokesOffset, lStrokesCount * sizeof(stroke_t));
+    lValid = lValid && SectionFits(lHeader.mEulerAnglesOffset, lStrokesCount * sizeof(glm::vec3));
+    lValid = lValid && SectionFits(lHeader.mNameOffsetsOffset, (lStrokesCount + 1) * sizeof(uint32_t));
+    lValid = lValid && SectionFits(lHeader.mStringsOffset, lHeader.mStringsSize);
+    lValid = lValid && SectionFits(lHeader.mMaterialOffset, sizeof(TGlobalMaterialBufferData));
+    if (!lValid)
+    {
+        SBX_ERROR("File [%s] is truncated or corrupted", mFilePath.c_str());
+        return false;
+    }
+
+    const uint8_t* lNameOffsets = lData + lHeader.mNameOffsetsOffset;
+    const char* lStrings = (const char*)(lData + lHeader.mStringsOffset);
+
+    mScene.mStrokesArray.clear();
+    mScene.mSelectedItems.clear();
+    mScene.mStrokesArray.resize(size_t(lStrokesCount));
+
+    // One copy from the mapping, the quaternions come with the strokes
+    for (size_t i = 0; i < lStrokesCount; i++)
+    {
+        TStrokeInfo& lStroke = mScene.mStrokesArray[i];
+        ::memcpy(static_cast<stroke_t*>(&lStroke), lData + lHeader.mStrokesOffset + i * sizeof(stroke_t), sizeof(stroke_t));
+        ::memcpy(&lStroke.mEulerAngles, lData + lHeader.mEulerAnglesOffset + i * sizeof(glm::vec3), sizeof(glm::vec3));
+
+        // Same fallbacks as the JSON loader for what it couldn't name
+        if (lStroke.id.x < 0 || lStroke.id.x >= EPrimitive::PrCount)
+        {
+            SBX_ERROR("Error reading entry [%zu], field [primitive_id]: unknown primitive %d", i, lStroke.id.x);
+            lStroke.id.x = EPrimitive::PrBox;
+        }
+
+        if ((lStroke.id.y & ~EStrokeOp::OpsMaskAll) != 0)
+        {
+            SBX_ERROR("Error reading entry [%zu], field [operation]: unknown bits 0x%x", i, uint32_t(lStroke.id.y));
+            lStroke.id.y &= EStrokeOp::OpsMaskAll;
+        }
+
+        uint32_t lNameRange[2];
+        ::memcpy(lNameRange, lNameOffsets + i * sizeof(uint32_t), sizeof(lNameRange));
+        if (lNameRange[0] > lNameRange[1] || lNameRange[1] > lHeader.mStringsSize)
+        {
+            SBX_ERROR("Error reading entry [%zu], field [name]: out of the string table", i);
+            continue;
+        }
+
+        const size_t lNameLength = std::min(size_t(lNameRange[1] - lNameRange[0]), size_t(TStrokeInfo::MAX_NAME_SIZE - 1));
+        ::memcpy(lStroke.mName, lStrings + lNameRange[0], lNameLength);
+        lStroke.mName[lNameLength] = 0;
+    }
+
+    ::memcpy(&mScene.mGlobalMaterial, lData + lHeader.mMaterialOffset, sizeof(TGlobalMaterialBufferData));
+
+    return true;
 }
@@ -24,9 +24,17 @@ public:
 
     void SetDocStateChangeCallback(TDocStateChangeCallback aCallback) { mDocStateChangeCallback = aCallback; }
 
-    void Save();
-    void Load();
+    // The format follows the extension, .strkb is binary and anything else JSON
+    bool Save();
+    bool Load();
+
+    static bool IsBinaryFilePath(const std::string& aFilePath);
+
 private:
+    bool SaveJson();
+    bool LoadJson();
+    bool SaveBinary();
+    bool LoadBinary();
 
     CScene& mScene;
 
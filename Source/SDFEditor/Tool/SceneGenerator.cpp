@@ -0,0 +1,184 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "SceneGenerator.h"
+#include "Scene.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const char* sLayoutNames[ESceneLayout::COUNT] =
+    {
+        "uniform",
+        "clustered",
+        "overlapping",
+        "subtract_chain",
+    };
+
+    const int32_t sGeneratorOpCodes[ESceneGeneratorOp::COUNT] =
+    {
+        EStrokeOp::OpAdd,
+        EStrokeOp::OpSubtract,
+        EStrokeOp::OpIntersect,
+    };
+
+    // mt19937 is defined bit for bit by the standard, the distributions aren't
+    class CRandom
+    {
+    public:
+        CRandom(uint32_t aSeed) : mEngine(aSeed) {}
+
+        // [0, 1)
+        float Float() { return float(mEngine() >> 8) * (1.0f / 16777216.0f); }
+        float Range(float aMin, float aMax) { return aMin + (aMax - aMin) * Float(); }
+        glm::vec3 Vec3(float aMin, float aMax) { return glm::vec3(Range(aMin, aMax), Range(aMin, aMax), Range(aMin, aMax)); }
+
+        // About normal, sum of three uniforms, [-1.5, 1.5)
+        glm::vec3 Spread()
+        {
+            return Vec3(-0.5f, 0.5f) + Vec3(-0.5f, 0.5f) + Vec3(-0.5f, 0.5f);
+        }
+
+        uint32_t Pick(const float* aWeights, uint32_t aCount)
+        {
+            float lTotal = 0.0f;
+            for (uint32_t i = 0; i < aCount; i++)
+            {
+                lTotal += glm::max(aWeights[i], 0.0f);
+            }
+
+            float lValue = Float() * lTotal;
+            for (uint32_t i = 0; i < aCount; i++)
+            {
+                const float lWeight = glm::max(aWeights[i], 0.0f);
+                if (lValue < lWeight)
+                {
+                    return i;
+                }
+                lValue -= lWeight;
+            }
+
+            // All zero, or the rounding of the last one
+            for (uint32_t i = aCount; i > 0; i--)
+            {
+                if (aWeights[i - 1] > 0.0f)
+                {
+                    return i - 1;
+                }
+            }
+            return 0;
+        }
+
+    private:
+        std::mt19937 mEngine;
+    };
+}
+
+void CSceneGenerator::Generate(TSceneGeneratorParams const& aParams, CScene& aScene)
+{
+    CRandom lRandom(aParams.mSeed);
+    const uint32_t lCount = aParams.mStrokesCount;
+
+    // Same filled fraction of the region for any count
+    float lSizeMin = aParams.mSizeMin;
+    float lSizeMax = aParams.mSizeMax;
+    if (lSizeMin <= 0.0f || lSizeMax <= 0.0f)
+    {
+        const float lSize = glm::clamp(aParams.mExtent * 0.5f / std::cbrt(float(glm::max(lCount, 1u))), 0.02f, 0.5f);
+        lSizeMin = lSize * 0.5f;
+        lSizeMax = lSize * 1.5f;
+    }
+    lSizeMax = glm::max(lSizeMin, lSizeMax);
+
+    std::vector<glm::vec3> lClusters(glm::max(aParams.mClustersCount, 1u));
+    for (glm::vec3& lCenter : lClusters)
+    {
+        lCenter = lRandom.Vec3(-aParams.mExtent, aParams.mExtent) * 0.7f;
+    }
+    const glm::vec3 lSpot = lRandom.Vec3(-aParams.mExtent, aParams.mExtent) * 0.2f;
+    const uint32_t lChainLength = glm::max(aParams.mChainLength, 2u);
+    glm::vec3 lChainPos(0.0f);
+
+    aScene.mStrokesArray.clear();
+    aScene.mStrokesArray.reserve(lCount);
+    aScene.mSelectedItems.clear();
+    for (uint32_t i = 0; i < lCount; i++)
+    {
+        stroke_t lStroke;
+        const glm::vec3 lSize = lRandom.Vec3(lSizeMin, lSizeMax);
+        lStroke.param0 = glm::vec4(lSize, 0.0f);
+        lStroke.id.x = int32_t(lRandom.Pick(aParams.mPrimitiveWeights, EPrimitive::PrCount));
+        int32_t lOp = sGeneratorOpCodes[lRandom.Pick(aParams.mOpWeights, ESceneGeneratorOp::COUNT)];
+
+        glm::vec3 lPos(0.0f);
+        switch (aParams.mLayout)
+        {
+        case ESceneLayout::CLUSTERED:
+            lPos = lClusters[uint32_t(lRandom.Float() * float(lClusters.size())) % lClusters.size()] + lRandom.Spread() * aParams.mClusterRadius;
+            break;
+        case ESceneLayout::OVERLAPPING:
+            lPos = lSpot + lRandom.Vec3(-0.1f, 0.1f) * lSizeMin;
+            break;
+        case ESceneLayout::SUBTRACT_CHAIN:
+            // Each link half a stroke away from the previous one, chains restart at random spots
+            if ((i % lChainLength) == 0)
+            {
+                lChainPos = lRandom.Vec3(-aParams.mExtent, aParams.mExtent) * 0.8f;
+                lStroke.param0 = glm::vec4(glm::vec3(lSizeMax * 2.0f), 0.0f);
+                lOp = EStrokeOp::OpAdd;
+            }
+            else
+            {
+                lChainPos += glm::normalize(lRandom.Vec3(-1.0f, 1.0f) + glm::vec3(1e-3f)) * lSizeMin * 0.5f;
+                lOp = EStrokeOp::OpSubtract;
+            }
+            lPos = lChainPos;
+            break;
+        default:
+            lPos = lRandom.Vec3(-aParams.mExtent, aParams.mExtent);
+            break;
+        }
+
+        lPos = glm::clamp(lPos, -aParams.mExtent, aParams.mExtent);
+        lStroke.posb = glm::vec4(lPos, lRandom.Range(aParams.mBlendMin, glm::max(aParams.mBlendMin, aParams.mBlendMax)));
+
+        if (lRandom.Float() < aParams.mMirrorChance)
+        {
+            lOp |= EStrokeOp::OpMirrorX;
+        }
+        if (lRandom.Float() < aParams.mMirrorChance)
+        {
+            lOp |= EStrokeOp::OpMirrorY;
+        }
+        lStroke.id.y = lOp;
+
+        char lName[TStrokeInfo::MAX_NAME_SIZE];
+        ::snprintf(lName, sizeof(lName), "Stroke_%u", i);
+        aScene.mStrokesArray.emplace_back(lStroke, lRandom.Vec3(-180.0f, 180.0f), lName);
+    }
+
+    aScene.mStack->Reset();
+    aScene.mStack->PushState(EPushStateFlags::EPE_ALL);
+    aScene.SetDirty();
+}
+
+const char* CSceneGenerator::GetLayoutName(ESceneLayout::Type aLayout)
+{
+    return (aLayout < ESceneLayout::COUNT) ? sLayoutNames[aLayout] : "";
+}
+
+bool CSceneGenerator::GetLayoutByName(std::string const& aName, ESceneLayout::Type& aOutLayout)
+{
+    for (int32_t i = 0; i < ESceneLayout::COUNT; i++)
+    {
+        if (aName == sLayoutNames[i])
+        {
+            aOutLayout = ESceneLayout::Type(i);
+            return true;
+        }
+    }
+    return false;
+}
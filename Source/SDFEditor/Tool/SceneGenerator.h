@@ -0,0 +1,70 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Seeded synthetic scenes for scaling and stress tests
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <SDFEditor/Tool/StrokeInfo.h>
+
+class CScene;
+
+namespace ESceneLayout
+{
+    enum Type
+    {
+        UNIFORM,            // spread over the whole region
+        CLUSTERED,          // around mClustersCount centers
+        OVERLAPPING,        // every stroke on the same spot, the worst case of the culling
+        SUBTRACT_CHAIN,     // an add followed by mChainLength - 1 subtracts, each one over the previous
+
+        COUNT
+    };
+};
+
+namespace ESceneGeneratorOp
+{
+    enum Type
+    {
+        ADD,
+        SUBTRACT,
+        INTERSECT,
+
+        COUNT
+    };
+};
+
+struct TSceneGeneratorParams
+{
+    uint32_t mSeed{ 1 };
+    uint32_t mStrokesCount{ 1000 };
+    ESceneLayout::Type mLayout{ ESceneLayout::UNIFORM };
+
+    // Relative weights, the chance of each one is its share of the sum
+    float mPrimitiveWeights[EPrimitive::PrCount]{ 1.0f, 1.0f, 1.0f, 1.0f };
+    float mOpWeights[ESceneGeneratorOp::COUNT]{ 0.8f, 0.2f, 0.0f };
+    float mMirrorChance{ 0.0f };            // chance of OpMirrorX, and the same of OpMirrorY
+
+    float mBlendMin{ 0.0f };                // blend radius range
+    float mBlendMax{ 0.05f };
+    float mSizeMin{ 0.0f };                 // size range, 0 fits it to the strokes count
+    float mSizeMax{ 0.0f };
+    float mExtent{ 2.5f };                  // half side of the region around the origin
+
+    uint32_t mClustersCount{ 8 };           // CLUSTERED
+    float mClusterRadius{ 0.5f };
+    uint32_t mChainLength{ 64 };            // SUBTRACT_CHAIN
+};
+
+// Same params and seed give the same strokes on every platform, the random
+// numbers don't go through the std distributions
+class CSceneGenerator
+{
+public:
+    // Replaces the strokes of aScene, the history restarts from the new strokes
+    static void Generate(TSceneGeneratorParams const& aParams, CScene& aScene);
+
+    static const char* GetLayoutName(ESceneLayout::Type aLayout);
+    static bool GetLayoutByName(std::string const& aName, ESceneLayout::Type& aOutLayout);
+};
@@ -5,85 +5,246 @@
 
 #include <sbx/Core/Log.h>
 
-constexpr size_t kMaxStackElements = 20;
-
-TStoredSceneState::TStoredSceneState(TPushStateFlags aFlags)
-    : mFlags(aFlags)
-    , mStrokesArray(nullptr)
-    , mSelectedItems(nullptr)
-    , mGlobalMaterial(nullptr)
+#include <algorithm>
+#include <cstring>
 
+namespace
 {
+    // Field by field, the padding of TStrokeInfo is not copied
+    bool StrokesEqual(TStrokeInfo const& aA, TStrokeInfo const& aB)
+    {
+        return (::memcmp(static_cast<stroke_t const*>(&aA), static_cast<stroke_t const*>(&aB), sizeof(stroke_t)) == 0)
+            && (aA.mEulerAngles == aB.mEulerAngles)
+            && (::memcmp(aA.mName, aB.mName, TStrokeInfo::MAX_NAME_SIZE) == 0);
+    }
+
+    // Fills aOutEntry so applying it to aAfter gives back aBefore
+    void DiffStrokes(std::vector< TStrokeInfo > const& aBefore, std::vector< TStrokeInfo > const& aAfter, TSceneStackEntry& aOutEntry)
+    {
+        aOutEntry.mSpans.clear();
+        aOutEntry.mStrokes.clear();
+
+        const size_t lMinCount = std::min(aBefore.size(), aAfter.size());
+        size_t lPrefix = 0;
+        while (lPrefix < lMinCount && StrokesEqual(aBefore[lPrefix], aAfter[lPrefix]))
+        {
+            lPrefix++;
+        }
+
+        size_t lSuffix = 0;
+        while (lSuffix < lMinCount - lPrefix && StrokesEqual(aBefore[aBefore.size() - 1 - lSuffix], aAfter[aAfter.size() - 1 - lSuffix]))
+        {
+            lSuffix++;
+        }
+
+        if (aBefore.size() != aAfter.size())
+        {
+            // Strokes inserted or removed, one span from the first to the last difference
+            TSceneStackEntry::TSpan lSpan;
+            lSpan.mIndex = uint32_t(lPrefix);
+            lSpan.mArrayCount = uint32_t(aAfter.size() - lSuffix - lPrefix);
+            lSpan.mStoredFirst = 0;
+            lSpan.mStoredCount = uint32_t(aBefore.size() - lSuffix - lPrefix);
+            aOutEntry.mSpans.push_back(lSpan);
+            aOutEntry.mStrokes.assign(aBefore.begin() + lPrefix, aBefore.end() - lSuffix);
+            return;
+        }
+
+        // Same count, only the modified strokes
+        for (size_t i = lPrefix; i < aAfter.size() - lSuffix; i++)
+        {
+            if (StrokesEqual(aBefore[i], aAfter[i]))
+            {
+                continue;
+            }
+
+            if (!aOutEntry.mSpans.empty() && (aOutEntry.mSpans.back().mIndex + aOutEntry.mSpans.back().mArrayCount) == i)
+            {
+                aOutEntry.mSpans.back().mArrayCount++;
+                aOutEntry.mSpans.back().mStoredCount++;
+            }
+            else
+            {
+                aOutEntry.mSpans.push_back({ uint32_t(i), 1, uint32_t(aOutEntry.mStrokes.size()), 1 });
+            }
+            aOutEntry.mStrokes.push_back(aBefore[i]);
+        }
+
+        aOutEntry.mSpans.shrink_to_fit();
+        aOutEntry.mStrokes.shrink_to_fit();
+    }
+
+    // Turns aBefore into aAfter copying only the spans of their diff
+    void CopyDiffSpans(TSceneStackEntry const& aDiff, std::vector< TStrokeInfo > const& aAfter, std::vector< TStrokeInfo >& aBefore)
+    {
+        // Back to front, the indices of the spans not copied yet stay valid
+        for (auto lIt = aDiff.mSpans.rbegin(); lIt != aDiff.mSpans.rend(); ++lIt)
+        {
+            auto lFirst = aBefore.begin() + lIt->mIndex;
+            auto lSource = aAfter.begin() + lIt->mIndex;
+            if (lIt->mArrayCount == lIt->mStoredCount)
+            {
+                std::copy(lSource, lSource + lIt->mArrayCount, lFirst);
+            }
+            else
+            {
+                lFirst = aBefore.erase(lFirst, lFirst + lIt->mStoredCount);
+                aBefore.insert(lFirst, lSource, lSource + lIt->mArrayCount);
+            }
+        }
+    }
 }
 
-TStoredSceneState::~TStoredSceneState()
+void TSceneStackEntry::Apply(std::vector< TStrokeInfo >& aStrokesArray)
 {
-    if (mStrokesArray != nullptr)
+    // Strokes swapped out, and the spans as seen from the other state
+    std::vector< TStrokeInfo > lSwappedStrokes;
+    std::vector< TSpan > lSwappedSpans;
+    lSwappedSpans.reserve(mSpans.size());
+
+    // Exact capacity, GetSizeBytes must not change when applied twice
+    size_t lSwappedCount = 0;
+    for (TSpan const& lSpan : mSpans)
     {
-        delete mStrokesArray;
-        mStrokesArray = nullptr;
+        lSwappedCount += lSpan.mArrayCount;
     }
+    lSwappedStrokes.reserve(lSwappedCount);
 
-    if (mSelectedItems != nullptr)
+    int64_t lIndexOffset = 0;
+    for (TSpan const& lSpan : mSpans)
     {
-        delete mSelectedItems;
-        mSelectedItems = nullptr;
+        TSpan lSwapped;
+        lSwapped.mIndex = uint32_t(int64_t(lSpan.mIndex) + lIndexOffset);
+        lSwapped.mArrayCount = lSpan.mStoredCount;
+        lSwapped.mStoredFirst = uint32_t(lSwappedStrokes.size());
+        lSwapped.mStoredCount = lSpan.mArrayCount;
+        lSwappedSpans.push_back(lSwapped);
+
+        lSwappedStrokes.insert(lSwappedStrokes.end(), aStrokesArray.begin() + lSpan.mIndex, aStrokesArray.begin() + lSpan.mIndex + lSpan.mArrayCount);
+        lIndexOffset += int64_t(lSpan.mStoredCount) - int64_t(lSpan.mArrayCount);
     }
 
-    if (mGlobalMaterial != nullptr)
+    // Back to front, the indices of the spans not applied yet stay valid
+    for (auto lIt = mSpans.rbegin(); lIt != mSpans.rend(); ++lIt)
     {
-        delete mGlobalMaterial;
-        mGlobalMaterial = nullptr;
+        auto lFirst = aStrokesArray.begin() + lIt->mIndex;
+        auto lStored = mStrokes.begin() + lIt->mStoredFirst;
+        if (lIt->mArrayCount == lIt->mStoredCount)
+        {
+            std::copy(lStored, lStored + lIt->mStoredCount, lFirst);
+        }
+        else
+        {
+            lFirst = aStrokesArray.erase(lFirst, lFirst + lIt->mArrayCount);
+            aStrokesArray.insert(lFirst, lStored, lStored + lIt->mStoredCount);
+        }
     }
+
+    mStrokes.swap(lSwappedStrokes);
+    mSpans.swap(lSwappedSpans);
+}
+
+size_t TSceneStackEntry::GetSizeBytes() const
+{
+    return sizeof(TSceneStackEntry)
+        + mSpans.capacity() * sizeof(TSpan)
+        + mStrokes.capacity() * sizeof(TStrokeInfo)
+        + mSelectedItems.capacity() * sizeof(uint32_t);
 }
 
 void CSceneStack::Reset()
 {
     mPopedStates.clear();
     mPushedStates.clear();
+    mStackStrokes.clear();
+    mMemoryUsage = 0;
 }
 
-void CSceneStack::PushState(TPushStateFlags aFlags)
+void CSceneStack::PushState(TPushStateFlags aFlags, uint32_t aCoalesceKey)
 {
-    if (aFlags != 0)
+    if (aFlags == 0)
     {
-        mPopedStates.clear();
+        return;
+    }
 
-        while (mPushedStates.size() >= kMaxStackElements)
-        {
-            mPushedStates.pop_front();
-        }
+    // First state after a reset, the base the history starts from
+    if (mPushedStates.empty())
+    {
+        TSceneStackEntryRef lBase = std::make_shared< TSceneStackEntry >();
+        lBase->mFlags = aFlags;
+        lBase->mSelectedItems = mScene.mSelectedItems;
+        mStackStrokes = mScene.mStrokesArray;
+        mPushedStates.push_back(lBase);
+        mMemoryUsage += lBase->GetSizeBytes();
+        return;
+    }
 
-        TStoredSceneStateRef lState = std::make_shared< TStoredSceneState >(aFlags);
+    TSceneStackEntryRef lTop = mPushedStates.back();
+    const bool lCoalesce = (aCoalesceKey != 0) && (lTop->mCoalesceKey == aCoalesceKey) && (mPushedStates.size() > 1);
 
-        if (aFlags & EPushStateFlags::EPE_STROKES)
-        {
-            lState->mStrokesArray = new std::vector< TStrokeInfo >(mScene.mStrokesArray);
-        }
+    // Counted before the coalesce path applies it
+    const size_t lTopSizeBytes = lTop->GetSizeBytes();
+
+    TSceneStackEntryRef lEntry = std::make_shared< TSceneStackEntry >();
+    lEntry->mFlags = aFlags | (lCoalesce ? lTop->mFlags : 0);
+    lEntry->mCoalesceKey = aCoalesceKey;
 
-        if (aFlags & EPushStateFlags::EPE_SELECTION)
+    if (lEntry->mFlags & EPushStateFlags::EPE_STROKES)
+    {
+        if (lCoalesce)
         {
-            lState->mSelectedItems = new std::vector< uint32_t >(mScene.mSelectedItems);
+            // From the state before the top entry, the top entry is replaced
+            lTop->Apply(mStackStrokes);
         }
+        DiffStrokes(mStackStrokes, mScene.mStrokesArray, *lEntry);
+        CopyDiffSpans(*lEntry, mScene.mStrokesArray, mStackStrokes);
+    }
 
-        // TODO: material not in undo & redo for now
-        //if (aFlags & EPushStateFlags::EPE_MATERIAL)
-        //{
-        //    lState->mGlobalMaterial = new TGlobalMaterialBufferData(mScene.mGlobalMaterial);
-        //}
+    if (aFlags & EPushStateFlags::EPE_SELECTION)
+    {
+        lEntry->mSelectedItems = mScene.mSelectedItems;
+    }
+    else if (lCoalesce)
+    {
+        lEntry->mSelectedItems = lTop->mSelectedItems;
+    }
+
+    // TODO: material not in undo & redo for now
+
+    // Nothing changed, keep the redo states
+    const bool lSameSelection = !(aFlags & EPushStateFlags::EPE_SELECTION) || (lEntry->mSelectedItems == lTop->mSelectedItems);
+    if (!lCoalesce && lEntry->mSpans.empty() && lSameSelection)
+    {
+        return;
+    }
+
+    for (TSceneStackEntryRef const& lPoped : mPopedStates)
+    {
+        mMemoryUsage -= lPoped->GetSizeBytes();
+    }
+    mPopedStates.clear();
 
-        mPushedStates.push_back(lState);
+    if (lCoalesce)
+    {
+        mMemoryUsage -= lTopSizeBytes;
+        mPushedStates.pop_back();
     }
+
+    mPushedStates.push_back(lEntry);
+    mMemoryUsage += lEntry->GetSizeBytes();
+
+    EnforceMemoryBudget();
 }
 
 bool CSceneStack::PopState()
 {
     if(mPushedStates.size() > 1)
     {
-        mPopedStates.push_back(mPushedStates.back());
+        TSceneStackEntryRef lEntry = mPushedStates.back();
         mPushedStates.pop_back();
+        mPopedStates.push_back(lEntry);
 
-        ApplySceneState(true);
+        ApplyEntry(*lEntry);
 
         return true;
     }
@@ -95,10 +256,11 @@ bool CSceneStack::RestorePopedState()
 {
     if (mPopedStates.size() > 0)
     {
-        mPushedStates.push_back(mPopedStates.back());
+        TSceneStackEntryRef lEntry = mPopedStates.back();
         mPopedStates.pop_back();
+        mPushedStates.push_back(lEntry);
 
-        ApplySceneState(false);
+        ApplyEntry(*lEntry);
 
         return true;
     }
@@ -106,36 +268,44 @@ bool CSceneStack::RestorePopedState()
     return false;
 }
 
-void CSceneStack::ApplySceneState(bool aPopedSelection)
+void CSceneStack::SetMemoryBudget(size_t aBytes)
+{
+    mMemoryBudget = aBytes;
+    EnforceMemoryBudget();
+}
+
+void CSceneStack::ApplyEntry(TSceneStackEntry& aEntry)
 {
-    //appply scene changes
-    if (mPushedStates.size() > 0)
+    //appply scene changes, edits not pushed yet are dropped
+    if (aEntry.mFlags & EPushStateFlags::EPE_STROKES)
     {
-        if (mPushedStates.back()->mStrokesArray)
-        {
-            mScene.mStrokesArray = *mPushedStates.back()->mStrokesArray;
-            mScene.SetDirty();
-        }
+        mMemoryUsage -= aEntry.GetSizeBytes();
+        aEntry.Apply(mStackStrokes);
+        mMemoryUsage += aEntry.GetSizeBytes();
 
-        if (mPushedStates.back()->mGlobalMaterial)
-        {
-            mScene.mGlobalMaterial = *mPushedStates.back()->mGlobalMaterial;
-            mScene.SetMaterialDirty();
-        }
+        mScene.mStrokesArray = mStackStrokes;
+        mScene.SetDirty();
     }
 
-    if(aPopedSelection)
+    // Undo and redo both select what the entry had selected when pushed
+    if (aEntry.mFlags & EPushStateFlags::EPE_SELECTION)
     {
-        if (mPopedStates.size() > 0 && mPopedStates.back()->mSelectedItems)
-        {
-            mScene.mSelectedItems = *mPopedStates.back()->mSelectedItems;
-        }
+        mScene.mSelectedItems = aEntry.mSelectedItems;
     }
-    else
+}
+
+void CSceneStack::EnforceMemoryBudget()
+{
+    // The front entry is never applied, dropping it makes the next one the new base
+    while (mMemoryUsage > mMemoryBudget && mPushedStates.size() > 2)
     {
-        if (mPushedStates.size() > 0 && mPushedStates.back()->mSelectedItems)
-        {
-            mScene.mSelectedItems = *mPushedStates.back()->mSelectedItems;
-        }
+        mMemoryUsage -= mPushedStates.front()->GetSizeBytes();
+        mPushedStates.pop_front();
+
+        TSceneStackEntry& lBase = *mPushedStates.front();
+        mMemoryUsage -= lBase.GetSizeBytes();
+        std::vector< TSceneStackEntry::TSpan >().swap(lBase.mSpans);
+        std::vector< TStrokeInfo >().swap(lBase.mStrokes);
+        mMemoryUsage += lBase.GetSizeBytes();
     }
 }
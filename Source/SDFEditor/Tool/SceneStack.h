@@ -25,39 +25,72 @@ namespace EPushStateFlags
 
 using TPushStateFlags = uint32_t;
 
-struct TStoredSceneState
+// Undo entry, only the strokes that differ between two consecutive states.
+// Applying the entry swaps its strokes with the ones in the array, so the
+// same entry undoes the change and, applied again, redoes it.
+struct TSceneStackEntry
 {
-    TPushStateFlags             mFlags;
-    std::vector< TStrokeInfo >* mStrokesArray;
-    std::vector< uint32_t >*    mSelectedItems;
-    TGlobalMaterialBufferData*  mGlobalMaterial;
+    struct TSpan
+    {
+        uint32_t mIndex;            // first stroke of the span in the array
+        uint32_t mArrayCount;       // strokes of the span in the array
+        uint32_t mStoredFirst;      // first stroke of the span in mStrokes
+        uint32_t mStoredCount;      // strokes that replace them when applied
+    };
 
-    TStoredSceneState(TPushStateFlags aFlags);
-    ~TStoredSceneState();
+    TPushStateFlags             mFlags{ 0 };
+    uint32_t                    mCoalesceKey{ 0 };
+    std::vector< TSpan >        mSpans;             // sorted, not overlapping
+    std::vector< TStrokeInfo >  mStrokes;
+    std::vector< uint32_t >     mSelectedItems;
+
+    void Apply(std::vector< TStrokeInfo >& aStrokesArray);
+    size_t GetSizeBytes() const;
 };
 
-using TStoredSceneStateRef = std::shared_ptr< TStoredSceneState >;
+using TSceneStackEntryRef = std::shared_ptr< TSceneStackEntry >;
 
 class CSceneStack
 {
 public:
+    static constexpr size_t kDefaultMemoryBudget = 64 * 1024 * 1024;
+
     CSceneStack(CScene& aScene) : mScene(aScene) {}
 
     // Undo/Redo functionality
     void Reset();
-    void PushState(TPushStateFlags aFlags);
+
+    // Pushes the strokes changed since the previous state. Pushes with the same
+    // non zero aCoalesceKey in a row end up in one entry, for continuous edits.
+    void PushState(TPushStateFlags aFlags, uint32_t aCoalesceKey = 0);
     bool PopState();
     bool RestorePopedState();
     bool HavePushedStates() const { return mPushedStates.size() > 1; }
     bool HavePopedStates() const { return mPopedStates.size() > 0; }
 
+    // Unique key for a new continuous edit
+    uint32_t NewCoalesceKey() { return ++mLastCoalesceKey; }
+
+    // The oldest entries are dropped when the history goes over the budget
+    void SetMemoryBudget(size_t aBytes);
+    size_t GetMemoryBudget() const { return mMemoryBudget; }
+    size_t GetMemoryUsage() const { return mMemoryUsage; }
+    size_t GetUndoCount() const { return HavePushedStates() ? mPushedStates.size() - 1 : 0; }
+
 private:
-    void ApplySceneState(bool aPopedSelection);
+    void ApplyEntry(TSceneStackEntry& aEntry);
+    void EnforceMemoryBudget();
 
 private:
     CScene& mScene;
 
-    // Undo/Redo data
-    std::deque< TStoredSceneStateRef > mPushedStates;
-    std::deque< TStoredSceneStateRef > mPopedStates;
+    // Undo/Redo data, the front of mPushedStates is the oldest state that can be reached
+    std::deque< TSceneStackEntryRef > mPushedStates;
+    std::deque< TSceneStackEntryRef > mPopedStates;
+
+    // Strokes at the top of the stack, the entries are deltas against it
+    std::vector< TStrokeInfo > mStackStrokes;
+    uint32_t mLastCoalesceKey{ 0 };
+    size_t mMemoryBudget{ kDefaultMemoryBudget };
+    size_t mMemoryUsage{ 0 };
 };
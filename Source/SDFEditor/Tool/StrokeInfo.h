@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <cstdio>
+#include <cstring>
+
 #include "glm/glm.hpp"
 #include "glm/gtc/quaternion.hpp"
 
@@ -69,6 +72,19 @@ struct TStrokeInfo : public stroke_t
         UpdateRotation();
     }
 
+    // Same as the copy, the quaternion is rebuilt from the euler angles
+    TStrokeInfo& operator=(const TStrokeInfo& aOther)
+    {
+        if (this != &aOther)
+        {
+            stroke_t::operator=(aOther);
+            mEulerAngles = aOther.mEulerAngles;
+            ::memcpy(mName, aOther.mName, MAX_NAME_SIZE);
+            UpdateRotation();
+        }
+        return *this;
+    }
+
     TStrokeInfo(const stroke_t& aBaseStroke, glm::vec3 aEulerAngles, const char* aName)
         : stroke_t(aBaseStroke)
         , mEulerAngles(aEulerAngles)
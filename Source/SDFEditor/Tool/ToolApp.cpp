@@ -6,10 +6,14 @@
 #include "imgui/imgui.h"
 #include "GLFW/glfw3.h"
 #include "sbx/Core/Log.h"
+#include "sbx/Core/ErrorHandling.h"
 
 #include "SDFEditor/GUI/GUIStrokesEdit.h"
 #include "SDFEditor/GUI/GUIDocument.h"
 #include "SDFEditor/Utils/FileIO.h"
+#include "SDFEditor/Sdf/SdfEvaluator.h"
+#include "SDFEditor/Sdf/SdfDualContouring.h"
+#include "SDFEditor/Sdf/SdfMesh.h"
 
 CToolApp::CToolApp()
 {
@@ -68,9 +72,32 @@ void CToolApp::Update()
     ImGui::Checkbox("LUT Nearest Filter", &mScene.mLutNearestFilter);
     ImGui::Checkbox("Atlas Nearest Filter", &mScene.mAtlasNearestFilter);
     ImGui::DragInt("Preview Slice", &mScene.mPreviewSlice, 1, 0, 127);
+
+    CSdfSlotAllocator const& lAtlasSlots = mRenderer.GetSdfVolume().GetSlotAllocator();
+    TSdfVolumeBakeStats const& lBakeStats = mRenderer.GetLastBakeStats();
+    ImGui::Separator();
+    ImGui::Text("Uploads: %zu bytes/frame (strokes %zu bytes in %u calls)", mRenderer.GetFrameUploadedBytes(), mRenderer.GetFrameStrokesUploadedBytes(), mRenderer.GetFrameStrokesUploadCalls());
+    ImGui::Text("Buffer uploads: %s, %u ring stalls", (mRenderer.GetBufferUploadMode() == EBufferUploadMode::PERSISTENT_RING) ? "persistent ring" : "sub data", mRenderer.GetRingStallsCount());
+    ImGui::Text("Atlas slots: %u / %u, high watermark %u (%.1f%% occupied)", lAtlasSlots.GetUsedCount(), lAtlasSlots.GetCapacity(), lAtlasSlots.GetHighWatermark(), lAtlasSlots.GetOccupancy() * 100.0f);
+    ImGui::Text("Last bake: %zu voxels, %u bricks, +%u -%u slots, %.2f ms", lBakeStats.mLut.mVoxels, lBakeStats.mBricks, lBakeStats.mAllocatedSlots, lBakeStats.mReleasedSlots, lBakeStats.mSeconds * 1000.0);
+    if (lBakeStats.mOverflowSlots > 0)
+    {
+        ImGui::Text("Atlas full, %u surface voxels without brick", lBakeStats.mOverflowSlots);
+    }
+    TSdfVolumeCacheStats const& lCacheStats = mRenderer.GetVolumeCache().GetStats();
+    ImGui::Text("Volume cache: %u hits, %u misses, %u stored", lCacheStats.mHits, lCacheStats.mMisses, lCacheStats.mStores);
+    ImGui::Text("Undo: %zu states, %.2f / %.0f MB", mScene.mStack->GetUndoCount(), double(mScene.mStack->GetMemoryUsage()) / (1024.0 * 1024.0), double(mScene.mStack->GetMemoryBudget()) / (1024.0 * 1024.0));
+    if (ImGui::Button("Compact Atlas"))
+    {
+        mRenderer.RequestAtlasCompaction();
+    }
     ImGui::End(); 
 #endif
 
+    if (mScene.IsDirty())
+    {
+        mScene.SyncPackedStrokes();
+    }
     mRenderer.UpdateSceneData(mScene);
 
     mScene.CleanDirtyFlag();
@@ -200,6 +227,12 @@ bool CToolApp::HandleShortcuts()
         return true;
     }
 
+    if (io.KeyCtrl && ImGui::IsKeyPressed('E', false))
+    {
+        GUI::LaunchExportMeshDialog(*this);
+        return true;
+    }
+
     if (io.KeyCtrl && ImGui::IsKeyPressed('N', false))
     {
         //SaveScene("test.dfs");
@@ -265,6 +298,35 @@ void CToolApp::LoadScene(const std::string& aFilePath)
     mScene.mDocument->Load();
 }
 
+void CToolApp::ExportMesh(const std::string& aFilePath)
+{
+    CSdfEvaluator lEvaluator;
+    lEvaluator.SetStrokes(mScene.mStrokesArray);
+
+    // Dual contouring keeps the box edges sharp on a grid coarser than the atlas
+    TSdfBakeParams lParams = mRenderer.GetSdfVolume().GetParams();
+    lParams.mBrickSize = CSdfDualContouring::kDefaultBrickSize;
+
+    // Slabs go to the file as they are meshed, the whole mesh is never in memory
+    CSdfMeshStreamWriter lWriter;
+    if (!lWriter.Open(aFilePath, false))
+    {
+        SBX_ERROR("Unable to write the mesh [%s]", aFilePath.c_str());
+        return;
+    }
+
+    CSdfDualContouring lMesher;
+    const TSdfMeshStats lStats = lMesher.Extract(lEvaluator, lParams, [&lWriter](TSdfMesh const& aPiece) { return lWriter.Write(aPiece); });
+
+    if (!lWriter.Close())
+    {
+        SBX_ERROR("Unable to write the mesh [%s]", aFilePath.c_str());
+        return;
+    }
+
+    SBX_LOG("Mesh exported to %s, %zu vertices, %zu triangles, %.2f s", aFilePath.c_str(), lStats.mVertices, lStats.mTriangles, lStats.mSeconds);
+}
+
 void CToolApp::WantClose()
 {
     GUI::WantCloseDocument(*this);
@@ -30,6 +30,9 @@ public:
     void SaveScene(const std::string& aFilePath);
     void LoadScene(const std::string& aFilePath);
 
+    // Dual contouring mesh of the scene, .obj or binary .ply
+    void ExportMesh(const std::string& aFilePath);
+
     void WantClose();
     void Terminate();
     bool IsRunning() const { return mRunning; }
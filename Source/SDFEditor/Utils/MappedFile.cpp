@@ -0,0 +1,105 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include "MappedFile.h"
+
+#include <sbx/Core/Platform.h>
+
+#if SBX_OS_WINDOWS
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+CMappedFile::~CMappedFile()
+{
+    Close();
+}
+
+bool CMappedFile::Open(const std::string& aFilename)
+{
+    Close();
+
+#if SBX_OS_WINDOWS
+    HANDLE lFile = ::CreateFileA(aFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (lFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER lFileSize;
+    if (!::GetFileSizeEx(lFile, &lFileSize) || lFileSize.QuadPart == 0)
+    {
+        ::CloseHandle(lFile);
+        return false;
+    }
+
+    HANDLE lMapping = ::CreateFileMappingA(lFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* lData = (lMapping != nullptr) ? ::MapViewOfFile(lMapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (lData == nullptr)
+    {
+        if (lMapping != nullptr)
+        {
+            ::CloseHandle(lMapping);
+        }
+        ::CloseHandle(lFile);
+        return false;
+    }
+
+    mFileHandle = lFile;
+    mMappingHandle = lMapping;
+    mData = (const uint8_t*)lData;
+    mSize = size_t(lFileSize.QuadPart);
+#else
+    const int lFile = ::open(aFilename.c_str(), O_RDONLY);
+    if (lFile < 0)
+    {
+        return false;
+    }
+
+    struct stat lStat;
+    if (::fstat(lFile, &lStat) != 0 || lStat.st_size == 0)
+    {
+        ::close(lFile);
+        return false;
+    }
+
+    // The mapping keeps the file referenced, the descriptor is not needed anymore
+    void* lData = ::mmap(nullptr, size_t(lStat.st_size), PROT_READ, MAP_PRIVATE, lFile, 0);
+    ::close(lFile);
+    if (lData == MAP_FAILED)
+    {
+        return false;
+    }
+
+    ::madvise(lData, size_t(lStat.st_size), MADV_SEQUENTIAL);
+    mData = (const uint8_t*)lData;
+    mSize = size_t(lStat.st_size);
+#endif
+
+    return true;
+}
+
+void CMappedFile::Close()
+{
+    if (mData == nullptr)
+    {
+        return;
+    }
+
+#if SBX_OS_WINDOWS
+    ::UnmapViewOfFile(mData);
+    ::CloseHandle(HANDLE(mMappingHandle));
+    ::CloseHandle(HANDLE(mFileHandle));
+    mMappingHandle = nullptr;
+    mFileHandle = nullptr;
+#else
+    ::munmap((void*)mData, mSize);
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+}
@@ -0,0 +1,33 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Read only memory mapped files
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class CMappedFile
+{
+public:
+    CMappedFile() = default;
+    ~CMappedFile();
+
+    CMappedFile(CMappedFile const&) = delete;
+    CMappedFile& operator=(CMappedFile const&) = delete;
+
+    // Maps the whole file, false if it can't be opened or is empty
+    bool Open(const std::string& aFilename);
+    void Close();
+
+    bool IsOpen() const { return mData != nullptr; }
+    const uint8_t* GetData() const { return mData; }
+    size_t GetSize() const { return mSize; }
+
+private:
+    const uint8_t* mData{ nullptr };
+    size_t mSize{ 0 };
+
+    // Windows keeps the file and mapping handles until unmapped
+    void* mFileHandle{ nullptr };
+    void* mMappingHandle{ nullptr };
+};
@@ -0,0 +1,185 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Writes seeded synthetic scenes, see CSceneGenerator
+
+#include <SDFEditor/Tool/Scene.h>
+#include <SDFEditor/Tool/SceneGenerator.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct TGenOptions
+    {
+        TSceneGeneratorParams mParams;
+        std::string mOutputPath;
+    };
+
+    void PrintUsage()
+    {
+        TSceneGeneratorParams lDefaults;
+        fprintf(stderr, "usage: sdfgen [options] -o <output.strks|output.strkb>\n");
+        fprintf(stderr, "  -n, --strokes <n>           strokes count (default %u)\n", lDefaults.mStrokesCount);
+        fprintf(stderr, "      --seed <n>              same seed and options, same scene (default %u)\n", lDefaults.mSeed);
+        fprintf(stderr, "  -l, --layout <layout>       uniform, clustered, overlapping or subtract_chain (default uniform)\n");
+        fprintf(stderr, "      --primitives <e,b,t,c>  weights of ellipsoid, box, torus and capsule (default 1,1,1,1)\n");
+        fprintf(stderr, "      --ops <a,s,i>           weights of add, subtract and intersect (default 0.8,0.2,0)\n");
+        fprintf(stderr, "      --mirror <chance>       chance of mirror X, and of mirror Y, 0 to 1 (default 0)\n");
+        fprintf(stderr, "      --blend <min,max>       blend radius range (default 0,0.05)\n");
+        fprintf(stderr, "      --size <min,max>        stroke size range (default: fitted to the strokes count)\n");
+        fprintf(stderr, "      --extent <e>            half side of the region (default 2.5, the LUT covers 3.2)\n");
+        fprintf(stderr, "      --clusters <n>          clusters of the clustered layout (default %u)\n", lDefaults.mClustersCount);
+        fprintf(stderr, "      --cluster-radius <r>    (default 0.5)\n");
+        fprintf(stderr, "      --chain <n>             strokes per subtract chain (default %u)\n", lDefaults.mChainLength);
+        fprintf(stderr, "  -o, --output <path>         .strkb is binary, anything else JSON\n");
+        fprintf(stderr, "  -h, --help                  this usage\n");
+    }
+
+    bool ParseFloats(const char* aText, float* aOutValues, size_t aCount)
+    {
+        std::stringstream lStream(aText);
+        std::string lItem;
+        size_t lParsed = 0;
+        while (std::getline(lStream, lItem, ','))
+        {
+            char* lEnd = nullptr;
+            const float lValue = ::strtof(lItem.c_str(), &lEnd);
+            if (lParsed >= aCount || lEnd == lItem.c_str() || *lEnd != 0)
+            {
+                return false;
+            }
+            aOutValues[lParsed++] = lValue;
+        }
+        return lParsed == aCount;
+    }
+
+    bool ParseOptions(int argc, char** argv, TGenOptions& aOutOptions)
+    {
+        TSceneGeneratorParams& lParams = aOutOptions.mParams;
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string lArg = argv[i];
+            if (lArg == "-h" || lArg == "--help")
+            {
+                return false;
+            }
+
+            if ((i + 1) >= argc)
+            {
+                fprintf(stderr, "Missing value for [%s]\n", lArg.c_str());
+                return false;
+            }
+
+            const char* lValue = argv[++i];
+            bool lValid = true;
+            float lFloats[4];
+            if (lArg == "-n" || lArg == "--strokes" || lArg == "--seed" || lArg == "--clusters" || lArg == "--chain")
+            {
+                char* lEnd = nullptr;
+                const unsigned long long lInt = ::strtoull(lValue, &lEnd, 10);
+                lValid = (lEnd != lValue) && (*lEnd == 0) && (lValue[0] != '-') && (lInt <= UINT32_MAX);
+                const uint32_t lUint = uint32_t(lInt);
+                if (lArg == "--seed")
+                {
+                    lParams.mSeed = lUint;
+                }
+                else if (lArg == "--clusters")
+                {
+                    lValid &= (lUint > 0);
+                    lParams.mClustersCount = lUint;
+                }
+                else if (lArg == "--chain")
+                {
+                    lValid &= (lUint > 1);
+                    lParams.mChainLength = lUint;
+                }
+                else
+                {
+                    lParams.mStrokesCount = lUint;
+                }
+            }
+            else if (lArg == "-l" || lArg == "--layout")
+            {
+                lValid = CSceneGenerator::GetLayoutByName(lValue, lParams.mLayout);
+            }
+            else if (lArg == "--primitives")
+            {
+                lValid = ParseFloats(lValue, lParams.mPrimitiveWeights, EPrimitive::PrCount);
+            }
+            else if (lArg == "--ops")
+            {
+                lValid = ParseFloats(lValue, lParams.mOpWeights, ESceneGeneratorOp::COUNT);
+            }
+            else if (lArg == "--mirror")
+            {
+                lValid = ParseFloats(lValue, &lParams.mMirrorChance, 1);
+            }
+            else if (lArg == "--blend")
+            {
+                lValid = ParseFloats(lValue, lFloats, 2) && lFloats[0] >= 0.0f && lFloats[1] >= lFloats[0];
+                lParams.mBlendMin = lFloats[0];
+                lParams.mBlendMax = lFloats[1];
+            }
+            else if (lArg == "--size")
+            {
+                lValid = ParseFloats(lValue, lFloats, 2) && lFloats[0] > 0.0f && lFloats[1] >= lFloats[0];
+                lParams.mSizeMin = lFloats[0];
+                lParams.mSizeMax = lFloats[1];
+            }
+            else if (lArg == "--extent")
+            {
+                lValid = ParseFloats(lValue, &lParams.mExtent, 1) && lParams.mExtent > 0.0f;
+            }
+            else if (lArg == "--cluster-radius")
+            {
+                lValid = ParseFloats(lValue, &lParams.mClusterRadius, 1) && lParams.mClusterRadius >= 0.0f;
+            }
+            else if (lArg == "-o" || lArg == "--output")
+            {
+                aOutOptions.mOutputPath = lValue;
+            }
+            else
+            {
+                fprintf(stderr, "Unknown option [%s]\n", lArg.c_str());
+                return false;
+            }
+
+            if (!lValid)
+            {
+                fprintf(stderr, "Invalid value [%s] for %s\n", lValue, lArg.c_str());
+                return false;
+            }
+        }
+
+        return !aOutOptions.mOutputPath.empty();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    TGenOptions lOptions;
+    if (!ParseOptions(argc, argv, lOptions))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const auto lStart = std::chrono::steady_clock::now();
+    CScene lScene;
+    CSceneGenerator::Generate(lOptions.mParams, lScene);
+    lScene.mDocument->SetFilePath(lOptions.mOutputPath);
+    if (!lScene.mDocument->Save())
+    {
+        fprintf(stderr, "Unable to write [%s]\n", lOptions.mOutputPath.c_str());
+        return 1;
+    }
+
+    const double lSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lStart).count();
+    printf("%s: %zu strokes, %s layout, seed %u, %.3f s\n", lOptions.mOutputPath.c_str(), lScene.mStrokesArray.size(),
+        CSceneGenerator::GetLayoutName(lOptions.mParams.mLayout), lOptions.mParams.mSeed, lSeconds);
+    return 0;
+}
@@ -0,0 +1,322 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Extracts triangle meshes of scenes, no window or GL context
+
+#include <SDFEditor/Tool/Scene.h>
+#include <SDFEditor/Sdf/SdfEvaluator.h>
+#include <SDFEditor/Sdf/SdfDualContouring.h>
+#include <SDFEditor/Sdf/SdfMarchingCubes.h>
+#include <SDFEditor/Sdf/SdfMesh.h>
+#include <SDFEditor/Sdf/SdfMeshSimplifier.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct TMeshOptions
+    {
+        TSdfBakeParams mParams;
+        bool mDualContouring{ false };
+        bool mCellsSet{ false };
+        int32_t mLods{ 0 };
+        float mLodRatio{ CSdfMeshSimplifier::kDefaultLodRatio };
+        std::string mExtension{ ".ply" };
+        std::string mOutputDir;
+        std::vector<std::string> mInputs;
+    };
+
+    void PrintUsage()
+    {
+        fprintf(stderr, "usage: sdfmesh [options] <input.strks|input.strkb>...\n");
+        fprintf(stderr, "  -r, --resolution <n>    LUT voxels per side, 8 to 256 (default 128), same world extent\n");
+        fprintf(stderr, "  -m, --method <m>        mc: marching cubes (default), dc: dual contouring, sharp edges\n");
+        fprintf(stderr, "  -c, --cells <n>         mesh cells per LUT voxel side, 1 to 16 (default 8 for mc, %d for dc)\n", CSdfDualContouring::kDefaultBrickSize);
+        fprintf(stderr, "  -t, --threads <n>       threads (default 0, all hardware threads)\n");
+        fprintf(stderr, "  -l, --lods <n>          simplified LODs after the full mesh, 0 to 8 (default 0), <name>_lod<i> files\n");
+        fprintf(stderr, "      --lod-ratio <r>     triangles each LOD keeps from the previous, 0.01 to 0.9 (default %.2f)\n", CSdfMeshSimplifier::kDefaultLodRatio);
+        fprintf(stderr, "  -f, --format <fmt>      ply: binary PLY (default), obj: Wavefront OBJ\n");
+        fprintf(stderr, "  -o, --output <dir>      output directory (default: next to each input)\n");
+        fprintf(stderr, "      --no-cull           evaluate every stroke on every voxel\n");
+    }
+
+    bool ParseInt(const char* aText, int32_t aMin, int32_t aMax, int32_t& aOutValue)
+    {
+        char* lEnd = nullptr;
+        const long lValue = ::strtol(aText, &lEnd, 10);
+        if (lEnd == aText || *lEnd != 0 || lValue < aMin || lValue > aMax)
+        {
+            return false;
+        }
+        aOutValue = int32_t(lValue);
+        return true;
+    }
+
+    bool ParseFloat(const char* aText, float aMin, float aMax, float& aOutValue)
+    {
+        char* lEnd = nullptr;
+        const float lValue = ::strtof(aText, &lEnd);
+        if (lEnd == aText || *lEnd != 0 || !(lValue >= aMin && lValue <= aMax))
+        {
+            return false;
+        }
+        aOutValue = lValue;
+        return true;
+    }
+
+    bool ParseOptions(int argc, char** argv, TMeshOptions& aOutOptions)
+    {
+        // The default LUT covers 6.4 units, other resolutions keep it
+        const float lExtent = float(aOutOptions.mParams.mLutSize) * aOutOptions.mParams.mLutVoxelSide;
+
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string lArg = argv[i];
+            const bool lHasValue = (i + 1) < argc;
+            int32_t lValue = 0;
+
+            if ((lArg == "-r" || lArg == "--resolution") && lHasValue)
+            {
+                if (!ParseInt(argv[++i], 8, 256, lValue))
+                {
+                    fprintf(stderr, "Invalid resolution [%s], 8 to 256\n", argv[i]);
+                    return false;
+                }
+                aOutOptions.mParams.mLutSize = lValue;
+                aOutOptions.mParams.mLutVoxelSide = lExtent / float(lValue);
+            }
+            else if ((lArg == "-c" || lArg == "--cells") && lHasValue)
+            {
+                if (!ParseInt(argv[++i], 1, 16, lValue))
+                {
+                    fprintf(stderr, "Invalid cells [%s], 1 to 16\n", argv[i]);
+                    return false;
+                }
+                aOutOptions.mParams.mBrickSize = lValue;
+                aOutOptions.mCellsSet = true;
+            }
+            else if ((lArg == "-m" || lArg == "--method") && lHasValue)
+            {
+                const std::string lMethod = argv[++i];
+                if (lMethod != "mc" && lMethod != "dc")
+                {
+                    fprintf(stderr, "Unknown method [%s], mc or dc\n", lMethod.c_str());
+                    return false;
+                }
+                aOutOptions.mDualContouring = (lMethod == "dc");
+            }
+            else if ((lArg == "-t" || lArg == "--threads") && lHasValue)
+            {
+                if (!ParseInt(argv[++i], 0, 4096, lValue))
+                {
+                    fprintf(stderr, "Invalid thread count [%s]\n", argv[i]);
+                    return false;
+                }
+                aOutOptions.mParams.mThreads = uint32_t(lValue);
+            }
+            else if ((lArg == "-l" || lArg == "--lods") && lHasValue)
+            {
+                if (!ParseInt(argv[++i], 0, 8, aOutOptions.mLods))
+                {
+                    fprintf(stderr, "Invalid LODs [%s], 0 to 8\n", argv[i]);
+                    return false;
+                }
+            }
+            else if (lArg == "--lod-ratio" && lHasValue)
+            {
+                if (!ParseFloat(argv[++i], 0.01f, 0.9f, aOutOptions.mLodRatio))
+                {
+                    fprintf(stderr, "Invalid LOD ratio [%s], 0.01 to 0.9\n", argv[i]);
+                    return false;
+                }
+            }
+            else if ((lArg == "-f" || lArg == "--format") && lHasValue)
+            {
+                const std::string lFormat = argv[++i];
+                if (lFormat != "ply" && lFormat != "obj")
+                {
+                    fprintf(stderr, "Unknown format [%s], ply or obj\n", lFormat.c_str());
+                    return false;
+                }
+                aOutOptions.mExtension = "." + lFormat;
+            }
+            else if ((lArg == "-o" || lArg == "--output") && lHasValue)
+            {
+                aOutOptions.mOutputDir = argv[++i];
+            }
+            else if (lArg == "--no-cull")
+            {
+                aOutOptions.mParams.mCullStrokes = false;
+            }
+            else if (!lArg.empty() && lArg[0] == '-')
+            {
+                fprintf(stderr, "Unknown option [%s]\n", lArg.c_str());
+                return false;
+            }
+            else
+            {
+                aOutOptions.mInputs.push_back(lArg);
+            }
+        }
+
+        if (aOutOptions.mDualContouring && !aOutOptions.mCellsSet)
+        {
+            aOutOptions.mParams.mBrickSize = CSdfDualContouring::kDefaultBrickSize;
+        }
+
+        return !aOutOptions.mInputs.empty();
+    }
+
+    double SecondsSince(std::chrono::steady_clock::time_point const& aStart)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - aStart).count();
+    }
+
+    bool MeshScene(std::string const& aInputPath, TMeshOptions const& aOptions)
+    {
+        TSdfBakeParams const& lParams = aOptions.mParams;
+
+        auto lStageStart = std::chrono::steady_clock::now();
+        CScene lScene;
+        lScene.mDocument->SetFilePath(aInputPath);
+        if (!lScene.mDocument->Load())
+        {
+            fprintf(stderr, "Unable to load [%s]\n", aInputPath.c_str());
+            return false;
+        }
+        lScene.SyncPackedStrokes();
+        const double lLoadSeconds = SecondsSince(lStageStart);
+
+        std::vector<stroke_t> const& lStrokes = lScene.GetPackedStrokes();
+        CSdfEvaluator lEvaluator(lStrokes);
+
+        std::filesystem::path lOutputPath = std::filesystem::path(aInputPath).replace_extension(aOptions.mExtension);
+        if (!aOptions.mOutputDir.empty())
+        {
+            lOutputPath = std::filesystem::path(aOptions.mOutputDir) / lOutputPath.filename();
+        }
+
+        // Slabs go to the file as they are meshed, marching cubes has normals
+        CSdfMeshStreamWriter lWriter;
+        if (!lWriter.Open(lOutputPath.string(), !aOptions.mDualContouring))
+        {
+            fprintf(stderr, "Unable to write [%s]\n", lOutputPath.string().c_str());
+            return false;
+        }
+
+        // The LODs need the whole mesh, it is only kept for them
+        TSdfMesh lMesh;
+        double lWriteSeconds = 0.0;
+        auto lSink = [&lWriter, &lWriteSeconds, &lMesh, &aOptions](TSdfMesh const& aPiece)
+        {
+            const auto lWriteStart = std::chrono::steady_clock::now();
+            const bool lWritten = lWriter.Write(aPiece);
+            if (aOptions.mLods > 0)
+            {
+                lMesh.Append(aPiece);
+            }
+            lWriteSeconds += SecondsSince(lWriteStart);
+            return lWritten;
+        };
+
+        TSdfMeshStats lMeshStats;
+        if (aOptions.mDualContouring)
+        {
+            CSdfDualContouring lMesher;
+            lMeshStats = lMesher.Extract(lEvaluator, lParams, lSink);
+        }
+        else
+        {
+            CSdfMarchingCubes lMesher;
+            lMeshStats = lMesher.Extract(lEvaluator, lParams, lSink);
+        }
+        const double lMeshSeconds = lMeshStats.mSeconds - lMeshStats.mLutSeconds - lWriteSeconds;
+
+        lStageStart = std::chrono::steady_clock::now();
+        if (!lWriter.Close())
+        {
+            fprintf(stderr, "Unable to write [%s]\n", lOutputPath.string().c_str());
+            return false;
+        }
+        lWriteSeconds += SecondsSince(lStageStart);
+
+        const int32_t lGridSide = lParams.mLutSize * lParams.mBrickSize;
+        printf("%s: %zu strokes, %d^3 grid, %u bricks, %zu vertices, %zu triangles, %u threads\n", lOutputPath.string().c_str(), lStrokes.size(),
+            lGridSide, lMeshStats.mBricks, lMeshStats.mVertices, lMeshStats.mTriangles, lMeshStats.mThreads);
+        printf("  load  %8.3f s\n", lLoadSeconds);
+        printf("  lut   %8.3f s  %.1f strokes/voxel\n", lMeshStats.mLutSeconds, lMeshStats.mStrokesPerVoxel);
+        printf("  mesh  %8.3f s  weld %.3f s, %u slabs, %zu triangles in the largest\n", lMeshSeconds,
+            lMeshStats.mWeldSeconds, lMeshStats.mSlabs, lMeshStats.mMaxSlabTriangles);
+        printf("  write %8.3f s\n", lWriteSeconds);
+
+        if (aOptions.mLods > 0)
+        {
+            std::vector<size_t> lTargets;
+            size_t lTarget = lMesh.GetTrianglesCount();
+            for (int32_t i = 0; i < aOptions.mLods; i++)
+            {
+                lTarget = size_t(double(lTarget) * aOptions.mLodRatio);
+                lTargets.push_back(lTarget);
+            }
+
+            TSdfSimplifyParams lSimplifyParams;
+            lSimplifyParams.mThreads = lParams.mThreads;
+
+            std::vector<TSdfMesh> lLods;
+            CSdfMeshSimplifier lSimplifier;
+            const std::vector<TSdfSimplifyStats> lLodStats = lSimplifier.BuildLodChain(lMesh, lTargets, lSimplifyParams, lLods);
+
+            for (size_t i = 0; i < lLods.size(); i++)
+            {
+                std::filesystem::path lLodPath = lOutputPath;
+                lLodPath.replace_filename(lOutputPath.stem().string() + "_lod" + std::to_string(i + 1) + lOutputPath.extension().string());
+
+                lStageStart = std::chrono::steady_clock::now();
+                if (!Sdf::WriteMesh(lLodPath.string(), lLods[i]))
+                {
+                    fprintf(stderr, "Unable to write [%s]\n", lLodPath.string().c_str());
+                    return false;
+                }
+
+                TSdfSimplifyStats const& lLodStat = lLodStats[i];
+                printf("  lod%zu  %8.3f s  %zu triangles, %zu vertices, error %.5f, %u partitions %.3f s, border %zu triangles %.3f s, write %.3f s\n",
+                    i + 1, lLodStat.mSeconds, lLodStat.mTriangles, lLodStat.mVertices, lLodStat.mError, lLodStat.mPartitions, lLodStat.mPartitionSeconds,
+                    lLodStat.mPartitionTriangles, lLodStat.mBorderSeconds, SecondsSince(lStageStart));
+            }
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    TMeshOptions lOptions;
+    if (!ParseOptions(argc, argv, lOptions))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (!lOptions.mOutputDir.empty())
+    {
+        std::error_code lError;
+        std::filesystem::create_directories(lOptions.mOutputDir, lError);
+    }
+
+    uint32_t lFailed = 0;
+    for (std::string const& lInput : lOptions.mInputs)
+    {
+        lFailed += MeshScene(lInput, lOptions) ? 0 : 1;
+    }
+
+    if (lOptions.mInputs.size() > 1)
+    {
+        printf("%zu scenes meshed, %u failed\n", lOptions.mInputs.size() - lFailed, lFailed);
+    }
+
+    return (lFailed == 0) ? 0 : 1;
+}
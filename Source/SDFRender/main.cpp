@@ -0,0 +1,397 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Renders scenes to PNG on the CPU, thumbnails and turntables without a GPU
+
+#include <SDFEditor/Tool/Scene.h>
+#include <SDFEditor/Sdf/SdfAtlasBaker.h>
+#include <SDFEditor/Sdf/SdfEvaluator.h>
+#include <SDFEditor/Sdf/SdfLutBaker.h>
+#include <SDFEditor/Sdf/SdfRaymarcher.h>
+
+#include <sbx/Texture/Texture.h>
+#include <sbx/Texture/TextureUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+namespace
+{
+    namespace ERenderMode
+    {
+        enum Type
+        {
+            STROKES,    // exact distances of the strokes, RaymarchStrokes
+            ATLAS,      // baked LUT and bricks, RaymarchAtlas
+            COMPARE,    // both, <name>.png and <name>_atlas.png with the differences
+        };
+    };
+
+    struct TRenderOptions
+    {
+        TSdfRenderParams mParams;
+        TSdfBakeParams mBakeParams;
+        ERenderMode::Type mMode{ ERenderMode::STROKES };
+        int32_t mFrames{ 1 };           // turntable frames around the view up axis
+        std::string mOutputDir;
+        std::string mRoughnessMap;
+        std::string mTileStatsPath;     // CSV with the timing of every tile
+        std::vector<std::string> mInputs;
+    };
+
+    void PrintUsage()
+    {
+        fprintf(stderr, "usage: sdfrender [options] <input.strks|input.strkb>...\n");
+        fprintf(stderr, "  -w, --width <n>         image width (default 512)\n");
+        fprintf(stderr, "  -h, --height <n>        image height (default 512)\n");
+        fprintf(stderr, "  -t, --threads <n>       render threads (default 0, all hardware threads)\n");
+        fprintf(stderr, "      --tile <n>          tile side in pixels (default 32)\n");
+        fprintf(stderr, "  -m, --mode <mode>       strokes: exact strokes (default)\n");
+        fprintf(stderr, "                          atlas: baked LUT and brick atlas, any strokes count\n");
+        fprintf(stderr, "                          compare: both, reports speed and image differences\n");
+        fprintf(stderr, "  -r, --resolution <n>    LUT voxels per side of the atlas modes, 8 to 256 (default 128)\n");
+        fprintf(stderr, "      --turntable <n>     n frames around the scene, <name>_NNN.png\n");
+        fprintf(stderr, "      --roughness <img>   roughness map, white by default like the editor\n");
+        fprintf(stderr, "      --no-vignette       skip the vignette of the editor view\n");
+        fprintf(stderr, "      --tile-stats <csv>  writes the timing of every tile\n");
+        fprintf(stderr, "  -o, --output <dir>      output directory (default: next to each input)\n");
+    }
+
+    bool ParseInt(const char* aText, int32_t aMin, int32_t aMax, int32_t& aOutValue)
+    {
+        char* lEnd = nullptr;
+        const long lValue = ::strtol(aText, &lEnd, 10);
+        if (lEnd == aText || *lEnd != 0 || lValue < aMin || lValue > aMax)
+        {
+            return false;
+        }
+        aOutValue = int32_t(lValue);
+        return true;
+    }
+
+    bool ParseOptions(int argc, char** argv, TRenderOptions& aOutOptions)
+    {
+        // Same world extent for any resolution, like sdfbake
+        const float lExtent = float(aOutOptions.mBakeParams.mLutSize) * aOutOptions.mBakeParams.mLutVoxelSide;
+
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string lArg = argv[i];
+            const bool lHasValue = (i + 1) < argc;
+            int32_t lValue = 0;
+
+            auto lParseInt = [&](int32_t aMin, int32_t aMax) -> bool
+            {
+                if (!ParseInt(argv[++i], aMin, aMax, lValue))
+                {
+                    fprintf(stderr, "Invalid value [%s] for %s, %d to %d\n", argv[i], lArg.c_str(), aMin, aMax);
+                    return false;
+                }
+                return true;
+            };
+
+            if ((lArg == "-w" || lArg == "--width") && lHasValue)
+            {
+                if (!lParseInt(1, 16384)) return false;
+                aOutOptions.mParams.mWidth = lValue;
+            }
+            else if ((lArg == "-h" || lArg == "--height") && lHasValue)
+            {
+                if (!lParseInt(1, 16384)) return false;
+                aOutOptions.mParams.mHeight = lValue;
+            }
+            else if ((lArg == "-t" || lArg == "--threads") && lHasValue)
+            {
+                if (!lParseInt(0, 4096)) return false;
+                aOutOptions.mParams.mThreads = uint32_t(lValue);
+                aOutOptions.mBakeParams.mThreads = uint32_t(lValue);
+            }
+            else if (lArg == "--tile" && lHasValue)
+            {
+                if (!lParseInt(1, 4096)) return false;
+                aOutOptions.mParams.mTileSize = lValue;
+            }
+            else if ((lArg == "-m" || lArg == "--mode") && lHasValue)
+            {
+                const std::string lMode = argv[++i];
+                if (lMode == "strokes")
+                {
+                    aOutOptions.mMode = ERenderMode::STROKES;
+                }
+                else if (lMode == "atlas")
+                {
+                    aOutOptions.mMode = ERenderMode::ATLAS;
+                }
+                else if (lMode == "compare")
+                {
+                    aOutOptions.mMode = ERenderMode::COMPARE;
+                }
+                else
+                {
+                    fprintf(stderr, "Unknown mode [%s], strokes, atlas or compare\n", lMode.c_str());
+                    return false;
+                }
+            }
+            else if ((lArg == "-r" || lArg == "--resolution") && lHasValue)
+            {
+                if (!lParseInt(8, 256)) return false;
+                aOutOptions.mBakeParams.mLutSize = lValue;
+                aOutOptions.mBakeParams.mLutVoxelSide = lExtent / float(lValue);
+            }
+            else if (lArg == "--turntable" && lHasValue)
+            {
+                if (!lParseInt(1, 3600)) return false;
+                aOutOptions.mFrames = lValue;
+            }
+            else if (lArg == "--roughness" && lHasValue)
+            {
+                aOutOptions.mRoughnessMap = argv[++i];
+            }
+            else if (lArg == "--tile-stats" && lHasValue)
+            {
+                aOutOptions.mTileStatsPath = argv[++i];
+            }
+            else if ((lArg == "-o" || lArg == "--output") && lHasValue)
+            {
+                aOutOptions.mOutputDir = argv[++i];
+            }
+            else if (lArg == "--no-vignette")
+            {
+                aOutOptions.mParams.mVignette = false;
+            }
+            else if (!lArg.empty() && lArg[0] == '-')
+            {
+                fprintf(stderr, "Unknown option [%s]\n", lArg.c_str());
+                return false;
+            }
+            else
+            {
+                aOutOptions.mInputs.push_back(lArg);
+            }
+        }
+
+        return !aOutOptions.mInputs.empty();
+    }
+
+    struct TImageDiff
+    {
+        double mRmse{ 0.0 };            // 8 bit units over the rgb channels
+        int32_t mMax{ 0 };
+        double mDifferingPixels{ 0.0 }; // fraction of pixels with a channel off by more than kDifferingThreshold
+    };
+
+    constexpr int32_t kDifferingThreshold = 8;
+
+    TImageDiff CompareImages(sbx::TTexture const& aImageA, sbx::TTexture const& aImageB)
+    {
+        TImageDiff lDiff;
+        const size_t lPixelsCount = size_t(aImageA.mWidth) * size_t(aImageA.mHeight);
+        sbx::TColor8U const* lPixelsA = aImageA.AsRGBA8Buffer();
+        sbx::TColor8U const* lPixelsB = aImageB.AsRGBA8Buffer();
+
+        double lSquaredSum = 0.0;
+        size_t lDiffering = 0;
+        for (size_t i = 0; i < lPixelsCount; i++)
+        {
+            const int32_t lChannels[3] = { std::abs(int32_t(lPixelsA[i].r) - int32_t(lPixelsB[i].r)),
+                                           std::abs(int32_t(lPixelsA[i].g) - int32_t(lPixelsB[i].g)),
+                                           std::abs(int32_t(lPixelsA[i].b) - int32_t(lPixelsB[i].b)) };
+            int32_t lPixelMax = 0;
+            for (int32_t lChannel : lChannels)
+            {
+                lSquaredSum += double(lChannel * lChannel);
+                lPixelMax = std::max(lPixelMax, lChannel);
+            }
+            lDiff.mMax = std::max(lDiff.mMax, lPixelMax);
+            lDiffering += (lPixelMax > kDifferingThreshold) ? 1 : 0;
+        }
+
+        lDiff.mRmse = std::sqrt(lSquaredSum / double(lPixelsCount * 3));
+        lDiff.mDifferingPixels = double(lDiffering) / double(lPixelsCount);
+        return lDiff;
+    }
+
+    void ReportRender(std::string const& aImagePath, int32_t aFrame, TSdfRenderStats const& aStats, FILE* aTileStats)
+    {
+        double lTileMin = 1e30, lTileMax = 0.0, lTileSum = 0.0;
+        for (TSdfRenderTileStats const& lTile : aStats.mTiles)
+        {
+            lTileMin = std::min(lTileMin, lTile.mSeconds);
+            lTileMax = std::max(lTileMax, lTile.mSeconds);
+            lTileSum += lTile.mSeconds;
+
+            if (aTileStats != nullptr)
+            {
+                fprintf(aTileStats, "%s,%d,%d,%d,%d,%d,%u,%u,%llu,%.4f\n", aImagePath.c_str(), aFrame, lTile.mMin.x, lTile.mMin.y, lTile.mMax.x, lTile.mMax.y,
+                    lTile.mWorker, lTile.mHits, (unsigned long long)lTile.mEvaluations, lTile.mSeconds * 1000.0);
+            }
+        }
+
+        printf("  %s: %.3f s, %.2f Mrays/s, %.1f evals/ray, %u threads\n", aImagePath.c_str(), aStats.mSeconds, aStats.mRaysPerSecond / 1e6,
+            double(aStats.mEvaluations) / double(aStats.mRays), aStats.mThreads);
+        printf("    %zu tiles (%u stolen), tile ms min %.2f avg %.2f max %.2f\n", aStats.mTiles.size(), aStats.mStolenTiles,
+            lTileMin * 1000.0, (lTileSum / double(aStats.mTiles.size())) * 1000.0, lTileMax * 1000.0);
+    }
+
+    bool SaveImage(std::string const& aPath, sbx::TTexture& aImage)
+    {
+        sbx::TTextureView lView;
+        lView.mTexture = &aImage;
+        sbx::texutil::SaveToFile(aPath, sbx::ETextureFileType::PNG, lView);
+        return std::filesystem::exists(aPath);
+    }
+
+    bool RenderScene(std::string const& aInputPath, TRenderOptions const& aOptions, CSdfRaymarcher const& aRaymarcher, FILE* aTileStats)
+    {
+        CScene lScene;
+        lScene.mDocument->SetFilePath(aInputPath);
+        if (!lScene.mDocument->Load())
+        {
+            fprintf(stderr, "Unable to load [%s]\n", aInputPath.c_str());
+            return false;
+        }
+        lScene.SyncPackedStrokes();
+
+        CSdfEvaluator lEvaluator(lScene.GetPackedStrokes());
+        TSdfRenderParams const& lParams = aOptions.mParams;
+        lScene.mCamera.UpdateAspect(float(lParams.mWidth), float(lParams.mHeight));
+
+        std::filesystem::path lOutputBase = std::filesystem::path(aInputPath).replace_extension();
+        if (!aOptions.mOutputDir.empty())
+        {
+            lOutputBase = std::filesystem::path(aOptions.mOutputDir) / lOutputBase.filename();
+        }
+
+        printf("%s: %zu strokes, %dx%d, %d frames\n", aInputPath.c_str(), lEvaluator.GetStrokesCount(), lParams.mWidth, lParams.mHeight, aOptions.mFrames);
+
+        // The atlas modes bake the volume once for all the frames
+        const bool lRenderStrokes = (aOptions.mMode != ERenderMode::ATLAS);
+        const bool lRenderAtlas = (aOptions.mMode != ERenderMode::STROKES);
+        sbx::TTexture lLut;
+        TSdfBrickAtlas lAtlas;
+        if (lRenderAtlas)
+        {
+            TSdfBakeParams const& lBakeParams = aOptions.mBakeParams;
+            std::vector<uint32_t> lSlotList;
+            CSdfLutBaker lLutBaker;
+            const TSdfLutBakeStats lLutStats = lLutBaker.Bake(lEvaluator, lBakeParams, lLut, &lSlotList);
+            CSdfAtlasBaker lAtlasBaker;
+            const TSdfAtlasBakeStats lAtlasStats = lAtlasBaker.Bake(lEvaluator, lBakeParams, lSlotList, lAtlas, lBakeParams.mCullStrokes ? &lLutBaker.GetCullGrid() : nullptr);
+            printf("  bake: %d^3 LUT, %u bricks, %.3f s\n", lBakeParams.mLutSize, lAtlas.GetBricksCount(), lLutStats.mCullSeconds + lLutStats.mSeconds + lAtlasStats.mSeconds);
+        }
+
+        // Turntable frames orbit the camera origin around the look at point
+        const glm::vec3 lOrbit = lScene.mCamera.mOrigin - lScene.mCamera.mLookAt;
+        const glm::vec3 lAxis = glm::normalize(lScene.mCamera.mViewUp);
+        sbx::TTexture lStrokesImage;
+        sbx::TTexture lAtlasImage;
+        bool lSaved = true;
+        for (int32_t lFrame = 0; lFrame < aOptions.mFrames; lFrame++)
+        {
+            const float lAngle = glm::two_pi<float>() * float(lFrame) / float(aOptions.mFrames);
+            const glm::vec3 lAlong = lAxis * glm::dot(lAxis, lOrbit);
+            const glm::vec3 lAcross = lOrbit - lAlong;
+            lScene.mCamera.mOrigin = lScene.mCamera.mLookAt + lAlong + lAcross * glm::cos(lAngle) + glm::cross(lAxis, lAcross) * glm::sin(lAngle);
+
+            char lSuffix[32] = "";
+            if (aOptions.mFrames > 1)
+            {
+                snprintf(lSuffix, sizeof(lSuffix), "_%03d", lFrame);
+            }
+            const std::string lImageBase = lOutputBase.string() + lSuffix;
+            const glm::mat4 lView = lScene.mCamera.GetViewMatrix();
+            const glm::mat4 lProjection = lScene.mCamera.GetProjectionMatrix();
+
+            TSdfRenderStats lStrokesStats;
+            if (lRenderStrokes)
+            {
+                lStrokesStats = aRaymarcher.RenderStrokes(lEvaluator, lScene.mGlobalMaterial, lView, lProjection, lParams, lStrokesImage);
+                const std::string lImagePath = lImageBase + ".png";
+                lSaved &= SaveImage(lImagePath, lStrokesImage);
+                ReportRender(lImagePath, lFrame, lStrokesStats, aTileStats);
+            }
+
+            TSdfRenderStats lAtlasStats;
+            if (lRenderAtlas)
+            {
+                lAtlasStats = aRaymarcher.RenderAtlas(lLut, lAtlas, aOptions.mBakeParams, lScene.mGlobalMaterial, lView, lProjection, lParams, lAtlasImage);
+                const std::string lImagePath = lImageBase + (lRenderStrokes ? "_atlas.png" : ".png");
+                lSaved &= SaveImage(lImagePath, lAtlasImage);
+                ReportRender(lImagePath, lFrame, lAtlasStats, aTileStats);
+            }
+
+            if (lRenderStrokes && lRenderAtlas)
+            {
+                const TImageDiff lDiff = CompareImages(lStrokesImage, lAtlasImage);
+                printf("    atlas vs strokes: %.2fx speed, rmse %.2f, max %d, %.2f%% pixels off by more than %d\n",
+                    lStrokesStats.mSeconds / std::max(lAtlasStats.mSeconds, 1e-9), lDiff.mRmse, lDiff.mMax, lDiff.mDifferingPixels * 100.0, kDifferingThreshold);
+            }
+        }
+
+        if (!lSaved)
+        {
+            fprintf(stderr, "Unable to write the images of [%s]\n", aInputPath.c_str());
+        }
+
+        return lSaved;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    TRenderOptions lOptions;
+    if (!ParseOptions(argc, argv, lOptions))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (!lOptions.mOutputDir.empty())
+    {
+        std::error_code lError;
+        std::filesystem::create_directories(lOptions.mOutputDir, lError);
+    }
+
+    CSdfRaymarcher lRaymarcher;
+    sbx::TTexture lRoughnessMap;
+    if (!lOptions.mRoughnessMap.empty())
+    {
+        sbx::texutil::LoadFromFile(lOptions.mRoughnessMap, lRoughnessMap, true);
+        if (lRoughnessMap.mWidth <= 0 || lRoughnessMap.mHeight <= 0)
+        {
+            fprintf(stderr, "Unable to load the roughness map [%s]\n", lOptions.mRoughnessMap.c_str());
+            return 1;
+        }
+        lRaymarcher.SetRoughnessMap(&lRoughnessMap);
+    }
+
+    FILE* lTileStats = nullptr;
+    if (!lOptions.mTileStatsPath.empty())
+    {
+        lTileStats = fopen(lOptions.mTileStatsPath.c_str(), "w");
+        if (lTileStats == nullptr)
+        {
+            fprintf(stderr, "Unable to write [%s]\n", lOptions.mTileStatsPath.c_str());
+            return 1;
+        }
+        fprintf(lTileStats, "image,frame,x0,y0,x1,y1,worker,hits,evaluations,ms\n");
+    }
+
+    uint32_t lFailed = 0;
+    for (std::string const& lInput : lOptions.mInputs)
+    {
+        lFailed += RenderScene(lInput, lOptions, lRaymarcher, lTileStats) ? 0 : 1;
+    }
+
+    if (lTileStats != nullptr)
+    {
+        fclose(lTileStats);
+    }
+
+    return (lFailed == 0) ? 0 : 1;
+}
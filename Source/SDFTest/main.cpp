@@ -0,0 +1,510 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Regression tests of the editor code that runs without a window, returns the failures count
+
+#include <SDFEditor/Tool/Scene.h>
+#include <SDFEditor/Tool/SceneStack.h>
+#include <SDFEditor/Tool/SceneGenerator.h>
+#include <SDFEditor/Tool/SceneDocument.h>
+#include <SDFEditor/Tool/SceneBinaryFormat.h>
+#include <SDFEditor/Sdf/SdfEvaluator.h>
+#include <SDFEditor/Sdf/SdfLutBaker.h>
+#include <SDFEditor/Sdf/SdfAtlasBaker.h>
+
+#include <sbx/Texture/Texture.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    uint32_t sFailures = 0;
+
+    #define SDF_TEST_CHECK(aCondition) \
+        do { if (!(aCondition)) { fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #aCondition); sFailures++; } } while (0)
+
+    bool SameStrokes(std::vector<TStrokeInfo> const& aA, std::vector<TStrokeInfo> const& aB)
+    {
+        if (aA.size() != aB.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < aA.size(); i++)
+        {
+            if (::memcmp(static_cast<stroke_t const*>(&aA[i]), static_cast<stroke_t const*>(&aB[i]), sizeof(stroke_t)) != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Strokes, rotations and names
+    bool SameStrokeInfos(std::vector<TStrokeInfo> const& aA, std::vector<TStrokeInfo> const& aB)
+    {
+        if (!SameStrokes(aA, aB))
+        {
+            return false;
+        }
+        for (size_t i = 0; i < aA.size(); i++)
+        {
+            if (aA[i].mEulerAngles != aB[i].mEulerAngles || ::strcmp(aA[i].mName, aB[i].mName) != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string GetTempFilePath(const char* aName)
+    {
+        return (std::filesystem::temp_directory_path() / aName).string();
+    }
+
+    bool ReadFileBytes(std::string const& aPath, std::vector<uint8_t>& aOutBytes)
+    {
+        std::ifstream lFile(aPath, std::ios::binary);
+        aOutBytes.assign(std::istreambuf_iterator<char>(lFile), std::istreambuf_iterator<char>());
+        return lFile.good() || lFile.eof();
+    }
+
+    bool WriteFileBytes(std::string const& aPath, std::vector<uint8_t> const& aBytes)
+    {
+        std::ofstream lFile(aPath, std::ios::binary | std::ios::trunc);
+        lFile.write((const char*)aBytes.data(), std::streamsize(aBytes.size()));
+        return lFile.good();
+    }
+
+    bool LoadScene(CScene& aScene, std::string const& aPath)
+    {
+        aScene.mDocument->SetFilePath(aPath);
+        return aScene.mDocument->Load();
+    }
+
+    bool SaveScene(CScene& aScene, std::string const& aPath)
+    {
+        aScene.mDocument->SetFilePath(aPath);
+        return aScene.mDocument->Save();
+    }
+
+    // Generated scene with every primitive, op and mirror, and a name of every length
+    void GenerateDocumentScene(CScene& aScene, uint32_t aStrokesCount)
+    {
+        TSceneGeneratorParams lGenParams;
+        lGenParams.mSeed = 7;
+        lGenParams.mStrokesCount = aStrokesCount;
+        lGenParams.mOpWeights[ESceneGeneratorOp::INTERSECT] = 0.1f;
+        lGenParams.mMirrorChance = 0.3f;
+        CSceneGenerator::Generate(lGenParams, aScene);
+
+        for (size_t i = 0; i < aScene.mStrokesArray.size(); i++)
+        {
+            TStrokeInfo& lStroke = aScene.mStrokesArray[i];
+            const size_t lLength = 1 + (i * 37) % (TStrokeInfo::MAX_NAME_SIZE - 1);
+            ::memset(lStroke.mName, 'a' + int(i % 26), lLength);
+            lStroke.mName[lLength] = 0;
+        }
+        aScene.mGlobalMaterial.surfaceColor = glm::vec4(0.25f, 0.5f, 0.75f, 1.0f);
+    }
+
+    // JSON -> strkb -> JSON keeps the strokes, names and material, and the JSON text
+    void TestSceneBinaryRoundTrip()
+    {
+        const std::string lJsonPath = GetTempFilePath("sdftest_roundtrip.json");
+        const std::string lBinaryPath = GetTempFilePath("sdftest_roundtrip.strkb");
+        const std::string lJsonBackPath = GetTempFilePath("sdftest_roundtrip_back.json");
+
+        CScene lSource;
+        GenerateDocumentScene(lSource, 64);
+        SDF_TEST_CHECK(SaveScene(lSource, lJsonPath));
+
+        CScene lFromJson;
+        SDF_TEST_CHECK(LoadScene(lFromJson, lJsonPath));
+        SDF_TEST_CHECK(SameStrokeInfos(lFromJson.mStrokesArray, lSource.mStrokesArray));
+        SDF_TEST_CHECK(SaveScene(lFromJson, lBinaryPath));
+
+        CScene lFromBinary;
+        SDF_TEST_CHECK(LoadScene(lFromBinary, lBinaryPath));
+        SDF_TEST_CHECK(SameStrokeInfos(lFromBinary.mStrokesArray, lFromJson.mStrokesArray));
+        SDF_TEST_CHECK(::memcmp(&lFromBinary.mGlobalMaterial, &lSource.mGlobalMaterial, sizeof(TGlobalMaterialBufferData)) == 0);
+        SDF_TEST_CHECK(SaveScene(lFromBinary, lJsonBackPath));
+
+        std::vector<uint8_t> lJson;
+        std::vector<uint8_t> lJsonBack;
+        SDF_TEST_CHECK(ReadFileBytes(lJsonPath, lJson));
+        SDF_TEST_CHECK(ReadFileBytes(lJsonBackPath, lJsonBack));
+        SDF_TEST_CHECK(!lJson.empty() && lJson == lJsonBack);
+
+        std::error_code lError;
+        std::filesystem::remove(lJsonPath, lError);
+        std::filesystem::remove(lBinaryPath, lError);
+        std::filesystem::remove(lJsonBackPath, lError);
+    }
+
+    template <typename T>
+    void PatchBytes(std::vector<uint8_t>& aBytes, size_t aOffset, T const& aValue)
+    {
+        ::memcpy(aBytes.data() + aOffset, &aValue, sizeof(T));
+    }
+
+    // Broken binaries are rejected before the scene is touched, bad values
+    // inside a valid layout fall back like the JSON loader does. The errors
+    // break into the debugger in Debug builds, the test isn't listed there
+    void TestSceneBinaryRejectsCorrupted()
+    {
+        const std::string lValidPath = GetTempFilePath("sdftest_valid.strkb");
+        const std::string lCorruptPath = GetTempFilePath("sdftest_corrupt.strkb");
+
+        CScene lSource;
+        GenerateDocumentScene(lSource, 8);
+        std::vector<uint8_t> lValid;
+        SDF_TEST_CHECK(SaveScene(lSource, lValidPath));
+        SDF_TEST_CHECK(ReadFileBytes(lValidPath, lValid));
+        SDF_TEST_CHECK(lValid.size() > sizeof(TStrkbHeader));
+        if (lValid.size() <= sizeof(TStrkbHeader))
+        {
+            return;
+        }
+
+        TStrkbHeader lHeader;
+        ::memcpy(&lHeader, lValid.data(), sizeof(TStrkbHeader));
+
+        CScene lTarget;
+        const std::vector<TStrokeInfo> lInitial = lTarget.mStrokesArray;
+        auto LoadBytes = [&](std::vector<uint8_t> const& aBytes)
+        {
+            SDF_TEST_CHECK(WriteFileBytes(lCorruptPath, aBytes));
+            return LoadScene(lTarget, lCorruptPath);
+        };
+
+        // Truncated, with the original and with a matching file size
+        const size_t lSizes[] = { 0, 4, sizeof(TStrkbHeader) - 1, sizeof(TStrkbHeader), lValid.size() / 2, lValid.size() - 1 };
+        for (size_t lSize : lSizes)
+        {
+            std::vector<uint8_t> lBytes(lValid.begin(), lValid.begin() + lSize);
+            SDF_TEST_CHECK(!LoadBytes(lBytes));
+            if (lSize >= sizeof(TStrkbHeader))
+            {
+                PatchBytes(lBytes, offsetof(TStrkbHeader, mFileSize), uint64_t(lSize));
+                SDF_TEST_CHECK(!LoadBytes(lBytes));
+            }
+        }
+
+        // Strokes count past what the file can hold, and a section that wraps around
+        const uint32_t lCounts[] = { uint32_t(lValid.size() / sizeof(stroke_t)) + 1, 0x10000000u, UINT32_MAX };
+        for (uint32_t lCount : lCounts)
+        {
+            std::vector<uint8_t> lBytes = lValid;
+            PatchBytes(lBytes, offsetof(TStrkbHeader, mStrokesCount), lCount);
+            SDF_TEST_CHECK(!LoadBytes(lBytes));
+        }
+        {
+            std::vector<uint8_t> lBytes = lValid;
+            PatchBytes(lBytes, offsetof(TStrkbHeader, mMaterialOffset), UINT64_MAX - 8);
+            SDF_TEST_CHECK(!LoadBytes(lBytes));
+        }
+        SDF_TEST_CHECK(SameStrokeInfos(lTarget.mStrokesArray, lInitial));
+
+        // Unknown primitives become boxes and unknown op bits are dropped
+        {
+            std::vector<uint8_t> lBytes = lValid;
+            const size_t lIdOffset = size_t(lHeader.mStrokesOffset) + offsetof(stroke_t, id);
+            PatchBytes(lBytes, lIdOffset, glm::ivec2(99, EStrokeOp::OpAdd));
+            PatchBytes(lBytes, lIdOffset + sizeof(stroke_t), glm::ivec2(-3, EStrokeOp::OpSubtract));
+            PatchBytes(lBytes, lIdOffset + 2 * sizeof(stroke_t), glm::ivec2(EPrimitive::PrTorus, EStrokeOp::OpSubtract | EStrokeOp::OpMirrorX | 0x30));
+            SDF_TEST_CHECK(LoadBytes(lBytes));
+            SDF_TEST_CHECK(lTarget.mStrokesArray.size() == lSource.mStrokesArray.size());
+            if (lTarget.mStrokesArray.size() == lSource.mStrokesArray.size())
+            {
+                SDF_TEST_CHECK(lTarget.mStrokesArray[0].id.x == EPrimitive::PrBox);
+                SDF_TEST_CHECK(lTarget.mStrokesArray[1].id.x == EPrimitive::PrBox);
+                SDF_TEST_CHECK(lTarget.mStrokesArray[1].id.y == EStrokeOp::OpSubtract);
+                SDF_TEST_CHECK(lTarget.mStrokesArray[2].id.x == EPrimitive::PrTorus);
+                SDF_TEST_CHECK(lTarget.mStrokesArray[2].id.y == (EStrokeOp::OpSubtract | EStrokeOp::OpMirrorX));
+                for (size_t i = 3; i < lSource.mStrokesArray.size(); i++)
+                {
+                    SDF_TEST_CHECK(lTarget.mStrokesArray[i].id == lSource.mStrokesArray[i].id);
+                }
+            }
+        }
+
+        // A name out of the string table keeps the default name, the others load
+        {
+            std::vector<uint8_t> lBytes = lValid;
+            PatchBytes(lBytes, size_t(lHeader.mNameOffsetsOffset) + sizeof(uint32_t), UINT32_MAX);
+            SDF_TEST_CHECK(LoadBytes(lBytes));
+            SDF_TEST_CHECK(lTarget.mStrokesArray.size() == lSource.mStrokesArray.size());
+            if (lTarget.mStrokesArray.size() == lSource.mStrokesArray.size())
+            {
+                SDF_TEST_CHECK(::strcmp(lTarget.mStrokesArray[0].mName, TStrokeInfo().mName) == 0);
+                SDF_TEST_CHECK(::strcmp(lTarget.mStrokesArray[1].mName, TStrokeInfo().mName) == 0);
+                for (size_t i = 2; i < lSource.mStrokesArray.size(); i++)
+                {
+                    SDF_TEST_CHECK(::strcmp(lTarget.mStrokesArray[i].mName, lSource.mStrokesArray[i].mName) == 0);
+                }
+            }
+        }
+
+        std::error_code lError;
+        std::filesystem::remove(lValidPath, lError);
+        std::filesystem::remove(lCorruptPath, lError);
+    }
+
+    // Drags of 3 non adjacent strokes selected together, one push per frame
+    // with the same coalesce key as the guizmo does. Each drag must stay one
+    // entry, with its memory counted once
+    void TestUndoCoalescedDrags()
+    {
+        constexpr uint32_t kStrokes = 16;
+        constexpr uint32_t kDrags = 4;
+        constexpr uint32_t kFrames = 64;
+
+        CScene lScene;
+        for (uint32_t i = 1; i < kStrokes; i++)
+        {
+            lScene.AddNewStroke();
+        }
+        lScene.mStack->Reset();
+        lScene.mStack->PushState(EPushStateFlags::EPE_ALL);
+        const std::vector<TStrokeInfo> lInitial = lScene.mStrokesArray;
+        const size_t lBaseUsage = lScene.mStack->GetMemoryUsage();
+
+        // 3 spans of one stroke, and the selection
+        const size_t lEntryBound = sizeof(TSceneStackEntry) + 3 * (sizeof(TSceneStackEntry::TSpan) + sizeof(TStrokeInfo) + sizeof(uint32_t));
+
+        lScene.mSelectedItems = { 1, 7, 12 };
+        for (uint32_t d = 0; d < kDrags; d++)
+        {
+            const uint32_t lKey = lScene.mStack->NewCoalesceKey();
+            for (uint32_t f = 0; f < kFrames; f++)
+            {
+                for (uint32_t lSelected : lScene.mSelectedItems)
+                {
+                    lScene.mStrokesArray[lSelected].posb.x += 0.01f;
+                }
+                lScene.mStack->PushState(EPushStateFlags::EPE_STROKES_ALL, lKey);
+
+                const size_t lUsage = lScene.mStack->GetMemoryUsage();
+                SDF_TEST_CHECK(lUsage >= lBaseUsage);
+                SDF_TEST_CHECK(lUsage <= lBaseUsage + (d + 1) * lEntryBound);
+            }
+            SDF_TEST_CHECK(lScene.mStack->GetUndoCount() == d + 1);
+        }
+
+        const std::vector<TStrokeInfo> lFinal = lScene.mStrokesArray;
+        const size_t lFinalUsage = lScene.mStack->GetMemoryUsage();
+
+        // Undo and redo of the whole history
+        uint32_t lUndos = 0;
+        while (lScene.mStack->PopState())
+        {
+            lUndos++;
+        }
+        SDF_TEST_CHECK(lUndos == kDrags);
+        SDF_TEST_CHECK(SameStrokes(lScene.mStrokesArray, lInitial));
+
+        while (lScene.mStack->RestorePopedState())
+        {
+        }
+        SDF_TEST_CHECK(SameStrokes(lScene.mStrokesArray, lFinal));
+        SDF_TEST_CHECK(lScene.mStack->GetMemoryUsage() == lFinalUsage);
+        SDF_TEST_CHECK(lScene.mStack->GetUndoCount() == kDrags);
+    }
+
+    // Small volume, the strokes of the tests fit in +-3.2
+    TSdfBakeParams GetTestBakeParams()
+    {
+        TSdfBakeParams lParams;
+        lParams.mLutSize = 64;
+        lParams.mLutVoxelSide = 0.1f;
+        return lParams;
+    }
+
+    // Culled and full LUT bakes of aStrokes must give the same slots and, in
+    // the surface band, the same distances
+    void CheckCulledLutBake(std::vector<TStrokeInfo> const& aStrokes, const char* aLabel)
+    {
+        constexpr float kTolerance = 1e-4f;
+
+        CSdfEvaluator lEvaluator;
+        lEvaluator.SetStrokes(aStrokes);
+        TSdfBakeParams lParams = GetTestBakeParams();
+
+        CSdfLutBaker lFullBaker;
+        CSdfLutBaker lCulledBaker;
+        sbx::TTexture lLut;
+        std::vector<uint32_t> lFullSlots;
+        std::vector<uint32_t> lCulledSlots;
+
+        lParams.mCullStrokes = false;
+        lFullBaker.Bake(lEvaluator, lParams, lLut, &lFullSlots);
+        lParams.mCullStrokes = true;
+        lCulledBaker.Bake(lEvaluator, lParams, lLut, &lCulledSlots);
+
+        std::vector<float> const& lFull = lFullBaker.GetDistances();
+        std::vector<float> const& lCulled = lCulledBaker.GetDistances();
+        const float lBand = lParams.GetSurfaceBand();
+        float lMaxError = 0.0f;
+        for (size_t i = 0; i < lFull.size(); i++)
+        {
+            if (glm::abs(lFull[i]) < lBand || glm::abs(lCulled[i]) < lBand)
+            {
+                lMaxError = glm::max(lMaxError, glm::abs(lFull[i] - lCulled[i]));
+            }
+        }
+
+        const bool lSameSlots = (lFullSlots == lCulledSlots);
+        if (!lSameSlots || lMaxError > kTolerance)
+        {
+            fprintf(stderr, "%s: %zu slots full, %zu culled, band error %f\n", aLabel, lFullSlots.size(), lCulledSlots.size(), lMaxError);
+        }
+        SDF_TEST_CHECK(lSameSlots);
+        SDF_TEST_CHECK(lMaxError <= kTolerance);
+    }
+
+    // Scenes where a cell drops strokes that a wide blend after them reads back
+    // into the band: a small sphere blended from far away by a large one, and
+    // random scenes with wide blends and every op
+    void ForEachWideBlendScene(void (*aCheck)(std::vector<TStrokeInfo> const& aStrokes, const char* aLabel))
+    {
+        for (int32_t i = 0; i < 8; i++)
+        {
+            stroke_t lSmall;
+            lSmall.posb = glm::vec4(1.1f + 0.1f * float(i), 0.0f, 0.0f, 0.0f);
+            lSmall.param0 = glm::vec4(0.15f, 0.15f, 0.15f, 0.0f);
+            lSmall.id = glm::ivec4(EPrimitive::PrEllipsoid, EStrokeOp::OpAdd, 0, 0);
+
+            stroke_t lLarge;
+            lLarge.posb = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            lLarge.param0 = glm::vec4(0.8f, 0.8f, 0.8f, 0.0f);
+            lLarge.id = glm::ivec4(EPrimitive::PrEllipsoid, EStrokeOp::OpAdd, 0, 0);
+
+            const std::vector<TStrokeInfo> lStrokes = { TStrokeInfo(lSmall, glm::vec3(0.0f), "Small"), TStrokeInfo(lLarge, glm::vec3(0.0f), "Large") };
+            char lLabel[64];
+            ::snprintf(lLabel, sizeof(lLabel), "spheres %d", i);
+            aCheck(lStrokes, lLabel);
+        }
+
+        for (uint32_t lSeed = 1; lSeed <= 24; lSeed++)
+        {
+            TSceneGeneratorParams lGenParams;
+            lGenParams.mSeed = lSeed;
+            lGenParams.mStrokesCount = 16 + (lSeed % 4) * 8;
+            lGenParams.mLayout = (lSeed % 2) ? ESceneLayout::UNIFORM : ESceneLayout::CLUSTERED;
+            lGenParams.mOpWeights[ESceneGeneratorOp::ADD] = 0.5f;
+            lGenParams.mOpWeights[ESceneGeneratorOp::SUBTRACT] = 0.4f;
+            lGenParams.mOpWeights[ESceneGeneratorOp::INTERSECT] = (lSeed % 3 == 0) ? 0.1f : 0.0f;
+            lGenParams.mMirrorChance = (lSeed % 4 == 1) ? 0.3f : 0.0f;
+            lGenParams.mBlendMin = 0.3f;
+            lGenParams.mBlendMax = 1.0f;
+            lGenParams.mSizeMin = 0.05f;
+            lGenParams.mSizeMax = 0.5f;
+            lGenParams.mExtent = 1.0f + 0.25f * float(lSeed % 5);
+
+            CScene lScene;
+            CSceneGenerator::Generate(lGenParams, lScene);
+            char lLabel[64];
+            ::snprintf(lLabel, sizeof(lLabel), "seed %u", lSeed);
+            aCheck(lScene.mStrokesArray, lLabel);
+        }
+    }
+
+    // Strokes dropped from a cell still change the distance past the cull
+    // margin, the wide blends after them must not bring it back to the band
+    void TestBakeCulledMatchesFull()
+    {
+        ForEachWideBlendScene(CheckCulledLutBake);
+    }
+
+    // Bricks evaluated through the cull grid, as sdfbake does by default, must
+    // match the bricks of the full bake
+    void CheckCulledAtlasBake(std::vector<TStrokeInfo> const& aStrokes, const char* aLabel)
+    {
+        CSdfEvaluator lEvaluator;
+        lEvaluator.SetStrokes(aStrokes);
+        TSdfBakeParams lParams = GetTestBakeParams();
+
+        CSdfLutBaker lLutBaker;
+        CSdfAtlasBaker lAtlasBaker;
+        sbx::TTexture lLut;
+        std::vector<uint32_t> lSlots;
+        TSdfBrickAtlas lFullAtlas;
+        TSdfBrickAtlas lCulledAtlas;
+
+        lParams.mCullStrokes = false;
+        lLutBaker.Bake(lEvaluator, lParams, lLut, &lSlots);
+        lAtlasBaker.Bake(lEvaluator, lParams, lSlots, lFullAtlas);
+        lParams.mCullStrokes = true;
+        lLutBaker.Bake(lEvaluator, lParams, lLut, &lSlots);
+        lAtlasBaker.Bake(lEvaluator, lParams, lSlots, lCulledAtlas, &lLutBaker.GetCullGrid());
+
+        const bool lSameSlots = (lFullAtlas.mSlotList == lCulledAtlas.mSlotList);
+        size_t lBadVoxels = 0;
+        if (lSameSlots)
+        {
+            for (size_t i = 0; i < lFullAtlas.mBricks.size(); i++)
+            {
+                lBadVoxels += (lFullAtlas.mBricks[i] != lCulledAtlas.mBricks[i]) ? 1 : 0;
+            }
+        }
+
+        if (!lSameSlots || lBadVoxels > 0)
+        {
+            fprintf(stderr, "%s: %u bricks full, %u culled, %zu brick voxels differ\n", aLabel, lFullAtlas.GetBricksCount(), lCulledAtlas.GetBricksCount(), lBadVoxels);
+        }
+        SDF_TEST_CHECK(lSameSlots);
+        SDF_TEST_CHECK(lBadVoxels == 0);
+    }
+
+    void TestAtlasCulledMatchesFull()
+    {
+        ForEachWideBlendScene(CheckCulledAtlasBake);
+    }
+
+    struct TTest
+    {
+        const char* mName;
+        void (*mFunction)();
+    };
+
+    const TTest sTests[] =
+    {
+        { "undo_coalesced_drags", TestUndoCoalescedDrags },
+        { "scene_binary_round_trip", TestSceneBinaryRoundTrip },
+#ifndef DEBUG
+        { "scene_binary_rejects_corrupted", TestSceneBinaryRejectsCorrupted },
+#endif
+        { "bake_culled_matches_full", TestBakeCulledMatchesFull },
+        { "atlas_culled_matches_full", TestAtlasCulledMatchesFull },
+    };
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t lFailedTests = 0;
+    for (TTest const& lTest : sTests)
+    {
+        // Optional names filter
+        bool lSelected = (argc < 2);
+        for (int i = 1; i < argc && !lSelected; i++)
+        {
+            lSelected = (::strcmp(argv[i], lTest.mName) == 0);
+        }
+        if (!lSelected)
+        {
+            continue;
+        }
+
+        const uint32_t lPrevFailures = sFailures;
+        lTest.mFunction();
+        const bool lPassed = (sFailures == lPrevFailures);
+        lFailedTests += lPassed ? 0 : 1;
+        printf("%-32s %s\n", lTest.mName, lPassed ? "ok" : "FAILED");
+    }
+
+    return int(lFailedTests);
+}
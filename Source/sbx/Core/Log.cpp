@@ -9,6 +9,8 @@
 
 #include <mutex>
 #include <cstdarg>
+#include <cstdio>
+#include <cstring>
 
 void _sbx_write_log_va_list(const char* aFormat, va_list aArgsList);
 
@@ -25,8 +27,9 @@ void _sbx_write_log_va_list(const char* aFormat, va_list aArgsList)
     static std::mutex sUniqueRegistryMutex; 
     std::lock_guard< std::mutex > lScopedMutex(sUniqueRegistryMutex);
     static char lMessageBuffer[49152];
-    vsprintf_s(lMessageBuffer, sizeof(lMessageBuffer), aFormat, aArgsList);
-    strcat_s(lMessageBuffer, sizeof(lMessageBuffer), "\n");
+    // Leaves room for the line break
+    ::vsnprintf(lMessageBuffer, sizeof(lMessageBuffer) - 1, aFormat, aArgsList);
+    ::strcat(lMessageBuffer, "\n");
 
 #if SBX_OS_WINDOWS
     OutputDebugString(lMessageBuffer);
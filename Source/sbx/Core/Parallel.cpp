@@ -0,0 +1,237 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include <sbx/Core/Parallel.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+    // Worker threads created once and parked between calls. One job runs at a
+    // time, calls from other threads wait for it and calls nested in a job run
+    // on the calling thread alone.
+    class CWorkerPool
+    {
+    public:
+        using TJobFn = std::function<void(uint32_t aWorker)>;
+
+        ~CWorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lLock(mMutex);
+                mStop = true;
+            }
+            mWakeCondition.notify_all();
+
+            for (std::thread& lThread : mThreads)
+            {
+                lThread.join();
+            }
+        }
+
+        // aFunction(0) runs on the calling thread, aFunction(1..aThreads-1) on the pool
+        void Run(uint32_t aThreads, TJobFn const& aFunction)
+        {
+            if (aThreads <= 1 || sInJob)
+            {
+                aFunction(0);
+                return;
+            }
+
+            std::lock_guard<std::mutex> lJobLock(mJobMutex);
+            {
+                std::lock_guard<std::mutex> lLock(mMutex);
+                while (mThreads.size() < (aThreads - 1))
+                {
+                    mThreads.emplace_back(&CWorkerPool::WorkerLoop, this, uint32_t(mThreads.size() + 1));
+                }
+
+                mJob = &aFunction;
+                mJobThreads = aThreads;
+                mPending = aThreads - 1;
+                mGeneration++;
+            }
+            mWakeCondition.notify_all();
+
+            sInJob = true;
+            aFunction(0);
+            sInJob = false;
+
+            std::unique_lock<std::mutex> lLock(mMutex);
+            mDoneCondition.wait(lLock, [this] { return mPending == 0; });
+            mJob = nullptr;
+        }
+
+    private:
+        void WorkerLoop(uint32_t aWorker)
+        {
+            sInJob = true;
+
+            uint64_t lSeenGeneration = 0;
+            std::unique_lock<std::mutex> lLock(mMutex);
+            while (true)
+            {
+                mWakeCondition.wait(lLock, [&] { return mStop || (mGeneration != lSeenGeneration); });
+                if (mStop)
+                {
+                    return;
+                }
+
+                lSeenGeneration = mGeneration;
+                if (aWorker >= mJobThreads)
+                {
+                    continue;
+                }
+
+                TJobFn const* lJob = mJob;
+                lLock.unlock();
+                (*lJob)(aWorker);
+                lLock.lock();
+
+                if (--mPending == 0)
+                {
+                    mDoneCondition.notify_one();
+                }
+            }
+        }
+
+    private:
+        static thread_local bool sInJob;
+
+        std::mutex mJobMutex;
+        std::mutex mMutex;
+        std::condition_variable mWakeCondition;
+        std::condition_variable mDoneCondition;
+        std::vector<std::thread> mThreads;
+
+        TJobFn const* mJob{ nullptr };
+        uint32_t mJobThreads{ 0 };
+        uint32_t mPending{ 0 };
+        uint64_t mGeneration{ 0 };
+        bool mStop{ false };
+    };
+
+    thread_local bool CWorkerPool::sInJob = false;
+
+    CWorkerPool& GetWorkerPool()
+    {
+        static CWorkerPool sPool;
+        return sPool;
+    }
+}
+
+namespace sbx
+{
+    uint32_t GetHardwareThreadsCount()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    void ParallelFor(size_t aCount, size_t aGrain, TParallelForFn const& aFunction, uint32_t aThreads)
+    {
+        if (aCount == 0)
+        {
+            return;
+        }
+
+        const size_t lGrain = std::max<size_t>(1, aGrain);
+        const size_t lNumChunks = (aCount + lGrain - 1) / lGrain;
+        const uint32_t lNumThreads = uint32_t(std::min<size_t>((aThreads > 0) ? aThreads : GetHardwareThreadsCount(), lNumChunks));
+
+        std::atomic<size_t> lNextChunk{ 0 };
+        auto lWorker = [&](uint32_t aWorker)
+        {
+            for (size_t lChunk = lNextChunk++; lChunk < lNumChunks; lChunk = lNextChunk++)
+            {
+                const size_t lBegin = lChunk * lGrain;
+                aFunction(lBegin, std::min(lBegin + lGrain, aCount), aWorker);
+            }
+        };
+
+        GetWorkerPool().Run(lNumThreads, lWorker);
+    }
+
+    uint32_t ParallelForEachStealing(size_t aCount, TParallelForEachFn const& aFunction, uint32_t aThreads)
+    {
+        if (aCount == 0)
+        {
+            return 0;
+        }
+
+        const uint32_t lNumThreads = uint32_t(std::min<size_t>((aThreads > 0) ? aThreads : GetHardwareThreadsCount(), aCount));
+
+        // [mBegin, mEnd) left of each block, the owner pops the front and thieves the back
+        struct TBlock
+        {
+            std::mutex mMutex;
+            size_t mBegin{ 0 };
+            size_t mEnd{ 0 };
+        };
+
+        std::vector<TBlock> lBlocks(lNumThreads);
+        for (uint32_t i = 0; i < lNumThreads; i++)
+        {
+            lBlocks[i].mBegin = (aCount * i) / lNumThreads;
+            lBlocks[i].mEnd = (aCount * (i + 1)) / lNumThreads;
+        }
+
+        std::atomic<uint32_t> lStolen{ 0 };
+        auto lWorker = [&](uint32_t aWorker)
+        {
+            TBlock& lOwn = lBlocks[aWorker];
+            while (true)
+            {
+                size_t lIndex = SIZE_MAX;
+                {
+                    std::lock_guard<std::mutex> lLock(lOwn.mMutex);
+                    if (lOwn.mBegin < lOwn.mEnd)
+                    {
+                        lIndex = lOwn.mBegin++;
+                    }
+                }
+
+                if (lIndex == SIZE_MAX)
+                {
+                    // Victim with the most items left, it may be empty by the time it is locked
+                    uint32_t lVictim = aWorker;
+                    size_t lVictimLeft = 0;
+                    for (uint32_t i = 0; i < lNumThreads; i++)
+                    {
+                        std::lock_guard<std::mutex> lLock(lBlocks[i].mMutex);
+                        const size_t lLeft = lBlocks[i].mEnd - lBlocks[i].mBegin;
+                        if (lLeft > lVictimLeft)
+                        {
+                            lVictim = i;
+                            lVictimLeft = lLeft;
+                        }
+                    }
+
+                    if (lVictimLeft == 0)
+                    {
+                        return;
+                    }
+
+                    std::lock_guard<std::mutex> lLock(lBlocks[lVictim].mMutex);
+                    if (lBlocks[lVictim].mBegin < lBlocks[lVictim].mEnd)
+                    {
+                        lIndex = --lBlocks[lVictim].mEnd;
+                        lStolen++;
+                    }
+                }
+
+                if (lIndex != SIZE_MAX)
+                {
+                    aFunction(lIndex, aWorker);
+                }
+            }
+        };
+
+        GetWorkerPool().Run(lNumThreads, lWorker);
+
+        return lStolen;
+    }
+};
@@ -0,0 +1,31 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+// Minimal data parallel helpers over a pool of std::thread, created on the
+// first call and reused by the next ones
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace sbx
+{
+    // [aBegin, aEnd) range of items and the index of the worker running it
+    using TParallelForFn = std::function<void(size_t aBegin, size_t aEnd, uint32_t aWorker)>;
+
+    // Index of the item and of the worker running it
+    using TParallelForEachFn = std::function<void(size_t aIndex, uint32_t aWorker)>;
+
+    uint32_t GetHardwareThreadsCount();
+
+    // Splits [0, aCount) in chunks of aGrain items, workers pull chunks until
+    // the range is consumed. aThreads = 0 uses all the hardware threads.
+    // The calling thread works as worker 0, returns when all chunks are done.
+    void ParallelFor(size_t aCount, size_t aGrain, TParallelForFn const& aFunction, uint32_t aThreads = 0);
+
+    // Work stealing for items of uneven cost, like screen tiles. Each worker
+    // gets a contiguous block of [0, aCount) and runs it front to back, once
+    // empty it steals from the back of the busiest block. The calling thread
+    // works as worker 0. Returns the number of stolen items.
+    uint32_t ParallelForEachStealing(size_t aCount, TParallelForEachFn const& aFunction, uint32_t aThreads = 0);
+};
@@ -0,0 +1,111 @@
+// Copyright (c) 2022 David Gallardo and SDFEditor Project
+
+#include <sbx/Core/Platform.h>
+
+#if SBX_SIMD_X86
+#   if SBX_COMPILER_MSVC
+#       include <intrin.h>
+#       include <immintrin.h>
+#   else
+#       include <cpuid.h>
+#   endif
+#endif
+
+namespace sbx
+{
+#if SBX_SIMD_X86
+    namespace
+    {
+        void CpuId(uint32_t aLeaf, uint32_t aSubLeaf, uint32_t aOutRegs[4])
+        {
+#   if SBX_COMPILER_MSVC
+            int lRegs[4];
+            __cpuidex(lRegs, int(aLeaf), int(aSubLeaf));
+            for (int i = 0; i < 4; i++)
+            {
+                aOutRegs[i] = uint32_t(lRegs[i]);
+            }
+#   else
+            __cpuid_count(aLeaf, aSubLeaf, aOutRegs[0], aOutRegs[1], aOutRegs[2], aOutRegs[3]);
+#   endif
+        }
+
+        uint64_t GetXCR0()
+        {
+#   if SBX_COMPILER_MSVC
+            return _xgetbv(0);
+#   else
+            uint32_t lEax = 0, lEdx = 0;
+            __asm__ volatile("xgetbv" : "=a"(lEax), "=d"(lEdx) : "c"(0));
+            return (uint64_t(lEdx) << 32) | lEax;
+#   endif
+        }
+
+        uint32_t DetectCpuFeatures()
+        {
+            uint32_t lFeatures = 0;
+            uint32_t lRegs[4] = { 0 };
+
+            CpuId(0, 0, lRegs);
+            const uint32_t lMaxLeaf = lRegs[0];
+            if (lMaxLeaf < 1)
+            {
+                return 0;
+            }
+
+            CpuId(1, 0, lRegs);
+            const uint32_t lEcx1 = lRegs[2];
+
+            if (lEcx1 & (1u << 19))
+            {
+                lFeatures |= ECpuFeature::SSE41;
+            }
+
+            // AVX registers must be saved by the OS (OSXSAVE + XCR0 YMM state)
+            const bool lOSXSave = (lEcx1 & (1u << 27)) != 0;
+            const uint64_t lXCR0 = lOSXSave ? GetXCR0() : 0;
+            const bool lYmmEnabled = (lXCR0 & 0x6) == 0x6;
+            const bool lZmmEnabled = (lXCR0 & 0xE6) == 0xE6;
+
+            if (lYmmEnabled && (lEcx1 & (1u << 28)))
+            {
+                lFeatures |= ECpuFeature::AVX;
+
+                if (lEcx1 & (1u << 12))
+                {
+                    lFeatures |= ECpuFeature::FMA;
+                }
+
+                if (lMaxLeaf >= 7)
+                {
+                    CpuId(7, 0, lRegs);
+                    const uint32_t lEbx7 = lRegs[1];
+
+                    if (lEbx7 & (1u << 5))
+                    {
+                        lFeatures |= ECpuFeature::AVX2;
+                    }
+
+                    if (lZmmEnabled && (lEbx7 & (1u << 16)))
+                    {
+                        lFeatures |= ECpuFeature::AVX512F;
+                    }
+                }
+            }
+
+            return lFeatures;
+        }
+    }
+
+    uint32_t GetCpuFeatures()
+    {
+        static const uint32_t sFeatures = DetectCpuFeatures();
+        return sFeatures;
+    }
+#else
+    uint32_t GetCpuFeatures()
+    {
+        return 0;
+    }
+#endif
+};
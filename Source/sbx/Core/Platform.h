@@ -36,8 +36,10 @@
 #   define SBX_OS_LINUX        1
 #   ifdef __i386
 #       define SBX_ARCH_I386   1
-#   elif defined(LINUX64)
+#   elif defined(LINUX64) || defined(__x86_64__)
 #       define SBX_ARCH_X86_64 1
+#   elif defined(__aarch64__)
+#       define SBX_ARCH_ARM64  1
 #   endif
 
 #elif defined(__APPLE__)
@@ -127,7 +129,7 @@
 #elif __GNUC__
 #   define SBX_COMPILER_GCC    1
 #   define SBX_GCC_ALIGN(a)    __attribute__((aligned(a)))
-#   define SBX_PLATFORM_ALIGNED_MALLOC(_ALIGNMENT, _SIZE)   ::aligned_malloc(_ALIGNMENT, _SIZE)
+#   define SBX_PLATFORM_ALIGNED_MALLOC(_ALIGNMENT, _SIZE)   ::aligned_alloc(_ALIGNMENT, _SIZE)
 #   define SBX_PLATFORM_ALIGNED_FREE(_PTR)                  ::free(_PTR)
 #else
 #   error Unknown compiler.
@@ -148,6 +150,40 @@
 #   define SBX_GCC_ALIGN(a)
 #endif
 
+/*
+ * SIMD instruction sets, the compiler ones are only the baseline, use
+ * sbx::GetCpuFeatures() to select wider code paths at runtime.
+ */
+#if SBX_ARCH_X86_64 || SBX_ARCH_I386
+#   define SBX_SIMD_X86        1
+#endif
+
+#ifndef SBX_SIMD_X86
+#   define SBX_SIMD_X86        0
+#endif
+
+#ifdef __cplusplus
+#include <cstdint>
+
+namespace sbx
+{
+    namespace ECpuFeature
+    {
+        enum Type
+        {
+            SSE41       = 1 << 0,
+            AVX         = 1 << 1,
+            AVX2        = 1 << 2,
+            FMA         = 1 << 3,
+            AVX512F     = 1 << 4,
+        };
+    };
+
+    // ECpuFeature bitfield, only reports the features the OS also enables
+    uint32_t GetCpuFeatures();
+};
+#endif
+
 /*
  * IDE Macros
  */
@@ -7,6 +7,7 @@
 #define _SBX_RAW_BUFFER_H_
 
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace sbx
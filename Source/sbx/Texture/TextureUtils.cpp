@@ -109,7 +109,7 @@ namespace sbx { namespace texutil
         lOutput.write(&lEnd, sizeof(char));
         lOutput.close();
 
-        return true;
+        return !lOutput.fail();
     }
 
     bool LoadTexturePack(std::string const& aPath, std::vector< TTexture >& aTexturePack)
@@ -138,16 +138,29 @@ namespace sbx { namespace texutil
                 uint64_t lBufferSize = 0;
                 lInput.read((char*)&lBufferSize, sizeof(uint64_t));
 
+                //Truncated or not a texture pack
+                if (!lInput || lTexFormat > ETextureFormat::RGBA32F)
+                {
+                    break;
+                }
+
                 aTexturePack.emplace_back();
                 TTexture& lTexture = aTexturePack.back();
                 lTexture.Init(lTexWidth, lTexHeight, lTexSlices, ETextureFormat::Type(lTexFormat));
 
+                if (lBufferSize != lTexture.GetSliceSize() * lTexture.mSlices)
+                {
+                    lInput.setstate(std::ios::failbit);
+                    break;
+                }
+
                 //Read all the texture
                 lInput.read((char*)lTexture.mBuffer.GetByteArray(), lBufferSize);
             }
 
+            const bool lGood = !lInput.fail();
             lInput.close();
-            return true;
+            return lGood;
         }
 
         lInput.close();